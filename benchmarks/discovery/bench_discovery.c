@@ -0,0 +1,178 @@
+/**
+ * @file      bench_discovery.c
+ * @brief     Cote discovery convergence benchmark in C
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define BENCH_NODES          (8)     /* Default amount of nodes */
+#define BENCH_HELLO_INTERVAL (500)   /* Default hello interval (milliseconds) */
+#define BENCH_TIMEOUT        (60000) /* Timeout waiting for the convergence (milliseconds) */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Callback function invoked when node is added
+ * @param cote Cote instance
+ * @param node Node
+ * @param user User data (counter of the instance)
+ * @return Always return NULL
+ */
+static void *added_callback(cote_t *cote, discover_node_t *node, void *user);
+
+/**
+ * @brief Get monotonic time
+ * @return Time in nanoseconds
+ */
+static double get_time_ns(void);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Main function
+ * @param argc Number of arguments
+ * @param argv Arguments (amount of nodes, hello interval)
+ * @return 0 if the function succeeded, 1 otherwise
+ */
+int
+main(int argc, char **argv) {
+
+    int nodes          = (1 < argc) ? atoi(argv[1]) : BENCH_NODES;
+    int hello_interval = (2 < argc) ? atoi(argv[2]) : BENCH_HELLO_INTERVAL;
+    if ((1 >= nodes) || (0 >= hello_interval)) {
+        printf("usage: %s [nodes] [hello interval]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Allocate memory */
+    cote_t **cotes    = (cote_t **)malloc(nodes * sizeof(cote_t *));
+    int *    counters = (int *)malloc(nodes * sizeof(int));
+    if ((NULL == cotes) || (NULL == counters)) {
+        printf("unable to allocate memory\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(counters, 0, nodes * sizeof(int));
+
+    /* Create monitor instances, all of them are sharing the same discovery port */
+    for (int index = 0; index < nodes; index++) {
+        if (NULL == (cotes[index] = cote_create("mon", "bench_discovery"))) {
+            printf("unable to create cote instance\n");
+            exit(EXIT_FAILURE);
+        }
+        if (0 != cote_set_option(cotes[index], "helloInterval", &hello_interval)) {
+            printf("unable to set cote options\n");
+            exit(EXIT_FAILURE);
+        }
+        cote_on(cotes[index], "added", &added_callback, &counters[index]);
+    }
+
+    /* Start all instances and wait until each of them has discovered all the others */
+    double start = get_time_ns();
+    for (int index = 0; index < nodes; index++) {
+        if (0 != cote_start(cotes[index])) {
+            printf("unable to start cote instance\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    int    converged = 0;
+    double now       = get_time_ns();
+    while ((converged < nodes) && (now - start < BENCH_TIMEOUT * 1000000.0)) {
+        usleep(1000);
+        converged = 0;
+        for (int index = 0; index < nodes; index++) {
+            if (nodes - 1 <= __atomic_load_n(&counters[index], __ATOMIC_RELAXED)) {
+                converged++;
+            }
+        }
+        now = get_time_ns();
+    }
+
+    /* Print results */
+    printf("{\"benchmark\":\"discovery\",\"nodes\":%d,\"hello_interval_ms\":%d,\"converged\":%s,\"convergence_ms\":%.1f}\n",
+           nodes,
+           hello_interval,
+           (converged == nodes) ? "true" : "false",
+           (now - start) / 1000000.0);
+
+    /* Release memory */
+    for (int index = 0; index < nodes; index++) {
+        cote_release(cotes[index]);
+    }
+    free(counters);
+    free(cotes);
+
+    return 0;
+}
+
+/**
+ * @brief Callback function invoked when node is added
+ * @param cote Cote instance
+ * @param node Node
+ * @param user User data (counter of the instance)
+ * @return Always return NULL
+ */
+static void *
+added_callback(cote_t *cote, discover_node_t *node, void *user) {
+
+    (void)cote;
+    (void)node;
+
+    /* Count nodes */
+    __atomic_fetch_add((int *)user, 1, __ATOMIC_RELAXED);
+
+    return NULL;
+}
+
+/**
+ * @brief Get monotonic time
+ * @return Time in nanoseconds
+ */
+static double
+get_time_ns(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec * 1000000000.0 + (double)ts.tv_nsec;
+}
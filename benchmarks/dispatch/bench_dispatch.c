@@ -0,0 +1,285 @@
+/**
+ * @file      bench_dispatch.c
+ * @brief     Cote subscription dispatch benchmark in C
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cote.h"
+#include "cote_sub.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define BENCH_MESSAGES   (100000)   /* Amount of messages dispatched for each measure */
+#define BENCH_LIST_TESTS (2000000)  /* Maximum amount of subscription tests for the list walk measure */
+#define BENCH_REGEX_SUBS (100)      /* Amount of subscriptions for the regular expression complexity measure */
+
+/******************************************************************************/
+/* Variables                                                                  */
+/******************************************************************************/
+
+static int matches = 0; /* Amount of subscriptions matching the dispatched topics */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Function invoked for each subscription matching the topic
+ * @param sub Subscription
+ * @param user User data
+ */
+static void match_cb(cote_sub_t *sub, void *user);
+
+/**
+ * @brief Measure dispatch cost of regular expression subscriptions
+ * @param pattern Name of the pattern
+ * @param format Format of the topic of the subscriptions (with the index of the subscription)
+ * @param topics Topics of the messages
+ */
+static void bench_regex(char *pattern, char *format, char **topics);
+
+/**
+ * @brief Get monotonic time
+ * @return Time in nanoseconds
+ */
+static double get_time_ns(void);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Main function
+ * @param argc Number of arguments
+ * @param argv Arguments
+ * @return 0 if the function succeeded, 1 otherwise
+ */
+int
+main(int argc, char **argv) {
+
+    (void)argc;
+    (void)argv;
+
+    int  amounts[] = { 10, 100, 1000, 10000 };
+    char topic[64];
+
+    /* Pre-format topics of the messages */
+    char **topics = (char **)malloc(BENCH_MESSAGES * sizeof(char *));
+    if (NULL == topics) {
+        printf("unable to allocate memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Measure dispatch cost for each amount of subscriptions */
+    for (size_t index_amount = 0; index_amount < sizeof(amounts) / sizeof(int); index_amount++) {
+
+        int amount = amounts[index_amount];
+
+        /* Create subscriptions, half literal and half regular expressions */
+        cote_sub_t **     list  = (cote_sub_t **)malloc(amount * sizeof(cote_sub_t *));
+        cote_sub_table_t *table = cote_sub_table_create();
+        if ((NULL == list) || (NULL == table)) {
+            printf("unable to allocate memory\n");
+            exit(EXIT_FAILURE);
+        }
+        for (int index = 0; index < amount; index++) {
+            if (0 == index % 2) {
+                snprintf(topic, sizeof(topic), "message::ns::topic%d", index);
+            } else {
+                snprintf(topic, sizeof(topic), "message::ns::group%d::.*", index);
+            }
+            cote_sub_table_t *new_table = NULL;
+            if ((NULL == (list[index] = cote_sub_create(topic, NULL, NULL))) || (NULL == (new_table = cote_sub_table_add(table, list[index])))) {
+                printf("unable to create subscription\n");
+                exit(EXIT_FAILURE);
+            }
+            cote_sub_table_release(table);
+            table = new_table;
+        }
+
+        /* Format topics of the messages, topics are matching a literal subscription, a regular expression subscription or nothing */
+        srand(0);
+        for (int index = 0; index < BENCH_MESSAGES; index++) {
+            int value = rand() % amount;
+            if (0 == index % 3) {
+                snprintf(topic, sizeof(topic), "message::ns::unknown%d", value);
+            } else if (0 == value % 2) {
+                snprintf(topic, sizeof(topic), "message::ns::topic%d", value);
+            } else {
+                snprintf(topic, sizeof(topic), "message::ns::group%d::item", value);
+            }
+            if (NULL == (topics[index] = strdup(topic))) {
+                printf("unable to allocate memory\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        /* Measure list walk, each subscription is tested (the amount of messages is limited to keep a reasonable duration) */
+        int list_messages = (BENCH_MESSAGES < BENCH_LIST_TESTS / amount) ? BENCH_MESSAGES : BENCH_LIST_TESTS / amount;
+        matches           = 0;
+        double start      = get_time_ns();
+        for (int index = 0; index < list_messages; index++) {
+            for (int index_sub = 0; index_sub < amount; index_sub++) {
+                if (true == cote_sub_match(list[index_sub], topics[index])) {
+                    match_cb(list[index_sub], NULL);
+                }
+            }
+        }
+        double list_ns      = (get_time_ns() - start) / list_messages;
+        double list_matches = (double)matches / list_messages;
+
+        /* Measure subscription table */
+        matches = 0;
+        start   = get_time_ns();
+        for (int index = 0; index < BENCH_MESSAGES; index++) {
+            cote_sub_table_match(table, topics[index], &match_cb, NULL);
+        }
+        double table_ns      = (get_time_ns() - start) / BENCH_MESSAGES;
+        double table_matches = (double)matches / BENCH_MESSAGES;
+
+        /* Print results */
+        printf("{\"benchmark\":\"dispatch\",\"subscriptions\":%d,\"mode\":\"list\",\"ns_per_message\":%.1f,\"matches_per_message\":%.3f}\n", amount, list_ns, list_matches);
+        printf("{\"benchmark\":\"dispatch\",\"subscriptions\":%d,\"mode\":\"table\",\"ns_per_message\":%.1f,\"matches_per_message\":%.3f}\n", amount, table_ns, table_matches);
+
+        /* Release memory */
+        for (int index = 0; index < BENCH_MESSAGES; index++) {
+            free(topics[index]);
+        }
+        cote_sub_table_release_all(table);
+        free(list);
+    }
+
+    /* Format topics of the messages for the regular expression complexity measure */
+    srand(0);
+    for (int index = 0; index < BENCH_MESSAGES; index++) {
+        snprintf(topic, sizeof(topic), "message::ns::group%d::item", rand() % BENCH_REGEX_SUBS);
+        if (NULL == (topics[index] = strdup(topic))) {
+            printf("unable to allocate memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* Measure dispatch cost versus complexity of the regular expressions */
+    bench_regex("wildcard", "message::ns::group%d::.*", topics);
+    bench_regex("class", "message::ns::[a-z]+%d::[a-z]+", topics);
+    bench_regex("alternation", "message::ns::(group|set|list)%d::(item|entry)", topics);
+    bench_regex("repetition", "message::ns::([a-z]|_)+%d(::[a-z]+)*$", topics);
+
+    /* Release memory */
+    for (int index = 0; index < BENCH_MESSAGES; index++) {
+        free(topics[index]);
+    }
+    free(topics);
+
+    return 0;
+}
+
+/**
+ * @brief Measure dispatch cost of regular expression subscriptions
+ * @param pattern Name of the pattern
+ * @param format Format of the topic of the subscriptions (with the index of the subscription)
+ * @param topics Topics of the messages
+ */
+static void
+bench_regex(char *pattern, char *format, char **topics) {
+
+    char topic[128];
+
+    /* Create subscriptions */
+    cote_sub_table_t *table = cote_sub_table_create();
+    if (NULL == table) {
+        printf("unable to allocate memory\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int index = 0; index < BENCH_REGEX_SUBS; index++) {
+        snprintf(topic, sizeof(topic), format, index);
+        cote_sub_t *      sub       = cote_sub_create(topic, NULL, NULL);
+        cote_sub_table_t *new_table = NULL;
+        if ((NULL == sub) || (NULL == (new_table = cote_sub_table_add(table, sub)))) {
+            printf("unable to create subscription\n");
+            exit(EXIT_FAILURE);
+        }
+        cote_sub_table_release(table);
+        table = new_table;
+    }
+
+    /* Measure subscription table */
+    matches      = 0;
+    double start = get_time_ns();
+    for (int index = 0; index < BENCH_MESSAGES; index++) {
+        cote_sub_table_match(table, topics[index], &match_cb, NULL);
+    }
+    double table_ns      = (get_time_ns() - start) / BENCH_MESSAGES;
+    double table_matches = (double)matches / BENCH_MESSAGES;
+
+    /* Print results */
+    printf("{\"benchmark\":\"dispatch_regex\",\"pattern\":\"%s\",\"subscriptions\":%d,\"ns_per_message\":%.1f,\"matches_per_message\":%.3f}\n",
+           pattern,
+           BENCH_REGEX_SUBS,
+           table_ns,
+           table_matches);
+
+    /* Release memory */
+    cote_sub_table_release_all(table);
+}
+
+/**
+ * @brief Function invoked for each subscription matching the topic
+ * @param sub Subscription
+ * @param user User data
+ */
+static void
+match_cb(cote_sub_t *sub, void *user) {
+
+    (void)sub;
+    (void)user;
+
+    /* Count matches */
+    matches++;
+}
+
+/**
+ * @brief Get monotonic time
+ * @return Time in nanoseconds
+ */
+static double
+get_time_ns(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec * 1000000000.0 + (double)ts.tv_nsec;
+}
@@ -0,0 +1,270 @@
+/**
+ * @file      bench_pubsub.c
+ * @brief     Cote publish/subscribe fan-out benchmark in C
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <cJSON.h>
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define BENCH_MESSAGES    (100000) /* Default amount of messages published */
+#define BENCH_SUBSCRIBERS (4)      /* Default amount of subscribers */
+#define BENCH_SIZE        (64)     /* Default size of the payload of the messages */
+#define BENCH_TIMEOUT     (30000)  /* Timeout waiting for the connections and the messages (milliseconds) */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Create and start a cote instance with the given topics option
+ * @param type Type of Cote instance
+ * @param name Name of Cote instance
+ * @param option Topics option name
+ * @param topic Topic set in the topics option
+ * @return Cote instance if the function succeeded, NULL otherwise
+ */
+static cote_t *bench_create(char *type, char *name, char *option, char *topic);
+
+/**
+ * @brief Callback function invoked when message is received
+ * @param cote Cote instance
+ * @param topic Topic of the message
+ * @param amp AMP message
+ * @param user User data (counter of the subscriber)
+ * @return Always return NULL
+ */
+static amp_msg_t *callback(cote_t *cote, char *topic, amp_msg_t *amp, void *user);
+
+/**
+ * @brief Get monotonic time
+ * @return Time in nanoseconds
+ */
+static double get_time_ns(void);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Main function
+ * @param argc Number of arguments
+ * @param argv Arguments (amount of messages, amount of subscribers, size of the payload)
+ * @return 0 if the function succeeded, 1 otherwise
+ */
+int
+main(int argc, char **argv) {
+
+    int messages    = (1 < argc) ? atoi(argv[1]) : BENCH_MESSAGES;
+    int subscribers = (2 < argc) ? atoi(argv[2]) : BENCH_SUBSCRIBERS;
+    int size        = (3 < argc) ? atoi(argv[3]) : BENCH_SIZE;
+    if ((0 >= messages) || (0 >= subscribers) || (0 >= size)) {
+        printf("usage: %s [messages] [subscribers] [size]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Allocate memory */
+    cote_t **subs     = (cote_t **)malloc(subscribers * sizeof(cote_t *));
+    int *    counters = (int *)malloc(subscribers * sizeof(int));
+    char *   payload  = (char *)malloc(size);
+    if ((NULL == subs) || (NULL == counters) || (NULL == payload)) {
+        printf("unable to allocate memory\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(counters, 0, subscribers * sizeof(int));
+    memset(payload, 0xA5, size);
+
+    /* Create publisher */
+    cote_t *pub = bench_create("pub", "bench_publisher", "broadcasts", "bench");
+    if (NULL == pub) {
+        printf("unable to create publisher\n");
+        exit(EXIT_FAILURE);
+    }
+    cote_topic_t *handle = cote_topic_get(pub, "bench");
+    if (NULL == handle) {
+        printf("unable to get topic handle\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Create subscribers */
+    for (int index = 0; index < subscribers; index++) {
+        if (NULL == (subs[index] = bench_create("sub", "bench_subscriber", "subscribesTo", "bench"))) {
+            printf("unable to create subscriber\n");
+            exit(EXIT_FAILURE);
+        }
+        cote_subscribe(subs[index], "bench", &callback, &counters[index]);
+    }
+
+    /* Publish until all subscribers are connected */
+    double start     = get_time_ns();
+    int    connected = 0;
+    while ((connected < subscribers) && (get_time_ns() - start < BENCH_TIMEOUT * 1000000.0)) {
+        cote_publish(pub, handle, 1, AMP_TYPE_STRING, "warmup");
+        usleep(10000);
+        connected = 0;
+        for (int index = 0; index < subscribers; index++) {
+            if (0 != __atomic_load_n(&counters[index], __ATOMIC_RELAXED)) {
+                connected++;
+            }
+        }
+    }
+    if (connected < subscribers) {
+        printf("unable to connect all subscribers\n");
+        exit(EXIT_FAILURE);
+    }
+    usleep(100000);
+    for (int index = 0; index < subscribers; index++) {
+        __atomic_store_n(&counters[index], 0, __ATOMIC_RELAXED);
+    }
+
+    /* Measure publish */
+    start = get_time_ns();
+    for (int index = 0; index < messages; index++) {
+        cote_publish(pub, handle, 1, AMP_TYPE_BLOB, payload, size);
+    }
+    double sent_ns = get_time_ns() - start;
+
+    /* Wait for the messages to be received */
+    long   received = 0;
+    double now      = get_time_ns();
+    while ((received < (long)messages * subscribers) && (now - start < BENCH_TIMEOUT * 1000000.0)) {
+        usleep(1000);
+        received = 0;
+        for (int index = 0; index < subscribers; index++) {
+            received += __atomic_load_n(&counters[index], __ATOMIC_RELAXED);
+        }
+        now = get_time_ns();
+    }
+    double received_ns = now - start;
+
+    /* Print results */
+    printf("{\"benchmark\":\"pubsub\",\"messages\":%d,\"subscribers\":%d,\"size\":%d,\"sent_per_sec\":%.0f,\"received\":%ld,\"received_per_sec\":%.0f}\n",
+           messages,
+           subscribers,
+           size,
+           messages * 1000000000.0 / sent_ns,
+           received,
+           received * 1000000000.0 / received_ns);
+
+    /* Release memory */
+    for (int index = 0; index < subscribers; index++) {
+        cote_release(subs[index]);
+    }
+    cote_release(pub);
+    free(payload);
+    free(counters);
+    free(subs);
+
+    return 0;
+}
+
+/**
+ * @brief Create and start a cote instance with the given topics option
+ * @param type Type of Cote instance
+ * @param name Name of Cote instance
+ * @param option Topics option name
+ * @param topic Topic set in the topics option
+ * @return Cote instance if the function succeeded, NULL otherwise
+ */
+static cote_t *
+bench_create(char *type, char *name, char *option, char *topic) {
+
+    cote_t *cote;
+
+    /* Create Cote instance */
+    if (NULL == (cote = cote_create(type, name))) {
+        return NULL;
+    }
+
+    /* Set cote options */
+    cJSON *topics = cJSON_CreateArray();
+    if (NULL == topics) {
+        cote_release(cote);
+        return NULL;
+    }
+    cJSON_AddItemToArray(topics, cJSON_CreateString(topic));
+    if (0 != cote_set_option(cote, option, topics)) {
+        cJSON_Delete(topics);
+        cote_release(cote);
+        return NULL;
+    }
+    cJSON_Delete(topics);
+
+    /* Start instance */
+    if (0 != cote_start(cote)) {
+        cote_release(cote);
+        return NULL;
+    }
+
+    return cote;
+}
+
+/**
+ * @brief Callback function invoked when message is received
+ * @param cote Cote instance
+ * @param topic Topic of the message
+ * @param amp AMP message
+ * @param user User data (counter of the subscriber)
+ * @return Always return NULL
+ */
+static amp_msg_t *
+callback(cote_t *cote, char *topic, amp_msg_t *amp, void *user) {
+
+    (void)cote;
+    (void)topic;
+    (void)amp;
+
+    /* Count messages */
+    __atomic_fetch_add((int *)user, 1, __ATOMIC_RELAXED);
+
+    return NULL;
+}
+
+/**
+ * @brief Get monotonic time
+ * @return Time in nanoseconds
+ */
+static double
+get_time_ns(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec * 1000000000.0 + (double)ts.tv_nsec;
+}
@@ -0,0 +1,307 @@
+/**
+ * @file      bench_reqrep.c
+ * @brief     Cote request/reply round-trip latency benchmark in C
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <cJSON.h>
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define BENCH_REQUESTS (10000) /* Default amount of requests */
+#define BENCH_TIMEOUT  (5000)  /* Timeout waiting for each reply (milliseconds) */
+#define BENCH_WARMUP   (30)    /* Maximum amount of attempts waiting for the replier to be connected */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Create and start a cote instance with the given topics option
+ * @param type Type of Cote instance
+ * @param name Name of Cote instance
+ * @param option Topics option name
+ * @param topic Topic set in the topics option
+ * @return Cote instance if the function succeeded, NULL otherwise
+ */
+static cote_t *bench_create(char *type, char *name, char *option, char *topic);
+
+/**
+ * @brief Send a request and wait for the reply
+ * @param cote Cote instance
+ * @param index Index of the request
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int bench_request(cote_t *cote, int index, int timeout);
+
+/**
+ * @brief Callback function invoked when request is received
+ * @param cote Cote instance
+ * @param topic Topic of the message
+ * @param amp AMP message
+ * @param user User data
+ * @return Reply
+ */
+static amp_msg_t *callback(cote_t *cote, char *topic, amp_msg_t *amp, void *user);
+
+/**
+ * @brief Compare two latencies, used to sort the latencies
+ * @param a First latency
+ * @param b Second latency
+ * @return Comparison result
+ */
+static int compare(const void *a, const void *b);
+
+/**
+ * @brief Get monotonic time
+ * @return Time in nanoseconds
+ */
+static double get_time_ns(void);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Main function
+ * @param argc Number of arguments
+ * @param argv Arguments (amount of requests)
+ * @return 0 if the function succeeded, 1 otherwise
+ */
+int
+main(int argc, char **argv) {
+
+    int requests = (1 < argc) ? atoi(argv[1]) : BENCH_REQUESTS;
+    if (0 >= requests) {
+        printf("usage: %s [requests]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Allocate memory */
+    double *latencies = (double *)malloc(requests * sizeof(double));
+    if (NULL == latencies) {
+        printf("unable to allocate memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Create replier and requester */
+    cote_t *rep = bench_create("rep", "bench_replier", "respondsTo", "bench");
+    if (NULL == rep) {
+        printf("unable to create replier\n");
+        exit(EXIT_FAILURE);
+    }
+    cote_subscribe(rep, "bench", &callback, NULL);
+    cote_t *req = bench_create("req", "bench_requester", "requests", "bench");
+    if (NULL == req) {
+        printf("unable to create requester\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Wait for the replier to be connected */
+    int attempt = 0;
+    while ((attempt < BENCH_WARMUP) && (0 != bench_request(req, 0, 1000))) {
+        attempt++;
+    }
+    if (BENCH_WARMUP == attempt) {
+        printf("unable to connect to the replier\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Measure round-trip of each request */
+    int    count  = 0;
+    int    failed = 0;
+    double start  = get_time_ns();
+    for (int index = 0; index < requests; index++) {
+        double t0 = get_time_ns();
+        if (0 == bench_request(req, index, BENCH_TIMEOUT)) {
+            latencies[count++] = (get_time_ns() - t0) / 1000.0;
+        } else {
+            failed++;
+        }
+    }
+    double total_ns = get_time_ns() - start;
+
+    /* Compute percentiles */
+    qsort(latencies, count, sizeof(double), &compare);
+    double mean = 0;
+    for (int index = 0; index < count; index++) {
+        mean += latencies[index];
+    }
+    mean = (0 < count) ? mean / count : 0;
+
+    double p50  = (0 < count) ? latencies[(int)(count * 0.50)] : 0;
+    double p99  = (0 < count) ? latencies[(int)(count * 0.99)] : 0;
+    double p999 = (0 < count) ? latencies[(int)(count * 0.999)] : 0;
+    double max  = (0 < count) ? latencies[count - 1] : 0;
+
+    /* Print results */
+    printf("{\"benchmark\":\"reqrep\",\"requests\":%d,\"failed\":%d,\"requests_per_sec\":%.0f,\"mean_us\":%.1f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"p999_us\":%.1f,\"max_us\":%.1f}\n",
+           requests,
+           failed,
+           count * 1000000000.0 / total_ns,
+           mean,
+           p50,
+           p99,
+           p999,
+           max);
+
+    /* Release memory */
+    cote_release(req);
+    cote_release(rep);
+    free(latencies);
+
+    return 0;
+}
+
+/**
+ * @brief Create and start a cote instance with the given topics option
+ * @param type Type of Cote instance
+ * @param name Name of Cote instance
+ * @param option Topics option name
+ * @param topic Topic set in the topics option
+ * @return Cote instance if the function succeeded, NULL otherwise
+ */
+static cote_t *
+bench_create(char *type, char *name, char *option, char *topic) {
+
+    cote_t *cote;
+
+    /* Create Cote instance */
+    if (NULL == (cote = cote_create(type, name))) {
+        return NULL;
+    }
+
+    /* Set cote options */
+    cJSON *topics = cJSON_CreateArray();
+    if (NULL == topics) {
+        cote_release(cote);
+        return NULL;
+    }
+    cJSON_AddItemToArray(topics, cJSON_CreateString(topic));
+    if (0 != cote_set_option(cote, option, topics)) {
+        cJSON_Delete(topics);
+        cote_release(cote);
+        return NULL;
+    }
+    cJSON_Delete(topics);
+
+    /* Start instance */
+    if (0 != cote_start(cote)) {
+        cote_release(cote);
+        return NULL;
+    }
+
+    return cote;
+}
+
+/**
+ * @brief Send a request and wait for the reply
+ * @param cote Cote instance
+ * @param index Index of the request
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+bench_request(cote_t *cote, int index, int timeout) {
+
+    amp_msg_t *amp = NULL;
+    int        ret = -1;
+
+    /* Send request */
+    cJSON *json = cJSON_CreateObject();
+    if (NULL == json) {
+        return -1;
+    }
+    cJSON_AddNumberToObject(json, "index", index);
+    if (0 == cote_send(cote, "bench", 1, AMP_TYPE_JSON, json, &amp, timeout)) {
+        if (NULL != amp) {
+            amp_release(amp);
+            ret = 0;
+        }
+    }
+    cJSON_Delete(json);
+
+    return ret;
+}
+
+/**
+ * @brief Callback function invoked when request is received
+ * @param cote Cote instance
+ * @param topic Topic of the message
+ * @param amp AMP message
+ * @param user User data
+ * @return Reply
+ */
+static amp_msg_t *
+callback(cote_t *cote, char *topic, amp_msg_t *amp, void *user) {
+
+    (void)topic;
+    (void)amp;
+    (void)user;
+
+    /* Reply */
+    return cote_reply(cote, 1, AMP_TYPE_STRING, "ok");
+}
+
+/**
+ * @brief Compare two latencies, used to sort the latencies
+ * @param a First latency
+ * @param b Second latency
+ * @return Comparison result
+ */
+static int
+compare(const void *a, const void *b) {
+
+    double diff = *((double *)a) - *((double *)b);
+
+    return (0 > diff) ? -1 : ((0 < diff) ? 1 : 0);
+}
+
+/**
+ * @brief Get monotonic time
+ * @return Time in nanoseconds
+ */
+static double
+get_time_ns(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec * 1000000000.0 + (double)ts.tv_nsec;
+}
@@ -223,36 +223,17 @@ display_nodes(cote_t *cote) {
     free(port);
     port = NULL;
 
-    /* Parse nodes of the discover structure iself (a simple way to not invent a new wheel here but not the recommend way because internals of the library may change ! */
-    discover_node_t *tmp = cote->discover->nodes.first;
-    while (NULL != tmp) {
-
-        /* Retrieve and format Name */
-        cJSON *name_json = NULL;
-        if (NULL != tmp->data.advertisement) {
-            name_json = cJSON_GetObjectItemCaseSensitive(tmp->data.advertisement, "name");
-            if (NULL != name_json) {
-                name = cJSON_GetStringValue(name_json);
-            }
-        }
-        name = format_string(name, 20);
-
-        /* Retrieve and format Instance ID */
-        iid = format_string(tmp->iid, 40);
-
-        /* Retrieve and format Address */
-        address = format_string(tmp->address, 18);
-
-        /* Retrieve and format Port */
-        cJSON *port_json   = NULL;
-        int    port_number = 0;
-        if (NULL != tmp->data.advertisement) {
-            port_json = cJSON_GetObjectItemCaseSensitive(tmp->data.advertisement, "port");
-            if (NULL != port_json) {
-                port_number = (int)cJSON_GetNumberValue(port_json);
-            }
-        }
-        port = (0 != port_number) ? format_integer(port_number, 5) : format_string(NULL, 5);
+    /* Retrieve a snapshot of the nodes from the index of the instance */
+    int               count = cote_get_nodes(cote, NULL, NULL, 0);
+    cote_node_info_t *nodes = (0 < count) ? (cote_node_info_t *)malloc(count * sizeof(cote_node_info_t)) : NULL;
+    count                   = (NULL != nodes) ? cote_get_nodes(cote, NULL, nodes, count) : 0;
+    for (int index = 0; index < count; index++) {
+
+        /* Format node data */
+        name    = format_string(nodes[index].name, 20);
+        iid     = format_string(nodes[index].iid, 40);
+        address = format_string(nodes[index].address, 18);
+        port    = (0 != nodes[index].port) ? format_integer(nodes[index].port, 5) : format_string(NULL, 5);
 
         /* Print node data */
         printf("\033[36m%s\033[0m \033[35m%s\033[0m \033[33m%s\033[0m \033[31m%s\033[0m\n", name, iid, address, port);
@@ -266,9 +247,9 @@ display_nodes(cote_t *cote) {
         address = NULL;
         free(port);
         port = NULL;
-
-        /* Next node */
-        tmp = tmp->next;
+    }
+    if (NULL != nodes) {
+        free(nodes);
     }
 
     /* Release semaphore */
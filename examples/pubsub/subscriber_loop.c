@@ -0,0 +1,176 @@
+/**
+ * @file      subscriber_loop.c
+ * @brief     Cote Subscriber example in C, driven by an event loop
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <assert.h>
+#include <signal.h>
+#include <poll.h>
+#include <cJSON.h>
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Variables                                                                  */
+/******************************************************************************/
+
+static bool terminate = false; /* Flag used to terminate the application */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Signal hanlder
+ * @param signo Signal number
+ */
+static void sig_handler(int signo);
+
+/**
+ * @brief Callback function invoked when message is received, invoked by the main thread with cote_process
+ * @param cote Cote instance
+ * @param amp AMP message
+ * @param user User data
+ * @return Always return NULL
+ */
+static amp_msg_t *callback(cote_t *cote, amp_msg_t *amp, void *user);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Main function
+ * @param argc Number of arguments
+ * @param argv Arguments
+ * @return Always returns 0
+ */
+int
+main(int argc, char **argv) {
+
+    cote_t *cote;
+
+    /* Initialize sig handler */
+    signal(SIGINT, sig_handler);
+
+    /* Create Cote "sub" instance */
+    if (NULL == (cote = cote_create("sub", "subscriber"))) {
+        printf("unable to create cote instance\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Set cote options, the messages are processed by the main thread */
+    bool eventLoop = true;
+    if (0 != cote_set_option(cote, "eventLoop", &eventLoop)) {
+        printf("unable to set cote eventLoop option\n");
+        cote_release(cote);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Start instance */
+    if (0 != cote_start(cote)) {
+        printf("unable to start cote instance\n");
+        cote_release(cote);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Definition of message callback */
+    cote_on(cote, "message", &callback, NULL);
+
+    printf("subscriber started\n");
+
+    /* Process the messages when the file descriptor of the instance is readable, other file descriptors of the application may be watched too */
+    struct pollfd fds[1];
+    fds[0].fd     = cote_get_fd(cote);
+    fds[0].events = POLLIN;
+    while (false == terminate) {
+        if ((0 < poll(fds, 1, 1000)) && (0 != (fds[0].revents & POLLIN))) {
+            cote_process(cote, 64);
+        }
+    }
+
+    /* Release memory */
+    cote_release(cote);
+
+    return 0;
+}
+
+/**
+ * @brief Signal hanlder
+ * @param signo Signal number
+ */
+static void
+sig_handler(int signo) {
+
+    /* SIGINT handling */
+    if (SIGINT == signo) {
+        terminate = true;
+    }
+}
+
+/**
+ * @brief Callback function invoked when message is received, invoked by the main thread with cote_process
+ * @param cote Cote instance
+ * @param amp AMP message
+ * @param user User data
+ * @return Always return NULL
+ */
+static amp_msg_t *
+callback(cote_t *cote, amp_msg_t *amp, void *user) {
+
+    (void)cote;
+    assert(NULL != amp);
+    (void)user;
+
+    printf("sub client message received\n");
+
+    /* Parse all fields of the message */
+    amp_field_t *field = amp_get_first(amp);
+    while (NULL != field) {
+
+        /* Print the string and JSON fields */
+        if (AMP_TYPE_STRING == field->type) {
+            printf("%s\n", (char *)field->data);
+        } else if (AMP_TYPE_JSON == field->type) {
+            char *str = cJSON_PrintUnformatted((cJSON *)field->data);
+            printf("%s\n", str);
+            free(str);
+        }
+
+        /* Next field */
+        field = amp_get_next(amp);
+    }
+
+    return NULL;
+}
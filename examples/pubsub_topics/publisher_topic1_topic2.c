@@ -117,6 +117,15 @@ main(int argc, char **argv) {
 
     printf("publisher started\n");
 
+    /* Get topic handles */
+    cote_topic_t *handle1 = cote_topic_get(cote, "topic1");
+    cote_topic_t *handle2 = cote_topic_get(cote, "topic2");
+    if ((NULL == handle1) || (NULL == handle2)) {
+        printf("unable to get topic handles\n");
+        cote_release(cote);
+        exit(EXIT_FAILURE);
+    }
+
     /* Loop */
     while (false == terminate) {
 
@@ -125,13 +134,13 @@ main(int argc, char **argv) {
         /* Sending JSON object topic 1 */
         cJSON *json = cJSON_CreateObject();
         cJSON_AddStringToObject(json, "payload", "the payload of topic 1");
-        cote_send(cote, "topic1", 1, AMP_TYPE_JSON, json);
+        cote_publish(cote, handle1, 1, AMP_TYPE_JSON, json);
         cJSON_Delete(json);
 
         /* Sending JSON object topic 2 */
         json = cJSON_CreateObject();
         cJSON_AddStringToObject(json, "payload", "the payload of topic 2");
-        cote_send(cote, "topic2", 1, AMP_TYPE_JSON, json);
+        cote_publish(cote, handle2, 1, AMP_TYPE_JSON, json);
         cJSON_Delete(json);
 
         /* Wait for a while */
@@ -87,7 +87,10 @@ then using the COTE_API_VISIBILITY flag to "export" the same symbols the way COT
 /******************************************************************************/
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <semaphore.h>
+#include <pthread.h>
+#include <regex.h>
 #include <cJSON.h>
 
 #include "discover.h"
@@ -97,6 +100,12 @@ then using the COTE_API_VISIBILITY flag to "export" the same symbols the way COT
 /* Definitions                                                                */
 /******************************************************************************/
 
+#define COTE_FIELDS_MAX       (8)   /* Maximum amount of fields of a message sent with cote_send_batch, topic excluded */
+#define COTE_STATS_SHARDS     (16)  /* Amount of statistics shards, threads are distributed on the shards */
+#define COTE_STATS_BUCKETS    (40)  /* Amount of buckets of the latency histograms */
+#define COTE_STATS_CACHE_LINE (64)  /* Size of a cache line, each statistics shard is aligned on a cache line */
+#define COTE_NODE_BUCKETS     (256) /* Amount of buckets of the discovered nodes already evaluated, the nodes are searched by instance ID */
+
 /* Cote type */
 typedef enum {
     COTE_TYPE_PUB, /* Publisher (server which is broadcasting data to all its clients) */
@@ -106,36 +115,591 @@ typedef enum {
     COTE_TYPE_MON  /* Monitor (discover configuration only) */
 } cote_enum_e;
 
+/* Cote load balancing of the requests */
+typedef enum {
+    COTE_BALANCING_ROUND_ROBIN,       /* Requests are sent to each replier in turn */
+    COTE_BALANCING_LEAST_OUTSTANDING, /* Requests are sent to the replier with the least pending requests */
+    COTE_BALANCING_POWER_OF_TWO       /* Requests are sent to the best of two repliers chosen randomly, using pending requests and latency */
+} cote_balancing_e;
+
+/* Cote discovery mode */
+typedef enum {
+    COTE_DISCOVERY_DEFAULT, /* Hellos are sent at the hello interval */
+    COTE_DISCOVERY_FAST     /* A burst of hellos is sent at startup, then the interval is doubled until it reaches the hello interval */
+} cote_discovery_e;
+
+/* Cote compression of the large requests and replies */
+typedef enum {
+    COTE_COMPRESSION_NONE, /* Messages are not compressed */
+    COTE_COMPRESSION_LZ4,  /* Messages are compressed with LZ4, for latency */
+    COTE_COMPRESSION_ZSTD  /* Messages are compressed with zstd, for ratio */
+} cote_compression_e;
+
+/* Cote policy of the send queues of the peers when the high water mark is reached */
+typedef enum {
+    COTE_DROP_BLOCK,     /* The publisher waits until the queue has space */
+    COTE_DROP_OLDEST,    /* The oldest message of the queue is dropped */
+    COTE_DROP_NEWEST,    /* The new message is dropped */
+    COTE_DROP_DISCONNECT /* The queued messages are dropped and the peer is disconnected */
+} cote_drop_e;
+
 /* Cote topic subscription */
 struct cote_s;
 typedef struct cote_sub_s {
-    struct cote_sub_s *next;                                         /* Next subscription */
+    struct cote_sub_s *next;                                         /* Next subscription (chaining of the subscriptions released with a subscription table) */
     char *             topic;                                        /* Topic of the subscription */
+    bool               literal;                                      /* Topic has no regular expression metacharacter, matched by the same topic only */
+    regex_t            regex;                                        /* Compiled regular expression of the topic (not used if the topic is literal) */
     amp_msg_t *(*fct)(struct cote_s *, char *, amp_msg_t *, void *); /* Callback function invoked when topic is received */
     void *user;                                                      /* User data passed to the callback */
 } cote_sub_t;
 
+/* Cote topic subscription trie node, regular expressions matched from the start of the topic are stored under their leading literal "::" segments */
+typedef struct cote_sub_node_s {
+    struct cote_sub_node_s * next;        /* Next node (chaining of the nodes released with a subscription table) */
+    char *                   segment;     /* Segment of the topic, NULL for the root node */
+    size_t                   len;         /* Length of the segment */
+    struct cote_sub_node_s **children;    /* Children nodes sorted by segment */
+    int                      nb_children; /* Amount of children nodes */
+    cote_sub_t **            subs;        /* Regular expression subscriptions stored on this node */
+    int                      nb_subs;     /* Amount of subscriptions stored on this node */
+} cote_sub_node_t;
+
+/* Cote topic subscription table, tables are never modified once built, each change creates a new table sharing the unchanged content */
+typedef struct cote_sub_table_s {
+    struct cote_sub_table_s *next;    /* Next table (chaining of the tables replaced and waiting to be released) */
+    unsigned int             epoch;   /* Epoch at which the table has been replaced */
+    unsigned int             version; /* Version of the table, incremented by each change */
+    cote_sub_t **            exact;   /* Literal subscriptions hash table (open addressing) */
+    size_t                   size;    /* Size of the hash table (power of 2) */
+    int                      count;   /* Amount of literal subscriptions */
+    cote_sub_node_t *        root;    /* Regular expression subscriptions trie */
+    struct {
+        cote_sub_t **    exact; /* Hash table replaced by the next table */
+        cote_sub_t *     subs;  /* Subscriptions replaced or removed by the next table */
+        cote_sub_node_t *nodes; /* Nodes replaced or removed by the next table */
+    } garbage;
+} cote_sub_table_t;
+
+/* Cote topic subscriptions, the current table is read without lock and the replaced tables are released once their readers have left */
+typedef struct {
+    cote_sub_table_t *table;      /* Current subscription table (atomic access) */
+    unsigned int      epoch;      /* Current epoch (atomic access) */
+    unsigned int      readers[2]; /* Amount of readers entered during even and odd epochs (atomic access) */
+    cote_sub_table_t *retired;    /* Replaced tables waiting to be released, oldest first */
+    sem_t             sem;        /* Semaphore used to serialize subscription changes */
+} cote_subs_t;
+
+/* Cote topic handle, the full topic is formatted once and updated when the namespace is changed */
+typedef struct cote_topic_s {
+    struct cote_topic_s *next;      /* Next topic handle */
+    char *               topic;     /* Topic */
+    char *               fulltopic; /* Full topic used to send messages (atomic access) */
+    int                  id;        /* Topic ID sent instead of the full topic to the subscribers decoding topic IDs */
+    struct {
+        char **fulltopics; /* Full topics replaced when the namespace has been changed, released with the handle */
+        int    count;      /* Amount of replaced full topics */
+    } garbage;
+} cote_topic_t;
+
+/* Cote message field */
+typedef struct {
+    amp_type_e type; /* Type of the field */
+    void *     data; /* Data of the field (pointer to an int64_t value for AMP_TYPE_BIGINT) */
+    int        size; /* Size of the data (AMP_TYPE_BLOB only) */
+} cote_field_t;
+
+/* Cote message */
+typedef struct {
+    cote_topic_t *topic;  /* Topic handle of the message */
+    cote_field_t *fields; /* Fields of the message */
+    int           count;  /* Amount of fields (up to COTE_FIELDS_MAX) */
+} cote_msg_t;
+
+/* Cote statistics, the bucket i of the histograms counts the durations in range [2^i, 2^(i+1)[ nanoseconds */
+typedef struct {
+    uint64_t messages_in;                   /* Amount of messages received */
+    uint64_t messages_out;                  /* Amount of messages sent */
+    uint64_t send_errors;                   /* Amount of messages which can not be sent */
+    uint64_t matches;                       /* Amount of subscription callbacks invoked */
+    uint64_t unmatched;                     /* Amount of messages received without matching subscription (dropped) */
+    uint64_t messages_dropped;              /* Amount of messages received and dropped because they can not be queued (eventLoop, dispatchThreads) */
+    uint64_t requests_failed;               /* Amount of requests failed or timed out (Requester instance only) */
+    uint64_t requests_hedged;               /* Amount of duplicate requests sent to a second replier (Requester instance only) */
+    uint64_t requests_expired;              /* Amount of requests dropped because their deadline (Replier) or their timeout while queued (Requester) expired */
+    uint64_t sem_contended;                 /* Amount of semaphore waits which have blocked */
+    uint64_t sem_wait_ns;                   /* Time spent waiting the semaphores (nanoseconds) */
+    uint64_t dispatch_ns;                   /* Time spent dispatching the received messages (nanoseconds, statsHistograms only) */
+    uint64_t callbacks[COTE_STATS_BUCKETS]; /* Histogram of the subscription callbacks execution time (statsHistograms only) */
+    uint64_t requests[COTE_STATS_BUCKETS];  /* Histogram of the requests round-trip time (statsHistograms only) */
+} cote_stats_t;
+
+/* Cote statistics shard, counters are updated with relaxed atomic operations */
+typedef struct {
+    cote_stats_t stats; /* Statistics of the shard */
+} __attribute__((aligned(COTE_STATS_CACHE_LINE))) cote_stats_shard_t;
+
+/* Cote asynchronous request */
+typedef struct cote_request_s {
+    struct cote_request_s *next;                        /* Next request in the queue */
+    char *                 topic;                       /* Topic of the request */
+    cJSON *                payload;                     /* Payload of the request, released once sent */
+    int                    timeout;                     /* Timeout waiting for the reply (milliseconds) */
+    uint64_t               expiry;                      /* Time at which the timeout expires, the time spent in the queue is included (nanoseconds) */
+    void *(*fct)(struct cote_s *, amp_msg_t *, void *); /* Callback function invoked with the reply (NULL if the request failed) */
+    void *user;                                         /* User data passed to the callback */
+} cote_request_t;
+
+/* Cote asynchronous requests, queued requests are sent by a pool of threads */
+typedef struct {
+    cote_request_t *first;       /* First request of the queue */
+    cote_request_t *last;        /* Last request of the queue */
+    int             count;       /* Amount of queued requests */
+    int             max_queued;  /* Maximum amount of queued requests, the requests are rejected beyond */
+    int             max_threads; /* Maximum amount of threads sending the requests */
+    pthread_t *     threads;     /* Threads sending the requests, created when a request is queued while all the threads are busy */
+    int             nb_threads;  /* Amount of threads created */
+    int             waiting;     /* Amount of threads waiting for a request */
+    bool            terminate;   /* Flag used to terminate the threads */
+    sem_t           pending;     /* Semaphore counting the queued requests */
+    sem_t           sem;         /* Semaphore used to protect the queue */
+} cote_requests_t;
+
+/* Cote hedged request, shared by the caller and the attempts of the request, released with the last reference */
+typedef struct {
+    amp_type_e type;     /* Type of the payload, AMP_TYPE_JSON or AMP_TYPE_STRING */
+    char *     text;     /* JSON text of the payload, serialized once and shared so that the attempts can complete after the caller has returned */
+    int64_t    deadline; /* Deadline of the request, 0 if no deadline is attached */
+    amp_msg_t *resp;     /* First reply received */
+    bool       finished; /* Flag set when the caller does not wait for the replies anymore */
+    int        refs;     /* References to the request */
+    sem_t      done;     /* Semaphore posted each time an attempt is completed */
+    sem_t      sem;      /* Semaphore used to protect the request */
+} cote_hedge_call_t;
+
+/* Cote hedged attempt, a request sent to a replier by one of the hedging threads */
+struct cote_peer_s;
+typedef struct cote_hedge_attempt_s {
+    struct cote_hedge_attempt_s *next;    /* Next attempt in the queue */
+    struct cote_s *              cote;    /* Cote instance */
+    cote_hedge_call_t *          call;    /* Hedged request */
+    struct cote_peer_s *         peer;    /* Peer the request is sent to, entered by the caller */
+    int                          timeout; /* Timeout waiting for the reply (milliseconds) */
+} cote_hedge_attempt_t;
+
+/* Cote hedging, the attempts are sent by a pool of threads so that the caller takes the first reply and abandons the other attempt */
+typedef struct {
+    int                   inflight;    /* Amount of attempts reserved or in flight */
+    cote_hedge_attempt_t *first;       /* First attempt waiting for a thread */
+    cote_hedge_attempt_t *last;        /* Last attempt waiting for a thread */
+    int                   queued;      /* Amount of attempts waiting for a thread */
+    int                   waiting;     /* Amount of threads waiting for an attempt */
+    pthread_t *           threads;     /* Threads sending the attempts, created when all the threads are busy */
+    int                   max_threads; /* Maximum amount of threads, the maximum amount of attempts in flight */
+    int                   nb_threads;  /* Amount of threads created */
+    bool                  terminate;   /* Flag set when the instance is released, no attempt is reserved anymore */
+    sem_t                 pending;     /* Semaphore counting the queued attempts */
+    sem_t                 idle;        /* Semaphore posted by each attempt completed once terminating */
+    sem_t                 sem;         /* Semaphore used to protect the attempts */
+    int (*fct)(struct cote_s *, struct cote_peer_s *, amp_type_e, char *, int64_t, amp_msg_t **, int); /* Function invoked to send an attempt */
+} cote_hedge_t;
+
+/* Cote dispatch job, the fields of a received message waiting to be dispatched */
+typedef struct cote_job_s {
+    struct cote_job_s *next;  /* Next job in the queue */
+    amp_field_t *      first; /* First field of the message */
+    amp_field_t *      last;  /* Last field of the message */
+    int                count; /* Amount of fields */
+} cote_job_t;
+
+/* Cote dispatch worker */
+struct cote_pool_s;
+typedef struct {
+    struct cote_pool_s *pool;    /* Dispatch pool of the worker */
+    cote_job_t *        first;   /* First job of the queue */
+    cote_job_t *        last;    /* Last job of the queue */
+    cote_job_t *        cache;   /* Jobs already dispatched, reused to queue the next messages */
+    int                 cached;  /* Amount of jobs in the cache */
+    pthread_t           thread;  /* Thread of the worker */
+    sem_t               pending; /* Semaphore counting the queued jobs */
+    sem_t               sem;     /* Semaphore used to protect the queue */
+} cote_worker_t;
+
+/* Cote dispatch pool, each worker has its own queue */
+typedef struct cote_pool_s {
+    struct cote_s *cote;                       /* Cote instance */
+    void (*fct)(struct cote_s *, amp_msg_t *); /* Function invoked to dispatch a message */
+    cote_worker_t *workers;                    /* Workers */
+    int            nb_workers;                 /* Amount of workers */
+    bool           terminate;                  /* Flag used to terminate the workers */
+} cote_pool_t;
+
+/* Cote publisher shards, the topics are distributed on several axon instances bound to their own port */
+typedef struct {
+    axon_t ** axons;  /* Axon instances of the shards, the first one is the axon instance of the Publisher instance */
+    uint16_t *ports;  /* Ports of the shards, 0 until the shard is bound */
+    int       count;  /* Amount of shards, 0 if the Publisher instance is not sharded */
+    int       bound;  /* Amount of shards bound */
+    int       legacy; /* Amount of discovered subscribers connecting only to the first shard, all the topics are sent by the first shard meanwhile */
+} cote_shards_t;
+
+/* Cote message kept for replay, the message is encoded as a frame after the structure in the same allocation */
+typedef struct {
+    uint32_t length; /* Size of the frame */
+    size_t   size;   /* Size of the allocation, reused by the next messages of the topic if large enough */
+} cote_replay_msg_t;
+
+/* Cote topic kept for replay, the ring of its most recent messages is allocated with the topic */
+typedef struct cote_replay_topic_s {
+    struct cote_replay_topic_s *next;  /* Next topic of the bucket */
+    struct cote_replay_topic_s *older; /* Topic published less recently */
+    struct cote_replay_topic_s *newer; /* Topic published more recently */
+    char *                      topic; /* Topic */
+    cote_replay_msg_t **        msgs;  /* Ring of the most recent messages */
+    int                         first; /* Index of the oldest message of the ring */
+    int                         count; /* Amount of messages of the ring */
+} cote_replay_topic_t;
+
+/* Cote replay of the most recent messages of each topic to the subscribers joining a Publisher instance */
+typedef struct {
+    cote_replay_topic_t **topics; /* Buckets of the topics */
+    cote_replay_topic_t * oldest; /* Topic published the least recently, evicted first */
+    cote_replay_topic_t * newest; /* Topic published the most recently */
+    int                   count;  /* Amount of topics */
+    int                   depth;  /* Amount of messages kept per topic, 0 if replay is disabled */
+    sem_t                 sem;    /* Semaphore used to protect the topics */
+} cote_replay_t;
+
+/* Cote snapshot of the messages kept for replay, the frames are copied so that they are sent without holding the semaphore of the replay */
+typedef struct {
+    uint8_t *buffer;  /* Frames of the messages, followed by their topics */
+    size_t * offsets; /* Offsets of the frames in the buffer, the last entry is the size of the frames */
+    char **  topics;  /* Topics of the messages, in the buffer */
+    int      count;   /* Amount of messages */
+} cote_replay_snapshot_t;
+
+/* Cote startup probing, the hello interval of the discover instance is increased on an exponential schedule, protected by the options semaphore */
+typedef struct {
+    pthread_t thread;    /* Thread increasing the hello interval */
+    bool      started;   /* Flag set when the thread is started */
+    bool      terminate; /* Flag set to terminate the thread */
+    int       interval;  /* Current hello interval of the schedule (milliseconds), 0 once the hello interval option is reached */
+    bool      answer;    /* Flag set when a single fast hello answers a probing node, the hello interval option is restored after it */
+    sem_t     wakeup;    /* Semaphore posted when the schedule is changed or to terminate the thread */
+} cote_probe_t;
+
+/* Cote event, a received message or a completed asynchronous request waiting to be processed by cote_process, stored in a slot of the ring */
+typedef struct {
+    size_t          seq;     /* Sequence number of the slot, the event is written when it is the position of the slot and ready once incremented */
+    amp_msg_t *     amp;     /* AMP message, or reply of the request (NULL if the request failed) */
+    cote_request_t *request; /* Completed asynchronous request, NULL for a received message */
+} cote_event_t;
+
+/* Cote event loop, the events are pushed by the library threads without lock to a bounded ring and processed by the thread calling cote_process */
+typedef struct {
+    cote_event_t *events;                         /* Ring of the events, allocated when the event loop is started */
+    size_t        size;                           /* Size of the ring (power of 2) */
+    size_t        head;                           /* Position of the next event to be processed, accessed only by the thread calling cote_process */
+    size_t        tail;                           /* Position of the next event to be pushed by the library threads */
+    bool          signaled;                       /* Flag set once the event file descriptor is written, cleared by cote_process */
+    bool          closing;                        /* Flag set when the instance is released, the replies do not wait for space in the ring anymore */
+    int           waiting;                        /* Amount of threads waiting for space in the ring */
+    sem_t         space;                          /* Semaphore posted when an event is processed while threads are waiting for space */
+    void (*fct)(struct cote_s *, cote_event_t *); /* Function invoked to process an event */
+    int           fd;                             /* Event file descriptor, readable when events are waiting, -1 if the event loop is not used */
+} cote_loop_t;
+
+/* Cote discovered node, the result of the topics matching is kept until the node is removed, advertises other topics or the local topics are changed */
+typedef struct cote_node_s {
+    struct cote_node_s *next;    /* Next node of the bucket */
+    char *              iid;     /* Instance ID of the node */
+    cJSON *             topics;  /* Copy of the broadcasts/respondsTo array the result has been computed for, NULL if the node advertises none */
+    bool                match;   /* Topics advertised by the node are matching the local topics */
+    bool                pending; /* The node is matching since the topics have changed, or was deferred, and must be connected */
+    uint64_t            seen;    /* Time the node has been evaluated first, used to defer the TCP connection to shared memory publishers (nanoseconds) */
+} cote_node_t;
+
+/* Cote shared memory ring buffer, placed at the beginning of the shared memory and followed by the data */
+typedef struct {
+    uint32_t        magic;   /* Magic number, set once the ring buffer is initialized */
+    uint32_t        size;    /* Size of the data of the ring buffer */
+    uint64_t        head;    /* Position of the next frame written (amount of bytes written since creation) */
+    uint64_t        tail;    /* Position of the next frame read (amount of bytes read since creation) */
+    pthread_mutex_t lock;    /* Robust mutex shared between the processes used to serialize the writers, recovered if a writer dies holding it */
+    sem_t           frames;  /* Semaphore shared between the processes counting the frames to be read */
+    int             waiting; /* Amount of writers waiting for space */
+    sem_t           space;   /* Semaphore shared between the processes posted when a frame is read while writers are waiting for space */
+} cote_shm_ring_t;
+
+/* Cote publisher writing to a shared memory, the subscriber waits for the publisher to be attached before connecting to it with TCP */
+typedef struct cote_shm_attached_s {
+    struct cote_shm_attached_s *next;     /* Next publisher */
+    char *                      id;       /* Identifier of the publisher, as announced in its advertisement */
+    char *                      iid;      /* Instance ID of the publisher, NULL until the publisher is discovered */
+    bool                        attached; /* Flag set when the frame announcing the publisher has been read */
+} cote_shm_attached_t;
+
+/* Cote frame, message encoded in a contiguous buffer for the shared memory transport and the batches, the data of the fields is not copied */
+typedef struct {
+    void *   data[COTE_FIELDS_MAX + 1];  /* Data of the topic and of the fields */
+    uint32_t sizes[COTE_FIELDS_MAX + 1]; /* Size of the data of the topic and of the fields */
+    uint8_t  types[COTE_FIELDS_MAX + 1]; /* Type of the topic and of the fields */
+    char *   texts[COTE_FIELDS_MAX + 1]; /* Serialized JSON fields, NULL for the other fields */
+    int      count;                      /* Amount of fields, topic included */
+    uint32_t size;                       /* Size of the encoded frame */
+} cote_frame_t;
+
+/* Cote shared memory transport */
+typedef struct cote_shm_s {
+    char *               name;            /* Name of the shared memory */
+    cote_shm_ring_t *    ring;            /* Ring buffer */
+    size_t               length;          /* Length of the shared memory */
+    bool                 owner;           /* The shared memory has been created by this instance which reads the frames */
+    pthread_t            thread;          /* Thread reading the frames (owner only) */
+    bool                 terminate;       /* Flag used to terminate the thread */
+    bool                 stalled;         /* A writer has not found space in time, the next writers do not wait until a frame is written (writer only) */
+    cote_shm_attached_t *attached;        /* Publishers writing or about to write to the shared memory (owner only) */
+    sem_t                sem;             /* Semaphore used to protect the publishers attached (owner only) */
+    void (*fct)(amp_msg_t *, void *);     /* Function invoked with each message read */
+    void *user;                           /* User data passed to the function */
+} cote_shm_t;
+
+/* Cote queued message, shared by the send queues of the peers, the topic and the data of the fields are stored in the same allocation */
+typedef struct {
+    int          refs;                     /* References to the message, released with the last one */
+    char *       fulltopic;                /* Full topic of the message */
+    cote_field_t fields[COTE_FIELDS_MAX];  /* Fields of the message */
+    int64_t      bigints[COTE_FIELDS_MAX]; /* Values of the AMP_TYPE_BIGINT fields */
+    int          count;                    /* Amount of fields */
+} cote_queue_msg_t;
+
+/* Cote send queue of a peer, the messages are sent by a dedicated thread so that a slow node does not block the publisher */
+typedef struct cote_queue_s {
+    cote_queue_msg_t **msgs;                           /* Queued messages, circular buffer of size entries */
+    int                first;                          /* Index of the first queued message */
+    int                count;                          /* Amount of queued messages */
+    int                size;                           /* Maximum amount of queued messages (high water mark) */
+    cote_drop_e        policy;                         /* Policy when the high water mark is reached */
+    uint64_t           sent;                           /* Amount of messages sent */
+    uint64_t           dropped;                        /* Amount of messages dropped */
+    bool               closed;                         /* Flag set when the queue is closed (COTE_DROP_DISCONNECT), new messages are dropped */
+    bool               terminate;                      /* Flag used to terminate the thread */
+    pthread_t          thread;                         /* Thread sending the messages */
+    sem_t              sem;                            /* Semaphore used to protect the queue */
+    sem_t              items;                          /* Semaphore counting the queued messages */
+    sem_t              space;                          /* Semaphore counting the free places of the queue (COTE_DROP_BLOCK) */
+    int (*fct)(axon_t *, char *, cote_field_t *, int); /* Function invoked to send a message */
+    axon_t *axon;                                      /* Axon instance the messages are sent to */
+} cote_queue_t;
+
+/* Cote corked messages of a Publisher instance, sent at once when the delay expires or when the size of their frames is reached */
+typedef struct {
+    cote_msg_t *       msgs;      /* Corked messages, their fields are the ones of the copies */
+    cote_frame_t *     frames;    /* Frames of the corked messages, prepared once when the messages are corked */
+    cote_queue_msg_t **copies;    /* Copies of the corked messages */
+    int                count;     /* Amount of corked messages */
+    int                size;      /* Size of the arrays of corked messages */
+    size_t             bytes;     /* Size of the frames of the corked messages */
+    int                delay;     /* Maximum delay before the corked messages are sent (milliseconds), 0 to disable (atomic access) */
+    int                max_bytes; /* Size of the frames from which the corked messages are sent at once */
+    bool               started;   /* Flag set once the thread sending the corked messages is created */
+    bool               terminate; /* Flag used to terminate the thread */
+    pthread_t          thread;    /* Thread sending the corked messages once the delay has expired */
+    sem_t              pending;   /* Semaphore posted when a message is corked while no message was corked */
+    sem_t              wakeup;    /* Semaphore posted to terminate the thread before the delay has expired */
+    sem_t              flush;     /* Semaphore taken while sending the corked messages, so that they are sent in order */
+    sem_t              sem;       /* Semaphore used to protect the corked messages */
+    int (*fct)(struct cote_s *, cote_msg_t *, cote_frame_t *, int); /* Function invoked to send the corked messages */
+} cote_cork_t;
+
+/* Cote topic defined by a publisher, with the subscriptions matching it, shared by the topic table and the dispatches in progress */
+typedef struct {
+    int           refs;      /* References to the topic, released with the last one */
+    bool          matched;   /* Flag set when the subscriptions matching the topic have been searched */
+    unsigned int  version;   /* Version of the subscription table the subscriptions have been searched in */
+    char *        fulltopic; /* Full topic */
+    cote_sub_t ** subs;      /* Subscriptions matching the full topic */
+    int           nb_subs;   /* Amount of subscriptions matching the full topic */
+} cote_ids_topic_t;
+
+/* Cote topic table of a publisher, built by a Subscriber instance from the topic definitions received */
+typedef struct cote_ids_table_s {
+    struct cote_ids_table_s *next;   /* Next topic table */
+    char *                   owner;  /* Identifier of the publisher, as announced in its advertisement */
+    uint64_t                 tag;    /* Tag of the publisher topic table */
+    cote_ids_topic_t **      topics; /* Topics indexed by topic ID, NULL if the ID is not defined */
+    int                      count;  /* Size of the topics array */
+} cote_ids_table_t;
+
+/* Cote topic IDs */
+typedef struct {
+    cote_ids_table_t *first;     /* Topic tables of the publishers (Subscriber instance), released when the publisher is removed */
+    char              owner[32]; /* Identifier of the topic tables of the instance (Publisher instance) */
+    uint64_t          tag;       /* Tag of the topic table (Publisher instance), changed when the full topics are changed */
+    int               count;     /* Amount of topic IDs assigned to the topic handles (Publisher instance) */
+    sem_t             sem;       /* Semaphore used to protect topic IDs */
+} cote_ids_t;
+
+/* Cote peer statistics */
+typedef struct {
+    char     iid[64];      /* Instance ID of the node (truncated if too long) */
+    char     address[256]; /* Address (or hostname, or name of the shared memory) of the node (truncated if too long) */
+    uint16_t port;         /* Port of the node */
+    int      queued;       /* Amount of messages waiting in the send queue */
+    uint64_t sent;         /* Amount of messages sent from the send queue */
+    uint64_t dropped;      /* Amount of messages dropped by the send queue */
+} cote_peer_stats_t;
+
+/* Cote node information, copied from the advertisement of a discovered node */
+typedef struct {
+    char     iid[64];        /* Instance ID of the node (truncated if too long) */
+    char     name[64];       /* Name of the node (truncated if too long), empty if not advertised */
+    char     address[256];   /* Address of the node (truncated if too long) */
+    char     hostname[256];  /* Hostname of the node (truncated if too long) */
+    uint16_t port;           /* Port of the node, 0 if not advertised */
+    char     axon_type[16];  /* Axon type of the node ("pub-emitter", "sub-emitter", "req" or "rep"), empty if not advertised */
+    char     namespace_[64]; /* Namespace of the node (truncated if too long), empty if not advertised */
+} cote_node_info_t;
+
+/* Cote node of the index */
+typedef struct cote_index_node_s {
+    struct cote_index_node_s *next;     /* Next node of the bucket */
+    char *                    iid;      /* Instance ID of the node */
+    cote_node_info_t          info;     /* Information of the node */
+    char **                   topics;   /* Topics advertised by the node, the subscribesTo/requests topics first */
+    int                       count;    /* Amount of topics */
+    int                       patterns; /* Amount of subscribesTo/requests topics, which are regular expressions */
+    unsigned int              query;    /* Last query the node has been retrieved by, a node matching several topics is retrieved once */
+} cote_index_node_t;
+
+/* Cote topic of the index */
+typedef struct cote_index_topic_s {
+    struct cote_index_topic_s *next;    /* Next topic of the bucket */
+    struct cote_index_topic_s *pattern; /* Next topic of the regular expressions list */
+    char *                     topic;   /* Topic */
+    regex_t *                  regex;   /* Compiled regular expression of the topic, NULL if the topic is literal */
+    cote_index_node_t **       nodes;   /* Nodes advertising the topic */
+    int                        count;   /* Amount of nodes */
+    int                        size;    /* Size of the nodes array */
+} cote_index_topic_t;
+
+/* Cote index of the discovered nodes by topic, updated when nodes are added or removed (Monitor and Requester instances) */
+typedef struct {
+    cote_index_node_t ** nodes;    /* Buckets of the nodes, by instance ID */
+    cote_index_topic_t **topics;   /* Buckets of the topics */
+    cote_index_topic_t * patterns; /* Topics which are regular expressions, evaluated with the topic of each query */
+    int                  count;    /* Amount of nodes */
+    unsigned int         query;    /* Index of the last query */
+    sem_t                sem;      /* Semaphore used to protect the index */
+} cote_index_t;
+
+/* Cote topic filter of a peer */
+typedef struct cote_peer_filter_s {
+    struct cote_peer_filter_s *next;   /* Filter replaced by this one, kept until the peer is released because it may still be used to send a message */
+    cJSON *                    topics; /* Topics advertised by the node, NULL if all the topics are sent to the node */
+    regex_t *                  regex;  /* Compiled regular expressions of the topics sent to the node */
+    int                        count;  /* Amount of compiled regular expressions */
+} cote_peer_filter_t;
+
+/* Cote peer, connection to a discovered publisher/replier instance (Subscriber and Requester instances), or to a subscriber instance (Publisher instance with selective fan-out) */
+typedef struct cote_peer_s {
+    struct cote_peer_s *next;    /* Next peer */
+    char *              iid;     /* Instance ID of the node */
+    char *              address; /* Address (or hostname) of the node */
+    uint16_t            port;    /* Port of the node */
+    axon_t *            axon;    /* Axon instance connected to the node, NULL if the shared memory transport is used */
+    cote_shm_t *        shm;     /* Shared memory of the node (Publisher instance with shared memory transport), NULL if axon is used */
+    cote_queue_t *      queue;   /* Send queue of the peer (Publisher instance with highWaterMark), NULL if the messages are sent directly */
+    int                 refs;    /* References to the peer, the axon instance is released with the last one */
+    int                 pending; /* Amount of requests waiting for a reply */
+    uint64_t            latency; /* Moving average of the response time (nanoseconds), 0 if no response has been received yet */
+    bool                removed; /* Flag set when the node has been removed, the peer is not used anymore */
+    uint32_t            caps;    /* Capabilities of the node announced in its advertisement (COTE_PEER_CAP_*) */
+    sem_t               sem;     /* Semaphore used to serialize the messages sent with topic IDs, the peers semaphore is not held while sending */
+    struct {
+        uint64_t tag;     /* Tag of the topic table the definitions have been sent for */
+        uint8_t *defined; /* Topic IDs already defined to the node, one bit per topic ID */
+        int      size;    /* Size of the defined array */
+    } ids;
+    cote_peer_filter_t *filter;  /* Topics sent to the node, replaced when the node advertises new topics (atomic access) */
+} cote_peer_t;
+
+/* Cote peers */
+typedef struct cote_peers_s {
+    cote_peer_t *    first;     /* Peers */
+    cote_peer_t *    next;      /* Next peer to be used to send a request */
+    int              count;     /* Amount of peers */
+    cote_balancing_e balancing; /* Load balancing of the requests */
+    sem_t            sem;       /* Semaphore used to protect peers */
+} cote_peers_t;
+
 /* Cote instance */
 typedef struct cote_s {
     cote_enum_e type; /* Cote instance type */
     char *      name; /* Name of the instance */
     uint16_t    port; /* Port of axon instance */
     struct {
-        char * namespace_;    /* Namespace used to format message topics */
-        bool   use_hostname;  /* Use hostname instead of address to connect to the other nodes */
-        cJSON *advertisement; /* The initial advertisement which is sent with each hello packet */
-        cJSON *broadcasts;    /* Publisher broadcast string array */
-        cJSON *subscribesTo;  /* Subscriber subscribe string array */
-        cJSON *requests;      /* Requester request string array */
-        cJSON *respondsTo;    /* Replier respond string array */
-        sem_t  sem;           /* Semaphore used to protect options */
+        char *      namespace_;      /* Namespace used to format message topics */
+        bool        use_hostname;    /* Use hostname instead of address to connect to the other nodes */
+        cJSON *     advertisement;   /* The initial advertisement which is sent with each hello packet */
+        cJSON *     broadcasts;      /* Publisher broadcast string array */
+        cJSON *     subscribesTo;    /* Subscriber subscribe string array */
+        cJSON *     requests;        /* Requester request string array */
+        cJSON *     respondsTo;      /* Replier respond string array */
+        cJSON *     advertised;      /* Last advertisement given to discover instance, released when it is replaced */
+        bool        dirty;           /* An option of the advertisement has changed since it has been given to discover instance */
+        int         dispatchThreads; /* Amount of threads dispatching the received messages to the subscriptions (Subscriber instance only) */
+        bool        eventLoop;       /* Messages and asynchronous replies are processed by cote_process instead of the library threads */
+        bool        statsHistograms; /* Measure dispatch time, callbacks execution and requests round-trip times */
+        bool        selectiveFanout; /* Publisher connects to the subscribers and sends them only the messages matching their subscribesTo topics */
+        bool        sharedMemory;    /* Publisher writes the messages to the shared memory of the subscribers running on the same host */
+        int         highWaterMark;   /* Maximum amount of messages queued for each peer of a Publisher instance, 0 to send directly */
+        cote_drop_e dropPolicy;      /* Policy of the send queues when the high water mark is reached */
+        bool        topicIds;        /* Topics are sent as numeric IDs between publishers and subscribers with selective fan-out supporting them */
+        int         shards;          /* Amount of axon instances of a Publisher instance, each topic is always sent by the same one, 1 to disable */
+        int         replay;          /* Amount of recent messages of each topic replayed to the joining subscribers with selective fan-out, 0 to disable */
+        bool        deadline;        /* Absolute deadline attached to the requests of the repliers enforcing it, which drop the expired requests */
+        int         maxRepliers;     /* Maximum amount of repliers a Requester instance is connected to, 0 for no limit */
+        struct {
+            cote_discovery_e mode;          /* Discovery mode */
+            int              helloInterval; /* Interval between the hellos once started (milliseconds) */
+        } discovery;
+        struct {
+            cote_compression_e algorithm; /* Compression of the requests and replies exchanged with the nodes supporting it */
+            int                threshold; /* Minimum size of the JSON text of a message to be compressed (bytes) */
+        } compression;
+        struct {
+            int delay;      /* Delay before a duplicate request is sent to a second replier (milliseconds), 0 to disable */
+            int percentile; /* Percentile of the requests round-trip time used as delay once measured (statsHistograms only), 0 to disable */
+            int threads;    /* Maximum amount of attempts in flight and of threads sending them, the requests are not hedged beyond */
+        } hedge;
+        struct {
+            regex_t *regex; /* Compiled subscribesTo/requests regular expressions */
+            int      count; /* Amount of compiled regular expressions */
+        } patterns;
+        cote_node_t *nodes[COTE_NODE_BUCKETS]; /* Discovered nodes already evaluated, by hash of their instance ID */
+        sem_t  sem;             /* Semaphore used to protect options */
     } options;
-    discover_t *discover; /* Discover instance */
-    axon_t *    axon;     /* Axon instance */
+    discover_t * discover; /* Discover instance */
+    axon_t *     axon;     /* Axon instance (Publisher and Replier instances, Subscriber instance with selective fan-out) */
+    cote_peers_t peers;    /* Connections to the discovered nodes (Subscriber and Requester instances, Publisher instance with selective fan-out) */
+    cote_subs_t  subs;     /* Topic subscriptions */
     struct {
-        cote_sub_t *first; /* Topic subscription daisy chain */
-        sem_t       sem;   /* Semaphore used to protect daisy chain */
-    } subs;
+        cote_topic_t *first; /* Topic handles, released with the Cote instance */
+        sem_t         sem;   /* Semaphore used to protect topic handles */
+    } topics;
+    cote_ids_t          ids;      /* Topic IDs */
+    cote_requests_t     requests; /* Asynchronous requests */
+    cote_pool_t         pool;     /* Dispatch threads */
+    cote_loop_t         loop;     /* Event loop (Subscriber and Requester instances with eventLoop) */
+    cote_probe_t        probe;    /* Startup probing (fast discovery mode) */
+    cote_index_t        index;    /* Index of the discovered nodes by topic (Monitor and Requester instances) */
+    cote_hedge_t        hedge;    /* Hedged requests (Requester instance) */
+    cote_shards_t       shards;   /* Axon instances of the shards (Publisher instance with shards) */
+    cote_replay_t       replay;   /* Recent messages replayed to the joining subscribers (Publisher instance with replay) */
+    cote_cork_t         cork;     /* Corked messages (Publisher instance with corkDelay) */
+    cote_shm_t *        shm;      /* Shared memory transport (Subscriber instance with shared memory transport) */
+    cote_stats_shard_t *stats;    /* Statistics shards (COTE_STATS_SHARDS) */
     struct {
         struct {
             amp_msg_t *(*fct)(struct cote_s *, amp_msg_t *, void *); /* Callback function invoked when message is received */
@@ -177,6 +741,15 @@ COTE_PUBLIC(cote_t *) cote_create(char *type, char *name);
  */
 COTE_PUBLIC(int) cote_set_option(cote_t *cote, char *option, void *value);
 
+/**
+ * @brief Set several cote options, the advertisement is updated once
+ * @param cote Cote instance
+ * @param count Amount of options
+ * @param ... option, value Array of option by name and new value of the option
+ * @return 0 if the function succeeded, -1 if at least one option has not been set
+ */
+COTE_PUBLIC(int) cote_set_options(cote_t *cote, int count, ...);
+
 /**
  * @brief Start Cote instance
  * @param cote Cote instance
@@ -230,6 +803,168 @@ COTE_PUBLIC(int) cote_unsubscribe(cote_t *cote, char *topic);
  */
 COTE_PUBLIC(int) cote_send(cote_t *cote, char *topic, int count, ...);
 
+/**
+ * @brief Function used by Requester instance to send a request without waiting for the reply
+ * @param cote Cote instance
+ * @param topic Topic of the request
+ * @param payload JSON payload of the request, owned and released by Cote instance
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @param fct Callback function invoked with the reply, or with NULL if the request failed, the reply is released once the callback returns
+ * @param user User data
+ * @return 0 if the request is queued, -1 otherwise (payload is released)
+ */
+COTE_PUBLIC(int) cote_send_async(cote_t *cote, char *topic, cJSON *payload, int timeout, void *fct, void *user);
+
+/**
+ * @brief Function used to get a topic handle (Publisher instances only), the handle is valid until the Cote instance is released
+ * @param cote Cote instance
+ * @param topic Topic of the messages
+ * @return Topic handle if the function succeeded, NULL otherwise
+ */
+COTE_PUBLIC(cote_topic_t *) cote_topic_get(cote_t *cote, char *topic);
+
+/**
+ * @brief Function used to send data to all connected subscribers using a topic handle, no memory is allocated and no lock is taken to format the topic
+ * @param cote Cote instance
+ * @param topic Topic handle of the message
+ * @param count Amount of data to be sent
+ * @param ... type, data Array of type and data (and size for blob type) to be sent
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+COTE_PUBLIC(int) cote_publish(cote_t *cote, cote_topic_t *topic, int count, ...);
+
+/**
+ * @brief Function used to send several messages to all connected subscribers (Publisher instances only)
+ * @param cote Cote instance
+ * @param msgs Messages to be sent
+ * @param count Amount of messages
+ * @return 0 if the function succeeded, -1 if at least one message has not been sent
+ */
+COTE_PUBLIC(int) cote_send_batch(cote_t *cote, cote_msg_t *msgs, int count);
+
+/**
+ * @brief Function used to send the corked messages at once without waiting for the delay (Publisher instances with corkDelay only)
+ * @param cote Cote instance
+ * @return 0 if the function succeeded, -1 if at least one message has not been sent
+ */
+COTE_PUBLIC(int) cote_flush(cote_t *cote);
+
+/**
+ * @brief Function used to send a message from an array of fields to all connected subscribers using a topic handle (Publisher instances only)
+ * @param cote Cote instance
+ * @param topic Topic handle of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to 2, more fields are rejected)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+COTE_PUBLIC(int) cote_publish_fields(cote_t *cote, cote_topic_t *topic, cote_field_t *fields, int count);
+
+/**
+ * @brief Function used to send a JSON message to all connected subscribers using a topic handle (Publisher instances only)
+ * @param cote Cote instance
+ * @param topic Topic handle of the message
+ * @param json JSON data
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static inline int
+cote_publish_json(cote_t *cote, cote_topic_t *topic, cJSON *json) {
+    cote_field_t field = { AMP_TYPE_JSON, json, 0 };
+    return cote_publish_fields(cote, topic, &field, 1);
+}
+
+/**
+ * @brief Function used to send a blob message to all connected subscribers using a topic handle (Publisher instances only)
+ * @param cote Cote instance
+ * @param topic Topic handle of the message
+ * @param data Blob data
+ * @param size Size of the blob data
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static inline int
+cote_publish_blob(cote_t *cote, cote_topic_t *topic, void *data, int size) {
+    cote_field_t field = { AMP_TYPE_BLOB, data, size };
+    return cote_publish_fields(cote, topic, &field, 1);
+}
+
+/**
+ * @brief Function used to send a string and blob message to all connected subscribers using a topic handle (Publisher instances only)
+ * @param cote Cote instance
+ * @param topic Topic handle of the message
+ * @param str String data
+ * @param data Blob data
+ * @param size Size of the blob data
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static inline int
+cote_publish_string_blob(cote_t *cote, cote_topic_t *topic, char *str, void *data, int size) {
+    cote_field_t fields[2] = { { AMP_TYPE_STRING, str, 0 }, { AMP_TYPE_BLOB, data, size } };
+    return cote_publish_fields(cote, topic, fields, 2);
+}
+
+/**
+ * @brief Function used to send a request and wait for the reply (Requester instances only)
+ * @param cote Cote instance
+ * @param topic Topic of the request
+ * @param payload JSON payload of the request, not modified, its "type" member is replaced by the topic
+ * @param resp AMP response message
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+COTE_PUBLIC(int) cote_request(cote_t *cote, char *topic, cJSON *payload, amp_msg_t **resp, int timeout);
+
+/**
+ * @brief Get the fields of a received message as an array of cote_field_t, only the array is filled, the fields have been decoded when the message was received
+ * The fields point to the data of the message and are only valid while the message is valid (during the callback the message is given to)
+ * @param amp AMP message
+ * @param fields Fields filled with the data of the message
+ * @param max Maximum amount of fields
+ * @return Amount of fields filled
+ */
+COTE_PUBLIC(int) cote_get_fields(amp_msg_t *amp, cote_field_t *fields, int max);
+
+/**
+ * @brief Get statistics of the instance, counters of all the shards are summed
+ * @param cote Cote instance
+ * @param stats Statistics
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+COTE_PUBLIC(int) cote_get_stats(cote_t *cote, cote_stats_t *stats);
+
+/**
+ * @brief Get statistics of the peers of the instance, including the counters of their send queues
+ * @param cote Cote instance
+ * @param stats Array of peer statistics
+ * @param max Size of the array
+ * @return Amount of peer statistics set if the function succeeded, -1 otherwise
+ */
+COTE_PUBLIC(int) cote_get_peer_stats(cote_t *cote, cote_peer_stats_t *stats, int max);
+
+/**
+ * @brief Get a snapshot of the discovered nodes advertising a topic in their broadcasts, subscribesTo, requests or respondsTo arrays (Monitor and Requester instances)
+ * @param cote Cote instance
+ * @param topic Topic as advertised by the nodes or matching the regular expressions they advertise, NULL to get all the discovered nodes
+ * @param nodes Array of node information, NULL to get the amount of nodes only
+ * @param max Size of the array
+ * @return Amount of node information set, or amount of nodes if nodes is NULL, if the function succeeded, -1 otherwise
+ */
+COTE_PUBLIC(int) cote_get_nodes(cote_t *cote, char *topic, cote_node_info_t *nodes, int max);
+
+/**
+ * @brief Get the event file descriptor of an instance started with the eventLoop option, to be watched with poll/epoll by the application
+ * The file descriptor is readable when events are waiting to be processed with cote_process
+ * @param cote Cote instance
+ * @return File descriptor if the function succeeded, -1 otherwise
+ */
+COTE_PUBLIC(int) cote_get_fd(cote_t *cote);
+
+/**
+ * @brief Process the events of an instance started with the eventLoop option, the callbacks are invoked by the calling thread
+ * @param cote Cote instance
+ * @param budget Maximum amount of events to be processed, 0 to process all the waiting events
+ * @return Amount of events processed if the function succeeded, -1 otherwise
+ */
+COTE_PUBLIC(int) cote_process(cote_t *cote, int budget);
+
 /**
  * @brief Function used by Replier instance to format response to the server or to a single client
  * @param cote Cote instance
@@ -41,6 +41,116 @@
 #include <time.h>
 
 #include "cote.h"
+#include "cote_sub.h"
+#include "cote_async.h"
+#include "cote_stats.h"
+#include "cote_pool.h"
+#include "cote_peer.h"
+#include "cote_json.h"
+#include "cote_shm.h"
+#include "cote_frame.h"
+#include "cote_queue.h"
+#include "cote_ids.h"
+#include "cote_compress.h"
+#include "cote_loop.h"
+#include "cote_probe.h"
+#include "cote_index.h"
+#include "cote_hedge.h"
+#include "cote_shard.h"
+#include "cote_replay.h"
+#include "cote_cork.h"
+#include "cote_hash.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+/* Maximum attempts to send a request, the request is sent again to another replier only if the replier has been removed while waiting for the reply */
+#define COTE_REQUEST_ATTEMPTS (2)
+
+/* Member of the requests holding their deadline, namespaced so that it does not collide with the members of the payloads */
+#define COTE_DEADLINE_KEY "__cote_deadline"
+
+/* Maximum amount of fields of a message encoded by axon from an array of fields, topic excluded, axon expects the fields as variable arguments */
+#define COTE_AXON_FIELDS_MAX (2)
+
+/* Topic of a batch of messages sent by a Publisher instance to the subscribers decoding them, followed by the frames of the messages as a blob */
+#define COTE_BATCH_TOPIC "__cote_batch"
+
+/* Arguments of axon_send for a message field */
+#define COTE_FIELD_ARGS_BLOB(field)   AMP_TYPE_BLOB, (field)->data, (field)->size
+#define COTE_FIELD_ARGS_STRING(field) AMP_TYPE_STRING, (char *)(field)->data
+#define COTE_FIELD_ARGS_BIGINT(field) AMP_TYPE_BIGINT, *((int64_t *)(field)->data)
+#define COTE_FIELD_ARGS_JSON(field)   AMP_TYPE_JSON, (cJSON *)(field)->data
+
+/* Send a message with the arguments of the topic given as variable arguments followed by the arguments of its last field */
+#define COTE_AXON_SEND_LAST(ret, axon, count, field, ...)                                                      \
+    switch ((field)->type) {                                                                                   \
+        case AMP_TYPE_BLOB: ret = axon_send(axon, count, __VA_ARGS__, COTE_FIELD_ARGS_BLOB(field)); break;     \
+        case AMP_TYPE_STRING: ret = axon_send(axon, count, __VA_ARGS__, COTE_FIELD_ARGS_STRING(field)); break; \
+        case AMP_TYPE_BIGINT: ret = axon_send(axon, count, __VA_ARGS__, COTE_FIELD_ARGS_BIGINT(field)); break; \
+        case AMP_TYPE_JSON: ret = axon_send(axon, count, __VA_ARGS__, COTE_FIELD_ARGS_JSON(field)); break;     \
+        default: ret = -1; break;                                                                              \
+    }
+
+/* Send a message of two fields with the arguments of the topic given as variable arguments */
+#define COTE_AXON_SEND_FIRST(ret, axon, count, first, last, ...)                                                              \
+    switch ((first)->type) {                                                                                                  \
+        case AMP_TYPE_BLOB: COTE_AXON_SEND_LAST(ret, axon, count, last, __VA_ARGS__, COTE_FIELD_ARGS_BLOB(first)); break;     \
+        case AMP_TYPE_STRING: COTE_AXON_SEND_LAST(ret, axon, count, last, __VA_ARGS__, COTE_FIELD_ARGS_STRING(first)); break; \
+        case AMP_TYPE_BIGINT: COTE_AXON_SEND_LAST(ret, axon, count, last, __VA_ARGS__, COTE_FIELD_ARGS_BIGINT(first)); break; \
+        case AMP_TYPE_JSON: COTE_AXON_SEND_LAST(ret, axon, count, last, __VA_ARGS__, COTE_FIELD_ARGS_JSON(first)); break;     \
+        default: ret = -1; break;                                                                                             \
+    }
+
+/* Send a message of up to COTE_AXON_FIELDS_MAX fields with the arguments of the topic given as variable arguments, ret is -1 otherwise */
+#define COTE_AXON_SEND_FIELDS(ret, axon, fields, count, ...)                                        \
+    switch (count) {                                                                                \
+        case 0: ret = axon_send(axon, 1, __VA_ARGS__); break;                                       \
+        case 1: COTE_AXON_SEND_LAST(ret, axon, 2, &(fields)[0], __VA_ARGS__); break;                \
+        case 2: COTE_AXON_SEND_FIRST(ret, axon, 3, &(fields)[0], &(fields)[1], __VA_ARGS__); break; \
+        default: ret = -1; break;                                                                   \
+    }
+
+/* Message sent by a Publisher instance, to the axon instance and to the peers with selective fan-out */
+typedef struct {
+    char *            fulltopic; /* Full topic of the message */
+    int               count;     /* Amount of data to be sent */
+    va_list *         params;    /* type, data Array of type and data (and size for blob type), NULL if fields are used */
+    cote_field_t *    fields;    /* Fields of the message */
+    int               id;        /* Topic ID of the message, -1 if the topic has no ID */
+    int64_t           key;       /* Key of the topic sent to the peers decoding topic IDs, -1 if the full topic is sent */
+    char *            owner;     /* Owner of the topic table, sent with the definitions of the topic IDs */
+    cote_queue_msg_t *queued;    /* Copy of the message shared by the send queues of the peers, created with the first queued message */
+} cote_fanout_t;
+
+/* Messages sent by a Publisher instance with cote_send_batch, the peers decoding batches receive the frames of the messages at once */
+typedef struct {
+    cote_msg_t *   msgs;    /* Messages */
+    int            count;   /* Amount of messages */
+    cote_fanout_t *fanouts; /* Messages sent one by one to the axon instance and to the peers not decoding batches */
+    int *          status;  /* Result of each message, -1 if it has not been sent to the instances interested in it */
+    size_t *       offsets; /* Positions of the frames of the messages in the buffer, the frame of a message ends where the next one starts */
+    uint8_t *      buffer;  /* Frames of all the messages, the frame of a message which can not be encoded is empty */
+    uint8_t *      scratch; /* Frames of the messages a peer is interested in, allocated with the first peer not interested in all the messages */
+} cote_batch_t;
+
+/* Recent messages of a Publisher instance replayed to a node which has just been added */
+typedef struct {
+    cote_t *                cote;     /* Cote instance */
+    cote_replay_snapshot_t *snapshot; /* Copy of the messages kept */
+} cote_replay_node_t;
+
+/* Subscription dispatch context */
+typedef struct {
+    cote_t *   cote;    /* Cote instance */
+    char *     topic;   /* Topic given to the subscription callbacks */
+    amp_msg_t *amp;     /* AMP message */
+    amp_msg_t *ret;     /* Reply of the last subscription callback invoked */
+    int        matches; /* Amount of subscription callbacks invoked */
+    bool       raw;     /* The first field of the AMP message is a JSON text, parsed when the first subscription is matching */
+    bool       invalid; /* The first field of the AMP message is not a valid JSON object, the subscription callbacks are not invoked */
+} cote_dispatch_t;
 
 /******************************************************************************/
 /* Prototypes                                                                 */
@@ -63,6 +173,68 @@ static void cote_axon_bind_cb(axon_t *axon, uint16_t port, void *user);
  */
 static amp_msg_t *cote_axon_message_cb(axon_t *axon, amp_msg_t *amp, void *user);
 
+/**
+ * @brief Callback function invoked when a message is read from the shared memory
+ * @param amp AMP message
+ * @param user User data
+ */
+static void cote_shm_message_cb(amp_msg_t *amp, void *user);
+
+/**
+ * @brief Dispatch a message received by a Subscriber instance to the subscriptions matching its topic
+ * @param cote Cote instance
+ * @param amp AMP message, the topic field is released
+ */
+static void cote_axon_dispatch_sub(cote_t *cote, amp_msg_t *amp);
+
+/**
+ * @brief Dispatch a request received by a Replier instance to the subscriptions matching its topic
+ * @param cote Cote instance
+ * @param amp AMP message
+ * @return Reply to the request
+ */
+static amp_msg_t *cote_axon_dispatch_rep(cote_t *cote, amp_msg_t *amp);
+
+/**
+ * @brief Process an event of the event loop, invoked by the thread calling cote_process
+ * @param cote Cote instance
+ * @param event Event, its AMP message and its request are released by the function
+ */
+static void cote_loop_event_cb(cote_t *cote, cote_event_t *event);
+
+/**
+ * @brief Retrieve the full topic of a received message from its first field, a string or a topic ID defined by the publisher
+ * @param cote Cote instance
+ * @param field First field of the message
+ * @param table Subscription table used to dispatch the message, NULL if the subscriptions matching a topic ID are not required
+ * @param id Topic of the topic ID, to be released with cote_ids_put, NULL if the field is not a topic ID
+ * @return Full topic, NULL if the field is not a topic
+ */
+static char *cote_axon_get_fulltopic(cote_t *cote, amp_field_t *field, cote_sub_table_t *table, cote_ids_topic_t **id);
+
+/**
+ * @brief Function invoked for each subscription matching the topic of a received message
+ * @param sub Subscription
+ * @param user Dispatch context
+ */
+static void cote_axon_dispatch_cb(cote_sub_t *sub, void *user);
+
+/**
+ * @brief Parse the JSON text of the first field of a request, the field is replaced by the JSON object without the "type" member
+ * @param cote Cote instance
+ * @param amp AMP message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_parse_request(cote_t *cote, amp_msg_t *amp);
+
+/**
+ * @brief Check the deadline of a request (Replier instance with requestDeadline), the deadline member is removed from the JSON payload
+ * @param cote Cote instance
+ * @param field First field of the request
+ * @return true if the deadline of the request has expired, false otherwise
+ */
+static bool cote_axon_is_expired(cote_t *cote, amp_field_t *field);
+
 /**
  * @brief Callback function called to handle error from Axon instance
  * @param axon Axon instance
@@ -71,6 +243,71 @@ static amp_msg_t *cote_axon_message_cb(axon_t *axon, amp_msg_t *amp, void *user)
  */
 static void cote_axon_error_cb(axon_t *axon, char *err, void *user);
 
+/**
+ * @brief Send a request to the replier chosen by the load balancing (Requester instance)
+ * @param cote Cote instance
+ * @param type Type of the payload, AMP_TYPE_JSON or AMP_TYPE_STRING
+ * @param data Payload of the request
+ * @param resp AMP response message
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_request(cote_t *cote, amp_type_e type, void *data, amp_msg_t **resp, int timeout);
+
+/**
+ * @brief Send a request to a replier, the JSON text of the request is framed and compressed if the replier supports compression
+ * @param cote Cote instance
+ * @param peer Peer of the replier
+ * @param type Type of the payload, AMP_TYPE_JSON or AMP_TYPE_STRING
+ * @param data Payload of the request
+ * @param deadline Deadline of the request, attached only if the replier enforces it, 0 if no deadline is attached
+ * @param text JSON text of the request, formatted for the first replier supporting compression (to be released by the caller if the payload is a JSON)
+ * @param resp AMP response message
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_request_peer(cote_t *cote, cote_peer_t *peer, amp_type_e type, void *data, int64_t deadline, char **text, amp_msg_t **resp, int timeout);
+
+/**
+ * @brief Create the envelope of a request, the members of the payload are referenced and not copied, the payload is not modified
+ * @param payload JSON payload of the request
+ * @param topic Topic of the request, replacing the "type" member of the payload, NULL to keep the members of the payload
+ * @param deadline Deadline of the request, 0 if no deadline is attached
+ * @return Envelope object if the function succeeded (to be released by the caller before the payload), NULL otherwise
+ */
+static cJSON *cote_axon_envelope(cJSON *payload, char *topic, int64_t deadline);
+
+/**
+ * @brief Function invoked by the attempts of the hedged requests to send a request to a replier
+ * The JSON text is sent as is to the c-cote repliers, it is parsed only for the other repliers which expect a JSON payload
+ * @param cote Cote instance
+ * @param peer Peer of the replier
+ * @param type Type of the payload, AMP_TYPE_JSON or AMP_TYPE_STRING
+ * @param text JSON text of the payload, shared by the attempts
+ * @param deadline Deadline of the request, attached only if the replier enforces it, 0 if no deadline is attached
+ * @param resp AMP response message
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_request_hedge_cb(cote_t *cote, cote_peer_t *peer, amp_type_e type, char *text, int64_t deadline, amp_msg_t **resp, int timeout);
+
+/**
+ * @brief Get the absolute deadline of a request, the real time is used so that the deadline can be compared by repliers running on other hosts
+ * @param cote Cote instance
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return Deadline as milliseconds since the Epoch, 0 if no deadline is attached to the request
+ */
+static int64_t cote_axon_deadline(cote_t *cote, int timeout);
+
+/**
+ * @brief Create an axon instance connected to a discovered node (Subscriber and Requester instances, Publisher instance with selective fan-out)
+ * @param cote Cote instance
+ * @param address Address (or hostname) of the node
+ * @param port Port of the node
+ * @return Axon instance if the function succeeded, NULL otherwise
+ */
+static axon_t *cote_axon_connect(cote_t *cote, char *address, uint16_t port);
+
 /**
  * @brief Format fulltopic
  * @param cote Cote instance
@@ -79,6 +316,191 @@ static void cote_axon_error_cb(axon_t *axon, char *err, void *user);
  */
 static char *cote_axon_format_fulltopic(cote_t *cote, char *topic);
 
+/**
+ * @brief Send a message of a Publisher instance to the axon instance and to the peers interested in the topic
+ * @param cote Cote instance
+ * @param topic Topic of the message
+ * @param fanout Message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_publish(cote_t *cote, char *topic, cote_fanout_t *fanout);
+
+/**
+ * @brief Cork a message of a Publisher instance, it is sent with the other corked messages once the delay expires or the size of their frames is reached
+ * @param cote Cote instance
+ * @param topic Topic handle of the message
+ * @param fanout Message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_cork(cote_t *cote, cote_topic_t *topic, cote_fanout_t *fanout);
+
+/**
+ * @brief Keep a message of a Publisher instance for replay and send it to the axon instance (or the shard of the topic), the peers are not considered
+ * @param cote Cote instance
+ * @param topic Topic of the message
+ * @param fanout Message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_publish_axon(cote_t *cote, char *topic, cote_fanout_t *fanout);
+
+/**
+ * @brief Send several messages of a Publisher instance, the peers decoding batches receive the frames of the messages at once
+ * @param cote Cote instance
+ * @param msgs Messages
+ * @param frames Frames of the messages already prepared, NULL to prepare them
+ * @param count Amount of messages
+ * @return 0 if the function succeeded, -1 if at least one message has not been sent
+ */
+static int cote_axon_send_batch(cote_t *cote, cote_msg_t *msgs, cote_frame_t *frames, int count);
+
+/**
+ * @brief Encode a batch of messages of a Publisher instance, the frames of all the messages are written in a single buffer
+ * @param batch Batch
+ * @param msgs Messages
+ * @param frames Frames of the messages already prepared, NULL to prepare them
+ * @param count Amount of messages
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_batch_create(cote_batch_t *batch, cote_msg_t *msgs, cote_frame_t *frames, int count);
+
+/**
+ * @brief Send a batch of messages of a Publisher instance to a peer, in a single message if the peer decodes batches, one by one otherwise
+ * @param peer Peer
+ * @param user Batch
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_batch_peer(cote_peer_t *peer, void *user);
+
+/**
+ * @brief Send the messages of a batch one by one to a peer
+ * @param peer Peer
+ * @param batch Batch
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_batch_peer_each(cote_peer_t *peer, cote_batch_t *batch);
+
+/**
+ * @brief Release a batch of messages
+ * @param batch Batch
+ */
+static void cote_axon_batch_release(cote_batch_t *batch);
+
+/**
+ * @brief Dispatch the messages of a batch received by a Subscriber instance, each message is handled as if it had been received alone
+ * @param cote Cote instance
+ * @param frames Frames of the messages
+ * @param size Size of the frames
+ */
+static void cote_axon_dispatch_batch(cote_t *cote, uint8_t *frames, size_t size);
+
+/**
+ * @brief Send a message of a Publisher instance to an axon instance
+ * @param axon Axon instance
+ * @param user Message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_publish_cb(axon_t *axon, void *user);
+
+/**
+ * @brief Convert the params of a message of a Publisher instance to an array of fields
+ * @param fanout Message
+ * @param fields Array of fields (COTE_FIELDS_MAX), the data of the fields point to the params
+ * @param bigints Values of the AMP_TYPE_BIGINT fields (COTE_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise (too many fields)
+ */
+static int cote_axon_publish_fields(cote_fanout_t *fanout, cote_field_t *fields, int64_t *bigints);
+
+/**
+ * @brief Queue a message of a Publisher instance to the send queue of a peer, the message is copied once for all the peers
+ * @param peer Peer
+ * @param fanout Message
+ * @param fields Fields of the message
+ * @return 0 if the function succeeded (the message is queued), -1 if the message has been dropped
+ */
+static int cote_axon_publish_queue(cote_peer_t *peer, cote_fanout_t *fanout, cote_field_t *fields);
+
+/**
+ * @brief Send the messages kept for replay to a peer of the node which has just been added, the frames are sent as they have been kept
+ * The peers decoding batches receive them in a single batch, the shared memory receives them as is, they are decoded for the other peers
+ * @param peer Peer
+ * @param user Node
+ * @return 0 if the function succeeded, -1 if at least one message has not been sent
+ */
+static int cote_axon_replay_peer(cote_peer_t *peer, void *user);
+
+/**
+ * @brief Send a message kept for replay to a peer not decoding the frames, the frame is decoded to the fields of the message
+ * @param peer Peer
+ * @param frame Frame of the message, size of the frame included
+ * @param size Size of the frame
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_replay_decode(cote_peer_t *peer, uint8_t *frame, size_t size);
+
+/**
+ * @brief Send a message of a Publisher instance to a peer, using its axon instance, its send queue or its shared memory
+ * @param peer Peer
+ * @param user Message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_publish_peer(cote_peer_t *peer, void *user);
+
+/**
+ * @brief Send a message to axon instance from an array of fields, the topic is given by its full topic or by its key
+ * @param axon Axon instance
+ * @param fulltopic Full topic of the message
+ * @param key Key of the topic, the full topic is sent if it is negative
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_AXON_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_send_fields(axon_t *axon, char *fulltopic, int64_t key, cote_field_t *fields, int count);
+
+/**
+ * @brief Send a queued message to the axon instance of a subscriber from an array of fields, the full topic is sent
+ * @param axon Axon instance
+ * @param fulltopic Full topic of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_AXON_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_send_fields_queue(axon_t *axon, char *fulltopic, cote_field_t *fields, int count);
+
+/**
+ * @brief Send a message to the axon instance of a subscriber decoding batches from an array of fields
+ * The message is sent in a batch of one frame if it has more fields than axon can encode from an array
+ * @param axon Axon instance
+ * @param fulltopic Full topic of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_send_fields_batch(axon_t *axon, char *fulltopic, cote_field_t *fields, int count);
+
+/**
+ * @brief Send a message of a Publisher instance to a peer decoding topic IDs, the topic is defined to the peer with its first message
+ * @param peer Peer
+ * @param fanout Message
+ * @param fields Fields of the message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_axon_publish_id(cote_peer_t *peer, cote_fanout_t *fanout, cote_field_t *fields);
+
+/**
+ * @brief Set cote option, the options semaphore must be taken by the caller
+ * @param cote Cote instance
+ * @param option Option by name
+ * @param value New value of the option
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_option_set(cote_t *cote, char *option, void *value);
+
+/**
+ * @brief Update full topic of the topic handles, called when the namespace has been changed
+ * @param cote Cote instance
+ */
+static void cote_topics_update(cote_t *cote);
+
 /**
  * @brief Callback function invoked when a discovery node instance is added
  * @param discover Discover instance
@@ -95,6 +517,14 @@ static void cote_discovery_added_cb(discover_t *discover, discover_node_t *node,
  */
 static void cote_discovery_removed_cb(discover_t *discover, discover_node_t *node, void *user);
 
+/**
+ * @brief Callback function invoked when a hello is received from a discovery node instance
+ * @param discover Discover instance
+ * @param node Node
+ * @param user User data
+ */
+static void cote_discovery_hello_cb(discover_t *discover, discover_node_t *node, void *user);
+
 /**
  * @brief Callback function called to handle error from Axon instance
  * @param discover Discover instance
@@ -104,11 +534,12 @@ static void cote_discovery_removed_cb(discover_t *discover, discover_node_t *nod
 static void cote_discovery_error_cb(discover_t *discover, char *err, void *user);
 
 /**
- * @brief Function used to set Discovery instance advertisement
+ * @brief Function used to set Discovery instance advertisement, it is built again only if one of its inputs has changed
  * @param cote Cote instance
+ * @param changed The port, the shards or the shared memory of the instance have changed, the options are checked otherwise
  * @return 0 if the function succeeded, -1 otherwise
  */
-static int cote_discovery_set_advertisement(cote_t *cote);
+static int cote_discovery_set_advertisement(cote_t *cote, bool changed);
 
 /**
  * @brief Function used to check discovery callback node
@@ -118,6 +549,124 @@ static int cote_discovery_set_advertisement(cote_t *cote);
  */
 static int cote_discovery_check_node(cote_t *cote, discover_node_t *node);
 
+/**
+ * @brief Function used to connect to a discovered node if required (Subscriber and Requester instances, Publisher instance with selective fan-out or shared memory)
+ * @param cote Cote instance
+ * @param node Node
+ * @return 0 if the function succeeded (node is connected or does not need to be), -1 otherwise (node is ignored)
+ */
+static int cote_discovery_connect_node(cote_t *cote, discover_node_t *node);
+
+/**
+ * @brief Function used to connect a Publisher instance to the shared memory of a discovered node
+ * @param cote Cote instance
+ * @param node Node
+ * @param name Name of the shared memory of the node
+ * @return 0 if the function succeeded, -1 otherwise (node is ignored)
+ */
+static int cote_discovery_connect_shm(cote_t *cote, discover_node_t *node, char *name);
+
+/**
+ * @brief Function used to connect a Subscriber instance to the other shards of a discovered publisher, the options semaphore must be taken by the caller
+ * @param cote Cote instance
+ * @param node Node
+ * @param address Address (or hostname) of the node
+ * @param port Port of the first shard, already connected
+ * @param caps Capabilities of the node
+ * @return 0 if the function succeeded, -1 if at least one shard is not connected
+ */
+static int cote_discovery_connect_shards(cote_t *cote, discover_node_t *node, char *address, uint16_t port, uint32_t caps);
+
+/**
+ * @brief Function used to replay the recent messages of a Publisher instance to a node just added, the replay semaphore is not held
+ * @param cote Cote instance
+ * @param iid Instance ID of the node
+ * @param snapshot Copy of the messages kept taken when the peer has been added, it is released
+ * @return 0 if the function succeeded, -1 if at least one message has not been sent
+ */
+static int cote_discovery_replay(cote_t *cote, char *iid, cote_replay_snapshot_t *snapshot);
+
+/**
+ * @brief Check if a discovered node can share memory with the instance, it announces the same host token in its advertisement
+ * @param node Node
+ * @return true if the node is running on the same host, false otherwise
+ */
+static bool cote_discovery_is_local(discover_node_t *node);
+
+/**
+ * @brief Format the identifier of a Publisher instance announced to the subscribers sharing memory with it
+ * @param cote Cote instance
+ * @param id Identifier
+ * @param size Size of the identifier
+ */
+static void cote_discovery_get_shm_id(cote_t *cote, char *id, size_t size);
+
+/**
+ * @brief Retrieve the capabilities (COTE_PEER_CAP_*) shared with a discovered node, as announced in its advertisement
+ * @param cote Cote instance
+ * @param node Node
+ * @return Capabilities shared with the node
+ */
+static uint32_t cote_discovery_get_caps(cote_t *cote, discover_node_t *node);
+
+/**
+ * @brief Check if a discovered node is a subscriber connecting only to the first shard of a sharded Publisher instance
+ * @param cote Cote instance
+ * @param node Node
+ * @return true if the node is a Node.js cote subscriber or an older c-cote subscriber, false otherwise
+ */
+static bool cote_discovery_is_legacy(cote_t *cote, discover_node_t *node);
+
+/**
+ * @brief Compile subscribesTo/requests regular expressions, the options semaphore must be taken by the caller
+ * The discovered nodes already evaluated are evaluated again because the local topics have changed
+ * @param cote Cote instance
+ */
+static void cote_discovery_compile_patterns(cote_t *cote);
+
+/**
+ * @brief Check if the topics advertised by a node are matching the local topics, the options semaphore must be taken by the caller
+ * The result is kept for the node until it is removed, advertises other topics or the local topics are changed
+ * @param cote Cote instance
+ * @param node Node
+ * @return true if the topics are matching, false otherwise
+ */
+static bool cote_discovery_match_node(cote_t *cote, discover_node_t *node);
+
+/**
+ * @brief Check if a node which was not matching the local topics is matching them since they or its advertised topics have changed
+ * The options semaphore must be taken by the caller, the node is evaluated again only if it has already been evaluated
+ * @param cote Cote instance
+ * @param node Node
+ * @return true if the node is matching and must be connected, false otherwise
+ */
+static bool cote_discovery_refresh_node(cote_t *cote, discover_node_t *node);
+
+/**
+ * @brief Retrieve the result of the topics matching kept for a node, the options semaphore must be taken by the caller
+ * The node is evaluated again if the topics it advertises are not the ones the result has been computed for
+ * @param cote Cote instance
+ * @param node Node
+ * @param create Evaluate the node if it is not known yet
+ * @return Node already evaluated, NULL if it is not known or if the result can not be kept
+ */
+static cote_node_t *cote_discovery_get_node(cote_t *cote, discover_node_t *node, bool create);
+
+/**
+ * @brief Check if advertised topics are matching the compiled subscribesTo/requests regular expressions, the options semaphore must be taken by the caller
+ * @param cote Cote instance
+ * @param topics broadcasts/respondsTo array advertised by a node, may be NULL
+ * @return true if the topics are matching, false otherwise
+ */
+static bool cote_discovery_match_topics(cote_t *cote, cJSON *topics);
+
+/**
+ * @brief Forget a discovered node, the options semaphore must be taken by the caller
+ * @param cote Cote instance
+ * @param iid Instance ID of the node, NULL to forget all the nodes
+ */
+static void cote_discovery_forget_node(cote_t *cote, char *iid);
+
 /******************************************************************************/
 /* Functions                                                                  */
 /******************************************************************************/
@@ -173,14 +722,16 @@ cote_create(char *type, char *name) {
         return NULL;
     }
 
-    /* Definition of discover added/removed/error callbacks */
+    /* Definition of discover added/removed/helloReceived/error callbacks */
     discover_on(cote->discover, "added", &cote_discovery_added_cb, cote);
     discover_on(cote->discover, "removed", &cote_discovery_removed_cb, cote);
+    discover_on(cote->discover, "helloReceived", &cote_discovery_hello_cb, cote);
     discover_on(cote->discover, "error", &cote_discovery_error_cb, cote);
 
-    /* Set discover options */
-    int helloInterval = 2000;
+    /* Set discover options, the hello interval is kept to be restored once the startup probing is done */
+    int helloInterval = COTE_PROBE_HELLO_INTERVAL;
     discover_set_option(cote->discover, "helloInterval", &helloInterval);
+    cote->options.discovery.helloInterval = helloInterval;
     int checkInterval = 4000;
     discover_set_option(cote->discover, "checkInterval", &checkInterval);
     int nodeTimeout = 5000;
@@ -188,8 +739,8 @@ cote_create(char *type, char *name) {
     int masterTimeout = 6000;
     discover_set_option(cote->discover, "masterTimeout", &masterTimeout);
 
-    /* Treatment depending of Cote instance type */
-    if (COTE_TYPE_MON != cote->type) {
+    /* Treatment depending of Cote instance type, Subscriber and Requester instances use an axon instance per discovered node */
+    if ((COTE_TYPE_PUB == cote->type) || (COTE_TYPE_REP == cote->type)) {
 
         /* Create axon instance */
         if (NULL == (cote->axon = axon_create(type))) {
@@ -203,13 +754,69 @@ cote_create(char *type, char *name) {
         axon_on(cote->axon, "error", &cote_axon_error_cb, cote);
     }
 
-    /* Initialize semaphore used to access options */
-    sem_init(&cote->options.sem, 0, 1);
+    /* Initialize subscriptions */
+    if (0 != cote_subs_init(&cote->subs)) {
+        /* Unable to allocate memory */
+        axon_release(cote->axon);
+        discover_release(cote->discover);
+        free(cote);
+        return NULL;
+    }
 
-    /* Initialize semaphore used to access subscriptions */
-    sem_init(&cote->subs.sem, 0, 1);
+    /* Create statistics */
+    if (0 != cote_stats_init(cote)) {
+        /* Unable to allocate memory */
+        cote_subs_release(&cote->subs);
+        axon_release(cote->axon);
+        discover_release(cote->discover);
+        free(cote);
+        return NULL;
+    }
 
-    return cote;
+    /* Initialize index of the discovered nodes (Monitor and Requester instances) */
+    if (((COTE_TYPE_MON == cote->type) || (COTE_TYPE_REQ == cote->type)) && (0 != cote_index_init(&cote->index))) {
+        /* Unable to allocate memory */
+        cote_stats_release(cote);
+        cote_subs_release(&cote->subs);
+        axon_release(cote->axon);
+        discover_release(cote->discover);
+        free(cote);
+        return NULL;
+    }
+
+    /* Initialize semaphore used to access options */
+    sem_init(&cote->options.sem, 0, 1);
+
+    /* Initialize semaphore used to access topic handles */
+    sem_init(&cote->topics.sem, 0, 1);
+
+    /* Initialize connections to the discovered nodes */
+    cote_peers_init(&cote->peers);
+
+    /* Initialize topic IDs */
+    cote_ids_init(&cote->ids);
+
+    /* Initialize asynchronous requests */
+    cote_async_init(&cote->requests);
+
+    /* Initialize event loop */
+    cote_loop_init(&cote->loop);
+
+    /* Initialize compression threshold */
+    cote->options.compression.threshold = COTE_COMPRESS_THRESHOLD;
+
+    /* Initialize hedged requests, no deadline is attached to the requests by default */
+    cote->options.hedge.threads = COTE_HEDGE_THREADS;
+    cote->options.deadline      = false;
+    cote_hedge_init(&cote->hedge, &cote_axon_request_hedge_cb);
+
+    /* Initialize corked messages, the messages are not corked by default */
+    cote_cork_init(&cote->cork, &cote_axon_send_batch);
+
+    /* Initialize shards, the Publisher instance is not sharded by default */
+    cote->options.shards = 1;
+
+    return cote;
 }
 
 /**
@@ -226,97 +833,76 @@ cote_set_option(cote_t *cote, char *option, void *value) {
     assert(NULL != cote->discover);
     assert(NULL != option);
 
-    int ret = -1;
-
     /* Wait options semaphore */
-    sem_wait(&cote->options.sem);
+    cote_stats_sem_wait(cote, &cote->options.sem);
 
-    /* Treatment depending of the option */
-    if (!strcmp("helloInterval", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("checkInterval", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("nodeTimeout", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("masterTimeout", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("address", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("port", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("broadcast", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("multicast", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("multicastTTL", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("unicast", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("key", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("mastersRequired", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("weight", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("client", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("reuseAddr", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("ignoreProcess", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("ignoreInstance", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("hostname", option)) {
-        ret = discover_set_option(cote->discover, option, value);
-    } else if (!strcmp("namespace", option)) {
-        if (NULL != cote->options.namespace_) {
-            free(cote->options.namespace_);
-        }
-        cote->options.namespace_ = strdup((char *)value);
-        if (NULL != cote->options.namespace_) {
-            ret = 0;
-        }
-    } else if (!strcmp("useHostNames", option)) {
-        cote->options.use_hostname = *((bool *)value);
-        ret                        = 0;
-    } else if (!strcmp("advertisement", option)) {
-        if (NULL != cote->options.advertisement) {
-            cJSON_Delete(cote->options.advertisement);
-        }
-        cote->options.advertisement = (NULL != value) ? cJSON_Duplicate((cJSON *)value, 1) : NULL;
-        ret                         = 0;
-    } else if (!strcmp("broadcasts", option)) {
-        if (NULL != cote->options.broadcasts) {
-            cJSON_Delete(cote->options.broadcasts);
-        }
-        cote->options.broadcasts = (NULL != value) ? cJSON_Duplicate((cJSON *)value, 1) : NULL;
-        ret                      = 0;
-    } else if (!strcmp("subscribesTo", option)) {
-        if (NULL != cote->options.subscribesTo) {
-            cJSON_Delete(cote->options.subscribesTo);
-        }
-        cote->options.subscribesTo = (NULL != value) ? cJSON_Duplicate((cJSON *)value, 1) : NULL;
-        ret                        = 0;
-    } else if (!strcmp("requests", option)) {
-        if (NULL != cote->options.requests) {
-            cJSON_Delete(cote->options.requests);
-        }
-        cote->options.requests = (NULL != value) ? cJSON_Duplicate((cJSON *)value, 1) : NULL;
-        ret                    = 0;
-    } else if (!strcmp("respondsTo", option)) {
-        if (NULL != cote->options.respondsTo) {
-            cJSON_Delete(cote->options.respondsTo);
+    /* Set option */
+    int ret = cote_option_set(cote, option, value);
+
+    /* Release options semaphore */
+    sem_post(&cote->options.sem);
+
+    /* Update full topic of the topic handles, if required */
+    if ((0 == ret) && (!strcmp("namespace", option))) {
+        cote_topics_update(cote);
+    }
+
+    /* Update advertisement, if required */
+    if (0 == ret) {
+        ret = cote_discovery_set_advertisement(cote, false);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Set several cote options, the advertisement is updated once
+ * @param cote Cote instance
+ * @param count Amount of options
+ * @param ... option, value Array of option by name and new value of the option
+ * @return 0 if the function succeeded, -1 if at least one option has not been set
+ */
+int
+cote_set_options(cote_t *cote, int count, ...) {
+
+    assert(NULL != cote);
+    assert(NULL != cote->discover);
+
+    int  ret        = 0;
+    bool namespace_ = false;
+
+    /* Retrieve params */
+    va_list params;
+    va_start(params, count);
+
+    /* Wait options semaphore */
+    cote_stats_sem_wait(cote, &cote->options.sem);
+
+    /* Set options */
+    for (int index = 0; index < count; index++) {
+        char *option = va_arg(params, char *);
+        void *value  = va_arg(params, void *);
+        if ((NULL == option) || (0 != cote_option_set(cote, option, value))) {
+            ret = -1;
+        } else if (!strcmp("namespace", option)) {
+            namespace_ = true;
         }
-        cote->options.respondsTo = (NULL != value) ? cJSON_Duplicate((cJSON *)value, 1) : NULL;
-        ret                      = 0;
     }
 
     /* Release options semaphore */
     sem_post(&cote->options.sem);
 
+    /* End of params */
+    va_end(params);
+
+    /* Update full topic of the topic handles, if required */
+    if (true == namespace_) {
+        cote_topics_update(cote);
+    }
+
     /* Update advertisement, if required */
-    if (0 == ret) {
-        ret = cote_discovery_set_advertisement(cote);
+    if (0 != cote_discovery_set_advertisement(cote, false)) {
+        ret = -1;
     }
 
     return ret;
@@ -332,14 +918,73 @@ cote_start(cote_t *cote) {
 
     assert(NULL != cote);
 
+    /* Start probing in fast discovery mode, the first hellos are sent as soon as the discover instance is started */
+    if ((COTE_DISCOVERY_FAST == cote->options.discovery.mode) && (0 != cote_probe_start(cote))) {
+        /* Unable to start probing */
+        return -1;
+    }
+
     /* Treatment depending of cote type */
-    if ((COTE_TYPE_SUB == cote->type) || (COTE_TYPE_REP == cote->type)) {
+    if (((COTE_TYPE_SUB == cote->type) || (COTE_TYPE_REQ == cote->type)) && (true == cote->options.eventLoop)) {
+
+        /* Start event loop, the messages and the replies of the asynchronous requests are processed by cote_process */
+        if (0 != cote_loop_start(&cote->loop, &cote_loop_event_cb)) {
+            /* Unable to start event loop */
+            return -1;
+        }
+    } else if ((COTE_TYPE_SUB == cote->type) && (0 < cote->options.dispatchThreads)) {
+
+        /* Start dispatch threads */
+        if (0 != cote_pool_start(cote, &cote->pool, cote->options.dispatchThreads, &cote_axon_dispatch_sub)) {
+            /* Unable to start dispatch threads */
+            return -1;
+        }
+    }
+    if ((COTE_TYPE_SUB == cote->type) && (true == cote->options.selectiveFanout)) {
+
+        /* Create axon instance, publishers with selective fan-out connect to the subscriber */
+        if (NULL == (cote->axon = axon_create("sub"))) {
+            /* Unable to create Axon instance */
+            return -1;
+        }
+
+        /* Definition of axon error callback */
+        axon_on(cote->axon, "error", &cote_axon_error_cb, cote);
+    }
+    if ((COTE_TYPE_SUB == cote->type) && (true == cote->options.sharedMemory)) {
+
+        /* Create shared memory, publishers running on the same host write the messages to it */
+        if (NULL == (cote->shm = cote_shm_create(COTE_SHM_SIZE, &cote_shm_message_cb, cote))) {
+            /* Unable to create shared memory */
+            return -1;
+        }
+    }
+    if ((COTE_TYPE_REP == cote->type) || ((COTE_TYPE_SUB == cote->type) && (NULL != cote->axon))) {
 
         /* Definition of axon message callback */
         axon_on(cote->axon, "message", &cote_axon_message_cb, cote);
     }
 
-    if ((COTE_TYPE_PUB == cote->type) || (COTE_TYPE_REP == cote->type)) {
+    if ((COTE_TYPE_PUB == cote->type) && (0 < cote->options.replay) && ((true == cote->options.selectiveFanout) || (true == cote->options.sharedMemory))
+        && (NULL == cote->replay.topics)) {
+
+        /* Create the topics table of the recent messages replayed to the joining subscribers */
+        if (0 != cote_replay_create(&cote->replay, cote->options.replay)) {
+            /* Unable to create replay */
+            return -1;
+        }
+    }
+
+    if ((COTE_TYPE_PUB == cote->type) && (1 < cote->options.shards)) {
+
+        /* Create the other shards, the topics are distributed on several axon instances bound to their own port */
+        if (0 != cote_shards_create(cote, cote->options.shards, &cote_axon_bind_cb, &cote_axon_error_cb)) {
+            /* Unable to create shards */
+            return -1;
+        }
+    }
+
+    if ((COTE_TYPE_PUB == cote->type) || (COTE_TYPE_REP == cote->type) || ((COTE_TYPE_SUB == cote->type) && (NULL != cote->axon))) {
 
         /* Definition of axon bind callback */
         axon_on(cote->axon, "bind", &cote_axon_bind_cb, cote);
@@ -350,10 +995,16 @@ cote_start(cote_t *cote) {
             return -1;
         }
 
+        /* Bind the other shards, the advertisement is set once all the shards are bound */
+        if ((0 < cote->shards.count) && (0 != cote_shards_bind(&cote->shards))) {
+            /* Unable to bind shards */
+            return -1;
+        }
+
     } else if ((COTE_TYPE_SUB == cote->type) || (COTE_TYPE_REQ == cote->type) || (COTE_TYPE_MON == cote->type)) {
 
         /* Set Discovery advertisement */
-        if (0 != cote_discovery_set_advertisement(cote)) {
+        if (0 != cote_discovery_set_advertisement(cote, true)) {
             /* Unable to set advertisement */
             return -1;
         }
@@ -380,19 +1031,20 @@ cote_advertise(cote_t *cote, cJSON *advertisement) {
     assert(NULL != cote);
 
     /* Wait options semaphore */
-    sem_wait(&cote->options.sem);
+    cote_stats_sem_wait(cote, &cote->options.sem);
 
     /* Set advertisement */
     if (NULL != cote->options.advertisement) {
         cJSON_Delete(cote->options.advertisement);
     }
     cote->options.advertisement = (NULL != advertisement) ? cJSON_Duplicate(advertisement, 1) : NULL;
+    cote->options.dirty         = true;
 
     /* Release options semaphore */
     sem_post(&cote->options.sem);
 
-    /* Update advertisement, if required */
-    return cote_discovery_set_advertisement(cote);
+    /* Update advertisement */
+    return cote_discovery_set_advertisement(cote, false);
 }
 
 /**
@@ -454,49 +1106,29 @@ cote_subscribe(cote_t *cote, char *topic, void *fct, void *user) {
         return -1;
     }
 
-    int         ret      = 0;
-    cote_sub_t *last_sub = NULL;
-
-    /* Wait semaphore */
-    sem_wait(&cote->subs.sem);
+    int ret = 0;
 
-    /* Parse subscriptions, update callback and user data if topic is found */
-    cote_sub_t *curr_sub = cote->subs.first;
-    while (NULL != curr_sub) {
-        if (!strcmp(fulltopic, curr_sub->topic)) {
-            curr_sub->fct  = fct;
-            curr_sub->user = user;
-            goto LEAVE;
-        }
-        last_sub = curr_sub;
-        curr_sub = curr_sub->next;
+    /* Create subscription */
+    cote_sub_t *sub = cote_sub_create(fulltopic, fct, user);
+    if (NULL == sub) {
+        /* Unable to allocate memory or invalid regular expression */
+        free(fulltopic);
+        return -1;
     }
 
-    /* Subscription not found, add a new one */
-    cote_sub_t *new_sub = (cote_sub_t *)malloc(sizeof(cote_sub_t));
-    if (NULL == new_sub) {
-        /* Unable to allocate memory */
-        ret = -1;
-        goto LEAVE;
-    }
-    memset(new_sub, 0, sizeof(cote_sub_t));
-    new_sub->topic = strdup(fulltopic);
-    if (NULL == new_sub->topic) {
+    /* Wait semaphore */
+    cote_stats_sem_wait(cote, &cote->subs.sem);
+
+    /* Add subscription, the subscription with the same topic is replaced if it exists */
+    cote_sub_table_t *table = cote_sub_table_add(__atomic_load_n(&cote->subs.table, __ATOMIC_SEQ_CST), sub);
+    if (NULL != table) {
+        cote_subs_replace(&cote->subs, table);
+    } else {
         /* Unable to allocate memory */
-        free(new_sub);
+        cote_sub_release(sub);
         ret = -1;
-        goto LEAVE;
-    }
-    new_sub->fct  = fct;
-    new_sub->user = user;
-    if (NULL != last_sub) {
-        last_sub->next = new_sub;
-    } else {
-        cote->subs.first = new_sub;
     }
 
-LEAVE:
-
     /* Release semaphore */
     sem_post(&cote->subs.sem);
 
@@ -524,33 +1156,28 @@ cote_unsubscribe(cote_t *cote, char *topic) {
         return -1;
     }
 
-    cote_sub_t *last_sub = NULL;
+    /* Format full topic */
+    char *fulltopic = cote_axon_format_fulltopic(cote, topic);
+    if (NULL == fulltopic) {
+        /* Unable to allocate memory */
+        return -1;
+    }
 
     /* Wait semaphore */
-    sem_wait(&cote->subs.sem);
-
-    /* Parse subscriptions, remove subscription if topic is found */
-    cote_sub_t *curr_sub = cote->subs.first;
-    while (NULL != curr_sub) {
-        if (!strcmp(topic, curr_sub->topic)) {
-            if (cote->subs.first == curr_sub) {
-                cote->subs.first = curr_sub->next;
-            } else {
-                last_sub->next = curr_sub->next;
-            }
-            free(curr_sub->topic);
-            free(curr_sub);
-            goto LEAVE;
-        }
-        last_sub = curr_sub;
-        curr_sub = curr_sub->next;
-    }
+    cote_stats_sem_wait(cote, &cote->subs.sem);
 
-LEAVE:
+    /* Remove subscription if topic is found */
+    cote_sub_table_t *table = cote_sub_table_remove(__atomic_load_n(&cote->subs.table, __ATOMIC_SEQ_CST), fulltopic);
+    if (NULL != table) {
+        cote_subs_replace(&cote->subs, table);
+    }
 
     /* Release semaphore */
     sem_post(&cote->subs.sem);
 
+    /* Release memory */
+    free(fulltopic);
+
     return 0;
 }
 
@@ -566,7 +1193,6 @@ int
 cote_send(cote_t *cote, char *topic, int count, ...) {
 
     assert(NULL != cote);
-    assert(NULL != cote->axon);
     assert(NULL != topic);
 
     /* Check Cote instance type */
@@ -580,19 +1206,41 @@ cote_send(cote_t *cote, char *topic, int count, ...) {
     /* Treatment depending of Cote instance type (format of messages is very different !) */
     if (COTE_TYPE_PUB == cote->type) {
 
+        assert(NULL != cote->axon);
+
+        /* Retrieve params */
+        va_list params;
+        va_start(params, count);
+
+        /* The corked messages are kept with the handle of their topic, the full topic is formatted once with the handle */
+        cote_topic_t *handle = NULL;
+        if ((0 < __atomic_load_n(&cote->cork.delay, __ATOMIC_ACQUIRE)) && (NULL != (handle = cote_topic_get(cote, topic)))) {
+            cote_fanout_t fanout = { .fulltopic = __atomic_load_n(&handle->fulltopic, __ATOMIC_ACQUIRE),
+                                     .count     = count,
+                                     .params    = &params,
+                                     .fields    = NULL,
+                                     .id        = handle->id };
+            ret                  = cote_axon_cork(cote, handle, &fanout);
+            va_end(params);
+            return ret;
+        }
+
         /* Format full topic */
         char *fulltopic = cote_axon_format_fulltopic(cote, topic);
         if (NULL == fulltopic) {
             /* Unable to allocate memory */
+            va_end(params);
             return -1;
         }
 
-        /* Retrieve params */
-        va_list params;
-        va_start(params, count);
-
         /* Send message */
-        ret = axon_vsend(cote->axon, count + 1, AMP_TYPE_STRING, fulltopic, params);
+        cote_fanout_t fanout = { .fulltopic = fulltopic, .count = count, .params = &params, .fields = NULL, .id = -1 };
+        ret                  = cote_axon_publish(cote, topic, &fanout);
+        if (0 == ret) {
+            COTE_STATS_INC(cote, messages_out);
+        } else {
+            COTE_STATS_INC(cote, send_errors);
+        }
 
         /* End of params */
         va_end(params);
@@ -603,30 +1251,41 @@ cote_send(cote_t *cote, char *topic, int count, ...) {
     } else if (COTE_TYPE_REQ == cote->type) {
 
         cJSON *     json    = NULL;
+        char *      text    = NULL;
         amp_msg_t **resp    = NULL;
         int         timeout = 0;
 
-        /* Retrieve params and format message */
+        /* Retrieve params */
         va_list params;
         va_start(params, count);
         amp_type_e type = va_arg(params, int);
         if (AMP_TYPE_JSON == type) {
-            cJSON *tmp = va_arg(params, cJSON *);
-            if (NULL != tmp) {
-                json = cJSON_Duplicate(tmp, 1);
-                if (NULL != json) {
-                    cJSON_AddStringToObject(json, "type", topic);
-                }
-            }
+            json = va_arg(params, cJSON *);
+        } else if (AMP_TYPE_STRING == type) {
+            text = va_arg(params, char *);
         }
         resp    = va_arg(params, amp_msg_t **);
         timeout = va_arg(params, int);
         va_end(params);
 
-        /* Send message */
+        /* Send message depending of the type of the payload */
         if (NULL != json) {
-            ret = axon_send(cote->axon, 1, AMP_TYPE_JSON, json, resp, timeout);
-            cJSON_Delete(json);
+
+            /* Send message */
+            ret = cote_request(cote, topic, json, resp, timeout);
+
+        } else if (NULL != text) {
+
+            /* Format message, the topic is set in a copy of the JSON text of the caller which is not parsed */
+            char *request = cote_json_set_string(text, "type", topic);
+            if (NULL != request) {
+
+                /* Send message */
+                ret = cote_axon_request(cote, AMP_TYPE_STRING, request, resp, timeout);
+
+                /* Release memory */
+                free(request);
+            }
         }
     }
 
@@ -634,594 +1293,3546 @@ cote_send(cote_t *cote, char *topic, int count, ...) {
 }
 
 /**
- * @brief Release cote instance
+ * @brief Function used by Requester instance to send a request without waiting for the reply
  * @param cote Cote instance
+ * @param topic Topic of the request
+ * @param payload JSON payload of the request, owned and released by Cote instance
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @param fct Callback function invoked with the reply, or with NULL if the request failed, the reply is released once the callback returns
+ * @param user User data
+ * @return 0 if the request is queued, -1 otherwise (payload is released)
  */
-void
-cote_release(cote_t *cote) {
+int
+cote_send_async(cote_t *cote, char *topic, cJSON *payload, int timeout, void *fct, void *user) {
 
-    /* Release cote instance */
-    if (NULL != cote) {
+    assert(NULL != cote);
+    assert(NULL != topic);
+    assert(NULL != payload);
 
-        /* Release discover instance */
-        discover_release(cote->discover);
+    /* Check Cote instance type */
+    if (COTE_TYPE_REQ != cote->type) {
+        /* Not compatible */
+        cJSON_Delete(payload);
+        return -1;
+    }
 
-        /* Release axon instance */
-        axon_release(cote->axon);
+    /* Create request */
+    cote_request_t *request = (cote_request_t *)malloc(sizeof(cote_request_t));
+    if (NULL == request) {
+        /* Unable to allocate memory */
+        cJSON_Delete(payload);
+        return -1;
+    }
+    memset(request, 0, sizeof(cote_request_t));
+    request->payload = payload;
+    if (NULL == (request->topic = strdup(topic))) {
+        /* Unable to allocate memory */
+        cote_async_request_release(request);
+        return -1;
+    }
+    request->timeout = timeout;
+    request->expiry  = cote_stats_now() + (uint64_t)((0 < timeout) ? timeout : 0) * 1000000;
+    request->fct     = fct;
+    request->user    = user;
+
+    /* Queue request */
+    if (0 != cote_async_push(cote, request)) {
+        /* Unable to queue request */
+        cote_async_request_release(request);
+        return -1;
+    }
 
-        /* Release subscriptions */
-        sem_wait(&cote->subs.sem);
-        cote_sub_t *curr_sub = cote->subs.first;
-        while (NULL != curr_sub) {
-            cote_sub_t *tmp = curr_sub;
-            curr_sub        = curr_sub->next;
-            if (NULL != tmp->topic) {
-                free(tmp->topic);
-            }
-            free(tmp);
-        }
-        sem_post(&cote->subs.sem);
-        sem_close(&cote->subs.sem);
+    return 0;
+}
 
-        /* Release options */
-        sem_wait(&cote->options.sem);
-        if (NULL != cote->options.namespace_) {
-            free(cote->options.namespace_);
-        }
-        if (NULL != cote->options.advertisement) {
-            cJSON_Delete(cote->options.advertisement);
-        }
-        if (NULL != cote->options.broadcasts) {
-            cJSON_Delete(cote->options.broadcasts);
-        }
-        if (NULL != cote->options.subscribesTo) {
-            cJSON_Delete(cote->options.subscribesTo);
-        }
-        if (NULL != cote->options.requests) {
-            cJSON_Delete(cote->options.requests);
-        }
-        if (NULL != cote->options.respondsTo) {
-            cJSON_Delete(cote->options.respondsTo);
-        }
-        sem_post(&cote->options.sem);
-        sem_close(&cote->options.sem);
+/**
+ * @brief Function used to get a topic handle (Publisher instances only), the handle is valid until the Cote instance is released
+ * @param cote Cote instance
+ * @param topic Topic of the messages
+ * @return Topic handle if the function succeeded, NULL otherwise
+ */
+cote_topic_t *
+cote_topic_get(cote_t *cote, char *topic) {
 
-        /* Release name */
-        if (NULL != cote->name) {
-            free(cote->name);
-        }
+    assert(NULL != cote);
+    assert(NULL != topic);
 
-        /* Release Cote instance */
-        free(cote);
+    /* Check Cote instance type */
+    if (COTE_TYPE_PUB != cote->type) {
+        /* Not compatible */
+        return NULL;
+    }
+
+    /* Wait topic handles semaphore */
+    cote_stats_sem_wait(cote, &cote->topics.sem);
+
+    /* Search for an existing topic handle */
+    cote_topic_t *handle = cote->topics.first;
+    while ((NULL != handle) && (strcmp(handle->topic, topic))) {
+        handle = handle->next;
+    }
+    if (NULL != handle) {
+        sem_post(&cote->topics.sem);
+        return handle;
     }
+
+    /* Create new topic handle */
+    if (NULL == (handle = (cote_topic_t *)malloc(sizeof(cote_topic_t)))) {
+        /* Unable to allocate memory */
+        sem_post(&cote->topics.sem);
+        return NULL;
+    }
+    memset(handle, 0, sizeof(cote_topic_t));
+    if (NULL == (handle->topic = strdup(topic))) {
+        /* Unable to allocate memory */
+        free(handle);
+        sem_post(&cote->topics.sem);
+        return NULL;
+    }
+
+    /* Format full topic */
+    if (NULL == (handle->fulltopic = cote_axon_format_fulltopic(cote, topic))) {
+        /* Unable to allocate memory */
+        free(handle->topic);
+        free(handle);
+        sem_post(&cote->topics.sem);
+        return NULL;
+    }
+
+    /* Assign topic ID */
+    handle->id = cote_ids_assign(&cote->ids);
+
+    /* Add topic handle to the list */
+    handle->next       = cote->topics.first;
+    cote->topics.first = handle;
+
+    /* Release topic handles semaphore */
+    sem_post(&cote->topics.sem);
+
+    return handle;
 }
 
 /**
- * @brief Callback function called when Axon socket is bound
- * @param axon Axon instance
- * @param port Port on which the socket is bound
- * @param user User data
+ * @brief Function used to send data to all connected subscribers using a topic handle, no memory is allocated and no lock is taken to format the topic
+ * @param cote Cote instance
+ * @param topic Topic handle of the message
+ * @param count Amount of data to be sent
+ * @param ... type, data Array of type and data (and size for blob type) to be sent
+ * @return 0 if the function succeeded, -1 otherwise
  */
-static void
-cote_axon_bind_cb(axon_t *axon, uint16_t port, void *user) {
-
-    (void)axon;
-    assert(NULL != user);
+int
+cote_publish(cote_t *cote, cote_topic_t *topic, int count, ...) {
 
-    /* Retrieve cote instance using user data */
-    cote_t *cote = (cote_t *)user;
+    assert(NULL != cote);
+    assert(NULL != cote->axon);
+    assert(NULL != topic);
 
     /* Check Cote instance type */
-    if ((COTE_TYPE_PUB != cote->type) && (COTE_TYPE_REP != cote->type)) {
+    if (COTE_TYPE_PUB != cote->type) {
         /* Not compatible */
-        return;
+        return -1;
     }
 
-    /* Memorize port */
-    cote->port = port;
+    /* Retrieve params */
+    va_list params;
+    va_start(params, count);
 
-    /* Set Discovery advertisement */
-    if (0 != cote_discovery_set_advertisement(cote)) {
-        /* Unable to set advertisement */
-        /* Invoke error callback if defined */
-        if (NULL != cote->cb.error.fct) {
-            cote->cb.error.fct(cote, "cote: unable to set advertisement", cote->cb.error.user);
+    /* Send message, or cork it if the messages are corked */
+    cote_fanout_t fanout
+        = { .fulltopic = __atomic_load_n(&topic->fulltopic, __ATOMIC_ACQUIRE), .count = count, .params = &params, .fields = NULL, .id = topic->id };
+    int ret = -1;
+    if (0 < __atomic_load_n(&cote->cork.delay, __ATOMIC_ACQUIRE)) {
+        ret = cote_axon_cork(cote, topic, &fanout);
+    } else {
+        ret = cote_axon_publish(cote, topic->topic, &fanout);
+        if (0 == ret) {
+            COTE_STATS_INC(cote, messages_out);
+        } else {
+            COTE_STATS_INC(cote, send_errors);
         }
-        return;
     }
 
-    /* Start discover instance */
-    if (0 != discover_start(cote->discover)) {
-        /* Unable to create Discover instance */
-        /* Invoke error callback if defined */
-        if (NULL != cote->cb.error.fct) {
-            cote->cb.error.fct(cote, "cote: unable to start discover instance", cote->cb.error.user);
+    /* End of params */
+    va_end(params);
+
+    return ret;
+}
+
+/**
+ * @brief Function used to send several messages to all connected subscribers (Publisher instances only)
+ * @param cote Cote instance
+ * @param msgs Messages to be sent
+ * @param count Amount of messages
+ * @return 0 if the function succeeded, -1 if at least one message has not been sent
+ */
+int
+cote_send_batch(cote_t *cote, cote_msg_t *msgs, int count) {
+
+    assert(NULL != cote);
+    assert(NULL != cote->axon);
+    assert((NULL != msgs) || (0 == count));
+
+    /* Check Cote instance type */
+    if (COTE_TYPE_PUB != cote->type) {
+        /* Not compatible */
+        return -1;
+    }
+
+    /* The messages are corked after the messages already corked so that they are sent in order */
+    if (0 < __atomic_load_n(&cote->cork.delay, __ATOMIC_ACQUIRE)) {
+        int ret = 0;
+        for (int index = 0; index < count; index++) {
+            assert(NULL != msgs[index].topic);
+            if (0 != cote_cork_push(cote, msgs[index].topic, msgs[index].fields, msgs[index].count)) {
+                COTE_STATS_INC(cote, send_errors);
+                ret = -1;
+            }
         }
-        return;
+        return ret;
     }
+
+    return cote_axon_send_batch(cote, msgs, NULL, count);
 }
 
 /**
- * @brief Callback function invoked when Axon data is received
- * @param axon Axon instance
- * @param amp AMP message
- * @param user User data
- * @return Reply to the message received
+ * @brief Function used to send the corked messages at once without waiting for the delay (Publisher instances with corkDelay only)
+ * @param cote Cote instance
+ * @return 0 if the function succeeded, -1 if at least one message has not been sent
  */
-static amp_msg_t *
-cote_axon_message_cb(axon_t *axon, amp_msg_t *amp, void *user) {
+int
+cote_flush(cote_t *cote) {
 
-    (void)axon;
-    assert(NULL != amp);
-    assert(NULL != user);
+    assert(NULL != cote);
 
-    amp_msg_t *ret = NULL;
+    /* Check Cote instance type */
+    if (COTE_TYPE_PUB != cote->type) {
+        /* Not compatible */
+        return -1;
+    }
 
-    /* Retrieve cote instance using user data */
-    cote_t *cote = (cote_t *)user;
+    return cote_cork_flush(cote);
+}
+
+/**
+ * @brief Function used to send a message from an array of fields to all connected subscribers using a topic handle (Publisher instances only)
+ * @param cote Cote instance
+ * @param topic Topic handle of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to 2, more fields are rejected)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_publish_fields(cote_t *cote, cote_topic_t *topic, cote_field_t *fields, int count) {
+
+    assert(NULL != cote);
+    assert(NULL != topic);
+    assert((NULL != fields) || (0 == count));
 
     /* Check Cote instance type */
-    if ((COTE_TYPE_SUB != cote->type) && (COTE_TYPE_REP != cote->type)) {
+    if (COTE_TYPE_PUB != cote->type) {
         /* Not compatible */
-        return NULL;
+        return -1;
     }
 
-    /* Check the message has at least one field */
-    if ((NULL == amp->first) || (NULL == amp->last)) {
-        /* Invalid message */
-        return NULL;
+    /* axon encodes at most COTE_AXON_FIELDS_MAX fields from an array, the message would not reach all the subscribers */
+    if ((0 > count) || (COTE_AXON_FIELDS_MAX < count)) {
+        /* Too many fields */
+        return -1;
+    }
+
+    /* Send message, a single message is given as is to axon and to the peers without building a batch, or is corked if the messages are corked */
+    cote_fanout_t fanout = { .fulltopic = __atomic_load_n(&topic->fulltopic, __ATOMIC_ACQUIRE),
+                             .count     = count,
+                             .params    = NULL,
+                             .fields    = fields,
+                             .id        = topic->id };
+    if (0 < __atomic_load_n(&cote->cork.delay, __ATOMIC_ACQUIRE)) {
+        return cote_axon_cork(cote, topic, &fanout);
     }
+    if (0 != cote_axon_publish(cote, topic->topic, &fanout)) {
+        COTE_STATS_INC(cote, send_errors);
+        return -1;
+    }
+    COTE_STATS_INC(cote, messages_out);
 
-    /* Check if message callback is define */
-    if (NULL != cote->cb.message.fct) {
+    return 0;
+}
 
-        /* Invoke message callback */
-        cote->cb.message.fct(cote, amp, cote->cb.message.user);
+/**
+ * @brief Function used to send a request and wait for the reply (Requester instances only)
+ * @param cote Cote instance
+ * @param topic Topic of the request
+ * @param payload JSON payload of the request, not modified, its "type" member is replaced by the topic
+ * @param resp AMP response message
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_request(cote_t *cote, char *topic, cJSON *payload, amp_msg_t **resp, int timeout) {
+
+    assert(NULL != cote);
+    assert(NULL != topic);
+    assert(NULL != payload);
+
+    /* Check Cote instance type */
+    if (COTE_TYPE_REQ != cote->type) {
+        /* Not compatible */
+        return -1;
     }
 
-    /* Wait subscriptions semaphore */
-    sem_wait(&cote->subs.sem);
+    /* Format message, the members of the payload of the caller are referenced by the envelope instead of being copied, only the envelope is serialized */
+    cJSON *envelope = cote_axon_envelope(payload, topic, 0);
+    if (NULL == envelope) {
+        /* Unable to allocate memory */
+        return -1;
+    }
 
-    /* Treatment depending of Cote instance type */
-    if (COTE_TYPE_SUB == cote->type) {
+    /* Send message */
+    int ret = cote_axon_request(cote, AMP_TYPE_JSON, envelope, resp, timeout);
 
-        /* Cote is Subscriber - Invoke susbscriptions callback(s) if defined and if the first field of the AMP message is a string */
-        if ((NULL != cote->subs.first) && (AMP_TYPE_STRING == amp->first->type) && (NULL != amp->first->data)) {
-
-            /* Extract topic from the message */
-            amp_field_t *topic_field = amp->first;
-            amp->first               = amp->first->next;
-            amp->count--;
-
-            /* Parse all subscriptions */
-            cote_sub_t *curr_sub = cote->subs.first;
-            while (NULL != curr_sub) {
-                if (NULL != curr_sub->fct) {
-                    regex_t regex;
-                    if (0 == regcomp(&regex, curr_sub->topic, REG_NOSUB | REG_EXTENDED)) {
-                        if (0 == regexec(&regex, topic_field->data, 0, NULL, 0)) {
-                            /* Topic match subscription */
-                            /* Invoke subscription callback */
-                            ret = curr_sub->fct(cote,
-                                                topic_field->data + strlen("message::")
-                                                    + ((NULL != cote->options.namespace_) ? (strlen(cote->options.namespace_) + 2) : 0),
-                                                amp,
-                                                curr_sub->user);
-                        }
-                        regfree(&regex);
-                    }
-                }
-                curr_sub = curr_sub->next;
-            }
-            free(topic_field->data);
-            free(topic_field);
-        }
+    /* Release the envelope, the payload of the caller is not modified */
+    cJSON_Delete(envelope);
 
-    } else if (COTE_TYPE_REP == cote->type) {
+    return ret;
+}
 
-        /* Cote is Responder - Invoke susbscriptions callback(s) if defined and if the first field of the AMP message is a JSON */
-        if ((NULL != cote->subs.first) && (AMP_TYPE_JSON == amp->first->type) && (NULL != amp->first->data)) {
+/**
+ * @brief Get the fields of a received message as an array of cote_field_t, only the array is filled, the fields have been decoded when the message was received
+ * The fields point to the data of the message and are only valid while the message is valid (during the callback the message is given to)
+ * @param amp AMP message
+ * @param fields Fields filled with the data of the message
+ * @param max Maximum amount of fields
+ * @return Amount of fields filled
+ */
+int
+cote_get_fields(amp_msg_t *amp, cote_field_t *fields, int max) {
 
-            /* Extract topic from the message */
-            cJSON *tmp = cJSON_DetachItemFromObjectCaseSensitive(amp->first->data, "type");
-            if (NULL != tmp) {
-                char *topic = cJSON_GetStringValue(tmp);
-                if (NULL != topic) {
-                    /* Parse all subscriptions */
-                    cote_sub_t *curr_sub = cote->subs.first;
-                    while (NULL != curr_sub) {
-                        if (NULL != curr_sub->fct) {
-                            regex_t regex;
-                            if (0 == regcomp(&regex, curr_sub->topic, REG_NOSUB | REG_EXTENDED)) {
-                                if (0 == regexec(&regex, topic, 0, NULL, 0)) {
-                                    /* Topic match subscription */
-                                    /* Invoke subscription callback */
-                                    ret = curr_sub->fct(cote, topic, amp, curr_sub->user);
-                                }
-                                regfree(&regex);
-                            }
-                        }
-                        curr_sub = curr_sub->next;
-                    }
-                }
-                cJSON_Delete(tmp);
-            }
-        }
+    assert(NULL != amp);
+    assert((NULL != fields) || (0 == max));
+
+    int count = 0;
+
+    /* Parse the fields of the message, only the pointers to the data are kept */
+    amp_field_t *field = amp->first;
+    while ((NULL != field) && (count < max)) {
+        fields[count].type = field->type;
+        fields[count].data = field->data;
+        fields[count].size = field->size;
+        count++;
+        field = field->next;
     }
 
-    /* Release subscriptions semaphore */
-    sem_post(&cote->subs.sem);
+    return count;
+}
 
-    return ret;
+/**
+ * @brief Get statistics of the instance, counters of all the shards are summed
+ * @param cote Cote instance
+ * @param stats Statistics
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_get_stats(cote_t *cote, cote_stats_t *stats) {
+
+    assert(NULL != cote);
+    assert(NULL != cote->stats);
+    assert(NULL != stats);
+
+    /* Sum counters of all the shards, all the fields of the statistics are counters */
+    memset(stats, 0, sizeof(cote_stats_t));
+    for (int index = 0; index < COTE_STATS_SHARDS; index++) {
+        uint64_t *src = (uint64_t *)&cote->stats[index].stats;
+        uint64_t *dst = (uint64_t *)stats;
+        for (size_t index_counter = 0; index_counter < sizeof(cote_stats_t) / sizeof(uint64_t); index_counter++) {
+            dst[index_counter] += __atomic_load_n(&src[index_counter], __ATOMIC_RELAXED);
+        }
+    }
+
+    return 0;
 }
 
 /**
- * @brief Callback function called to handle error from Axon instance
- * @param axon Axon instance
- * @param err Error as string
- * @param user User data
+ * @brief Get statistics of the peers of the instance, including the counters of their send queues
+ * @param cote Cote instance
+ * @param stats Array of peer statistics
+ * @param max Size of the array
+ * @return Amount of peer statistics set if the function succeeded, -1 otherwise
  */
-static void
-cote_axon_error_cb(axon_t *axon, char *err, void *user) {
+int
+cote_get_peer_stats(cote_t *cote, cote_peer_stats_t *stats, int max) {
 
-    (void)axon;
-    assert(NULL != err);
-    assert(NULL != user);
+    assert(NULL != cote);
 
-    /* Retrieve cote instance using user data */
-    cote_t *cote = (cote_t *)user;
+    /* Check parameters */
+    if ((0 > max) || ((NULL == stats) && (0 < max))) {
+        /* Invalid parameters */
+        return -1;
+    }
 
-    /* Invoke error callback if defined */
-    if (NULL != cote->cb.error.fct) {
-        cote->cb.error.fct(cote, err, cote->cb.error.user);
+    return cote_peers_get_stats(&cote->peers, stats, max);
+}
+
+/**
+ * @brief Get a snapshot of the discovered nodes advertising a topic in their broadcasts, subscribesTo, requests or respondsTo arrays (Monitor and Requester instances)
+ * @param cote Cote instance
+ * @param topic Topic as advertised by the nodes or matching the regular expressions they advertise, NULL to get all the discovered nodes
+ * @param nodes Array of node information, NULL to get the amount of nodes only
+ * @param max Size of the array
+ * @return Amount of node information set, or amount of nodes if nodes is NULL, if the function succeeded, -1 otherwise
+ */
+int
+cote_get_nodes(cote_t *cote, char *topic, cote_node_info_t *nodes, int max) {
+
+    assert(NULL != cote);
+
+    /* Check the index is maintained for the instance and parameters */
+    if ((NULL == cote->index.nodes) || ((NULL != nodes) && (0 > max))) {
+        /* Index not available or invalid parameters */
+        return -1;
     }
+
+    return cote_index_get(&cote->index, topic, nodes, max);
 }
 
 /**
- * @brief Format fulltopic
+ * @brief Get the event file descriptor of an instance started with the eventLoop option, to be watched with poll/epoll by the application
+ * The file descriptor is readable when events are waiting to be processed with cote_process
  * @param cote Cote instance
- * @param topic Topic
- * @return Fulltopic if the fonction succeeded, NULL otherwise
+ * @return File descriptor if the function succeeded, -1 otherwise
  */
-static char *
-cote_axon_format_fulltopic(cote_t *cote, char *topic) {
+int
+cote_get_fd(cote_t *cote) {
 
-    char *fulltopic = NULL;
+    assert(NULL != cote);
 
-    /* Treatment depending of Cote instance type */
-    if ((COTE_TYPE_PUB == cote->type) || (COTE_TYPE_SUB == cote->type)) {
+    return cote->loop.fd;
+}
 
-        /* Wait options semaphore */
-        sem_wait(&cote->options.sem);
+/**
+ * @brief Process the events of an instance started with the eventLoop option, the callbacks are invoked by the calling thread
+ * @param cote Cote instance
+ * @param budget Maximum amount of events to be processed, 0 to process all the waiting events
+ * @return Amount of events processed if the function succeeded, -1 otherwise
+ */
+int
+cote_process(cote_t *cote, int budget) {
 
-        /* Format full topic */
-        size_t len = 0;
-        if (NULL != cote->options.namespace_) {
-            len = strlen("message::") + strlen(cote->options.namespace_) + strlen("::") + strlen(topic) + 1;
-        } else {
-            len = strlen("message::") + strlen(topic) + 1;
-        }
-        if (NULL == (fulltopic = (char *)malloc(len))) {
-            /* Unable to allocate memory */
-            sem_post(&cote->options.sem);
-            return NULL;
-        }
+    assert(NULL != cote);
+
+    /* Check if the event loop is started */
+    if ((0 > cote->loop.fd) || (0 > budget)) {
+        /* Event loop not used or invalid budget */
+        return -1;
+    }
+
+    return cote_loop_process(&cote->loop, cote, budget);
+}
+
+/**
+ * @brief Release cote instance
+ * @param cote Cote instance
+ */
+void
+cote_release(cote_t *cote) {
+
+    /* Release cote instance */
+    if (NULL != cote) {
+
+        /* Close event loop, the replies of the asynchronous requests do not wait anymore for space in the ring because it is processed only once released */
+        cote_loop_close(&cote->loop);
+
+        /* Release asynchronous requests */
+        cote_async_release(cote);
+
+        /* Release hedged requests */
+        cote_hedge_release(cote);
+
+        /* Release corked messages, the messages remaining are sent */
+        cote_cork_release(cote);
+
+        /* Stop probing */
+        cote_probe_release(cote);
+
+        /* Release discover instance */
+        discover_release(cote->discover);
+
+        /* Release connections to the discovered nodes */
+        cote_peers_release(&cote->peers);
+
+        /* Release axon instance */
+        axon_release(cote->axon);
+
+        /* Release the other shards */
+        cote_shards_release(&cote->shards);
+
+        /* Release the recent messages kept for replay */
+        cote_replay_release(&cote->replay);
+
+        /* Release shared memory, the messages are not read anymore */
+        cote_shm_release(cote->shm);
+
+        /* Release dispatch threads */
+        cote_pool_release(&cote->pool);
+
+        /* Release event loop, the waiting events are processed so that the callbacks of the completed requests are invoked */
+        cote_loop_release(&cote->loop, cote);
+
+        /* Release subscriptions */
+        cote_subs_release(&cote->subs);
+
+        /* Release topic IDs */
+        cote_ids_release(&cote->ids);
+
+        /* Release index of the discovered nodes */
+        cote_index_release(&cote->index);
+
+        /* Release topic handles */
+        cote_stats_sem_wait(cote, &cote->topics.sem);
+        while (NULL != cote->topics.first) {
+            cote_topic_t *tmp  = cote->topics.first;
+            cote->topics.first = cote->topics.first->next;
+            for (int index = 0; index < tmp->garbage.count; index++) {
+                free(tmp->garbage.fulltopics[index]);
+            }
+            if (NULL != tmp->garbage.fulltopics) {
+                free(tmp->garbage.fulltopics);
+            }
+            free(tmp->fulltopic);
+            free(tmp->topic);
+            free(tmp);
+        }
+        sem_post(&cote->topics.sem);
+        sem_close(&cote->topics.sem);
+
+        /* Release options */
+        cote_stats_sem_wait(cote, &cote->options.sem);
+        if (NULL != cote->options.namespace_) {
+            free(cote->options.namespace_);
+        }
+        if (NULL != cote->options.advertisement) {
+            cJSON_Delete(cote->options.advertisement);
+        }
+        if (NULL != cote->options.broadcasts) {
+            cJSON_Delete(cote->options.broadcasts);
+        }
+        if (NULL != cote->options.subscribesTo) {
+            cJSON_Delete(cote->options.subscribesTo);
+        }
+        if (NULL != cote->options.requests) {
+            cJSON_Delete(cote->options.requests);
+        }
+        if (NULL != cote->options.respondsTo) {
+            cJSON_Delete(cote->options.respondsTo);
+        }
+        if (NULL != cote->options.advertised) {
+            cJSON_Delete(cote->options.advertised);
+        }
+        cote->options.subscribesTo = NULL;
+        cote->options.requests     = NULL;
+        cote_discovery_compile_patterns(cote);
+        cote_discovery_forget_node(cote, NULL);
+        sem_post(&cote->options.sem);
+        sem_close(&cote->options.sem);
+
+        /* Release statistics */
+        cote_stats_release(cote);
+
+        /* Release name */
+        if (NULL != cote->name) {
+            free(cote->name);
+        }
+
+        /* Release Cote instance */
+        free(cote);
+    }
+}
+
+/**
+ * @brief Callback function called when Axon socket is bound
+ * @param axon Axon instance
+ * @param port Port on which the socket is bound
+ * @param user User data
+ */
+static void
+cote_axon_bind_cb(axon_t *axon, uint16_t port, void *user) {
+
+    assert(NULL != user);
+
+    /* Retrieve cote instance using user data */
+    cote_t *cote = (cote_t *)user;
+
+    /* Check Cote instance type */
+    if ((COTE_TYPE_PUB != cote->type) && (COTE_TYPE_REP != cote->type) && (COTE_TYPE_SUB != cote->type)) {
+        /* Not compatible */
+        return;
+    }
+
+    /* Memorize port */
+    if (axon == cote->axon) {
+        cote->port = port;
+    }
+
+    /* Wait for all the shards to be bound, the advertisement gives the ports of all the shards */
+    if ((0 < cote->shards.count) && (false == cote_shards_bound(&cote->shards, axon, port))) {
+        return;
+    }
+
+    /* Set Discovery advertisement */
+    if (0 != cote_discovery_set_advertisement(cote, true)) {
+        /* Unable to set advertisement */
+        /* Invoke error callback if defined */
+        if (NULL != cote->cb.error.fct) {
+            cote->cb.error.fct(cote, "cote: unable to set advertisement", cote->cb.error.user);
+        }
+        return;
+    }
+
+    /* Start discover instance */
+    if (0 != discover_start(cote->discover)) {
+        /* Unable to create Discover instance */
+        /* Invoke error callback if defined */
+        if (NULL != cote->cb.error.fct) {
+            cote->cb.error.fct(cote, "cote: unable to start discover instance", cote->cb.error.user);
+        }
+        return;
+    }
+}
+
+/**
+ * @brief Callback function invoked when Axon data is received
+ * @param axon Axon instance
+ * @param amp AMP message
+ * @param user User data
+ * @return Reply to the message received
+ */
+static amp_msg_t *
+cote_axon_message_cb(axon_t *axon, amp_msg_t *amp, void *user) {
+
+    (void)axon;
+    assert(NULL != amp);
+    assert(NULL != user);
+
+    amp_msg_t *ret = NULL;
+
+    /* Retrieve cote instance using user data */
+    cote_t *cote = (cote_t *)user;
+
+    /* Check Cote instance type */
+    if ((COTE_TYPE_SUB != cote->type) && (COTE_TYPE_REP != cote->type)) {
+        /* Not compatible */
+        return NULL;
+    }
+
+    /* Check the message has at least one field */
+    if ((NULL == amp->first) || (NULL == amp->last)) {
+        /* Invalid message */
+        return NULL;
+    }
+
+    /* Batch of messages of a publisher, the messages are handled one by one */
+    if ((COTE_TYPE_SUB == cote->type) && (AMP_TYPE_STRING == amp->first->type) && (NULL != amp->first->data)
+        && (!strcmp(COTE_BATCH_TOPIC, (char *)amp->first->data))) {
+        if ((NULL != amp->first->next) && (AMP_TYPE_BLOB == amp->first->next->type) && (NULL != amp->first->next->data)) {
+            cote_axon_dispatch_batch(cote, (uint8_t *)amp->first->next->data, (size_t)amp->first->next->size);
+        }
+        return NULL;
+    }
+
+    /* Definition of a topic ID by a publisher, the message is not dispatched */
+    if ((COTE_TYPE_SUB == cote->type) && (true == cote->options.topicIds) && (AMP_TYPE_BIGINT == amp->first->type) && (NULL != amp->first->data)
+        && (0 > *((int64_t *)amp->first->data))) {
+        amp_field_t *owner = (NULL != amp->first->next) ? amp->first->next->next : NULL;
+        if ((NULL != owner) && (AMP_TYPE_STRING == amp->first->next->type) && (NULL != amp->first->next->data) && (AMP_TYPE_STRING == owner->type)
+            && (NULL != owner->data)) {
+            cote_ids_define(&cote->ids, ~(*((int64_t *)amp->first->data)), (char *)amp->first->next->data, (char *)owner->data);
+        }
+        return NULL;
+    }
+
+    /* Decode the compressed request of a requester, the accepted algorithms are used to compress the reply */
+    uint8_t accept = 0;
+    if ((COTE_TYPE_REP == cote->type) && (COTE_COMPRESSION_NONE != cote->options.compression.algorithm) && (true == cote_compress_is_frame(amp->first))
+        && (0 != cote_compress_decode(amp->first, false, &accept))) {
+        /* Invalid compressed request */
+        COTE_STATS_INC(cote, unmatched);
+        return NULL;
+    }
+
+    /* Drop the request if its deadline has expired, the requester is not waiting for the reply anymore */
+    if ((COTE_TYPE_REP == cote->type) && (true == cote_axon_is_expired(cote, amp->first))) {
+        COTE_STATS_INC(cote, requests_expired);
+        return NULL;
+    }
+
+    /* Update statistics */
+    COTE_STATS_INC(cote, messages_in);
+
+    /* Check if message callback is define, it is invoked by cote_process when the event loop is used */
+    if ((NULL != cote->cb.message.fct) && (0 > cote->loop.fd)) {
+
+        /* Invoke message callback */
+        cote->cb.message.fct(cote, amp, cote->cb.message.user);
+    }
+
+    /* Treatment depending of Cote instance type */
+    if (COTE_TYPE_SUB == cote->type) {
+
+        /* Cote is Subscriber - Dispatch the message with cote_process (event loop), on the thread of its topic (dispatch threads), or inline */
+        if (0 <= cote->loop.fd) {
+
+            /* Move the fields to a new message, the original message is released by axon when returning */
+            amp_msg_t *job = amp_create();
+            if (NULL == job) {
+                /* Unable to allocate memory */
+                COTE_STATS_INC(cote, messages_dropped);
+                return NULL;
+            }
+            job->first   = amp->first;
+            job->last    = amp->last;
+            job->count   = amp->count;
+            amp->first   = NULL;
+            amp->last    = NULL;
+            amp->current = NULL;
+            amp->count   = 0;
+
+            /* Queue the message */
+            if (0 != cote_loop_push(&cote->loop, job, NULL)) {
+                /* Unable to queue the message */
+                COTE_STATS_INC(cote, messages_dropped);
+                amp_release(job);
+            }
+
+        } else if (0 < cote->pool.nb_workers) {
+
+            /* Queue the decoded fields, messages with the same topic are dispatched by the same thread to keep their order */
+            cote_ids_topic_t *id;
+            if (0 != cote_pool_push(&cote->pool, amp, cote_axon_get_fulltopic(cote, amp->first, NULL, &id))) {
+                /* Unable to queue the message */
+                COTE_STATS_INC(cote, messages_dropped);
+            }
+            cote_ids_put(id);
+
+        } else {
+
+            /* Dispatch the message */
+            cote_axon_dispatch_sub(cote, amp);
+        }
+
+    } else if (COTE_TYPE_REP == cote->type) {
+
+        /* Cote is Responder - Dispatch the request inline, axon sends the reply returned by the callback on the connection the request is received from */
+        ret = cote_axon_dispatch_rep(cote, amp);
+
+        /* Compress the large fields of the reply if the requester decodes the algorithm */
+        if ((NULL != ret) && (0 != (accept & (1 << cote->options.compression.algorithm)))) {
+            cote_compress_encode(ret, cote->options.compression.algorithm, cote->options.compression.threshold);
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Callback function invoked when a message is read from the shared memory
+ * @param amp AMP message
+ * @param user User data
+ */
+static void
+cote_shm_message_cb(amp_msg_t *amp, void *user) {
+
+    assert(NULL != amp);
+    assert(NULL != user);
+
+    /* Retrieve cote instance using user data */
+    cote_t *cote = (cote_t *)user;
+
+    /* A publisher is attached to the shared memory, its messages are not received with TCP anymore */
+    amp_field_t *field = amp->first;
+    if ((NULL != field) && (AMP_TYPE_STRING == field->type) && (!strcmp(COTE_SHM_ATTACH, (char *)field->data))) {
+        if ((NULL != field->next) && (AMP_TYPE_STRING == field->next->type)) {
+            char *iid = cote_shm_set_attached(cote->shm, (char *)field->next->data);
+            if (NULL != iid) {
+                while (0 == cote_peers_remove(&cote->peers, iid))
+                    ;
+                free(iid);
+            }
+        }
+        return;
+    }
+
+    /* Handle the message as if it has been received by axon, subscribers do not reply */
+    (void)cote_axon_message_cb(NULL, amp, user);
+}
+
+/**
+ * @brief Process an event of the event loop, invoked by the thread calling cote_process
+ * @param cote Cote instance
+ * @param event Event, its AMP message and its request are released by the function
+ */
+static void
+cote_loop_event_cb(cote_t *cote, cote_event_t *event) {
+
+    assert(NULL != cote);
+    assert(NULL != event);
+
+    if (NULL != event->request) {
+
+        /* Invoke the callback of the asynchronous request */
+        if (NULL != event->request->fct) {
+            event->request->fct(cote, event->amp, event->request->user);
+        }
+        cote_async_request_release(event->request);
+
+    } else {
+
+        /* Invoke message callback if defined and dispatch the message */
+        if (NULL != cote->cb.message.fct) {
+            cote->cb.message.fct(cote, event->amp, cote->cb.message.user);
+        }
+        cote_axon_dispatch_sub(cote, event->amp);
+    }
+
+    /* Release the message of the event, the event is a copy of the slot of the ring */
+    if (NULL != event->amp) {
+        amp_release(event->amp);
+    }
+}
+
+/**
+ * @brief Dispatch a message received by a Subscriber instance to the subscriptions matching its topic
+ * @param cote Cote instance
+ * @param amp AMP message, the topic field is released
+ */
+static void
+cote_axon_dispatch_sub(cote_t *cote, amp_msg_t *amp) {
+
+    assert(NULL != cote);
+    assert(NULL != amp);
+
+    /* Measure dispatch time if required */
+    uint64_t start = (true == cote->options.statsHistograms) ? cote_stats_now() : 0;
+
+    /* Enter subscriptions read-side section, the table is not locked and the callbacks are free to change the subscriptions */
+    unsigned int      epoch;
+    cote_sub_table_t *table = cote_subs_enter(&cote->subs, &epoch);
+
+    /* Invoke susbscriptions callback(s) if defined and if the first field of the AMP message is a string or a topic ID defined by the publisher */
+    cote_ids_topic_t *id        = NULL;
+    char *            fulltopic = (NULL != amp->first) ? cote_axon_get_fulltopic(cote, amp->first, table, &id) : NULL;
+    if ((NULL != fulltopic) && (false == cote_sub_table_is_empty(table))) {
+
+        /* Extract topic from the message */
+        amp_field_t *topic_field = amp->first;
+        amp->first               = amp->first->next;
+        if (NULL == amp->first) {
+            amp->last = NULL;
+        }
+        amp->count--;
+
+        /* Invoke all subscriptions matching the topic, the topic given to the callbacks is without "message::" and namespace prefixes */
+        cote_dispatch_t dispatch;
+        dispatch.cote  = cote;
+        dispatch.topic = fulltopic + strlen("message::")
+                         + ((NULL != cote->options.namespace_) ? (strlen(cote->options.namespace_) + strlen("::")) : 0);
+        dispatch.amp     = amp;
+        dispatch.ret     = NULL;
+        dispatch.matches = 0;
+        dispatch.raw     = false;
+        dispatch.invalid = false;
+        if ((NULL != id) && (true == id->matched) && (id->version == table->version)) {
+            /* Topic ID defined by the publisher, the subscriptions matching it are already known and no topic is compared */
+            for (int index = 0; index < id->nb_subs; index++) {
+                cote_axon_dispatch_cb(id->subs[index], &dispatch);
+            }
+        } else {
+            cote_sub_table_match(table, fulltopic, &cote_axon_dispatch_cb, &dispatch);
+        }
+        if (0 == dispatch.matches) {
+            COTE_STATS_INC(cote, unmatched);
+        }
+
+        /* Release topic */
+        free(topic_field->data);
+        free(topic_field);
+    }
+    cote_ids_put(id);
+
+    /* Leave subscriptions read-side section */
+    cote_subs_leave(&cote->subs, epoch);
+
+    /* Update statistics */
+    if (true == cote->options.statsHistograms) {
+        COTE_STATS_ADD(cote, dispatch_ns, cote_stats_now() - start);
+    }
+}
+
+/**
+ * @brief Dispatch a request received by a Replier instance to the subscriptions matching its topic
+ * @param cote Cote instance
+ * @param amp AMP message
+ * @return Reply to the request
+ */
+static amp_msg_t *
+cote_axon_dispatch_rep(cote_t *cote, amp_msg_t *amp) {
+
+    assert(NULL != cote);
+    assert(NULL != amp);
+
+    amp_msg_t *ret = NULL;
+
+    /* Measure dispatch time if required */
+    uint64_t start = (true == cote->options.statsHistograms) ? cote_stats_now() : 0;
+
+    /* Enter subscriptions read-side section, the table is not locked and the callbacks are free to change the subscriptions */
+    unsigned int      epoch;
+    cote_sub_table_t *table = cote_subs_enter(&cote->subs, &epoch);
+
+    /* Cote is Responder - Invoke susbscriptions callback(s) if defined and if the first field of the AMP message is a JSON */
+    if ((false == cote_sub_table_is_empty(table)) && (AMP_TYPE_JSON == amp->first->type) && (NULL != amp->first->data)) {
+
+        /* Extract topic from the message */
+        cJSON *tmp = cJSON_DetachItemFromObjectCaseSensitive(amp->first->data, "type");
+        if (NULL != tmp) {
+            char *topic = cJSON_GetStringValue(tmp);
+            if (NULL != topic) {
+                /* Invoke all subscriptions matching the topic */
+                cote_dispatch_t dispatch;
+                dispatch.cote    = cote;
+                dispatch.topic   = topic;
+                dispatch.amp     = amp;
+                dispatch.ret     = NULL;
+                dispatch.matches = 0;
+                dispatch.raw     = false;
+                dispatch.invalid = false;
+                cote_sub_table_match(table, topic, &cote_axon_dispatch_cb, &dispatch);
+                ret = dispatch.ret;
+                if (0 == dispatch.matches) {
+                    COTE_STATS_INC(cote, unmatched);
+                }
+            }
+            cJSON_Delete(tmp);
+        }
+
+    } else if ((false == cote_sub_table_is_empty(table)) && ((AMP_TYPE_STRING == amp->first->type) || (AMP_TYPE_BLOB == amp->first->type))
+               && (NULL != amp->first->data)) {
+
+        /* Extract topic from the JSON text of the message, the payload is parsed only if a subscription is matching and unmatched requests are rejected */
+        size_t len     = (AMP_TYPE_STRING == amp->first->type) ? strlen((char *)amp->first->data) : (size_t)amp->first->size;
+        char * topic   = cote_json_get_string((char *)amp->first->data, len, "type");
+        int    matches = 0;
+        if (NULL != topic) {
+            /* Invoke all subscriptions matching the topic */
+            cote_dispatch_t dispatch;
+            dispatch.cote    = cote;
+            dispatch.topic   = topic;
+            dispatch.amp     = amp;
+            dispatch.ret     = NULL;
+            dispatch.matches = 0;
+            dispatch.raw     = true;
+            dispatch.invalid = false;
+            cote_sub_table_match(table, topic, &cote_axon_dispatch_cb, &dispatch);
+            ret     = dispatch.ret;
+            matches = dispatch.matches;
+            free(topic);
+        }
+        if (0 == matches) {
+            COTE_STATS_INC(cote, unmatched);
+        }
+    }
+
+    /* Leave subscriptions read-side section */
+    cote_subs_leave(&cote->subs, epoch);
+
+    /* Update statistics */
+    if (true == cote->options.statsHistograms) {
+        COTE_STATS_ADD(cote, dispatch_ns, cote_stats_now() - start);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Retrieve the full topic of a received message from its first field, a string or a topic ID defined by the publisher
+ * @param cote Cote instance
+ * @param field First field of the message
+ * @param table Subscription table used to dispatch the message, NULL if the subscriptions matching a topic ID are not required
+ * @param id Topic of the topic ID, to be released with cote_ids_put, NULL if the field is not a topic ID
+ * @return Full topic, NULL if the field is not a topic
+ */
+static char *
+cote_axon_get_fulltopic(cote_t *cote, amp_field_t *field, cote_sub_table_t *table, cote_ids_topic_t **id) {
+
+    assert(NULL != cote);
+    assert(NULL != field);
+    assert(NULL != id);
+
+    *id = NULL;
+
+    /* Full topic sent as a string */
+    if ((AMP_TYPE_STRING == field->type) && (NULL != field->data)) {
+        return (char *)field->data;
+    }
+
+    /* Key of the topic, the topic is at the index of the topic ID in the topic table of the publisher */
+    if ((true == cote->options.topicIds) && (AMP_TYPE_BIGINT == field->type) && (NULL != field->data)) {
+        *id = cote_ids_get(&cote->ids, *((int64_t *)field->data), table);
+    }
+
+    return (NULL != *id) ? (*id)->fulltopic : NULL;
+}
+
+/**
+ * @brief Function invoked for each subscription matching the topic of a received message
+ * @param sub Subscription
+ * @param user Dispatch context
+ */
+static void
+cote_axon_dispatch_cb(cote_sub_t *sub, void *user) {
+
+    assert(NULL != sub);
+    assert(NULL != user);
+
+    /* Retrieve dispatch context using user data */
+    cote_dispatch_t *dispatch = (cote_dispatch_t *)user;
+
+    /* Parse the JSON text of the message when the first subscription is matching */
+    if (true == dispatch->raw) {
+        dispatch->raw     = false;
+        dispatch->invalid = (0 != cote_axon_parse_request(dispatch->cote, dispatch->amp)) ? true : false;
+    }
+
+    /* Invoke subscription callback if defined, measure execution time if required */
+    if ((NULL != sub->fct) && (false == dispatch->invalid)) {
+        uint64_t start = (true == dispatch->cote->options.statsHistograms) ? cote_stats_now() : 0;
+        dispatch->ret  = sub->fct(dispatch->cote, dispatch->topic, dispatch->amp, sub->user);
+        COTE_STATS_INC(dispatch->cote, matches);
+        if (true == dispatch->cote->options.statsHistograms) {
+            cote_stats_record(cote_stats_shard(dispatch->cote)->stats.callbacks, cote_stats_now() - start);
+        }
+        dispatch->matches++;
+    }
+}
+
+/**
+ * @brief Parse the JSON text of the first field of a request, the field is replaced by the JSON object without the "type" member
+ * @param cote Cote instance
+ * @param amp AMP message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_parse_request(cote_t *cote, amp_msg_t *amp) {
+
+    assert(NULL != cote);
+    assert(NULL != amp);
+    assert(NULL != amp->first);
+    assert(NULL != amp->first->data);
+
+    /* Parse the JSON text */
+    amp_field_t *field = amp->first;
+    size_t       len   = (AMP_TYPE_STRING == field->type) ? strlen((char *)field->data) : (size_t)field->size;
+    cJSON *      json  = cJSON_ParseWithLength((char *)field->data, len);
+    if (NULL == json) {
+        /* Invalid JSON text */
+        return -1;
+    }
+    if (!cJSON_IsObject(json)) {
+        /* Not an object */
+        cJSON_Delete(json);
+        return -1;
+    }
+
+    /* Remove topic and deadline from the payload, the deadline is only sent to the repliers enforcing it */
+    cJSON_DeleteItemFromObjectCaseSensitive(json, "type");
+    if (true == cote->options.deadline) {
+        cJSON_DeleteItemFromObjectCaseSensitive(json, COTE_DEADLINE_KEY);
+    }
+
+    /* Replace the field */
+    free(field->data);
+    field->type = AMP_TYPE_JSON;
+    field->data = json;
+    field->size = 0;
+
+    return 0;
+}
+
+/**
+ * @brief Check the deadline of a request (Replier instance with requestDeadline), the deadline member is removed from the JSON payload
+ * @param cote Cote instance
+ * @param field First field of the request
+ * @return true if the deadline of the request has expired, false otherwise
+ */
+static bool
+cote_axon_is_expired(cote_t *cote, amp_field_t *field) {
+
+    assert(NULL != cote);
+    assert(NULL != field);
+
+    int64_t deadline = 0;
+
+    /* Retrieve the deadline of the request, the JSON text is not parsed */
+    if ((false == cote->options.deadline) || (NULL == field->data)) {
+        return false;
+    } else if (AMP_TYPE_JSON == field->type) {
+        cJSON *item = cJSON_DetachItemFromObjectCaseSensitive((cJSON *)field->data, COTE_DEADLINE_KEY);
+        if (NULL == item) {
+            return false;
+        }
+        deadline = (cJSON_IsNumber(item)) ? (int64_t)cJSON_GetNumberValue(item) : 0;
+        cJSON_Delete(item);
+    } else if ((AMP_TYPE_STRING == field->type) || (AMP_TYPE_BLOB == field->type)) {
+        size_t len = (AMP_TYPE_STRING == field->type) ? strlen((char *)field->data) : (size_t)field->size;
+        if (0 != cote_json_get_integer((char *)field->data, len, COTE_DEADLINE_KEY, &deadline)) {
+            return false;
+        }
+    }
+    if (0 >= deadline) {
+        /* No deadline */
+        return false;
+    }
+
+    /* Compare the deadline to the current time */
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return (deadline < (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000) ? true : false;
+}
+
+/**
+ * @brief Callback function called to handle error from Axon instance
+ * @param axon Axon instance
+ * @param err Error as string
+ * @param user User data
+ */
+static void
+cote_axon_error_cb(axon_t *axon, char *err, void *user) {
+
+    (void)axon;
+    assert(NULL != err);
+    assert(NULL != user);
+
+    /* Retrieve cote instance using user data */
+    cote_t *cote = (cote_t *)user;
+
+    /* Invoke error callback if defined */
+    if (NULL != cote->cb.error.fct) {
+        cote->cb.error.fct(cote, err, cote->cb.error.user);
+    }
+}
+
+/**
+ * @brief Send a request to the replier chosen by the load balancing (Requester instance)
+ * @param cote Cote instance
+ * @param type Type of the payload, AMP_TYPE_JSON or AMP_TYPE_STRING
+ * @param data Payload of the request
+ * @param resp AMP response message
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_request(cote_t *cote, amp_type_e type, void *data, amp_msg_t **resp, int timeout) {
+
+    assert(NULL != cote);
+    assert(NULL != data);
+
+    int   ret  = -1;
+    char *text = NULL;
+
+    /* Algorithms decoded by this instance, announced to the repliers supporting compression to receive compressed replies */
+    cote_compression_e algorithm = cote->options.compression.algorithm;
+    uint8_t            accept    = (COTE_COMPRESSION_NONE != algorithm) ? cote_compress_available() : 0;
+
+    /* Deadline of the request, attached for the repliers enforcing it */
+    int64_t deadline = cote_axon_deadline(cote, timeout);
+
+    /* Hedge the request if there are several repliers and the delay is shorter than the timeout */
+    uint64_t start = cote_stats_now();
+    int      delay = cote_hedge_delay(cote);
+    if ((0 < delay) && (delay < timeout) && (2 <= cote_peers_count(&cote->peers)) && (true == cote_hedge_reserve(cote))) {
+
+        /* Send the payload to the repliers, it is serialized once because the abandoned attempt may still be sending it once returning */
+        ret = cote_hedge_request(cote, type, data, deadline, resp, timeout, delay);
+
+    } else {
+
+        /* Send message to the replier chosen by the load balancing, the round-trip is always measured to update the latency of the replier */
+        for (int attempt = 0; attempt < COTE_REQUEST_ATTEMPTS; attempt++) {
+            cote_peer_t *peer = cote_peers_enter(&cote->peers);
+            if (NULL == peer) {
+                /* No replier available */
+                break;
+            }
+            uint64_t sent = cote_stats_now();
+            ret           = cote_axon_request_peer(cote, peer, type, data, deadline, &text, resp, timeout);
+            if ((false == cote_peers_leave(&cote->peers, peer, cote_stats_now() - sent)) || (0 == ret)) {
+                /* Reply received, or the replier is still available */
+                break;
+            }
+        }
+    }
+    if ((NULL != text) && (AMP_TYPE_JSON == type)) {
+        cJSON_free(text);
+    }
+
+    /* Decode the compressed fields of the reply */
+    if ((0 == ret) && (0 != accept) && (NULL != resp) && (NULL != *resp)) {
+        for (amp_field_t *field = (*resp)->first; NULL != field; field = field->next) {
+            if ((true == cote_compress_is_frame(field)) && (0 != cote_compress_decode(field, true, NULL))) {
+                /* Invalid compressed field */
+                ret = -1;
+            }
+        }
+        if (0 != ret) {
+            amp_release(*resp);
+            *resp = NULL;
+        }
+    }
+
+    /* Update statistics */
+    if (0 == ret) {
+        COTE_STATS_INC(cote, messages_out);
+        if (true == cote->options.statsHistograms) {
+            cote_stats_record(cote_stats_shard(cote)->stats.requests, cote_stats_now() - start);
+        }
+    } else {
+        COTE_STATS_INC(cote, requests_failed);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Send a request to a replier, the JSON text of the request is framed and compressed if the replier supports compression
+ * @param cote Cote instance
+ * @param peer Peer of the replier
+ * @param type Type of the payload, AMP_TYPE_JSON or AMP_TYPE_STRING
+ * @param data Payload of the request
+ * @param deadline Deadline of the request, attached only if the replier enforces it, 0 if no deadline is attached
+ * @param text JSON text of the request, formatted for the first replier supporting compression (to be released by the caller if the payload is a JSON)
+ * @param resp AMP response message
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_request_peer(cote_t *cote, cote_peer_t *peer, amp_type_e type, void *data, int64_t deadline, char **text, amp_msg_t **resp, int timeout) {
+
+    assert(NULL != cote);
+    assert(NULL != peer);
+    assert(NULL != data);
+    assert(NULL != text);
+
+    /* Attach the deadline if the replier enforces it, the payload is not modified */
+    if ((0 != deadline) && (0 != (peer->caps & COTE_PEER_CAP_DEADLINE))) {
+        void *request = (AMP_TYPE_JSON == type) ? (void *)cote_axon_envelope((cJSON *)data, NULL, deadline)
+                                                : (void *)cote_json_insert_integer((char *)data, COTE_DEADLINE_KEY, deadline);
+        if (NULL == request) {
+            /* Unable to allocate memory */
+            return -1;
+        }
+        char *tmp = NULL;
+        int   ret = cote_axon_request_peer(cote, peer, type, request, 0, &tmp, resp, timeout);
+        if (AMP_TYPE_JSON == type) {
+            if (NULL != tmp) {
+                cJSON_free(tmp);
+            }
+            cJSON_Delete((cJSON *)request);
+        } else {
+            free(request);
+        }
+        return ret;
+    }
+
+    /* Algorithms decoded by this instance, announced to the repliers supporting compression to receive compressed replies */
+    cote_compression_e algorithm = cote->options.compression.algorithm;
+    uint8_t            accept    = (COTE_COMPRESSION_NONE != algorithm) ? cote_compress_available() : 0;
+
+    /* Check if the replier supports compression */
+    if (0 == (peer->caps & accept)) {
+        return axon_send(peer->axon, 1, type, data, resp, timeout);
+    }
+
+    /* The replier supports compression, the JSON text is framed and compressed if it is large enough and the replier decodes the algorithm */
+    if ((NULL == *text) && (AMP_TYPE_JSON == type)) {
+        *text = cJSON_PrintUnformatted((cJSON *)data);
+    } else if (NULL == *text) {
+        *text = (char *)data;
+    }
+    if (NULL == *text) {
+        /* Unable to allocate memory */
+        return -1;
+    }
+    size_t len      = strlen(*text);
+    bool   compress = (((size_t)cote->options.compression.threshold <= len) && (0 != (peer->caps & (1 << algorithm)))) ? true : false;
+    int    size     = 0;
+    void * frame    = cote_compress_frame(*text, len, (true == compress) ? algorithm : COTE_COMPRESSION_NONE, accept, &size);
+    int    ret      = (NULL != frame) ? axon_send(peer->axon, 1, AMP_TYPE_BLOB, frame, size, resp, timeout) : -1;
+    free(frame);
+
+    return ret;
+}
+
+/**
+ * @brief Create the envelope of a request, the members of the payload are referenced and not copied, the payload is not modified
+ * @param payload JSON payload of the request
+ * @param topic Topic of the request, replacing the "type" member of the payload, NULL to keep the members of the payload
+ * @param deadline Deadline of the request, 0 if no deadline is attached
+ * @return Envelope object if the function succeeded (to be released by the caller before the payload), NULL otherwise
+ */
+static cJSON *
+cote_axon_envelope(cJSON *payload, char *topic, int64_t deadline) {
+
+    assert(NULL != payload);
+
+    /* Create envelope */
+    cJSON *envelope = cJSON_CreateObject();
+    if (NULL == envelope) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+
+    /* Add the topic and the deadline, and reference the other members of the payload so that each key appears only once */
+    bool failed = false;
+    if (NULL != topic) {
+        failed = (NULL == cJSON_AddStringToObject(envelope, "type", topic)) ? true : false;
+    }
+    if ((false == failed) && (0 != deadline)) {
+        failed = (NULL == cJSON_AddNumberToObject(envelope, COTE_DEADLINE_KEY, (double)deadline)) ? true : false;
+    }
+    cJSON *member = NULL;
+    cJSON_ArrayForEach(member, payload) {
+        if ((false == failed) && (NULL != member->string) && ((NULL == topic) || (strcmp("type", member->string)))
+            && ((0 == deadline) || (strcmp(COTE_DEADLINE_KEY, member->string)))) {
+            failed = (!cJSON_AddItemReferenceToObject(envelope, member->string, member)) ? true : false;
+        }
+    }
+    if (true == failed) {
+        /* Unable to allocate memory */
+        cJSON_Delete(envelope);
+        return NULL;
+    }
+
+    return envelope;
+}
+
+/**
+ * @brief Function invoked by the attempts of the hedged requests to send a request to a replier
+ * The JSON text is sent as is to the c-cote repliers, it is parsed only for the other repliers which expect a JSON payload
+ * @param cote Cote instance
+ * @param peer Peer of the replier
+ * @param type Type of the payload, AMP_TYPE_JSON or AMP_TYPE_STRING
+ * @param text JSON text of the payload, shared by the attempts
+ * @param deadline Deadline of the request, attached only if the replier enforces it, 0 if no deadline is attached
+ * @param resp AMP response message
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_request_hedge_cb(cote_t *cote, cote_peer_t *peer, amp_type_e type, char *text, int64_t deadline, amp_msg_t **resp, int timeout) {
+
+    assert(NULL != cote);
+    assert(NULL != peer);
+    assert(NULL != text);
+
+    /* Algorithms decoded by this instance, announced to the repliers supporting compression to receive compressed replies */
+    cote_compression_e algorithm = cote->options.compression.algorithm;
+    uint8_t            accept    = (COTE_COMPRESSION_NONE != algorithm) ? cote_compress_available() : 0;
+
+    /* Send the text as the requests which are not hedged to the repliers decoding it, the text is shared by the attempts and not modified */
+    char *tmp = NULL;
+    if ((AMP_TYPE_STRING == type) || (0 != (peer->caps & (accept | COTE_PEER_CAP_DEADLINE)))) {
+        return cote_axon_request_peer(cote, peer, AMP_TYPE_STRING, text, deadline, &tmp, resp, timeout);
+    }
+
+    /* The replier expects a JSON payload */
+    cJSON *payload = cJSON_Parse(text);
+    if (NULL == payload) {
+        /* Unable to allocate memory */
+        return -1;
+    }
+    int ret = cote_axon_request_peer(cote, peer, AMP_TYPE_JSON, payload, deadline, &tmp, resp, timeout);
+    if (NULL != tmp) {
+        cJSON_free(tmp);
+    }
+    cJSON_Delete(payload);
+
+    return ret;
+}
+
+/**
+ * @brief Get the absolute deadline of a request, the real time is used so that the deadline can be compared by repliers running on other hosts
+ * @param cote Cote instance
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return Deadline as milliseconds since the Epoch, 0 if no deadline is attached to the request
+ */
+static int64_t
+cote_axon_deadline(cote_t *cote, int timeout) {
+
+    assert(NULL != cote);
+
+    /* Check if the deadline is attached to the requests */
+    if ((false == cote->options.deadline) || (0 >= timeout)) {
+        return 0;
+    }
+
+    /* Add the timeout to the current time */
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000 + timeout;
+}
+
+/**
+ * @brief Create an axon instance connected to a discovered node (Subscriber and Requester instances, Publisher instance with selective fan-out)
+ * @param cote Cote instance
+ * @param address Address (or hostname) of the node
+ * @param port Port of the node
+ * @return Axon instance if the function succeeded, NULL otherwise
+ */
+static axon_t *
+cote_axon_connect(cote_t *cote, char *address, uint16_t port) {
+
+    assert(NULL != cote);
+    assert(NULL != address);
+
+    /* Create axon instance */
+    axon_t *axon = axon_create((COTE_TYPE_SUB == cote->type) ? "sub" : ((COTE_TYPE_REQ == cote->type) ? "req" : "pub"));
+    if (NULL == axon) {
+        /* Unable to create Axon instance */
+        return NULL;
+    }
+
+    /* Definition of axon error and message callbacks */
+    axon_on(axon, "error", &cote_axon_error_cb, cote);
+    if (COTE_TYPE_SUB == cote->type) {
+        axon_on(axon, "message", &cote_axon_message_cb, cote);
+    }
+
+    /* Connect to the node */
+    if (0 != axon_connect(axon, address, port)) {
+        /* Unable to connect */
+        axon_release(axon);
+        return NULL;
+    }
+
+    return axon;
+}
+
+/**
+ * @brief Format fulltopic
+ * @param cote Cote instance
+ * @param topic Topic
+ * @return Fulltopic if the fonction succeeded, NULL otherwise
+ */
+static char *
+cote_axon_format_fulltopic(cote_t *cote, char *topic) {
+
+    char *fulltopic = NULL;
+
+    /* Treatment depending of Cote instance type */
+    if ((COTE_TYPE_PUB == cote->type) || (COTE_TYPE_SUB == cote->type)) {
+
+        /* Wait options semaphore */
+        cote_stats_sem_wait(cote, &cote->options.sem);
+
+        /* Format full topic */
+        size_t len = 0;
+        if (NULL != cote->options.namespace_) {
+            len = strlen("message::") + strlen(cote->options.namespace_) + strlen("::") + strlen(topic) + 1;
+        } else {
+            len = strlen("message::") + strlen(topic) + 1;
+        }
+        if (NULL == (fulltopic = (char *)malloc(len))) {
+            /* Unable to allocate memory */
+            sem_post(&cote->options.sem);
+            return NULL;
+        }
         memset(fulltopic, 0, len);
         strcat(fulltopic, "message::");
         if (NULL != cote->options.namespace_) {
-            strcat(fulltopic, cote->options.namespace_);
-            strcat(fulltopic, "::");
+            strcat(fulltopic, cote->options.namespace_);
+            strcat(fulltopic, "::");
+        }
+        strcat(fulltopic, topic);
+
+        /* Release options semaphore */
+        sem_post(&cote->options.sem);
+
+    } else if ((COTE_TYPE_REQ == cote->type) || (COTE_TYPE_REP == cote->type)) {
+
+        /* Fulltopic is the topic itself */
+        fulltopic = strdup(topic);
+    }
+
+    return fulltopic;
+}
+
+/**
+ * @brief Set cote option, the options semaphore must be taken by the caller
+ * @param cote Cote instance
+ * @param option Option by name
+ * @param value New value of the option
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_option_set(cote_t *cote, char *option, void *value) {
+
+    assert(NULL != cote);
+    assert(NULL != option);
+
+    int ret = -1;
+
+    /* Treatment depending of the option */
+    if (!strcmp("helloInterval", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+        if (0 == ret) {
+            __atomic_store_n(&cote->options.discovery.helloInterval, *((int *)value), __ATOMIC_RELAXED);
+        }
+    } else if (!strcmp("discoveryMode", option)) {
+        if (!strcmp("default", (char *)value)) {
+            cote->options.discovery.mode = COTE_DISCOVERY_DEFAULT;
+            ret                          = 0;
+        } else if (!strcmp("fast", (char *)value)) {
+            cote->options.discovery.mode = COTE_DISCOVERY_FAST;
+            ret                          = 0;
+        }
+    } else if (!strcmp("checkInterval", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("nodeTimeout", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("masterTimeout", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("address", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("port", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("broadcast", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("multicast", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("multicastTTL", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("unicast", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("key", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("mastersRequired", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("weight", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("client", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("reuseAddr", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("ignoreProcess", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("ignoreInstance", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("hostname", option)) {
+        ret = discover_set_option(cote->discover, option, value);
+    } else if (!strcmp("namespace", option)) {
+        if (NULL != cote->options.namespace_) {
+            free(cote->options.namespace_);
+        }
+        cote->options.namespace_ = strdup((char *)value);
+        if (NULL != cote->options.namespace_) {
+            ret = 0;
+        }
+    } else if (!strcmp("selectiveFanout", option)) {
+        cote->options.selectiveFanout = *((bool *)value);
+        ret                           = 0;
+    } else if (!strcmp("sharedMemory", option)) {
+        cote->options.sharedMemory = *((bool *)value);
+        ret                        = 0;
+    } else if (!strcmp("topicIds", option)) {
+        cote->options.topicIds = *((bool *)value);
+        ret                    = 0;
+    } else if (!strcmp("replay", option)) {
+        /* Only the subscribers joining with selective fan-out or shared memory are known by the publisher and receive the replay */
+        if ((0 <= *((int *)value)) && (COTE_REPLAY_DEPTH_MAX >= *((int *)value))
+            && ((0 == *((int *)value)) || (true == cote->options.selectiveFanout) || (true == cote->options.sharedMemory))) {
+            cote->options.replay = *((int *)value);
+            ret                  = 0;
+        }
+    } else if (!strcmp("shards", option)) {
+        if ((1 <= *((int *)value)) && (COTE_SHARDS_MAX >= *((int *)value))) {
+            cote->options.shards = *((int *)value);
+            ret                  = 0;
+        }
+    } else if (!strcmp("highWaterMark", option)) {
+        if (0 <= *((int *)value)) {
+            cote->options.highWaterMark = *((int *)value);
+            ret                         = 0;
+        }
+    } else if (!strcmp("corkDelay", option)) {
+        ret = cote_cork_set_delay(cote, *((int *)value));
+    } else if (!strcmp("corkBytes", option)) {
+        ret = cote_cork_set_bytes(&cote->cork, *((int *)value));
+    } else if (!strcmp("dropPolicy", option)) {
+        if (!strcmp("block", (char *)value)) {
+            cote->options.dropPolicy = COTE_DROP_BLOCK;
+            ret                      = 0;
+        } else if (!strcmp("drop-oldest", (char *)value)) {
+            cote->options.dropPolicy = COTE_DROP_OLDEST;
+            ret                      = 0;
+        } else if (!strcmp("drop-newest", (char *)value)) {
+            cote->options.dropPolicy = COTE_DROP_NEWEST;
+            ret                      = 0;
+        } else if (!strcmp("disconnect", (char *)value)) {
+            cote->options.dropPolicy = COTE_DROP_DISCONNECT;
+            ret                      = 0;
+        }
+    } else if (!strcmp("compression", option)) {
+        if (!strcmp("none", (char *)value)) {
+            cote->options.compression.algorithm = COTE_COMPRESSION_NONE;
+            ret                                 = 0;
+        } else if ((!strcmp("lz4", (char *)value)) && (0 != (cote_compress_available() & (1 << COTE_COMPRESSION_LZ4)))) {
+            cote->options.compression.algorithm = COTE_COMPRESSION_LZ4;
+            ret                                 = 0;
+        } else if ((!strcmp("zstd", (char *)value)) && (0 != (cote_compress_available() & (1 << COTE_COMPRESSION_ZSTD)))) {
+            cote->options.compression.algorithm = COTE_COMPRESSION_ZSTD;
+            ret                                 = 0;
+        }
+    } else if (!strcmp("compressionThreshold", option)) {
+        if (0 <= *((int *)value)) {
+            cote->options.compression.threshold = *((int *)value);
+            ret                                 = 0;
+        }
+    } else if (!strcmp("loadBalancing", option)) {
+        ret = cote_peers_set_balancing(&cote->peers, (char *)value);
+    } else if (!strcmp("hedgeDelay", option)) {
+        if (0 <= *((int *)value)) {
+            cote->options.hedge.delay = *((int *)value);
+            ret                       = 0;
+        }
+    } else if (!strcmp("hedgePercentile", option)) {
+        if ((0 <= *((int *)value)) && (100 >= *((int *)value))) {
+            cote->options.hedge.percentile = *((int *)value);
+            ret                            = 0;
+        }
+    } else if (!strcmp("hedgeThreads", option)) {
+        ret = cote_hedge_set_threads(cote, *((int *)value));
+    } else if (!strcmp("requestDeadline", option)) {
+        cote->options.deadline = *((bool *)value);
+        ret                    = 0;
+    } else if (!strcmp("maxRepliers", option)) {
+        if (0 <= *((int *)value)) {
+            cote->options.maxRepliers = *((int *)value);
+            ret                       = 0;
+        }
+    } else if (!strcmp("asyncThreads", option)) {
+        ret = cote_async_set_threads(&cote->requests, *((int *)value));
+    } else if (!strcmp("asyncQueue", option)) {
+        ret = cote_async_set_queue(&cote->requests, *((int *)value));
+    } else if (!strcmp("eventLoop", option)) {
+        cote->options.eventLoop = *((bool *)value);
+        ret                     = 0;
+    } else if (!strcmp("dispatchThreads", option)) {
+        cote->options.dispatchThreads = *((int *)value);
+        ret                           = 0;
+    } else if (!strcmp("statsHistograms", option)) {
+        cote->options.statsHistograms = *((bool *)value);
+        ret                           = 0;
+    } else if (!strcmp("useHostNames", option)) {
+        cote->options.use_hostname = *((bool *)value);
+        ret                        = 0;
+    } else if (!strcmp("advertisement", option)) {
+        if (NULL != cote->options.advertisement) {
+            cJSON_Delete(cote->options.advertisement);
+        }
+        cote->options.advertisement = (NULL != value) ? cJSON_Duplicate((cJSON *)value, 1) : NULL;
+        ret                         = 0;
+    } else if (!strcmp("broadcasts", option)) {
+        if (NULL != cote->options.broadcasts) {
+            cJSON_Delete(cote->options.broadcasts);
+        }
+        cote->options.broadcasts = (NULL != value) ? cJSON_Duplicate((cJSON *)value, 1) : NULL;
+        ret                      = 0;
+    } else if (!strcmp("subscribesTo", option)) {
+        if (NULL != cote->options.subscribesTo) {
+            cJSON_Delete(cote->options.subscribesTo);
+        }
+        cote->options.subscribesTo = (NULL != value) ? cJSON_Duplicate((cJSON *)value, 1) : NULL;
+        ret                        = 0;
+        cote_discovery_compile_patterns(cote);
+    } else if (!strcmp("requests", option)) {
+        if (NULL != cote->options.requests) {
+            cJSON_Delete(cote->options.requests);
+        }
+        cote->options.requests = (NULL != value) ? cJSON_Duplicate((cJSON *)value, 1) : NULL;
+        ret                    = 0;
+        cote_discovery_compile_patterns(cote);
+    } else if (!strcmp("respondsTo", option)) {
+        if (NULL != cote->options.respondsTo) {
+            cJSON_Delete(cote->options.respondsTo);
+        }
+        cote->options.respondsTo = (NULL != value) ? cJSON_Duplicate((cJSON *)value, 1) : NULL;
+        ret                      = 0;
+    }
+
+    /* The advertisement must be built again if one of its inputs has changed */
+    if ((0 == ret)
+        && ((!strcmp("namespace", option)) || (!strcmp("advertisement", option)) || (!strcmp("broadcasts", option)) || (!strcmp("subscribesTo", option))
+            || (!strcmp("requests", option)) || (!strcmp("respondsTo", option)) || (!strcmp("selectiveFanout", option))
+            || (!strcmp("sharedMemory", option)) || (!strcmp("topicIds", option)) || (!strcmp("compression", option))
+            || (!strcmp("requestDeadline", option)) || (!strcmp("discoveryMode", option)))) {
+        cote->options.dirty = true;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Send a message of a Publisher instance to the axon instance and to the peers interested in the topic
+ * @param cote Cote instance
+ * @param topic Topic of the message
+ * @param fanout Message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_publish(cote_t *cote, char *topic, cote_fanout_t *fanout) {
+
+    assert(NULL != cote);
+    assert(NULL != cote->axon);
+    assert(NULL != topic);
+    assert(NULL != fanout);
+
+    /* Send message to the subscribers connected to the publisher, or to the shard of the topic */
+    int ret = cote_axon_publish_axon(cote, topic, fanout);
+
+    /* Send message to the subscribers with selective fan-out or shared memory interested in the topic */
+    if (((true == cote->options.selectiveFanout) || (true == cote->options.sharedMemory))
+        && (0 != cote_peers_send(&cote->peers, topic, &cote_axon_publish_peer, fanout))) {
+        ret = -1;
+    }
+
+    /* Release the copy of the message, the send queues keep their own references */
+    cote_queue_msg_put(fanout->queued);
+    fanout->queued = NULL;
+
+    return ret;
+}
+
+/**
+ * @brief Cork a message of a Publisher instance, it is sent with the other corked messages once the delay expires or the size of their frames is reached
+ * @param cote Cote instance
+ * @param topic Topic handle of the message
+ * @param fanout Message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_cork(cote_t *cote, cote_topic_t *topic, cote_fanout_t *fanout) {
+
+    assert(NULL != cote);
+    assert(NULL != topic);
+    assert(NULL != fanout);
+
+    /* The params are converted to an array of fields, the message is copied when it is corked */
+    cote_field_t  fields[COTE_FIELDS_MAX];
+    int64_t       bigints[COTE_FIELDS_MAX];
+    cote_field_t *corked = fanout->fields;
+    if (NULL != fanout->params) {
+        if (0 != cote_axon_publish_fields(fanout, fields, bigints)) {
+            /* Too many fields */
+            COTE_STATS_INC(cote, send_errors);
+            return -1;
+        }
+        corked = fields;
+    }
+
+    /* Cork the message, the statistics of the corked messages are updated once they are sent */
+    if (0 != cote_cork_push(cote, topic, corked, fanout->count)) {
+        COTE_STATS_INC(cote, send_errors);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Keep a message of a Publisher instance for replay and send it to the axon instance (or the shard of the topic), the peers are not considered
+ * @param cote Cote instance
+ * @param topic Topic of the message
+ * @param fanout Message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_publish_axon(cote_t *cote, char *topic, cote_fanout_t *fanout) {
+
+    assert(NULL != cote);
+    assert(NULL != cote->axon);
+    assert(NULL != topic);
+    assert(NULL != fanout);
+
+    /* Key of the topic sent to the subscribers decoding topic IDs */
+    bool ids      = ((true == cote->options.topicIds) && (0 <= fanout->id) && (COTE_IDS_MAX > fanout->id)) ? true : false;
+    fanout->key   = (true == ids) ? COTE_IDS_KEY(__atomic_load_n(&cote->ids.tag, __ATOMIC_ACQUIRE), fanout->id) : -1;
+    fanout->owner = cote->ids.owner;
+
+    /* Keep the message for the joining subscribers, it is kept before being sent so that the subscribers added meanwhile receive it */
+    if (0 < cote->replay.depth) {
+        cote_field_t fields[COTE_FIELDS_MAX];
+        int64_t      bigints[COTE_FIELDS_MAX];
+        if ((NULL != fanout->fields) || (0 == cote_axon_publish_fields(fanout, fields, bigints))) {
+            cote_replay_store(&cote->replay, topic, fanout->fulltopic, (NULL != fanout->fields) ? fanout->fields : fields, fanout->count);
+        }
+    }
+
+    /* axon can not encode the arrays with too many fields, these messages are only sent to the peers with selective fan-out or shared memory */
+    if ((NULL == fanout->params) && (COTE_AXON_FIELDS_MAX < fanout->count)) {
+        return ((true == cote->options.selectiveFanout) || (true == cote->options.sharedMemory)) ? 0 : -1;
+    }
+
+    /* Send message to the subscribers connected to the publisher, or to the shard of the topic */
+    return cote_axon_publish_cb((0 < cote->shards.count) ? cote_shards_get(&cote->shards, topic) : cote->axon, fanout);
+}
+
+/**
+ * @brief Send several messages of a Publisher instance, the peers decoding batches receive the frames of the messages at once
+ * @param cote Cote instance
+ * @param msgs Messages
+ * @param frames Frames of the messages already prepared, NULL to prepare them
+ * @param count Amount of messages
+ * @return 0 if the function succeeded, -1 if at least one message has not been sent
+ */
+static int
+cote_axon_send_batch(cote_t *cote, cote_msg_t *msgs, cote_frame_t *frames, int count) {
+
+    assert(NULL != cote);
+    assert(NULL != cote->axon);
+    assert((NULL != msgs) || (0 == count));
+
+    int ret = 0;
+
+    /* The peers decoding batches receive the frames of the messages at once, the messages are sent one by one if the batch can not be encoded */
+    cote_batch_t batch;
+    if (((true == cote->options.selectiveFanout) || (true == cote->options.sharedMemory)) && (0 < count)
+        && (0 == cote_axon_batch_create(&batch, msgs, frames, count))) {
+
+        /* Send the messages to the subscribers connected to the publisher, axon encodes each message */
+        for (int index = 0; index < count; index++) {
+            if (0 != cote_axon_publish_axon(cote, msgs[index].topic->topic, &batch.fanouts[index])) {
+                batch.status[index] = -1;
+            }
+        }
+
+        /* Send the batch to the peers */
+        (void)cote_peers_send(&cote->peers, NULL, &cote_axon_batch_peer, &batch);
+
+        /* Update statistics */
+        for (int index = 0; index < count; index++) {
+            if (0 == batch.status[index]) {
+                COTE_STATS_INC(cote, messages_out);
+            } else {
+                COTE_STATS_INC(cote, send_errors);
+                ret = -1;
+            }
+        }
+
+        /* Release batch */
+        cote_axon_batch_release(&batch);
+
+        return ret;
+    }
+
+    /* Send all messages, continue if a message can not be sent */
+    for (int index = 0; index < count; index++) {
+        assert(NULL != msgs[index].topic);
+        cote_fanout_t fanout = { .fulltopic = __atomic_load_n(&msgs[index].topic->fulltopic, __ATOMIC_ACQUIRE),
+                                 .count     = msgs[index].count,
+                                 .params    = NULL,
+                                 .fields    = msgs[index].fields,
+                                 .id        = msgs[index].topic->id };
+        if (0 == cote_axon_publish(cote, msgs[index].topic->topic, &fanout)) {
+            COTE_STATS_INC(cote, messages_out);
+        } else {
+            COTE_STATS_INC(cote, send_errors);
+            ret = -1;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Encode a batch of messages of a Publisher instance, the frames of all the messages are written in a single buffer
+ * @param batch Batch
+ * @param msgs Messages
+ * @param frames Frames of the messages already prepared, NULL to prepare them
+ * @param count Amount of messages
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_batch_create(cote_batch_t *batch, cote_msg_t *msgs, cote_frame_t *frames, int count) {
+
+    assert(NULL != batch);
+    assert(NULL != msgs);
+    assert(0 < count);
+
+    /* Initialize batch */
+    memset(batch, 0, sizeof(cote_batch_t));
+    batch->msgs    = msgs;
+    batch->count   = count;
+    batch->fanouts = (cote_fanout_t *)calloc(count, sizeof(cote_fanout_t));
+    batch->status  = (int *)calloc(count, sizeof(int));
+    batch->offsets = (size_t *)malloc((count + 1) * sizeof(size_t));
+    if ((NULL == batch->fanouts) || (NULL == batch->status) || (NULL == batch->offsets)) {
+        /* Unable to allocate memory */
+        cote_axon_batch_release(batch);
+        return -1;
+    }
+
+    /* Encode the frames of the messages one after the other, the buffer grows as required */
+    size_t size     = 0;
+    size_t capacity = 0;
+    for (int index = 0; index < count; index++) {
+        assert(NULL != msgs[index].topic);
+        batch->fanouts[index].fulltopic = __atomic_load_n(&msgs[index].topic->fulltopic, __ATOMIC_ACQUIRE);
+        batch->fanouts[index].count     = msgs[index].count;
+        batch->fanouts[index].params    = NULL;
+        batch->fanouts[index].fields    = msgs[index].fields;
+        batch->fanouts[index].id        = msgs[index].topic->id;
+        batch->offsets[index]           = size;
+        cote_frame_t  prepared;
+        cote_frame_t *frame = (NULL != frames) ? &frames[index] : &prepared;
+        if ((NULL == frames) && (0 != cote_frame_prepare(frame, batch->fanouts[index].fulltopic, msgs[index].fields, msgs[index].count))) {
+            /* Too many fields or unable to serialize the fields, the message is not sent to the peers */
+            batch->status[index] = -1;
+        } else {
+            if (capacity - size < frame->size) {
+                capacity        = 2 * (size + frame->size);
+                uint8_t *buffer = (uint8_t *)realloc(batch->buffer, capacity);
+                if (NULL == buffer) {
+                    /* Unable to allocate memory */
+                    if (NULL == frames) {
+                        cote_frame_clean(frame);
+                    }
+                    cote_axon_batch_release(batch);
+                    return -1;
+                }
+                batch->buffer = buffer;
+            }
+            size = (size_t)(cote_frame_write(frame, &batch->buffer[size]) - batch->buffer);
+            if (NULL == frames) {
+                cote_frame_clean(frame);
+            }
+        }
+    }
+    batch->offsets[count] = size;
+
+    return 0;
+}
+
+/**
+ * @brief Send a batch of messages of a Publisher instance to a peer, in a single message if the peer decodes batches, one by one otherwise
+ * @param peer Peer
+ * @param user Batch
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_batch_peer(cote_peer_t *peer, void *user) {
+
+    assert(NULL != peer);
+    assert(NULL != user);
+
+    /* Retrieve batch using user data */
+    cote_batch_t *batch = (cote_batch_t *)user;
+
+    /* The messages are sent one by one to the peers not decoding batches, and through the send queue or the shared memory of the peers */
+    if ((NULL == peer->axon) || (NULL != peer->queue) || (0 == (peer->caps & COTE_PEER_CAP_BATCH))) {
+        return cote_axon_batch_peer_each(peer, batch);
+    }
+
+    /* Gather the frames of the messages the peer is interested in, they are copied only once a message is skipped */
+    uint8_t *frames = batch->buffer;
+    size_t   size   = 0;
+    for (int index = 0; index < batch->count; index++) {
+        size_t len   = batch->offsets[index + 1] - batch->offsets[index];
+        bool   match = ((0 < len) && (true == cote_peer_match(peer, batch->msgs[index].topic->topic))) ? true : false;
+        if ((true == match) && (frames != batch->buffer)) {
+            memcpy(&frames[size], &batch->buffer[batch->offsets[index]], len);
+        } else if ((false == match) && (0 < len) && (frames == batch->buffer)) {
+            if ((NULL == batch->scratch) && (NULL == (batch->scratch = (uint8_t *)malloc(batch->offsets[batch->count])))) {
+                /* Unable to allocate memory */
+                return cote_axon_batch_peer_each(peer, batch);
+            }
+            frames = batch->scratch;
+            memcpy(frames, batch->buffer, size);
+        }
+        size += (true == match) ? len : 0;
+    }
+
+    /* Send the frames in a single message */
+    if ((0 == size) || (0 == axon_send(peer->axon, 2, AMP_TYPE_STRING, COTE_BATCH_TOPIC, AMP_TYPE_BLOB, frames, (int)size))) {
+        return 0;
+    }
+
+    /* Unable to send the batch, the messages the peer is interested in have not been sent */
+    for (int index = 0; index < batch->count; index++) {
+        if (true == cote_peer_match(peer, batch->msgs[index].topic->topic)) {
+            batch->status[index] = -1;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Send the messages of a batch one by one to a peer
+ * @param peer Peer
+ * @param batch Batch
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_batch_peer_each(cote_peer_t *peer, cote_batch_t *batch) {
+
+    assert(NULL != peer);
+    assert(NULL != batch);
+
+    int ret = 0;
+
+    /* Send each message the peer is interested in */
+    for (int index = 0; index < batch->count; index++) {
+        if ((true == cote_peer_match(peer, batch->msgs[index].topic->topic)) && (0 != cote_axon_publish_peer(peer, &batch->fanouts[index]))) {
+            batch->status[index] = -1;
+            ret                  = -1;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Release a batch of messages
+ * @param batch Batch
+ */
+static void
+cote_axon_batch_release(cote_batch_t *batch) {
+
+    assert(NULL != batch);
+
+    /* Release the copies of the messages, the send queues keep their own references */
+    if (NULL != batch->fanouts) {
+        for (int index = 0; index < batch->count; index++) {
+            cote_queue_msg_put(batch->fanouts[index].queued);
+        }
+    }
+
+    /* Release memory */
+    if (NULL != batch->fanouts) {
+        free(batch->fanouts);
+    }
+    if (NULL != batch->status) {
+        free(batch->status);
+    }
+    if (NULL != batch->offsets) {
+        free(batch->offsets);
+    }
+    if (NULL != batch->buffer) {
+        free(batch->buffer);
+    }
+    if (NULL != batch->scratch) {
+        free(batch->scratch);
+    }
+}
+
+/**
+ * @brief Dispatch the messages of a batch received by a Subscriber instance, each message is handled as if it had been received alone
+ * @param cote Cote instance
+ * @param frames Frames of the messages
+ * @param size Size of the frames
+ */
+static void
+cote_axon_dispatch_batch(cote_t *cote, uint8_t *frames, size_t size) {
+
+    assert(NULL != cote);
+    assert(NULL != frames);
+
+    /* Decode each frame, the decoding stops at the first invalid frame */
+    size_t pos     = 0;
+    bool   invalid = false;
+    while ((false == invalid) && (pos < size)) {
+        uint32_t len = 0;
+        if (size - pos >= sizeof(uint32_t)) {
+            memcpy(&len, &frames[pos], sizeof(uint32_t));
+        }
+        amp_msg_t *amp = NULL;
+        if ((COTE_FRAME_HEADER <= len) && (size - pos >= len)) {
+            amp = cote_frame_decode(&frames[pos + sizeof(uint32_t)], len - sizeof(uint32_t));
+        }
+        if (NULL == amp) {
+            /* Invalid frame or unable to allocate memory */
+            COTE_STATS_INC(cote, unmatched);
+            invalid = true;
+        } else {
+            /* Handle the message as if it has been received by axon, subscribers do not reply */
+            (void)cote_axon_message_cb(NULL, amp, cote);
+            amp_release(amp);
+            pos += len;
+        }
+    }
+}
+
+/**
+ * @brief Send a message of a Publisher instance to an axon instance
+ * @param axon Axon instance
+ * @param user Message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_publish_cb(axon_t *axon, void *user) {
+
+    assert(NULL != axon);
+    assert(NULL != user);
+
+    /* Retrieve message using user data */
+    cote_fanout_t *fanout = (cote_fanout_t *)user;
+
+    /* Send message from an array of fields */
+    if (NULL == fanout->params) {
+        return cote_axon_send_fields(axon, fanout->fulltopic, -1, fanout->fields, fanout->count);
+    }
+
+    /* Send message from the params, they are copied because they are used for each axon instance */
+    va_list params;
+    va_copy(params, *fanout->params);
+    int ret = axon_vsend(axon, fanout->count + 1, AMP_TYPE_STRING, fanout->fulltopic, params);
+    va_end(params);
+
+    return ret;
+}
+
+/**
+ * @brief Send a message of a Publisher instance to a peer, using its axon instance, its send queue or its shared memory
+ * @param peer Peer
+ * @param user Message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_publish_peer(cote_peer_t *peer, void *user) {
+
+    assert(NULL != peer);
+    assert(NULL != user);
+
+    /* Retrieve message using user data */
+    cote_fanout_t *fanout = (cote_fanout_t *)user;
+
+    /* The topic ID is sent to the peers decoding them, if the message is sent directly to their axon instance */
+    bool id = false;
+    if ((NULL != peer->axon) && (NULL == peer->queue) && (0 != (peer->caps & COTE_PEER_CAP_IDS))) {
+        id = ((0 <= fanout->key) && (COTE_AXON_FIELDS_MAX >= fanout->count)) ? true : false;
+    }
+
+    /* Send message directly to the axon instance of the peer, the peers decoding batches receive the messages with too many fields in a batch */
+    if ((NULL != peer->axon) && (NULL == peer->queue) && (false == id)) {
+        if ((NULL == fanout->params) && (0 != (peer->caps & COTE_PEER_CAP_BATCH))) {
+            return cote_axon_send_fields_batch(peer->axon, fanout->fulltopic, fanout->fields, fanout->count);
+        }
+        return cote_axon_publish_cb(peer->axon, fanout);
+    }
+
+    /* Send message with the topic ID, queue message or write it to the shared memory of the peer from an array of fields */
+    if (NULL == fanout->params) {
+        if (true == id) {
+            return cote_axon_publish_id(peer, fanout, fanout->fields);
+        } else if (NULL != peer->queue) {
+            return cote_axon_publish_queue(peer, fanout, fanout->fields);
+        }
+        return cote_shm_send(peer->shm, fanout->fulltopic, fanout->fields, fanout->count);
+    }
+
+    /* Convert the params to an array of fields, they are copied because they are used for each peer */
+    cote_field_t fields[COTE_FIELDS_MAX];
+    int64_t      bigints[COTE_FIELDS_MAX];
+    if (0 != cote_axon_publish_fields(fanout, fields, bigints)) {
+        /* Too many fields */
+        return -1;
+    }
+    if (true == id) {
+        return cote_axon_publish_id(peer, fanout, fields);
+    } else if (NULL != peer->queue) {
+        return cote_axon_publish_queue(peer, fanout, fields);
+    }
+
+    return cote_shm_send(peer->shm, fanout->fulltopic, fields, fanout->count);
+}
+
+/**
+ * @brief Convert the params of a message of a Publisher instance to an array of fields
+ * @param fanout Message
+ * @param fields Array of fields (COTE_FIELDS_MAX), the data of the fields point to the params
+ * @param bigints Values of the AMP_TYPE_BIGINT fields (COTE_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise (too many fields)
+ */
+static int
+cote_axon_publish_fields(cote_fanout_t *fanout, cote_field_t *fields, int64_t *bigints) {
+
+    assert(NULL != fanout);
+    assert(NULL != fanout->params);
+    assert(NULL != fields);
+    assert(NULL != bigints);
+
+    /* Check amount of fields */
+    if ((0 > fanout->count) || (COTE_FIELDS_MAX < fanout->count)) {
+        /* Too many fields */
+        return -1;
+    }
+
+    /* Convert the params, they are copied because they are used several times */
+    va_list params;
+    va_copy(params, *fanout->params);
+    for (int index = 0; index < fanout->count; index++) {
+        fields[index].type = (amp_type_e)va_arg(params, int);
+        fields[index].size = 0;
+        if (AMP_TYPE_BIGINT == fields[index].type) {
+            bigints[index]     = va_arg(params, int64_t);
+            fields[index].data = &bigints[index];
+        } else {
+            fields[index].data = va_arg(params, void *);
+            if (AMP_TYPE_BLOB == fields[index].type) {
+                fields[index].size = va_arg(params, int);
+            }
+        }
+    }
+    va_end(params);
+
+    return 0;
+}
+
+/**
+ * @brief Queue a message of a Publisher instance to the send queue of a peer, the message is copied once for all the peers
+ * @param peer Peer
+ * @param fanout Message
+ * @param fields Fields of the message
+ * @return 0 if the function succeeded (the message is queued), -1 if the message has been dropped
+ */
+static int
+cote_axon_publish_queue(cote_peer_t *peer, cote_fanout_t *fanout, cote_field_t *fields) {
+
+    assert(NULL != peer);
+    assert(NULL != peer->queue);
+    assert(NULL != fanout);
+
+    /* Copy the message with the first queue, the copy is released once the message has been given to all the peers */
+    if (NULL == fanout->queued) {
+        fanout->queued = cote_queue_msg_create(fanout->fulltopic, fields, fanout->count);
+    }
+
+    /* Queue the message, it is dropped if it can not be copied */
+    return cote_queue_push(peer->queue, fanout->queued);
+}
+
+/**
+ * @brief Send the messages kept for replay to a peer of the node which has just been added, the frames are sent as they have been kept
+ * The peers decoding batches receive them in a single batch, the shared memory receives them as is, they are decoded for the other peers
+ * @param peer Peer
+ * @param user Node
+ * @return 0 if the function succeeded, -1 if at least one message has not been sent
+ */
+static int
+cote_axon_replay_peer(cote_peer_t *peer, void *user) {
+
+    assert(NULL != peer);
+    assert(NULL != user);
+
+    /* Retrieve node using user data */
+    cote_replay_node_t *    node     = (cote_replay_node_t *)user;
+    cote_replay_snapshot_t *snapshot = node->snapshot;
+
+    /* The frames are gathered for the peers decoding batches, they are sent one by one if it is not possible */
+    uint8_t *frames = NULL;
+    if ((NULL != peer->axon) && (0 != (peer->caps & COTE_PEER_CAP_BATCH))) {
+        frames = (uint8_t *)malloc(snapshot->offsets[snapshot->count]);
+    }
+
+    /* Send each message the peer is interested in, oldest first */
+    int    ret   = 0;
+    int    count = 0;
+    size_t size  = 0;
+    for (int index = 0; index < snapshot->count; index++) {
+        if (true == cote_peer_match(peer, snapshot->topics[index])) {
+            uint8_t *frame = &snapshot->buffer[snapshot->offsets[index]];
+            size_t   len   = snapshot->offsets[index + 1] - snapshot->offsets[index];
+            if (NULL != frames) {
+                memcpy(&frames[size], frame, len);
+                size += len;
+                count++;
+            } else if (0 == ((NULL != peer->shm) ? cote_shm_send_frame(peer->shm, frame, (uint32_t)len) : cote_axon_replay_decode(peer, frame, len))) {
+                COTE_STATS_INC(node->cote, messages_out);
+            } else {
+                COTE_STATS_INC(node->cote, send_errors);
+                ret = -1;
+            }
+        }
+    }
+
+    /* Send the frames in a single message */
+    if (NULL != frames) {
+        if ((0 == size) || (0 == axon_send(peer->axon, 2, AMP_TYPE_STRING, COTE_BATCH_TOPIC, AMP_TYPE_BLOB, frames, (int)size))) {
+            COTE_STATS_ADD(node->cote, messages_out, count);
+        } else {
+            COTE_STATS_ADD(node->cote, send_errors, count);
+            ret = -1;
+        }
+        free(frames);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Send a message kept for replay to a peer not decoding the frames, the frame is decoded to the fields of the message
+ * @param peer Peer
+ * @param frame Frame of the message, size of the frame included
+ * @param size Size of the frame
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_replay_decode(cote_peer_t *peer, uint8_t *frame, size_t size) {
+
+    assert(NULL != peer);
+    assert(NULL != frame);
+    assert(COTE_FRAME_HEADER <= size);
+
+    /* Decode the frame, the first field is the full topic */
+    amp_msg_t *amp = cote_frame_decode(&frame[sizeof(uint32_t)], size - sizeof(uint32_t));
+    if (NULL == amp) {
+        /* Unable to allocate memory */
+        return -1;
+    }
+    if ((NULL == amp->first) || (AMP_TYPE_STRING != amp->first->type) || (COTE_FIELDS_MAX < amp->count - 1)) {
+        /* Invalid frame */
+        amp_release(amp);
+        return -1;
+    }
+
+    /* Send the message from the fields of the frame */
+    cote_field_t fields[COTE_FIELDS_MAX];
+    int          count = 0;
+    for (amp_field_t *field = amp->first->next; NULL != field; field = field->next) {
+        fields[count].type = field->type;
+        fields[count].data = field->data;
+        fields[count].size = field->size;
+        count++;
+    }
+    cote_fanout_t fanout = { .fulltopic = (char *)amp->first->data, .count = count, .params = NULL, .fields = fields, .id = -1, .key = -1 };
+    int           ret    = cote_axon_publish_peer(peer, &fanout);
+
+    /* Release the copy of the message and the frame decoded */
+    cote_queue_msg_put(fanout.queued);
+    amp_release(amp);
+
+    return ret;
+}
+
+/**
+ * @brief Send a message of a Publisher instance to a peer decoding topic IDs, the topic is defined to the peer with its first message
+ * @param peer Peer
+ * @param fanout Message
+ * @param fields Fields of the message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_publish_id(cote_peer_t *peer, cote_fanout_t *fanout, cote_field_t *fields) {
+
+    assert(NULL != peer);
+    assert(NULL != peer->axon);
+    assert(NULL != fanout);
+    assert(0 <= fanout->key);
+
+    uint64_t tag = COTE_IDS_TAG(fanout->key);
+    uint32_t id  = COTE_IDS_ID(fanout->key);
+    int      ret = 0;
+
+    /* The definitions and the messages are sent to the node by one publisher at a time, the peers are not locked while sending */
+    sem_wait(&peer->sem);
+
+    /* The definitions sent previously are not valid anymore if the tag has changed */
+    if (tag != peer->ids.tag) {
+        if (NULL != peer->ids.defined) {
+            memset(peer->ids.defined, 0, peer->ids.size);
+        }
+        peer->ids.tag = tag;
+    }
+
+    /* Grow the topic IDs already defined to the node if required, the full topic is sent if it is not possible */
+    if ((int)(id / 8) >= peer->ids.size) {
+        int      size    = 2 * (int)(id / 8 + 1);
+        uint8_t *defined = (uint8_t *)realloc(peer->ids.defined, size);
+        if (NULL != defined) {
+            memset(&defined[peer->ids.size], 0, size - peer->ids.size);
+            peer->ids.defined = defined;
+            peer->ids.size    = size;
+        }
+    }
+
+    if ((int)(id / 8) >= peer->ids.size) {
+        /* Unable to allocate memory */
+        ret = cote_axon_send_fields(peer->axon, fanout->fulltopic, -1, fields, fanout->count);
+    } else if ((0 == (peer->ids.defined[id / 8] & (1 << (id % 8))))
+               && (0 != axon_send(peer->axon, 3, AMP_TYPE_BIGINT, ~fanout->key, AMP_TYPE_STRING, fanout->fulltopic, AMP_TYPE_STRING, fanout->owner))) {
+        /* Unable to define the topic to the node */
+        ret = -1;
+    } else {
+        /* The topic is defined to the node, the messages are received in order on the connection */
+        peer->ids.defined[id / 8] |= (uint8_t)(1 << (id % 8));
+
+        /* Send the message with the key of the topic */
+        ret = cote_axon_send_fields(peer->axon, NULL, fanout->key, fields, fanout->count);
+    }
+    sem_post(&peer->sem);
+
+    return ret;
+}
+
+/**
+ * @brief Send a message to axon instance from an array of fields, the topic is given by its full topic or by its key
+ * @param axon Axon instance
+ * @param fulltopic Full topic of the message
+ * @param key Key of the topic, the full topic is sent if it is negative
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_AXON_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_send_fields(axon_t *axon, char *fulltopic, int64_t key, cote_field_t *fields, int count) {
+
+    assert(NULL != axon);
+    assert((NULL != fulltopic) || (0 <= key));
+    assert((NULL != fields) || (0 == count));
+
+    /* axon expects the fields as variable arguments, the message is sent depending of the amount and of the types of the fields */
+    int ret = -1;
+    if (0 > key) {
+        COTE_AXON_SEND_FIELDS(ret, axon, fields, count, AMP_TYPE_STRING, fulltopic);
+    } else {
+        COTE_AXON_SEND_FIELDS(ret, axon, fields, count, AMP_TYPE_BIGINT, key);
+    }
+
+    /* -1 if the fields are invalid or if there are more than COTE_AXON_FIELDS_MAX fields */
+    return ret;
+}
+
+/**
+ * @brief Send a queued message to the axon instance of a subscriber from an array of fields, the full topic is sent
+ * @param axon Axon instance
+ * @param fulltopic Full topic of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_AXON_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_send_fields_queue(axon_t *axon, char *fulltopic, cote_field_t *fields, int count) {
+
+    assert(NULL != axon);
+    assert(NULL != fulltopic);
+
+    /* The send queues only store the full topic of the messages */
+    return cote_axon_send_fields(axon, fulltopic, -1, fields, count);
+}
+
+/**
+ * @brief Send a message to the axon instance of a subscriber decoding batches from an array of fields
+ * The message is sent in a batch of one frame if it has more fields than axon can encode from an array
+ * @param axon Axon instance
+ * @param fulltopic Full topic of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_axon_send_fields_batch(axon_t *axon, char *fulltopic, cote_field_t *fields, int count) {
+
+    assert(NULL != axon);
+    assert(NULL != fulltopic);
+    assert((NULL != fields) || (0 == count));
+
+    /* Send the message directly if axon can encode its fields */
+    if (COTE_AXON_FIELDS_MAX >= count) {
+        return cote_axon_send_fields(axon, fulltopic, -1, fields, count);
+    }
+
+    /* Encode the message in a frame */
+    cote_frame_t frame;
+    if (0 != cote_frame_prepare(&frame, fulltopic, fields, count)) {
+        /* Too many fields or unable to serialize the fields */
+        return -1;
+    }
+    uint8_t *buffer = (uint8_t *)malloc(frame.size);
+    if (NULL == buffer) {
+        /* Unable to allocate memory */
+        cote_frame_clean(&frame);
+        return -1;
+    }
+    cote_frame_write(&frame, buffer);
+    cote_frame_clean(&frame);
+
+    /* Send the batch */
+    int ret = axon_send(axon, 2, AMP_TYPE_STRING, COTE_BATCH_TOPIC, AMP_TYPE_BLOB, buffer, (int)frame.size);
+    free(buffer);
+
+    return ret;
+}
+
+/**
+ * @brief Update full topic of the topic handles, called when the namespace has been changed
+ * @param cote Cote instance
+ */
+static void
+cote_topics_update(cote_t *cote) {
+
+    assert(NULL != cote);
+
+    /* Wait topic handles semaphore */
+    cote_stats_sem_wait(cote, &cote->topics.sem);
+
+    /* Format new full topics, the previous ones may still be used by a publish in progress and are kept until the handle is released */
+    cote_topic_t *handle = cote->topics.first;
+    while (NULL != handle) {
+        char *fulltopic = cote_axon_format_fulltopic(cote, handle->topic);
+        if (NULL != fulltopic) {
+            char **tmp = (char **)realloc(handle->garbage.fulltopics, (handle->garbage.count + 1) * sizeof(char *));
+            if (NULL != tmp) {
+                handle->garbage.fulltopics                        = tmp;
+                handle->garbage.fulltopics[handle->garbage.count] = __atomic_exchange_n(&handle->fulltopic, fulltopic, __ATOMIC_ACQ_REL);
+                handle->garbage.count++;
+            } else {
+                /* Unable to allocate memory, the full topic of the handle is not updated */
+                free(fulltopic);
+            }
+        }
+        handle = handle->next;
+    }
+
+    /* The topic IDs are defined again to the subscribers with the new full topics */
+    cote_ids_renew(&cote->ids);
+
+    /* Release topic handles semaphore */
+    sem_post(&cote->topics.sem);
+}
+
+/**
+ * @brief Callback function invoked when a discovery node instance is added
+ * @param discover Discover instance
+ * @param node Node
+ * @param user User data
+ */
+static void
+cote_discovery_added_cb(discover_t *discover, discover_node_t *node, void *user) {
+
+    (void)discover;
+    assert(NULL != node);
+    assert(NULL != user);
+
+    /* Retrieve cote instance using user data */
+    cote_t *cote = (cote_t *)user;
+
+    /* Check node content */
+    if (0 != cote_discovery_check_node(cote, node)) {
+        /* Invalid node, ignore message */
+        return;
+    }
+
+    /* Send all the topics by the first shard while a subscriber connecting only to it is known */
+    if (true == cote_discovery_is_legacy(cote, node)) {
+        cote_shards_set_legacy(&cote->shards, true);
+    }
+
+    /* Answer a probing node at once, it discovers the instance without waiting for the next hello */
+    if ((cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "probe"))) && (0 != cote_probe_answer(cote))) {
+        /* Invoke error callback if defined, the node is handled anyway */
+        if (NULL != cote->cb.error.fct) {
+            cote->cb.error.fct(cote, "cote: unable to answer probing node", cote->cb.error.user);
+        }
+    }
+
+    /* Add the node to the index, the advertisement is parsed once for all the queries */
+    if ((NULL != cote->index.nodes) && (0 != cote_index_add(&cote->index, node))) {
+        /* Invoke error callback if defined, the node is handled anyway */
+        if (NULL != cote->cb.error.fct) {
+            cote->cb.error.fct(cote, "cote: unable to index new node", cote->cb.error.user);
+        }
+    }
+
+    /* Connect to the node if required */
+    if (0 != cote_discovery_connect_node(cote, node)) {
+        /* Node not connected, ignore message */
+        return;
+    }
+
+    /* Invoke added callback if defined */
+    if (NULL != cote->cb.added.fct) {
+        cote->cb.added.fct(cote, node, cote->cb.added.user);
+    }
+}
+
+/**
+ * @brief Callback function invoked when discovery node instance is removed
+ * @param discover Discover instance
+ * @param node Node
+ * @param user User data
+ */
+static void
+cote_discovery_removed_cb(discover_t *discover, discover_node_t *node, void *user) {
+
+    (void)discover;
+    assert(NULL != node);
+    assert(NULL != user);
+
+    /* Retrieve cote instance using user data */
+    cote_t *cote = (cote_t *)user;
+
+    /* Check node content */
+    if (0 != cote_discovery_check_node(cote, node)) {
+        /* Invalid node, ignore message */
+        return;
+    }
+
+    /* Forget node */
+    cote_stats_sem_wait(cote, &cote->options.sem);
+    cote_discovery_forget_node(cote, node->iid);
+    sem_post(&cote->options.sem);
+
+    /* Send the topics by their own shard again once the subscribers connecting only to the first shard are removed */
+    if (true == cote_discovery_is_legacy(cote, node)) {
+        cote_shards_set_legacy(&cote->shards, false);
+    }
+
+    /* Remove the node from the index */
+    cote_index_remove(&cote->index, node->iid);
+
+    /* Disconnect from the node and from all its shards, pending requests sent to the node are sent again to another replier once they have failed */
+    if (NULL != node->iid) {
+        while (0 == cote_peers_remove(&cote->peers, node->iid))
+            ;
+        if (NULL != cote->shm) {
+            cote_shm_forget(cote->shm, node->iid);
+        }
+    }
+
+    /* Release the topic tables defined by the publisher */
+    char *owner = cJSON_GetStringValue(cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "topicIdsOwner"));
+    if ((COTE_TYPE_SUB == cote->type) && (true == cote->options.topicIds) && (NULL != owner)) {
+        cote_ids_forget(&cote->ids, owner);
+    }
+
+    /* Invoke removed callback if defined */
+    if (NULL != cote->cb.removed.fct) {
+        cote->cb.removed.fct(cote, node, cote->cb.removed.user);
+    }
+}
+
+/**
+ * @brief Callback function invoked when a hello is received from a discovery node instance
+ * @param discover Discover instance
+ * @param node Node
+ * @param user User data
+ */
+static void
+cote_discovery_hello_cb(discover_t *discover, discover_node_t *node, void *user) {
+
+    (void)discover;
+    assert(NULL != node);
+    assert(NULL != user);
+
+    /* Retrieve cote instance using user data */
+    cote_t *cote = (cote_t *)user;
+
+    /* Check node content */
+    if ((NULL == node->iid) || (0 != cote_discovery_check_node(cote, node))) {
+        /* Invalid node, ignore message */
+        return;
+    }
+
+    /* Subscribers and requesters connect to the node ignored so far once it advertises matching topics or the local topics are changed */
+    if ((COTE_TYPE_SUB == cote->type) || (COTE_TYPE_REQ == cote->type)) {
+        cote_stats_sem_wait(cote, &cote->options.sem);
+        bool pending = cote_discovery_refresh_node(cote, node);
+        sem_post(&cote->options.sem);
+        if ((true == pending) && (0 == cote_discovery_connect_node(cote, node)) && (NULL != cote->cb.added.fct)) {
+            /* Invoke added callback if defined */
+            cote->cb.added.fct(cote, node, cote->cb.added.user);
+        }
+        return;
+    }
+
+    /* Only publishers filter the topics sent to the subscribers */
+    if (COTE_TYPE_PUB != cote->type) {
+        return;
+    }
+
+    /* Refresh the topics sent to the node, the subscriber may have changed its subscribesTo array since it has been connected */
+    cJSON *topics = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "subscribesTo");
+    if (0 != cote_peers_set_topics(&cote->peers, node->iid, topics)) {
+        /* Invoke error callback if defined, the previous topics are still sent to the node */
+        if (NULL != cote->cb.error.fct) {
+            cote->cb.error.fct(cote, "cote: unable to refresh topics of node", cote->cb.error.user);
+        }
+    }
+}
+
+/**
+ * @brief Callback function called to handle error from Axon instance
+ * @param discover Discover instance
+ * @param err Error as string
+ * @param user User data
+ */
+static void
+cote_discovery_error_cb(discover_t *discover, char *err, void *user) {
+
+    (void)discover;
+    assert(NULL != err);
+    assert(NULL != user);
+
+    /* Retrieve cote instance using user data */
+    cote_t *cote = (cote_t *)user;
+
+    /* Invoke error callback if defined */
+    if (NULL != cote->cb.error.fct) {
+        cote->cb.error.fct(cote, err, cote->cb.error.user);
+    }
+}
+
+/**
+ * @brief Function used to set Discovery instance advertisement, it is built again only if one of its inputs has changed
+ * @param cote Cote instance
+ * @param changed The port, the shards or the shared memory of the instance have changed, the options are checked otherwise
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_discovery_set_advertisement(cote_t *cote, bool changed) {
+
+    /* Wait options semaphore */
+    cote_stats_sem_wait(cote, &cote->options.sem);
+
+    /* Check if the advertisement must be built again */
+    if ((false == changed) && (false == cote->options.dirty)) {
+        sem_post(&cote->options.sem);
+        return 0;
+    }
+
+    /* Definition of advertisement */
+    cJSON *advertisement = NULL;
+    if (NULL != cote->options.advertisement) {
+        advertisement = cJSON_Duplicate(cote->options.advertisement, 1);
+    } else {
+        advertisement = cJSON_CreateObject();
+    }
+    if (NULL == advertisement) {
+        /* Unable to allocate memory */
+        sem_post(&cote->options.sem);
+        return -1;
+    }
+    cJSON_AddStringToObject(advertisement, "type", (COTE_TYPE_MON == cote->type) ? "monitor" : "service");
+    cJSON_AddStringToObject(advertisement, "name", cote->name);
+    if (NULL != cote->options.namespace_) {
+        cJSON_AddStringToObject(advertisement, "namespace", cote->options.namespace_);
+    }
+    if ((COTE_TYPE_PUB == cote->type) && (NULL != cote->options.broadcasts)) {
+        cJSON *broadcasts = cJSON_Duplicate(cote->options.broadcasts, 1);
+        if (NULL != broadcasts) {
+            cJSON_AddItemToObject(advertisement, "broadcasts", broadcasts);
+        }
+    } else if ((COTE_TYPE_SUB == cote->type) && (NULL != cote->options.subscribesTo)) {
+        cJSON *subscribesTo = cJSON_Duplicate(cote->options.subscribesTo, 1);
+        if (NULL != subscribesTo) {
+            cJSON_AddItemToObject(advertisement, "subscribesTo", subscribesTo);
+        }
+    } else if ((COTE_TYPE_REQ == cote->type) && (NULL != cote->options.requests)) {
+        cJSON *requests = cJSON_Duplicate(cote->options.requests, 1);
+        if (NULL != requests) {
+            cJSON_AddItemToObject(advertisement, "requests", requests);
+        }
+    } else if ((COTE_TYPE_REP == cote->type) && (NULL != cote->options.respondsTo)) {
+        cJSON *respondsTo = cJSON_Duplicate(cote->options.respondsTo, 1);
+        if (NULL != respondsTo) {
+            cJSON_AddItemToObject(advertisement, "respondsTo", respondsTo);
+        }
+    }
+    cJSON_AddStringToObject(advertisement, "key", "$$");
+    if (COTE_DISCOVERY_FAST == cote->options.discovery.mode) {
+        /* Request the nodes discovering the instance to answer at once */
+        cJSON_AddBoolToObject(advertisement, "probe", true);
+    }
+    if (COTE_TYPE_PUB == cote->type) {
+        cJSON_AddStringToObject(advertisement, "axon_type", "pub-emitter");
+        cJSON_AddNumberToObject(advertisement, "port", cote->port);
+        if (0 < cote->shards.count) {
+            /* Ports of all the shards, the first one is the port of the publisher */
+            cJSON *ports = cJSON_AddArrayToObject(advertisement, "ports");
+            for (int index = 0; (NULL != ports) && (index < cote->shards.count); index++) {
+                cJSON_AddItemToArray(ports, cJSON_CreateNumber(__atomic_load_n(&cote->shards.ports[index], __ATOMIC_RELAXED)));
+            }
+        }
+        if (true == cote->options.selectiveFanout) {
+            cJSON_AddBoolToObject(advertisement, "selectiveFanout", true);
+        }
+        if (true == cote->options.sharedMemory) {
+            char id[32];
+            cote_discovery_get_shm_id(cote, id, sizeof(id));
+            cJSON_AddStringToObject(advertisement, "shm", id);
+            cJSON_AddStringToObject(advertisement, "shmHost", cote_shm_get_host());
+        }
+        if (true == cote->options.topicIds) {
+            cJSON_AddBoolToObject(advertisement, "topicIds", true);
+            cJSON_AddStringToObject(advertisement, "topicIdsOwner", cote->ids.owner);
+        }
+    } else if (COTE_TYPE_SUB == cote->type) {
+        cJSON_AddStringToObject(advertisement, "axon_type", "sub-emitter");
+        if (0 != cote->port) {
+            cJSON_AddNumberToObject(advertisement, "port", cote->port);
+        }
+        if (NULL != cote->shm) {
+            cJSON_AddStringToObject(advertisement, "shm", cote->shm->name);
+            cJSON_AddStringToObject(advertisement, "shmHost", cote_shm_get_host());
+        }
+        if (0 != cote->port) {
+            cJSON_AddBoolToObject(advertisement, "batch", true);
+        }
+        /* Subscribers connect to all the shards of the publishers */
+        cJSON_AddBoolToObject(advertisement, "shards", true);
+        if ((0 != cote->port) && (true == cote->options.topicIds)) {
+            cJSON_AddBoolToObject(advertisement, "topicIds", true);
+        }
+    } else if (COTE_TYPE_REQ == cote->type) {
+        cJSON_AddStringToObject(advertisement, "axon_type", "req");
+    } else if (COTE_TYPE_REP == cote->type) {
+        cJSON_AddStringToObject(advertisement, "axon_type", "rep");
+        cJSON_AddNumberToObject(advertisement, "port", cote->port);
+        if (true == cote->options.deadline) {
+            cJSON_AddBoolToObject(advertisement, "deadline", true);
+        }
+    }
+    if (((COTE_TYPE_REQ == cote->type) || (COTE_TYPE_REP == cote->type)) && (COTE_COMPRESSION_NONE != cote->options.compression.algorithm)) {
+        /* Announce the algorithms decoded by the instance */
+        cJSON *compression = cJSON_AddArrayToObject(advertisement, "compression");
+        for (cote_compression_e algorithm = COTE_COMPRESSION_LZ4; (NULL != compression) && (algorithm <= COTE_COMPRESSION_ZSTD); algorithm++) {
+            if (0 != (cote_compress_available() & (1 << algorithm))) {
+                cJSON_AddItemToArray(compression, cJSON_CreateString(cote_compress_name(algorithm)));
+            }
+        }
+    } else if (COTE_TYPE_MON == cote->type) {
+        cJSON_AddNumberToObject(advertisement, "port", 0);
+    }
+
+    /* Give the advertisement to discover instance, the previous one is released */
+    discover_advertise(cote->discover, advertisement);
+    if (NULL != cote->options.advertised) {
+        cJSON_Delete(cote->options.advertised);
+    }
+    cote->options.advertised = advertisement;
+    cote->options.dirty      = false;
+
+    /* Release options semaphore */
+    sem_post(&cote->options.sem);
+
+    return 0;
+}
+
+/**
+ * @brief Function used to check discovery callback node
+ * @param cote Cote instance
+ * @param node Node
+ * @return 0 if the function succeeded (node is valid), -1 otherwise
+ */
+static int
+cote_discovery_check_node(cote_t *cote, discover_node_t *node) {
+
+    assert(NULL != cote);
+    assert(NULL != node);
+
+    /* Check advertisement content */
+    if (NULL == node->data.advertisement) {
+        /* No advertisement, ignore message */
+        return -1;
+    }
+
+    /* Treatment depending of Cote instance type */
+    if (COTE_TYPE_MON != cote->type) {
+
+        /* Check advertisement content */
+        cJSON *axon_type = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "axon_type");
+        if (NULL == axon_type) {
+            /* No axon type, ignore message */
+            return -1;
+        }
+        if (((COTE_TYPE_PUB == cote->type) && (strcmp("sub-emitter", cJSON_GetStringValue(axon_type))))
+            || ((COTE_TYPE_SUB == cote->type) && (strcmp("pub-emitter", cJSON_GetStringValue(axon_type))))
+            || ((COTE_TYPE_REQ == cote->type) && (strcmp("rep", cJSON_GetStringValue(axon_type))))
+            || ((COTE_TYPE_REP == cote->type) && (strcmp("req", cJSON_GetStringValue(axon_type))))) {
+            /* Invalid axon type, ignore message */
+            return -1;
+        }
+        cJSON *key = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "key");
+        if (NULL == key) {
+            /* No key, ignore message */
+            return -1;
+        }
+        if (strcmp("$$", cJSON_GetStringValue(key))) {
+            /* Invalid key, ignore message */
+            return -1;
+        }
+        cJSON *namespace = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "namespace");
+        cote_stats_sem_wait(cote, &cote->options.sem);
+        if (NULL != cote->options.namespace_) {
+            if (NULL == namespace) {
+                /* No namespace, ignore message */
+                sem_post(&cote->options.sem);
+                return -1;
+            }
+            if (strcmp(cote->options.namespace_, cJSON_GetStringValue(namespace))) {
+                /* Invalid namespace, ignore message */
+                sem_post(&cote->options.sem);
+                return -1;
+            }
+        } else {
+            if (NULL != namespace) {
+                /* Namespace present but not expected, ignore message */
+                sem_post(&cote->options.sem);
+                return -1;
+            }
         }
-        strcat(fulltopic, topic);
+        sem_post(&cote->options.sem);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Function used to connect to a discovered node if required (Subscriber and Requester instances, Publisher instance with selective fan-out or shared memory)
+ * @param cote Cote instance
+ * @param node Node
+ * @return 0 if the function succeeded (node is connected or does not need to be), -1 otherwise (node is ignored)
+ */
+static int
+cote_discovery_connect_node(cote_t *cote, discover_node_t *node) {
+
+    assert(NULL != cote);
+    assert(NULL != node);
+
+    /* Check Cote instance type */
+    if ((COTE_TYPE_SUB != cote->type) && (COTE_TYPE_REQ != cote->type)
+        && ((COTE_TYPE_PUB != cote->type) || ((false == cote->options.selectiveFanout) && (false == cote->options.sharedMemory)))) {
+        /* No connection required */
+        return 0;
+    }
+
+    /* Publishers and subscribers running on the same host with shared memory do not use TCP connections once the publisher is attached */
+    bool attaching = false;
+    if ((true == cote->options.sharedMemory) && (NULL != node->data.advertisement) && (NULL != node->iid) && (true == cote_discovery_is_local(node))) {
+        cJSON *shm = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "shm");
+        if ((COTE_TYPE_SUB == cote->type) && (NULL != cote->shm) && (cJSON_IsString(shm))) {
+            if (true == cote_shm_is_attached(cote->shm, cJSON_GetStringValue(shm), node->iid)) {
+                /* The publisher writes the messages to the shared memory of the subscriber */
+                return 0;
+            }
+            attaching = true;
+        } else if ((COTE_TYPE_PUB == cote->type) && (cJSON_IsString(shm))) {
+            return cote_discovery_connect_shm(cote, node, cJSON_GetStringValue(shm));
+        }
+    }
+    if ((COTE_TYPE_PUB == cote->type) && (false == cote->options.selectiveFanout)) {
+        /* No connection required, subscribers connect themselves to the publisher */
+        return 0;
+    }
+
+    /* Get port of the publisher/replier, or of the subscriber with selective fan-out */
+    uint16_t port = 0;
+    if (NULL != node->data.advertisement) {
+        cJSON *tmp = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "port");
+        if (NULL != tmp) {
+            port = (uint16_t)cJSON_GetNumberValue(tmp);
+        }
+    }
+    if (0 == port) {
+        /* Unable to find port, subscribers without selective fan-out connect themselves to the publisher */
+        return (COTE_TYPE_PUB == cote->type) ? 0 : -1;
+    }
+
+    /* Publishers with selective fan-out connect themselves to the subscriber */
+    if ((COTE_TYPE_SUB == cote->type) && (true == cote->options.selectiveFanout)
+        && (cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "selectiveFanout")))) {
+        return 0;
+    }
+
+    /* Wait options semaphore */
+    cote_stats_sem_wait(cote, &cote->options.sem);
+
+    /* Check if already connected to this node */
+    char *address = (true == cote->options.use_hostname) ? node->hostname : node->address;
+    if ((NULL == node->iid) || (NULL == address) || (true == cote_peers_exists(&cote->peers, address, port))) {
+        /* Already connected, ignore new node */
+        sem_post(&cote->options.sem);
+        return -1;
+    }
+
+    /* Check topics of the node to know if we need to connect to this publisher/replier instance, the subscriber topics are filtered by the publisher */
+    if ((COTE_TYPE_PUB != cote->type) && (false == cote_discovery_match_node(cote, node))) {
+        /* No match between broadcasts/respondsTo and subscribesTo/requests arrays, ignore this node */
+        sem_post(&cote->options.sem);
+        return -1;
+    }
+
+    /* Requesters connect to a limited amount of repliers, the node is connected on one of its next hellos once a replier is removed */
+    if ((COTE_TYPE_REQ == cote->type) && (0 < cote->options.maxRepliers) && (cote->options.maxRepliers <= cote_peers_count(&cote->peers))) {
+        cote_node_t *curr = cote_discovery_get_node(cote, node, false);
+        if (NULL != curr) {
+            curr->pending = true;
+        }
+        sem_post(&cote->options.sem);
+        return -1;
+    }
+
+    /* Subscribers wait for a publisher running on the same host to attach to the shared memory, so that no message is received with both transports */
+    if (true == attaching) {
+        uint64_t     delay = (uint64_t)COTE_SHM_HELLOS * __atomic_load_n(&cote->options.discovery.helloInterval, __ATOMIC_RELAXED) * 1000000;
+        cote_node_t *curr  = cote_discovery_get_node(cote, node, false);
+        if ((NULL != curr) && (cote_stats_now() - curr->seen < delay)) {
+            /* The node is connected with TCP on one of its next hellos if the publisher is still not attached */
+            curr->pending = true;
+            sem_post(&cote->options.sem);
+            return -1;
+        }
+    }
+
+    /* Connect to the node, the connection is closed when the node is removed, publishers send the messages from a queue if a high water mark is defined */
+    cJSON *       topics = (COTE_TYPE_PUB == cote->type) ? cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "subscribesTo") : NULL;
+    axon_t *      axon   = cote_axon_connect(cote, address, port);
+    cote_queue_t *queue  = NULL;
+    uint32_t      caps   = cote_discovery_get_caps(cote, node);
+    if ((NULL != axon) && (COTE_TYPE_PUB == cote->type) && (0 < cote->options.highWaterMark)) {
+        queue = cote_queue_create(cote->options.highWaterMark,
+                                  cote->options.dropPolicy,
+                                  (0 != (caps & COTE_PEER_CAP_BATCH)) ? &cote_axon_send_fields_batch : &cote_axon_send_fields_queue,
+                                  axon);
+    }
+
+    /* Add the peer, publishers keeping recent messages copy them at the same time, the messages published once the peer is added are sent to it */
+    bool                   replay   = ((COTE_TYPE_PUB == cote->type) && (0 < cote->replay.depth)) ? true : false;
+    int                    added    = -1;
+    int                    replayed = 0;
+    cote_replay_snapshot_t snapshot;
+    if (true == replay) {
+        cote_stats_sem_wait(cote, &cote->replay.sem);
+    }
+    if ((NULL != axon) && ((COTE_TYPE_PUB != cote->type) || (0 >= cote->options.highWaterMark) || (NULL != queue))) {
+        added = cote_peers_add(&cote->peers, axon, NULL, queue, node->iid, address, port, topics, caps);
+    }
+    if ((true == replay) && (0 == added)) {
+        replayed = cote_replay_snapshot(&cote->replay, &snapshot);
+    }
+    if (true == replay) {
+        sem_post(&cote->replay.sem);
+    }
+    if (0 != added) {
+        /* Unable to connect */
+        cote_queue_release(queue);
+        axon_release(axon);
+        sem_post(&cote->options.sem);
+        /* Invoke error callback if defined */
+        if (NULL != cote->cb.error.fct) {
+            cote->cb.error.fct(cote, "cote: unable to connect to new node", cote->cb.error.user);
+        }
+        return -1;
+    }
+
+    /* Connect to the other shards of a sharded publisher */
+    char *err = NULL;
+    if ((COTE_TYPE_SUB == cote->type) && (NULL != cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "ports"))
+        && (0 != cote_discovery_connect_shards(cote, node, address, port, caps))) {
+        err = "cote: unable to connect to a shard of new node";
+    }
+
+    /* Replay the recent messages to the subscriber */
+    if ((true == replay) && ((0 != replayed) || (0 != cote_discovery_replay(cote, node->iid, &snapshot)))) {
+        err = "cote: unable to replay messages to new node";
+    }
+
+    /* Release options semaphore */
+    sem_post(&cote->options.sem);
+
+    /* Invoke error callback if defined, the node is kept */
+    if ((NULL != err) && (NULL != cote->cb.error.fct)) {
+        cote->cb.error.fct(cote, err, cote->cb.error.user);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Function used to connect a Subscriber instance to the other shards of a discovered publisher, the options semaphore must be taken by the caller
+ * @param cote Cote instance
+ * @param node Node
+ * @param address Address (or hostname) of the node
+ * @param port Port of the first shard, already connected
+ * @param caps Capabilities of the node
+ * @return 0 if the function succeeded, -1 if at least one shard is not connected
+ */
+static int
+cote_discovery_connect_shards(cote_t *cote, discover_node_t *node, char *address, uint16_t port, uint32_t caps) {
+
+    assert(NULL != cote);
+    assert(NULL != node);
+    assert(NULL != address);
+
+    int ret = 0;
+
+    /* Connect to each shard, the peers of the shards have the instance ID of the node and are removed with it */
+    cJSON *item = NULL;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "ports")) {
+        uint16_t shard = (cJSON_IsNumber(item)) ? (uint16_t)cJSON_GetNumberValue(item) : 0;
+        if ((0 == shard) || (port == shard) || (true == cote_peers_exists(&cote->peers, address, shard))) {
+            /* Invalid port, or shard already connected */
+            continue;
+        }
+        axon_t *axon = cote_axon_connect(cote, address, shard);
+        if ((NULL == axon) || (0 != cote_peers_add(&cote->peers, axon, NULL, NULL, node->iid, address, shard, NULL, caps))) {
+            /* Unable to connect */
+            axon_release(axon);
+            ret = -1;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Function used to connect a Publisher instance to the shared memory of a discovered node
+ * @param cote Cote instance
+ * @param node Node
+ * @param name Name of the shared memory of the node
+ * @return 0 if the function succeeded, -1 otherwise (node is ignored)
+ */
+static int
+cote_discovery_connect_shm(cote_t *cote, discover_node_t *node, char *name) {
+
+    assert(NULL != cote);
+    assert(NULL != node);
+    assert(NULL != name);
+
+    /* Wait options semaphore */
+    cote_stats_sem_wait(cote, &cote->options.sem);
+
+    /* Check if already connected to this node, the name of the shared memory is used as address */
+    if ((NULL == node->iid) || (true == cote_peers_exists(&cote->peers, name, 0))) {
+        /* Already connected, ignore new node */
+        sem_post(&cote->options.sem);
+        return -1;
+    }
+
+    /* Open the shared memory, it is closed when the node is removed, the subscriber topics are filtered by the publisher */
+    cJSON *     topics = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "subscribesTo");
+    cote_shm_t *shm    = cote_shm_open(name);
+
+    /* Add the peer, publishers keeping recent messages copy them at the same time, the messages published once the peer is added are sent to it */
+    bool                   replay   = (0 < cote->replay.depth) ? true : false;
+    int                    added    = -1;
+    int                    replayed = 0;
+    cote_replay_snapshot_t snapshot;
+    if (true == replay) {
+        cote_stats_sem_wait(cote, &cote->replay.sem);
+    }
+    if (NULL != shm) {
+        added = cote_peers_add(&cote->peers, NULL, shm, NULL, node->iid, name, 0, topics, 0);
+    }
+    if ((true == replay) && (0 == added)) {
+        replayed = cote_replay_snapshot(&cote->replay, &snapshot);
+    }
+    if (true == replay) {
+        sem_post(&cote->replay.sem);
+    }
+    if (0 != added) {
+        /* Unable to connect */
+        cote_shm_release(shm);
+        sem_post(&cote->options.sem);
+        /* Invoke error callback if defined */
+        if (NULL != cote->cb.error.fct) {
+            cote->cb.error.fct(cote, "cote: unable to open shared memory of new node", cote->cb.error.user);
+        }
+        return -1;
+    }
+
+    /* Announce the publisher to the subscriber, which receives the messages with TCP until it reads the announce (a few may be received twice) */
+    char id[32];
+    cote_discovery_get_shm_id(cote, id, sizeof(id));
+    if (0 != cote_shm_attach(shm, id)) {
+        /* Unable to announce the publisher, the subscriber keeps using TCP and the shared memory is not used */
+        while (0 == cote_peers_remove(&cote->peers, node->iid))
+            ;
+        if ((true == replay) && (0 == replayed)) {
+            cote_replay_snapshot_release(&snapshot);
+        }
+        sem_post(&cote->options.sem);
+        /* Invoke error callback if defined */
+        if (NULL != cote->cb.error.fct) {
+            cote->cb.error.fct(cote, "cote: unable to attach to shared memory of new node", cote->cb.error.user);
+        }
+        return -1;
+    }
+
+    /* Replay the recent messages to the subscriber */
+    int ret = 0;
+    if ((true == replay) && ((0 != replayed) || (0 != cote_discovery_replay(cote, node->iid, &snapshot)))) {
+        ret = -1;
+    }
+
+    /* Release options semaphore */
+    sem_post(&cote->options.sem);
+
+    /* Invoke error callback if defined, the node is kept */
+    if ((0 != ret) && (NULL != cote->cb.error.fct)) {
+        cote->cb.error.fct(cote, "cote: unable to replay messages to new node", cote->cb.error.user);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Function used to replay the recent messages of a Publisher instance to a node just added, the replay semaphore is not held
+ * @param cote Cote instance
+ * @param iid Instance ID of the node
+ * @param snapshot Copy of the messages kept taken when the peer has been added, it is released
+ * @return 0 if the function succeeded, -1 if at least one message has not been sent
+ */
+static int
+cote_discovery_replay(cote_t *cote, char *iid, cote_replay_snapshot_t *snapshot) {
+
+    assert(NULL != cote);
+    assert(NULL != iid);
+    assert(NULL != snapshot);
+
+    /* Send the messages kept to the peers of the node */
+    cote_replay_node_t node = { .cote = cote, .snapshot = snapshot };
+    int                ret  = (0 < snapshot->count) ? cote_peers_send_node(&cote->peers, iid, NULL, &cote_axon_replay_peer, &node) : 0;
+
+    /* Release the copy of the messages */
+    cote_replay_snapshot_release(snapshot);
+
+    return ret;
+}
 
-        /* Release options semaphore */
-        sem_post(&cote->options.sem);
+/**
+ * @brief Check if a discovered node can share memory with the instance, it announces the same host token in its advertisement
+ * @param node Node
+ * @return true if the node is running on the same host, false otherwise
+ */
+static bool
+cote_discovery_is_local(discover_node_t *node) {
 
-    } else if ((COTE_TYPE_REQ == cote->type) || (COTE_TYPE_REP == cote->type)) {
+    assert(NULL != node);
 
-        /* Fulltopic is the topic itself */
-        fulltopic = strdup(topic);
+    /* Compare the host token of the node with the local one, the hostnames are not unique across containers and virtual machines */
+    char * host  = cote_shm_get_host();
+    cJSON *token = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "shmHost");
+    if (('\0' == host[0]) || (!cJSON_IsString(token))) {
+        /* Unable to identify the host */
+        return false;
     }
 
-    return fulltopic;
+    return (!strcmp(host, cJSON_GetStringValue(token))) ? true : false;
 }
 
 /**
- * @brief Callback function invoked when a discovery node instance is added
- * @param discover Discover instance
- * @param node Node
- * @param user User data
+ * @brief Format the identifier of a Publisher instance announced to the subscribers sharing memory with it
+ * @param cote Cote instance
+ * @param id Identifier
+ * @param size Size of the identifier
  */
 static void
-cote_discovery_added_cb(discover_t *discover, discover_node_t *node, void *user) {
+cote_discovery_get_shm_id(cote_t *cote, char *id, size_t size) {
 
-    (void)discover;
+    assert(NULL != cote);
+    assert(NULL != id);
+
+    /* The process and the port of the instance identify it on the host */
+    snprintf(id, size, "%d-%u", (int)getpid(), (unsigned int)cote->port);
+}
+
+/**
+ * @brief Retrieve the capabilities (COTE_PEER_CAP_*) shared with a discovered node, as announced in its advertisement
+ * @param cote Cote instance
+ * @param node Node
+ * @return Capabilities shared with the node
+ */
+static uint32_t
+cote_discovery_get_caps(cote_t *cote, discover_node_t *node) {
+
+    assert(NULL != cote);
     assert(NULL != node);
-    assert(NULL != user);
 
-    /* Retrieve cote instance using user data */
-    cote_t *cote = (cote_t *)user;
+    uint32_t caps = 0;
+    if (NULL == node->data.advertisement) {
+        /* No advertisement, node without any capability (Node.js cote) */
+        return caps;
+    }
 
-    /* Check node content */
-    if (0 != cote_discovery_check_node(cote, node)) {
-        /* Invalid node, ignore message */
-        return;
+    /* Topic IDs are sent by publishers to subscribers announcing them */
+    if ((COTE_TYPE_PUB == cote->type) && (true == cote->options.topicIds)
+        && (cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "topicIds")))) {
+        caps |= COTE_PEER_CAP_IDS;
     }
 
-    /* Treatment depending of the Cote instance type */
-    if ((COTE_TYPE_SUB == cote->type) || (COTE_TYPE_REQ == cote->type)) {
+    /* Batches are sent by publishers to subscribers announcing they decode them */
+    if ((COTE_TYPE_PUB == cote->type) && (cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "batch")))) {
+        caps |= COTE_PEER_CAP_BATCH;
+    }
 
-        /* Get port of the publisher/replier */
-        uint16_t port = 0;
-        if (NULL != node->data.advertisement) {
-            cJSON *tmp = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "port");
-            if (NULL != tmp) {
-                port = (uint16_t)cJSON_GetNumberValue(tmp);
+    /* Compression is used by requesters with repliers announcing the algorithms they decode */
+    if ((COTE_TYPE_REQ == cote->type) && (COTE_COMPRESSION_NONE != cote->options.compression.algorithm)) {
+        cJSON *algorithm = NULL;
+        cJSON_ArrayForEach(algorithm, cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "compression")) {
+            if ((cJSON_IsString(algorithm)) && (!strcmp(cote_compress_name(COTE_COMPRESSION_LZ4), cJSON_GetStringValue(algorithm)))) {
+                caps |= COTE_PEER_CAP_LZ4;
+            } else if ((cJSON_IsString(algorithm)) && (!strcmp(cote_compress_name(COTE_COMPRESSION_ZSTD), cJSON_GetStringValue(algorithm)))) {
+                caps |= COTE_PEER_CAP_ZSTD;
             }
         }
-        if (0 == port) {
-            /* Unable to find port */
-            return;
-        }
+        /* Only the algorithms available locally can be used, COTE_PEER_CAP_LZ4/ZSTD are the bits of the algorithms */
+        caps &= (uint32_t)cote_compress_available();
+    }
 
-        /* Wait options semaphore */
-        sem_wait(&cote->options.sem);
+    /* Deadline is attached by requesters to the requests of the repliers announcing they enforce it */
+    if ((COTE_TYPE_REQ == cote->type) && (true == cote->options.deadline)
+        && (cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "deadline")))) {
+        caps |= COTE_PEER_CAP_DEADLINE;
+    }
 
-        /* Check if already connected to this node */
-        if (true == axon_is_connected(cote->axon, (true == cote->options.use_hostname) ? node->hostname : node->address, port)) {
-            /* Already connected, ignore new node */
-            sem_post(&cote->options.sem);
-            return;
-        }
-
-        /* Parse broadcasts/respondsTo and subscribesTo/requests arrays to check if we need to connect to this publisher instance */
-        bool   match         = false;
-        cJSON *server_topics = NULL;
-        cJSON *client_topics = NULL;
-        if (COTE_TYPE_SUB == cote->type) {
-            server_topics = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "broadcasts");
-            client_topics = cote->options.subscribesTo;
-        } else if (COTE_TYPE_REQ == cote->type) {
-            server_topics = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "respondsTo");
-            client_topics = cote->options.requests;
-        }
-        if (NULL != client_topics) {
-            if (NULL != server_topics) {
-                for (int index_subscribesTo = 0; (index_subscribesTo < cJSON_GetArraySize(client_topics)) && (false == match); index_subscribesTo++) {
-                    for (int index_broadcasts = 0; (index_broadcasts < cJSON_GetArraySize(server_topics)) && (false == match); index_broadcasts++) {
-                        cJSON *tmp1 = cJSON_GetArrayItem(client_topics, index_subscribesTo);
-                        char * str1 = cJSON_GetStringValue(tmp1);
-                        cJSON *tmp2 = cJSON_GetArrayItem(server_topics, index_broadcasts);
-                        char * str2 = cJSON_GetStringValue(tmp2);
-                        if ((NULL != str1) && (NULL != str2)) {
-                            regex_t regex;
-                            if (0 == regcomp(&regex, str1, REG_NOSUB | REG_EXTENDED)) {
-                                if (0 == regexec(&regex, str2, 0, NULL, 0)) {
-                                    match = true;
-                                }
-                                regfree(&regex);
-                            }
-                        }
-                    }
-                }
-            }
-        } else {
-            match = true;
-        }
-        if (false == match) {
-            /* No match between broadcasts/respondsTo and subscribesTo/requests arrays, ignore this node */
-            sem_post(&cote->options.sem);
-            return;
-        }
+    return caps;
+}
 
-        /* Connect to the node */
-        if (0 != axon_connect(cote->axon, (true == cote->options.use_hostname) ? node->hostname : node->address, port)) {
-            /* Unable to connect */
-            sem_post(&cote->options.sem);
-            /* Invoke error callback if defined */
-            if (NULL != cote->cb.error.fct) {
-                cote->cb.error.fct(cote, "cote: unable to connect to new node", cote->cb.error.user);
+/**
+ * @brief Check if a discovered node is a subscriber connecting only to the first shard of a sharded Publisher instance
+ * @param cote Cote instance
+ * @param node Node
+ * @return true if the node is a Node.js cote subscriber or an older c-cote subscriber, false otherwise
+ */
+static bool
+cote_discovery_is_legacy(cote_t *cote, discover_node_t *node) {
+
+    assert(NULL != cote);
+    assert(NULL != node);
+
+    /* c-cote subscribers announce they connect to all the shards listed in the advertisement of the publisher */
+    char *type = cJSON_GetStringValue(cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "axon_type"));
+    return ((COTE_TYPE_PUB == cote->type) && (0 < cote->shards.count) && (NULL != type) && (!strcmp("sub-emitter", type))
+            && (!cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "shards"))))
+               ? true
+               : false;
+}
+
+/**
+ * @brief Compile subscribesTo/requests regular expressions, the options semaphore must be taken by the caller
+ * The discovered nodes already evaluated are evaluated again because the local topics have changed
+ * @param cote Cote instance
+ */
+static void
+cote_discovery_compile_patterns(cote_t *cote) {
+
+    assert(NULL != cote);
+
+    /* Release previous regular expressions */
+    for (int index = 0; index < cote->options.patterns.count; index++) {
+        regfree(&cote->options.patterns.regex[index]);
+    }
+    if (NULL != cote->options.patterns.regex) {
+        free(cote->options.patterns.regex);
+    }
+    cote->options.patterns.regex = NULL;
+    cote->options.patterns.count = 0;
+
+    /* Compile regular expressions of the local topics */
+    cJSON *client_topics = (COTE_TYPE_SUB == cote->type) ? cote->options.subscribesTo : ((COTE_TYPE_REQ == cote->type) ? cote->options.requests : NULL);
+    if ((NULL != client_topics) && (0 < cJSON_GetArraySize(client_topics))
+        && (NULL != (cote->options.patterns.regex = (regex_t *)malloc(cJSON_GetArraySize(client_topics) * sizeof(regex_t))))) {
+        cJSON *tmp = NULL;
+        cJSON_ArrayForEach(tmp, client_topics) {
+            char *str = cJSON_GetStringValue(tmp);
+            if ((NULL != str) && (0 == regcomp(&cote->options.patterns.regex[cote->options.patterns.count], str, REG_NOSUB | REG_EXTENDED))) {
+                cote->options.patterns.count++;
             }
-            return;
         }
-
-        /* Release options semaphore */
-        sem_post(&cote->options.sem);
     }
 
-    /* Invoke added callback if defined */
-    if (NULL != cote->cb.added.fct) {
-        cote->cb.added.fct(cote, node, cote->cb.added.user);
+    /* Evaluate again the nodes with the topics they advertised, the nodes matching now are connected on their next hello */
+    for (int bucket = 0; bucket < COTE_NODE_BUCKETS; bucket++) {
+        for (cote_node_t *curr = cote->options.nodes[bucket]; NULL != curr; curr = curr->next) {
+            bool match    = cote_discovery_match_topics(cote, curr->topics);
+            curr->pending = ((false == curr->match) && (true == match)) ? true : curr->pending;
+            curr->match   = match;
+        }
     }
 }
 
 /**
- * @brief Callback function invoked when discovery node instance is removed
- * @param discover Discover instance
+ * @brief Check if the topics advertised by a node are matching the local topics, the options semaphore must be taken by the caller
+ * The result is kept for the node until it is removed, advertises other topics or the local topics are changed
+ * @param cote Cote instance
  * @param node Node
- * @param user User data
+ * @return true if the topics are matching, false otherwise
  */
-static void
-cote_discovery_removed_cb(discover_t *discover, discover_node_t *node, void *user) {
+static bool
+cote_discovery_match_node(cote_t *cote, discover_node_t *node) {
 
-    (void)discover;
+    assert(NULL != cote);
     assert(NULL != node);
-    assert(NULL != user);
-
-    /* Retrieve cote instance using user data */
-    cote_t *cote = (cote_t *)user;
 
-    /* Check node content */
-    if (0 != cote_discovery_check_node(cote, node)) {
-        /* Invalid node, ignore message */
-        return;
+    /* Retrieve the result kept for the node, the node is evaluated if it is not known yet */
+    cote_node_t *curr = cote_discovery_get_node(cote, node, true);
+    if (NULL != curr) {
+        curr->pending = false;
+        return curr->match;
     }
 
-    /* Invoke removed callback if defined */
-    if (NULL != cote->cb.removed.fct) {
-        cote->cb.removed.fct(cote, node, cote->cb.removed.user);
-    }
+    /* Unable to keep the result, the node is evaluated each time */
+    return cote_discovery_match_topics(
+        cote, cJSON_GetObjectItemCaseSensitive(node->data.advertisement, (COTE_TYPE_SUB == cote->type) ? "broadcasts" : "respondsTo"));
 }
 
 /**
- * @brief Callback function called to handle error from Axon instance
- * @param discover Discover instance
- * @param err Error as string
- * @param user User data
+ * @brief Check if a node which was not matching the local topics is matching them since they or its advertised topics have changed
+ * The options semaphore must be taken by the caller, the node is evaluated again only if it has already been evaluated
+ * @param cote Cote instance
+ * @param node Node
+ * @return true if the node is matching and must be connected, false otherwise
  */
-static void
-cote_discovery_error_cb(discover_t *discover, char *err, void *user) {
-
-    (void)discover;
-    assert(NULL != err);
-    assert(NULL != user);
+static bool
+cote_discovery_refresh_node(cote_t *cote, discover_node_t *node) {
 
-    /* Retrieve cote instance using user data */
-    cote_t *cote = (cote_t *)user;
+    assert(NULL != cote);
+    assert(NULL != node);
 
-    /* Invoke error callback if defined */
-    if (NULL != cote->cb.error.fct) {
-        cote->cb.error.fct(cote, err, cote->cb.error.user);
+    /* Retrieve the result kept for the node, it is evaluated again if its topics have changed */
+    cote_node_t *curr    = cote_discovery_get_node(cote, node, false);
+    bool         pending = ((NULL != curr) && (true == curr->pending)) ? true : false;
+    if (true == pending) {
+        curr->pending = false;
     }
+
+    return pending;
 }
 
 /**
- * @brief Function used to set Discovery instance advertisement
+ * @brief Retrieve the result of the topics matching kept for a node, the options semaphore must be taken by the caller
+ * The node is evaluated again if the topics it advertises are not the ones the result has been computed for
  * @param cote Cote instance
- * @return 0 if the function succeeded, -1 otherwise
+ * @param node Node
+ * @param create Evaluate the node if it is not known yet
+ * @return Node already evaluated, NULL if it is not known or if the result can not be kept
  */
-static int
-cote_discovery_set_advertisement(cote_t *cote) {
+static cote_node_t *
+cote_discovery_get_node(cote_t *cote, discover_node_t *node, bool create) {
 
-    /* Wait options semaphore */
-    sem_wait(&cote->options.sem);
+    assert(NULL != cote);
+    assert(NULL != node);
 
-    /* Definition of advertisement */
-    cJSON *advertisement = NULL;
-    if (NULL != cote->options.advertisement) {
-        advertisement = cJSON_Duplicate(cote->options.advertisement, 1);
-    } else {
-        advertisement = cJSON_CreateObject();
-    }
-    if (NULL == advertisement) {
-        /* Unable to allocate memory */
-        sem_post(&cote->options.sem);
-        return -1;
+    /* Check instance ID of the node */
+    if (NULL == node->iid) {
+        return NULL;
     }
-    cJSON_AddStringToObject(advertisement, "type", (COTE_TYPE_MON == cote->type) ? "monitor" : "service");
-    cJSON_AddStringToObject(advertisement, "name", cote->name);
-    if (NULL != cote->options.namespace_) {
-        cJSON_AddStringToObject(advertisement, "namespace", cote->options.namespace_);
+
+    /* Search for the node in the nodes already evaluated */
+    cJSON *       topics = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, (COTE_TYPE_SUB == cote->type) ? "broadcasts" : "respondsTo");
+    cote_node_t **bucket = &cote->options.nodes[cote_hash(node->iid) & (COTE_NODE_BUCKETS - 1)];
+    cote_node_t * curr   = *bucket;
+    while ((NULL != curr) && (strcmp(curr->iid, node->iid))) {
+        curr = curr->next;
     }
-    if ((COTE_TYPE_PUB == cote->type) && (NULL != cote->options.broadcasts)) {
-        cJSON *broadcasts = cJSON_Duplicate(cote->options.broadcasts, 1);
-        if (NULL != broadcasts) {
-            cJSON_AddItemToObject(advertisement, "broadcasts", broadcasts);
+
+    /* Create the node if required */
+    if ((NULL == curr) && (true == create)) {
+        if (NULL == (curr = (cote_node_t *)calloc(1, sizeof(cote_node_t)))) {
+            /* Unable to allocate memory */
+            return NULL;
         }
-    } else if ((COTE_TYPE_SUB == cote->type) && (NULL != cote->options.subscribesTo)) {
-        cJSON *subscribesTo = cJSON_Duplicate(cote->options.subscribesTo, 1);
-        if (NULL != subscribesTo) {
-            cJSON_AddItemToObject(advertisement, "subscribesTo", subscribesTo);
+        if (NULL == (curr->iid = strdup(node->iid))) {
+            /* Unable to allocate memory */
+            free(curr);
+            return NULL;
         }
-    } else if ((COTE_TYPE_REQ == cote->type) && (NULL != cote->options.requests)) {
-        cJSON *requests = cJSON_Duplicate(cote->options.requests, 1);
-        if (NULL != requests) {
-            cJSON_AddItemToObject(advertisement, "requests", requests);
+        curr->topics = (NULL != topics) ? cJSON_Duplicate(topics, 1) : NULL;
+        curr->match  = cote_discovery_match_topics(cote, topics);
+        curr->seen   = cote_stats_now();
+        curr->next   = *bucket;
+        *bucket      = curr;
+        return curr;
+    }
+
+    /* Evaluate the node again if it advertises other topics, the topics are compared only because they rarely change */
+    if ((NULL != curr) && (((NULL == curr->topics) != (NULL == topics)) || ((NULL != topics) && (!cJSON_Compare(curr->topics, topics, true))))) {
+        cJSON *copy = (NULL != topics) ? cJSON_Duplicate(topics, 1) : NULL;
+        if ((NULL != topics) && (NULL == copy)) {
+            /* Unable to allocate memory, the node is evaluated again on its next hello */
+            return curr;
         }
-    } else if ((COTE_TYPE_REP == cote->type) && (NULL != cote->options.respondsTo)) {
-        cJSON *respondsTo = cJSON_Duplicate(cote->options.respondsTo, 1);
-        if (NULL != respondsTo) {
-            cJSON_AddItemToObject(advertisement, "respondsTo", respondsTo);
+        if (NULL != curr->topics) {
+            cJSON_Delete(curr->topics);
         }
+        bool match    = cote_discovery_match_topics(cote, topics);
+        curr->pending = ((false == curr->match) && (true == match)) ? true : curr->pending;
+        curr->match   = match;
+        curr->topics  = copy;
     }
-    cJSON_AddStringToObject(advertisement, "key", "$$");
-    if (COTE_TYPE_PUB == cote->type) {
-        cJSON_AddStringToObject(advertisement, "axon_type", "pub-emitter");
-        cJSON_AddNumberToObject(advertisement, "port", cote->port);
-    } else if (COTE_TYPE_SUB == cote->type) {
-        cJSON_AddStringToObject(advertisement, "axon_type", "sub-emitter");
-    } else if (COTE_TYPE_REQ == cote->type) {
-        cJSON_AddStringToObject(advertisement, "axon_type", "req");
-    } else if (COTE_TYPE_REP == cote->type) {
-        cJSON_AddStringToObject(advertisement, "axon_type", "rep");
-        cJSON_AddNumberToObject(advertisement, "port", cote->port);
-    } else if (COTE_TYPE_MON == cote->type) {
-        cJSON_AddNumberToObject(advertisement, "port", 0);
-    }
-    discover_advertise(cote->discover, advertisement);
-    cJSON_Delete(advertisement);
-
-    /* Release options semaphore */
-    sem_post(&cote->options.sem);
 
-    return 0;
+    return curr;
 }
 
 /**
- * @brief Function used to check discovery callback node
+ * @brief Check if advertised topics are matching the compiled subscribesTo/requests regular expressions, the options semaphore must be taken by the caller
  * @param cote Cote instance
- * @param node Node
- * @return 0 if the function succeeded (node is valid), -1 otherwise
+ * @param topics broadcasts/respondsTo array advertised by a node, may be NULL
+ * @return true if the topics are matching, false otherwise
  */
-static int
-cote_discovery_check_node(cote_t *cote, discover_node_t *node) {
+static bool
+cote_discovery_match_topics(cote_t *cote, cJSON *topics) {
 
     assert(NULL != cote);
-    assert(NULL != node);
 
-    /* Check advertisement content */
-    if (NULL == node->data.advertisement) {
-        /* No advertisement, ignore message */
-        return -1;
+    /* All the nodes are matching if the local topics are not defined */
+    cJSON *client_topics = (COTE_TYPE_SUB == cote->type) ? cote->options.subscribesTo : cote->options.requests;
+    if (NULL == client_topics) {
+        return true;
     }
 
-    /* Treatment depending of Cote instance type */
-    if (COTE_TYPE_MON != cote->type) {
-
-        /* Check advertisement content */
-        cJSON *axon_type = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "axon_type");
-        if (NULL == axon_type) {
-            /* No axon type, ignore message */
-            return -1;
-        }
-        if (((COTE_TYPE_PUB == cote->type) && (strcmp("sub-emitter", cJSON_GetStringValue(axon_type))))
-            || ((COTE_TYPE_SUB == cote->type) && (strcmp("pub-emitter", cJSON_GetStringValue(axon_type))))
-            || ((COTE_TYPE_REQ == cote->type) && (strcmp("rep", cJSON_GetStringValue(axon_type))))
-            || ((COTE_TYPE_REP == cote->type) && (strcmp("req", cJSON_GetStringValue(axon_type))))) {
-            /* Invalid axon type, ignore message */
-            return -1;
-        }
-        cJSON *key = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "key");
-        if (NULL == key) {
-            /* No key, ignore message */
-            return -1;
-        }
-        if (strcmp("$$", cJSON_GetStringValue(key))) {
-            /* Invalid key, ignore message */
-            return -1;
-        }
-        cJSON *namespace = cJSON_GetObjectItemCaseSensitive(node->data.advertisement, "namespace");
-        sem_wait(&cote->options.sem);
-        if (NULL != cote->options.namespace_) {
-            if (NULL == namespace) {
-                /* No namespace, ignore message */
-                sem_post(&cote->options.sem);
-                return -1;
-            }
-            if (strcmp(cote->options.namespace_, cJSON_GetStringValue(namespace))) {
-                /* Invalid namespace, ignore message */
-                sem_post(&cote->options.sem);
-                return -1;
-            }
-        } else {
-            if (NULL != namespace) {
-                /* Namespace present but not expected, ignore message */
-                sem_post(&cote->options.sem);
-                return -1;
+    /* Parse broadcasts/respondsTo array and match each topic with the compiled subscribesTo/requests regular expressions */
+    bool   match = false;
+    cJSON *tmp   = NULL;
+    cJSON_ArrayForEach(tmp, topics) {
+        char *str = cJSON_GetStringValue(tmp);
+        for (int index = 0; (NULL != str) && (index < cote->options.patterns.count) && (false == match); index++) {
+            if (0 == regexec(&cote->options.patterns.regex[index], str, 0, NULL, 0)) {
+                match = true;
             }
         }
-        sem_post(&cote->options.sem);
     }
 
-    return 0;
+    return match;
+}
+
+/**
+ * @brief Forget a discovered node, the options semaphore must be taken by the caller
+ * @param cote Cote instance
+ * @param iid Instance ID of the node, NULL to forget all the nodes
+ */
+static void
+cote_discovery_forget_node(cote_t *cote, char *iid) {
+
+    assert(NULL != cote);
+
+    /* Remove the node(s) from the nodes already evaluated */
+    for (int bucket = 0; bucket < COTE_NODE_BUCKETS; bucket++) {
+        cote_node_t **curr = &cote->options.nodes[bucket];
+        while (NULL != *curr) {
+            if ((NULL == iid) || (!strcmp((*curr)->iid, iid))) {
+                cote_node_t *tmp = *curr;
+                *curr            = (*curr)->next;
+                if (NULL != tmp->topics) {
+                    cJSON_Delete(tmp->topics);
+                }
+                free(tmp->iid);
+                free(tmp);
+            } else {
+                curr = &(*curr)->next;
+            }
+        }
+    }
 }
+
@@ -0,0 +1,349 @@
+/**
+ * @file      cote_async.c
+ * @brief     Cote library - Asynchronous requests
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "cote_async.h"
+#include "cote_loop.h"
+#include "cote_stats.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Thread used to send the queued requests
+ * @param arg Cote instance
+ * @return Always returns NULL
+ */
+static void *cote_async_thread(void *arg);
+
+/**
+ * @brief Send a request and invoke its callback with the reply, the callback is invoked by cote_process if the event loop is used
+ * @param cote Cote instance
+ * @param request Request, released once the callback has been invoked
+ */
+static void cote_async_send(cote_t *cote, cote_request_t *request);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Initialize asynchronous requests
+ * @param requests Asynchronous requests
+ */
+void
+cote_async_init(cote_requests_t *requests) {
+
+    assert(NULL != requests);
+
+    /* Initialize queue */
+    memset(requests, 0, sizeof(cote_requests_t));
+    requests->max_queued  = COTE_ASYNC_QUEUE;
+    requests->max_threads = COTE_ASYNC_THREADS;
+
+    /* Initialize semaphores */
+    sem_init(&requests->pending, 0, 0);
+    sem_init(&requests->sem, 0, 1);
+}
+
+/**
+ * @brief Set the maximum amount of threads sending the requests, it can not be changed once the threads are created
+ * @param requests Asynchronous requests
+ * @param nb_threads Maximum amount of threads
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_async_set_threads(cote_requests_t *requests, int nb_threads) {
+
+    assert(NULL != requests);
+
+    int ret = -1;
+
+    /* Set the amount of threads if they are not created yet */
+    sem_wait(&requests->sem);
+    if ((0 < nb_threads) && (NULL == requests->threads)) {
+        requests->max_threads = nb_threads;
+        ret                   = 0;
+    }
+    sem_post(&requests->sem);
+
+    return ret;
+}
+
+/**
+ * @brief Set the maximum amount of queued requests
+ * @param requests Asynchronous requests
+ * @param max_queued Maximum amount of queued requests
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_async_set_queue(cote_requests_t *requests, int max_queued) {
+
+    assert(NULL != requests);
+
+    /* Check value */
+    if (0 >= max_queued) {
+        /* Invalid value */
+        return -1;
+    }
+
+    /* Set the maximum amount of queued requests, the requests already queued are kept */
+    sem_wait(&requests->sem);
+    requests->max_queued = max_queued;
+    sem_post(&requests->sem);
+
+    return 0;
+}
+
+/**
+ * @brief Queue an asynchronous request, a thread sending the requests is created if all the threads are busy
+ * @param cote Cote instance
+ * @param request Request, released once the callback has been invoked
+ * @return 0 if the function succeeded, -1 otherwise (the queue is full)
+ */
+int
+cote_async_push(cote_t *cote, cote_request_t *request) {
+
+    assert(NULL != cote);
+    assert(NULL != request);
+
+    cote_requests_t *requests = &cote->requests;
+
+    /* Wait requests semaphore */
+    sem_wait(&requests->sem);
+
+    /* Check if the queue is full, the requests are not queued beyond the threads ability to send them in time */
+    if (requests->count >= requests->max_queued) {
+        /* Queue is full */
+        sem_post(&requests->sem);
+        return -1;
+    }
+
+    /* Allocate the threads with the first request */
+    if ((NULL == requests->threads) && (NULL == (requests->threads = (pthread_t *)malloc(requests->max_threads * sizeof(pthread_t))))) {
+        /* Unable to allocate memory */
+        sem_post(&requests->sem);
+        return -1;
+    }
+
+    /* Append request to the queue */
+    request->next = NULL;
+    if (NULL != requests->last) {
+        requests->last->next = request;
+    } else {
+        requests->first = request;
+    }
+    requests->last = request;
+    requests->count++;
+
+    /* Create a thread if all the threads are busy, the threads are kept for the next requests */
+    if ((requests->waiting < requests->count) && (requests->nb_threads < requests->max_threads)
+        && (0 == pthread_create(&requests->threads[requests->nb_threads], NULL, cote_async_thread, cote))) {
+        requests->nb_threads++;
+    }
+    if (0 == requests->nb_threads) {
+        /* Unable to create threads, the request is the only one queued */
+        requests->first = NULL;
+        requests->last  = NULL;
+        requests->count = 0;
+        sem_post(&requests->sem);
+        return -1;
+    }
+
+    /* Release requests semaphore */
+    sem_post(&requests->sem);
+
+    /* Wake up a thread */
+    sem_post(&requests->pending);
+
+    return 0;
+}
+
+/**
+ * @brief Release a request
+ * @param request Request
+ */
+void
+cote_async_request_release(cote_request_t *request) {
+
+    /* Release request */
+    if (NULL != request) {
+        if (NULL != request->topic) {
+            free(request->topic);
+        }
+        if (NULL != request->payload) {
+            cJSON_Delete(request->payload);
+        }
+        free(request);
+    }
+}
+
+/**
+ * @brief Release asynchronous requests, the threads are stopped and the callback of the queued requests is invoked with NULL reply
+ * @param cote Cote instance
+ */
+void
+cote_async_release(cote_t *cote) {
+
+    assert(NULL != cote);
+
+    cote_requests_t *requests = &cote->requests;
+
+    /* Stop threads, the requests being sent are completed */
+    sem_wait(&requests->sem);
+    requests->terminate = true;
+    sem_post(&requests->sem);
+    for (int index = 0; index < requests->nb_threads; index++) {
+        sem_post(&requests->pending);
+    }
+    for (int index = 0; index < requests->nb_threads; index++) {
+        pthread_join(requests->threads[index], NULL);
+    }
+    if (NULL != requests->threads) {
+        free(requests->threads);
+    }
+
+    /* Fail the requests remaining in the queue */
+    while (NULL != requests->first) {
+        cote_request_t *tmp = requests->first;
+        requests->first     = requests->first->next;
+        if (NULL != tmp->fct) {
+            tmp->fct(cote, NULL, tmp->user);
+        }
+        cote_async_request_release(tmp);
+    }
+
+    /* Release semaphores */
+    sem_close(&requests->pending);
+    sem_close(&requests->sem);
+}
+
+/**
+ * @brief Thread used to send the queued requests
+ * @param arg Cote instance
+ * @return Always returns NULL
+ */
+static void *
+cote_async_thread(void *arg) {
+
+    assert(NULL != arg);
+
+    /* Retrieve cote instance */
+    cote_t *         cote     = (cote_t *)arg;
+    cote_requests_t *requests = &cote->requests;
+
+    /* Send the requests until termination */
+    while (1) {
+
+        /* Wait for a request */
+        sem_wait(&requests->sem);
+        requests->waiting++;
+        sem_post(&requests->sem);
+        sem_wait(&requests->pending);
+
+        /* Take the first request of the queue */
+        sem_wait(&requests->sem);
+        requests->waiting--;
+        if (true == requests->terminate) {
+            sem_post(&requests->sem);
+            break;
+        }
+        cote_request_t *request = requests->first;
+        if (NULL != request) {
+            requests->first = request->next;
+            if (NULL == requests->first) {
+                requests->last = NULL;
+            }
+            requests->count--;
+        }
+        sem_post(&requests->sem);
+
+        /* Send the request and invoke the callback, the request is released once the callback has been invoked */
+        if (NULL != request) {
+            cote_async_send(cote, request);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Send a request and invoke its callback with the reply, the callback is invoked by cote_process if the event loop is used
+ * @param cote Cote instance
+ * @param request Request, released once the callback has been invoked
+ */
+static void
+cote_async_send(cote_t *cote, cote_request_t *request) {
+
+    assert(NULL != cote);
+    assert(NULL != request);
+
+    amp_msg_t *amp = NULL;
+
+    /* The time spent in the queue is part of the timeout, the request is failed without being sent if it has already expired */
+    int      timeout = request->timeout;
+    uint64_t now     = cote_stats_now();
+    bool     expired = ((0 < timeout) && (now >= request->expiry)) ? true : false;
+    if (true == expired) {
+        COTE_STATS_INC(cote, requests_expired);
+    } else if (0 < timeout) {
+        timeout = (int)((request->expiry - now + 999999) / 1000000);
+    }
+
+    /* Send request and wait for the reply, several threads are waiting in parallel on the same axon instance */
+    if ((true == expired) || (0 != cote_send(cote, request->topic, 1, AMP_TYPE_JSON, request->payload, &amp, timeout))) {
+        amp = NULL;
+    }
+
+    /* Give the reply to the event loop if it is used, the callback is invoked by the calling thread otherwise or if the instance is being released */
+    if ((0 <= cote->loop.fd) && (0 == cote_loop_push(&cote->loop, amp, request))) {
+        return;
+    }
+
+    /* Invoke callback */
+    if (NULL != request->fct) {
+        request->fct(cote, amp, request->user);
+    }
+
+    /* Release reply and request */
+    if (NULL != amp) {
+        amp_release(amp);
+    }
+    cote_async_request_release(request);
+}
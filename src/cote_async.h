@@ -0,0 +1,100 @@
+/**
+ * @file      cote_async.h
+ * @brief     Cote library - Asynchronous requests
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_ASYNC_H__
+#define __COTE_ASYNC_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define COTE_ASYNC_THREADS (4)    /* Default maximum amount of threads sending the asynchronous requests */
+#define COTE_ASYNC_QUEUE   (1024) /* Default maximum amount of queued asynchronous requests */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Initialize asynchronous requests
+ * @param requests Asynchronous requests
+ */
+void cote_async_init(cote_requests_t *requests);
+
+/**
+ * @brief Set the maximum amount of threads sending the requests, it can not be changed once the threads are created
+ * @param requests Asynchronous requests
+ * @param nb_threads Maximum amount of threads
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_async_set_threads(cote_requests_t *requests, int nb_threads);
+
+/**
+ * @brief Set the maximum amount of queued requests
+ * @param requests Asynchronous requests
+ * @param max_queued Maximum amount of queued requests
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_async_set_queue(cote_requests_t *requests, int max_queued);
+
+/**
+ * @brief Queue an asynchronous request, a thread sending the requests is created if all the threads are busy
+ * @param cote Cote instance
+ * @param request Request, released once the callback has been invoked
+ * @return 0 if the function succeeded, -1 otherwise (the queue is full)
+ */
+int cote_async_push(cote_t *cote, cote_request_t *request);
+
+/**
+ * @brief Release a request
+ * @param request Request
+ */
+void cote_async_request_release(cote_request_t *request);
+
+/**
+ * @brief Release asynchronous requests, the threads are stopped and the callback of the queued requests is invoked with NULL reply
+ * @param cote Cote instance
+ */
+void cote_async_release(cote_t *cote);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_ASYNC_H__ */
@@ -0,0 +1,453 @@
+/**
+ * @file      cote_compress.c
+ * @brief     Cote library - Compression of the requests and replies
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <cJSON.h>
+#ifdef COTE_HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef COTE_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "cote_compress.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+/*
+ * Format of a frame:
+ * - magic (3 bytes, the first one is null so that a frame is never a valid JSON text)
+ * - compression algorithm (1 byte, cote_compression_e)
+ * - mask of the algorithms the sender decodes (1 byte, 1 << cote_compression_e)
+ * - length of the JSON text (4 bytes, little endian)
+ * - JSON text, compressed or not
+ */
+#define COTE_COMPRESS_MAGIC       "\0CZ"
+#define COTE_COMPRESS_MAGIC_SIZE  (3)
+#define COTE_COMPRESS_HEADER_SIZE (COTE_COMPRESS_MAGIC_SIZE + 1 + 1 + 4)
+
+/* Largest length of a number, boolean or null printed by cJSON, used to estimate the length of a JSON text */
+#define COTE_COMPRESS_NUMBER_SIZE (26)
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Estimate the length of the JSON text of an object, the length returned is never lower than the length of the text printed by cJSON
+ * @param json JSON object
+ * @param limit The estimation stops once this length is reached
+ * @return Estimated length, at least limit if the JSON text may be longer
+ */
+static size_t cote_compress_estimate(cJSON *json, size_t limit);
+
+/**
+ * @brief Estimate the length of a JSON string once escaped, quotes included
+ * @param str String
+ * @return Length of the escaped string
+ */
+static size_t cote_compress_estimate_string(char *str);
+
+/**
+ * @brief Compress data
+ * @param algorithm Compression algorithm
+ * @param src Data
+ * @param len Length of the data
+ * @param dst Buffer of the compressed data
+ * @param capacity Size of the buffer
+ * @return Length of the compressed data if the function succeeded, 0 otherwise
+ */
+static size_t cote_compress_data(cote_compression_e algorithm, char *src, size_t len, uint8_t *dst, size_t capacity);
+
+/**
+ * @brief Decompress data
+ * @param algorithm Compression algorithm
+ * @param src Compressed data
+ * @param len Length of the compressed data
+ * @param dst Buffer of the data
+ * @param size Size of the data
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_decompress_data(cote_compression_e algorithm, uint8_t *src, size_t len, char *dst, size_t size);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Retrieve the compression algorithms available
+ * @return Mask of the algorithms available (1 << cote_compression_e), COTE_COMPRESSION_NONE excluded
+ */
+uint8_t
+cote_compress_available(void) {
+
+    uint8_t mask = 0;
+#ifdef COTE_HAVE_LZ4
+    mask |= (1 << COTE_COMPRESSION_LZ4);
+#endif
+#ifdef COTE_HAVE_ZSTD
+    mask |= (1 << COTE_COMPRESSION_ZSTD);
+#endif
+
+    return mask;
+}
+
+/**
+ * @brief Retrieve the name of a compression algorithm, as announced in the advertisement
+ * @param algorithm Compression algorithm
+ * @return Name of the algorithm
+ */
+char *
+cote_compress_name(cote_compression_e algorithm) {
+
+    switch (algorithm) {
+        case COTE_COMPRESSION_LZ4:
+            return "lz4";
+        case COTE_COMPRESSION_ZSTD:
+            return "zstd";
+        default:
+            return "none";
+    }
+}
+
+/**
+ * @brief Create a frame containing a JSON text, compressed if the algorithm is not COTE_COMPRESSION_NONE and if it reduces the size
+ * @param text JSON text
+ * @param len Length of the JSON text
+ * @param algorithm Compression algorithm
+ * @param accept Mask of the algorithms (1 << cote_compression_e) the sender decodes, to be used to compress the reply
+ * @param size Size of the frame
+ * @return Frame to be sent as AMP_TYPE_BLOB if the function succeeded, NULL otherwise
+ */
+void *
+cote_compress_frame(char *text, size_t len, cote_compression_e algorithm, uint8_t accept, int *size) {
+
+    assert(NULL != text);
+    assert(NULL != size);
+
+    /* Check length of the JSON text */
+    if (COTE_COMPRESS_SIZE_MAX < len) {
+        /* Too large */
+        return NULL;
+    }
+
+    /* Allocate the frame, it is never larger than the uncompressed frame because the JSON text is stored as is if compression does not reduce the size */
+    uint8_t *frame = (uint8_t *)malloc(COTE_COMPRESS_HEADER_SIZE + len);
+    if (NULL == frame) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+
+    /* Compress the JSON text */
+    size_t compressed = 0;
+    if ((COTE_COMPRESSION_NONE != algorithm) && (0 != (cote_compress_available() & (1 << algorithm)))) {
+        compressed = cote_compress_data(algorithm, text, len, &frame[COTE_COMPRESS_HEADER_SIZE], len);
+    }
+    if (0 == compressed) {
+        algorithm = COTE_COMPRESSION_NONE;
+        memcpy(&frame[COTE_COMPRESS_HEADER_SIZE], text, len);
+        compressed = len;
+    }
+
+    /* Format header */
+    memcpy(frame, COTE_COMPRESS_MAGIC, COTE_COMPRESS_MAGIC_SIZE);
+    frame[COTE_COMPRESS_MAGIC_SIZE]     = (uint8_t)algorithm;
+    frame[COTE_COMPRESS_MAGIC_SIZE + 1] = accept;
+    for (int index = 0; index < 4; index++) {
+        frame[COTE_COMPRESS_MAGIC_SIZE + 2 + index] = (uint8_t)(len >> (8 * index));
+    }
+    *size = (int)(COTE_COMPRESS_HEADER_SIZE + compressed);
+
+    return frame;
+}
+
+/**
+ * @brief Check if a field contains a frame created with cote_compress_frame
+ * @param field Field
+ * @return true if the field contains a frame, false otherwise
+ */
+bool
+cote_compress_is_frame(amp_field_t *field) {
+
+    assert(NULL != field);
+
+    return ((AMP_TYPE_BLOB == field->type) && (NULL != field->data) && (COTE_COMPRESS_HEADER_SIZE <= field->size)
+            && (0 == memcmp(field->data, COTE_COMPRESS_MAGIC, COTE_COMPRESS_MAGIC_SIZE)))
+               ? true
+               : false;
+}
+
+/**
+ * @brief Replace a frame by the JSON text it contains, as AMP_TYPE_STRING, or by the parsed JSON object, as AMP_TYPE_JSON
+ * @param field Field containing a frame
+ * @param parse Parse the JSON text
+ * @param accept Mask of the algorithms the sender decodes, may be NULL
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_compress_decode(amp_field_t *field, bool parse, uint8_t *accept) {
+
+    assert(NULL != field);
+    assert(true == cote_compress_is_frame(field));
+
+    /* Parse header */
+    uint8_t *frame     = (uint8_t *)field->data;
+    uint8_t  algorithm = frame[COTE_COMPRESS_MAGIC_SIZE];
+    size_t   len       = 0;
+    for (int index = 0; index < 4; index++) {
+        len |= (size_t)frame[COTE_COMPRESS_MAGIC_SIZE + 2 + index] << (8 * index);
+    }
+    if ((COTE_COMPRESS_SIZE_MAX < len) || (COTE_COMPRESSION_ZSTD < algorithm)
+        || ((COTE_COMPRESSION_NONE != algorithm) && (0 == (cote_compress_available() & (1 << algorithm))))) {
+        /* Invalid frame, unknown algorithm or algorithm not available */
+        return -1;
+    }
+
+    /* Retrieve the JSON text */
+    size_t payload = (size_t)field->size - COTE_COMPRESS_HEADER_SIZE;
+    char * text    = (char *)malloc(len + 1);
+    if (NULL == text) {
+        /* Unable to allocate memory */
+        return -1;
+    }
+    if (COTE_COMPRESSION_NONE == algorithm) {
+        if (payload != len) {
+            /* Invalid frame */
+            free(text);
+            return -1;
+        }
+        memcpy(text, &frame[COTE_COMPRESS_HEADER_SIZE], len);
+    } else if (0 != cote_decompress_data((cote_compression_e)algorithm, &frame[COTE_COMPRESS_HEADER_SIZE], payload, text, len)) {
+        /* Invalid compressed data */
+        free(text);
+        return -1;
+    }
+    text[len] = '\0';
+    if (NULL != accept) {
+        *accept = frame[COTE_COMPRESS_MAGIC_SIZE + 1];
+    }
+
+    /* Replace the frame by the JSON text or the JSON object */
+    if (true == parse) {
+        cJSON *json = cJSON_ParseWithLength(text, len);
+        free(text);
+        if (NULL == json) {
+            /* Invalid JSON text */
+            return -1;
+        }
+        free(field->data);
+        field->type = AMP_TYPE_JSON;
+        field->data = json;
+        field->size = 0;
+    } else {
+        free(field->data);
+        field->type = AMP_TYPE_STRING;
+        field->data = text;
+        field->size = (int)len;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Replace the JSON fields of a message which are larger than the threshold by compressed frames
+ * @param amp AMP message
+ * @param algorithm Compression algorithm
+ * @param threshold Minimum size of the JSON text of a field to be compressed (bytes)
+ */
+void
+cote_compress_encode(amp_msg_t *amp, cote_compression_e algorithm, int threshold) {
+
+    assert(NULL != amp);
+
+    /* Compress the JSON fields, fields which can not be compressed are kept unchanged */
+    for (amp_field_t *field = amp->first; NULL != field; field = field->next) {
+
+        /* Serialize the JSON fields which may be larger than the threshold, the smaller ones are serialized only once by axon when sending */
+        char *text = NULL;
+        if ((AMP_TYPE_JSON == field->type) && (NULL != field->data) && ((size_t)threshold <= cote_compress_estimate((cJSON *)field->data, (size_t)threshold))) {
+            text = cJSON_PrintUnformatted((cJSON *)field->data);
+        }
+
+        /* Replace the field by the frame if compression reduces the size */
+        size_t len = (NULL != text) ? strlen(text) : 0;
+        if ((NULL != text) && ((size_t)threshold <= len)) {
+            int   size  = 0;
+            void *frame = cote_compress_frame(text, len, algorithm, 0, &size);
+            if ((NULL != frame) && (COTE_COMPRESSION_NONE != ((uint8_t *)frame)[COTE_COMPRESS_MAGIC_SIZE])) {
+                cJSON_Delete((cJSON *)field->data);
+                field->type = AMP_TYPE_BLOB;
+                field->data = frame;
+                field->size = size;
+            } else {
+                /* Compression does not reduce the size */
+                free(frame);
+            }
+        }
+        if (NULL != text) {
+            cJSON_free(text);
+        }
+    }
+}
+
+/**
+ * @brief Estimate the length of the JSON text of an object, the length returned is never lower than the length of the text printed by cJSON
+ * @param json JSON object
+ * @param limit The estimation stops once this length is reached
+ * @return Estimated length, at least limit if the JSON text may be longer
+ */
+static size_t
+cote_compress_estimate(cJSON *json, size_t limit) {
+
+    assert(NULL != json);
+
+    size_t len = 0;
+
+    /* Add the length of the value, numbers, booleans and null are counted with the largest number printed by cJSON */
+    if ((cJSON_IsObject(json)) || (cJSON_IsArray(json))) {
+        len += 2;
+        for (cJSON *child = json->child; (NULL != child) && (len < limit); child = child->next) {
+            len += ((NULL != child->next) ? 1 : 0) + ((cJSON_IsObject(json)) ? cote_compress_estimate_string(child->string) + 1 : 0);
+            len += cote_compress_estimate(child, limit - ((len < limit) ? len : limit));
+        }
+    } else if (NULL != json->valuestring) {
+        len += cote_compress_estimate_string(json->valuestring);
+    } else {
+        len += COTE_COMPRESS_NUMBER_SIZE;
+    }
+
+    return len;
+}
+
+/**
+ * @brief Estimate the length of a JSON string once escaped, quotes included
+ * @param str String
+ * @return Length of the escaped string
+ */
+static size_t
+cote_compress_estimate_string(char *str) {
+
+    size_t len = 2;
+
+    /* Count the characters escaped by cJSON, control characters without short form are printed as \uXXXX */
+    for (unsigned char *c = (unsigned char *)str; (NULL != c) && ('\0' != *c); c++) {
+        if (('"' == *c) || ('\\' == *c) || ('\b' == *c) || ('\f' == *c) || ('\n' == *c) || ('\r' == *c) || ('\t' == *c)) {
+            len += 2;
+        } else if (32 > *c) {
+            len += 6;
+        } else {
+            len += 1;
+        }
+    }
+
+    return len;
+}
+
+/**
+ * @brief Compress data
+ * @param algorithm Compression algorithm
+ * @param src Data
+ * @param len Length of the data
+ * @param dst Buffer of the compressed data
+ * @param capacity Size of the buffer
+ * @return Length of the compressed data if the function succeeded, 0 otherwise
+ */
+static size_t
+cote_compress_data(cote_compression_e algorithm, char *src, size_t len, uint8_t *dst, size_t capacity) {
+
+    assert(NULL != src);
+    assert(NULL != dst);
+
+    (void)src;
+    (void)len;
+    (void)dst;
+    (void)capacity;
+
+    /* Compress the data, 0 is returned if the compressed data does not fit in the buffer */
+    switch (algorithm) {
+#ifdef COTE_HAVE_LZ4
+        case COTE_COMPRESSION_LZ4: {
+            int ret = LZ4_compress_default(src, (char *)dst, (int)len, (int)capacity);
+            return (0 < ret) ? (size_t)ret : 0;
+        }
+#endif
+#ifdef COTE_HAVE_ZSTD
+        case COTE_COMPRESSION_ZSTD: {
+            size_t ret = ZSTD_compress(dst, capacity, src, len, COTE_COMPRESS_ZSTD_LEVEL);
+            return (0 == ZSTD_isError(ret)) ? ret : 0;
+        }
+#endif
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Decompress data
+ * @param algorithm Compression algorithm
+ * @param src Compressed data
+ * @param len Length of the compressed data
+ * @param dst Buffer of the data
+ * @param size Size of the data
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_decompress_data(cote_compression_e algorithm, uint8_t *src, size_t len, char *dst, size_t size) {
+
+    assert(NULL != src);
+    assert(NULL != dst);
+
+    (void)src;
+    (void)len;
+    (void)dst;
+    (void)size;
+
+    /* Decompress the data, the size of the data must be the one given in the header of the frame */
+    switch (algorithm) {
+#ifdef COTE_HAVE_LZ4
+        case COTE_COMPRESSION_LZ4:
+            return (LZ4_decompress_safe((char *)src, dst, (int)len, (int)size) == (int)size) ? 0 : -1;
+#endif
+#ifdef COTE_HAVE_ZSTD
+        case COTE_COMPRESSION_ZSTD:
+            return (ZSTD_decompress(dst, size, src, len) == size) ? 0 : -1;
+#endif
+        default:
+            return -1;
+    }
+}
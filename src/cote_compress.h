@@ -0,0 +1,112 @@
+/**
+ * @file      cote_compress.h
+ * @brief     Cote library - Compression of the requests and replies
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_COMPRESS_H__
+#define __COTE_COMPRESS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+/* Default minimum size of the JSON text of a message to be compressed (bytes) */
+#define COTE_COMPRESS_THRESHOLD (8192)
+
+/* Maximum size of the JSON text of a compressed message (bytes), larger frames are rejected */
+#define COTE_COMPRESS_SIZE_MAX (256 * 1024 * 1024)
+
+/* Compression level of zstd */
+#define COTE_COMPRESS_ZSTD_LEVEL (3)
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Retrieve the compression algorithms available
+ * @return Mask of the algorithms available (1 << cote_compression_e), COTE_COMPRESSION_NONE excluded
+ */
+uint8_t cote_compress_available(void);
+
+/**
+ * @brief Retrieve the name of a compression algorithm, as announced in the advertisement
+ * @param algorithm Compression algorithm
+ * @return Name of the algorithm
+ */
+char *cote_compress_name(cote_compression_e algorithm);
+
+/**
+ * @brief Create a frame containing a JSON text, compressed if the algorithm is not COTE_COMPRESSION_NONE and if it reduces the size
+ * @param text JSON text
+ * @param len Length of the JSON text
+ * @param algorithm Compression algorithm
+ * @param accept Mask of the algorithms (1 << cote_compression_e) the sender decodes, to be used to compress the reply
+ * @param size Size of the frame
+ * @return Frame to be sent as AMP_TYPE_BLOB if the function succeeded, NULL otherwise
+ */
+void *cote_compress_frame(char *text, size_t len, cote_compression_e algorithm, uint8_t accept, int *size);
+
+/**
+ * @brief Check if a field contains a frame created with cote_compress_frame
+ * @param field Field
+ * @return true if the field contains a frame, false otherwise
+ */
+bool cote_compress_is_frame(amp_field_t *field);
+
+/**
+ * @brief Replace a frame by the JSON text it contains, as AMP_TYPE_STRING, or by the parsed JSON object, as AMP_TYPE_JSON
+ * @param field Field containing a frame
+ * @param parse Parse the JSON text
+ * @param accept Mask of the algorithms the sender decodes, may be NULL
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_compress_decode(amp_field_t *field, bool parse, uint8_t *accept);
+
+/**
+ * @brief Replace the JSON fields of a message which are larger than the threshold by compressed frames
+ * @param amp AMP message
+ * @param algorithm Compression algorithm
+ * @param threshold Minimum size of the JSON text of a field to be compressed (bytes)
+ */
+void cote_compress_encode(amp_msg_t *amp, cote_compression_e algorithm, int threshold);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_COMPRESS_H__ */
@@ -0,0 +1,380 @@
+/**
+ * @file      cote_cork.c
+ * @brief     Cote library - Corked messages
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "cote_cork.h"
+#include "cote_frame.h"
+#include "cote_queue.h"
+#include "cote_stats.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Thread used to send the corked messages once the delay has expired
+ * @param arg Cote instance
+ * @return Always returns NULL
+ */
+static void *cote_cork_thread(void *arg);
+
+/**
+ * @brief Grow the arrays of corked messages, the semaphore of the corked messages must be taken by the caller
+ * @param cork Corked messages
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_cork_grow(cote_cork_t *cork);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Initialize corked messages, the messages are not corked until a delay is set
+ * @param cork Corked messages
+ * @param fct Function invoked to send the corked messages
+ */
+void
+cote_cork_init(cote_cork_t *cork, int (*fct)(struct cote_s *, cote_msg_t *, cote_frame_t *, int)) {
+
+    assert(NULL != cork);
+    assert(NULL != fct);
+
+    /* Initialize corked messages */
+    memset(cork, 0, sizeof(cote_cork_t));
+    cork->max_bytes = COTE_CORK_BYTES;
+    cork->fct       = fct;
+
+    /* Initialize semaphores */
+    sem_init(&cork->pending, 0, 0);
+    sem_init(&cork->wakeup, 0, 0);
+    sem_init(&cork->flush, 0, 1);
+    sem_init(&cork->sem, 0, 1);
+}
+
+/**
+ * @brief Set the maximum delay before the corked messages are sent, the messages already corked are sent if the messages are not corked anymore
+ * @param cote Cote instance
+ * @param delay Delay (milliseconds), 0 to disable
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_cork_set_delay(cote_t *cote, int delay) {
+
+    assert(NULL != cote);
+
+    /* Check value */
+    if (0 > delay) {
+        /* Invalid value */
+        return -1;
+    }
+
+    /* Set the delay, it is used by the thread from the next corked message */
+    __atomic_store_n(&cote->cork.delay, delay, __ATOMIC_RELEASE);
+
+    /* The new messages are sent directly, the messages already corked are sent first */
+    if (0 == delay) {
+        (void)cote_cork_flush(cote);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Set the size of the frames from which the corked messages are sent at once
+ * @param cork Corked messages
+ * @param max_bytes Size of the frames (bytes)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_cork_set_bytes(cote_cork_t *cork, int max_bytes) {
+
+    assert(NULL != cork);
+
+    /* Check value */
+    if (0 >= max_bytes) {
+        /* Invalid value */
+        return -1;
+    }
+
+    /* Set the size, it is checked with the next corked message */
+    sem_wait(&cork->sem);
+    cork->max_bytes = max_bytes;
+    sem_post(&cork->sem);
+
+    return 0;
+}
+
+/**
+ * @brief Cork a message, the message is copied and its frame is prepared, the thread sending the corked messages is created with the first message
+ * The corked messages are sent at once by the calling thread if the size of their frames is reached
+ * @param cote Cote instance
+ * @param topic Topic handle of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_cork_push(cote_t *cote, cote_topic_t *topic, cote_field_t *fields, int count) {
+
+    assert(NULL != cote);
+    assert(NULL != topic);
+    assert((NULL != fields) || (0 == count));
+
+    cote_cork_t *cork = &cote->cork;
+
+    /* Copy the message, the data of the fields given by the caller is not kept */
+    cote_queue_msg_t *copy = cote_queue_msg_create(__atomic_load_n(&topic->fulltopic, __ATOMIC_ACQUIRE), fields, count);
+    if (NULL == copy) {
+        /* Too many fields or unable to allocate memory */
+        return -1;
+    }
+
+    /* Wait corked messages semaphore */
+    cote_stats_sem_wait(cote, &cork->sem);
+
+    /* Create thread if required, the message is sent directly if it can not be created or if the instance is being released */
+    if ((false == cork->started) && (false == cork->terminate)) {
+        cork->started = (0 == pthread_create(&cork->thread, NULL, cote_cork_thread, cote)) ? true : false;
+    }
+    if ((false == cork->started) || (true == cork->terminate)) {
+        sem_post(&cork->sem);
+        cote_msg_t msg = { .topic = topic, .fields = copy->fields, .count = copy->count };
+        int        ret = cork->fct(cote, &msg, NULL, 1);
+        cote_queue_msg_put(copy);
+        return ret;
+    }
+
+    /* Append the message, its frame is prepared once so that the JSON fields are serialized only once */
+    if ((cork->count == cork->size) && (0 != cote_cork_grow(cork))) {
+        /* Unable to allocate memory */
+        sem_post(&cork->sem);
+        cote_queue_msg_put(copy);
+        return -1;
+    }
+    if (0 != cote_frame_prepare(&cork->frames[cork->count], copy->fulltopic, copy->fields, copy->count)) {
+        /* Unable to serialize the fields */
+        sem_post(&cork->sem);
+        cote_queue_msg_put(copy);
+        return -1;
+    }
+    cork->msgs[cork->count].topic  = topic;
+    cork->msgs[cork->count].fields = copy->fields;
+    cork->msgs[cork->count].count  = copy->count;
+    cork->copies[cork->count]      = copy;
+    cork->bytes += cork->frames[cork->count].size;
+    cork->count++;
+    bool first = (1 == cork->count) ? true : false;
+    bool full  = (cork->bytes >= (size_t)cork->max_bytes) ? true : false;
+
+    /* Release corked messages semaphore */
+    sem_post(&cork->sem);
+
+    /* Wake up the thread, the delay starts with the first corked message */
+    if (true == first) {
+        sem_post(&cork->pending);
+    }
+
+    /* Send the corked messages at once if the size of their frames is reached */
+    return (true == full) ? cote_cork_flush(cote) : 0;
+}
+
+/**
+ * @brief Send the corked messages at once
+ * @param cote Cote instance
+ * @return 0 if the function succeeded, -1 if at least one message has not been sent
+ */
+int
+cote_cork_flush(cote_t *cote) {
+
+    assert(NULL != cote);
+
+    cote_cork_t *cork = &cote->cork;
+
+    /* The flushes are serialized so that the messages are sent in the order they have been corked */
+    cote_stats_sem_wait(cote, &cork->flush);
+
+    /* Take the corked messages, the messages corked meanwhile are appended to new arrays */
+    cote_stats_sem_wait(cote, &cork->sem);
+    cote_msg_t *       msgs   = cork->msgs;
+    cote_frame_t *     frames = cork->frames;
+    cote_queue_msg_t **copies = cork->copies;
+    int                count  = cork->count;
+    cork->msgs                = NULL;
+    cork->frames              = NULL;
+    cork->copies              = NULL;
+    cork->count               = 0;
+    cork->size                = 0;
+    cork->bytes               = 0;
+    sem_post(&cork->sem);
+
+    /* Send the messages */
+    int ret = (0 < count) ? cork->fct(cote, msgs, frames, count) : 0;
+
+    /* Release the frames and the copies of the messages */
+    for (int index = 0; index < count; index++) {
+        cote_frame_clean(&frames[index]);
+        cote_queue_msg_put(copies[index]);
+    }
+    if (NULL != msgs) {
+        free(msgs);
+    }
+    if (NULL != frames) {
+        free(frames);
+    }
+    if (NULL != copies) {
+        free(copies);
+    }
+
+    /* Release flush semaphore */
+    sem_post(&cork->flush);
+
+    return ret;
+}
+
+/**
+ * @brief Release corked messages, the thread is stopped and the messages remaining are sent
+ * @param cote Cote instance
+ */
+void
+cote_cork_release(cote_t *cote) {
+
+    assert(NULL != cote);
+
+    cote_cork_t *cork = &cote->cork;
+
+    /* Stop thread, the messages being sent are completed */
+    sem_wait(&cork->sem);
+    cork->terminate = true;
+    sem_post(&cork->sem);
+    if (true == cork->started) {
+        sem_post(&cork->pending);
+        sem_post(&cork->wakeup);
+        pthread_join(cork->thread, NULL);
+    }
+
+    /* Send the messages remaining */
+    (void)cote_cork_flush(cote);
+
+    /* Release semaphores */
+    sem_close(&cork->pending);
+    sem_close(&cork->wakeup);
+    sem_close(&cork->flush);
+    sem_close(&cork->sem);
+}
+
+/**
+ * @brief Thread used to send the corked messages once the delay has expired
+ * @param arg Cote instance
+ * @return Always returns NULL
+ */
+static void *
+cote_cork_thread(void *arg) {
+
+    assert(NULL != arg);
+
+    /* Retrieve cote instance */
+    cote_t *     cote = (cote_t *)arg;
+    cote_cork_t *cork = &cote->cork;
+
+    /* Send the corked messages until termination */
+    while (1) {
+
+        /* Wait for the first corked message */
+        sem_wait(&cork->pending);
+        if (true == __atomic_load_n(&cork->terminate, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        /* Wait for the delay, the messages corked meanwhile are sent with the first one */
+        int             delay = __atomic_load_n(&cork->delay, __ATOMIC_ACQUIRE);
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += delay / 1000;
+        ts.tv_nsec += (delay % 1000) * 1000000L;
+        if (1000000000L <= ts.tv_nsec) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        while ((0 != sem_timedwait(&cork->wakeup, &ts)) && (EINTR == errno))
+            ;
+        if (true == __atomic_load_n(&cork->terminate, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        /* Send the corked messages, their statistics are updated by the function sending them */
+        (void)cote_cork_flush(cote);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Grow the arrays of corked messages, the semaphore of the corked messages must be taken by the caller
+ * @param cork Corked messages
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_cork_grow(cote_cork_t *cork) {
+
+    assert(NULL != cork);
+
+    /* Grow the arrays one after the other, each array keeps its size until all of them are grown */
+    int                size   = (0 < cork->size) ? 2 * cork->size : COTE_CORK_MSGS;
+    cote_msg_t *       msgs   = (cote_msg_t *)realloc(cork->msgs, size * sizeof(cote_msg_t));
+    cote_frame_t *     frames = (NULL != msgs) ? (cote_frame_t *)realloc(cork->frames, size * sizeof(cote_frame_t)) : NULL;
+    cote_queue_msg_t **copies = (NULL != frames) ? (cote_queue_msg_t **)realloc(cork->copies, size * sizeof(cote_queue_msg_t *)) : NULL;
+    if (NULL != msgs) {
+        cork->msgs = msgs;
+    }
+    if (NULL != frames) {
+        cork->frames = frames;
+    }
+    if (NULL != copies) {
+        cork->copies = copies;
+    }
+    if (NULL == copies) {
+        /* Unable to allocate memory */
+        return -1;
+    }
+    cork->size = size;
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file      cote_cork.h
+ * @brief     Cote library - Corked messages
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_CORK_H__
+#define __COTE_CORK_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define COTE_CORK_BYTES (65536) /* Default size of the frames from which the corked messages are sent at once */
+#define COTE_CORK_MSGS  (64)    /* Initial size of the arrays of corked messages, they grow as required */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Initialize corked messages, the messages are not corked until a delay is set
+ * @param cork Corked messages
+ * @param fct Function invoked to send the corked messages
+ */
+void cote_cork_init(cote_cork_t *cork, int (*fct)(struct cote_s *, cote_msg_t *, cote_frame_t *, int));
+
+/**
+ * @brief Set the maximum delay before the corked messages are sent, the messages already corked are sent if the messages are not corked anymore
+ * @param cote Cote instance
+ * @param delay Delay (milliseconds), 0 to disable
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_cork_set_delay(cote_t *cote, int delay);
+
+/**
+ * @brief Set the size of the frames from which the corked messages are sent at once
+ * @param cork Corked messages
+ * @param max_bytes Size of the frames (bytes)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_cork_set_bytes(cote_cork_t *cork, int max_bytes);
+
+/**
+ * @brief Cork a message, the message is copied and its frame is prepared, the thread sending the corked messages is created with the first message
+ * The corked messages are sent at once by the calling thread if the size of their frames is reached
+ * @param cote Cote instance
+ * @param topic Topic handle of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_cork_push(cote_t *cote, cote_topic_t *topic, cote_field_t *fields, int count);
+
+/**
+ * @brief Send the corked messages at once
+ * @param cote Cote instance
+ * @return 0 if the function succeeded, -1 if at least one message has not been sent
+ */
+int cote_cork_flush(cote_t *cote);
+
+/**
+ * @brief Release corked messages, the thread is stopped and the messages remaining are sent
+ * @param cote Cote instance
+ */
+void cote_cork_release(cote_t *cote);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_CORK_H__ */
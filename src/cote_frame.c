@@ -0,0 +1,245 @@
+/**
+ * @file      cote_frame.c
+ * @brief     Cote library - Frames
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "cote_frame.h"
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Prepare the encoding of a message, only the JSON fields are serialized
+ * @param frame Frame
+ * @param topic Full topic of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_frame_prepare(cote_frame_t *frame, char *topic, cote_field_t *fields, int count) {
+
+    assert(NULL != frame);
+    assert(NULL != topic);
+    assert((NULL != fields) || (0 == count));
+
+    /* Check amount of fields */
+    if ((0 > count) || (COTE_FIELDS_MAX < count)) {
+        /* Too many fields */
+        return -1;
+    }
+
+    /* Retrieve data and size of the fields, JSON objects are serialized */
+    int ret         = 0;
+    frame->count    = count + 1;
+    frame->size     = COTE_FRAME_HEADER;
+    frame->data[0]  = topic;
+    frame->sizes[0] = (uint32_t)strlen(topic);
+    frame->types[0] = AMP_TYPE_STRING;
+    frame->texts[0] = NULL;
+    for (int index = 0; index < count; index++) {
+        frame->types[index + 1] = (uint8_t)fields[index].type;
+        frame->texts[index + 1] = NULL;
+        switch (fields[index].type) {
+            case AMP_TYPE_BLOB:
+                frame->data[index + 1]  = fields[index].data;
+                frame->sizes[index + 1] = (uint32_t)fields[index].size;
+                break;
+            case AMP_TYPE_STRING:
+                frame->data[index + 1]  = fields[index].data;
+                frame->sizes[index + 1] = (uint32_t)strlen((char *)fields[index].data);
+                break;
+            case AMP_TYPE_BIGINT:
+                frame->data[index + 1]  = fields[index].data;
+                frame->sizes[index + 1] = sizeof(int64_t);
+                break;
+            case AMP_TYPE_JSON:
+                frame->texts[index + 1] = (0 == ret) ? cJSON_PrintUnformatted((cJSON *)fields[index].data) : NULL;
+                frame->data[index + 1]  = frame->texts[index + 1];
+                frame->sizes[index + 1] = (NULL != frame->texts[index + 1]) ? (uint32_t)strlen(frame->texts[index + 1]) : 0;
+                ret                     = (NULL != frame->texts[index + 1]) ? ret : -1;
+                break;
+            default:
+                frame->sizes[index + 1] = 0;
+                ret                     = -1;
+                break;
+        }
+        frame->size += COTE_FIELD_HEADER + frame->sizes[index + 1];
+    }
+    frame->size += COTE_FIELD_HEADER + frame->sizes[0];
+
+    /* Release serialized JSON objects on error */
+    if (0 != ret) {
+        cote_frame_clean(frame);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Write a prepared frame to a buffer
+ * @param frame Frame
+ * @param buffer Buffer of at least frame->size bytes
+ * @return Position following the frame in the buffer
+ */
+uint8_t *
+cote_frame_write(cote_frame_t *frame, uint8_t *buffer) {
+
+    assert(NULL != frame);
+    assert(NULL != buffer);
+
+    /* Write header of the frame */
+    memcpy(buffer, &frame->size, sizeof(uint32_t));
+    buffer += sizeof(uint32_t);
+    *buffer++ = (uint8_t)frame->count;
+
+    /* Write the fields */
+    for (int index = 0; index < frame->count; index++) {
+        *buffer++ = frame->types[index];
+        memcpy(buffer, &frame->sizes[index], sizeof(uint32_t));
+        buffer += sizeof(uint32_t);
+        if (0 < frame->sizes[index]) {
+            memcpy(buffer, frame->data[index], frame->sizes[index]);
+            buffer += frame->sizes[index];
+        }
+    }
+
+    return buffer;
+}
+
+/**
+ * @brief Decode a frame
+ * @param frame Frame, size of the frame excluded
+ * @param size Size of the frame, size of the frame excluded
+ * @return AMP message if the function succeeded, NULL otherwise
+ */
+amp_msg_t *
+cote_frame_decode(uint8_t *frame, size_t size) {
+
+    assert(NULL != frame);
+
+    /* Create AMP message */
+    amp_msg_t *amp = amp_create();
+    if (NULL == amp) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+
+    /* Parse fields, they are allocated the same way as the fields of the messages received by axon */
+    size_t pos   = sizeof(uint8_t);
+    int    count = (0 < size) ? frame[0] : 0;
+    for (int index = 0; index < count; index++) {
+
+        /* Check and parse header of the field */
+        uint8_t  type;
+        uint32_t len;
+        if (size - pos < COTE_FIELD_HEADER) {
+            /* Invalid frame */
+            amp_release(amp);
+            return NULL;
+        }
+        memcpy(&type, &frame[pos], sizeof(uint8_t));
+        memcpy(&len, &frame[pos + sizeof(uint8_t)], sizeof(uint32_t));
+        pos += COTE_FIELD_HEADER;
+        if ((size - pos < len) || ((AMP_TYPE_BIGINT == type) && (sizeof(int64_t) != len))) {
+            /* Invalid frame */
+            amp_release(amp);
+            return NULL;
+        }
+
+        /* Create field */
+        amp_field_t *field = (amp_field_t *)malloc(sizeof(amp_field_t));
+        if (NULL == field) {
+            /* Unable to allocate memory */
+            amp_release(amp);
+            return NULL;
+        }
+        memset(field, 0, sizeof(amp_field_t));
+        field->type = (amp_type_e)type;
+        field->size = (int)len;
+        if (AMP_TYPE_JSON == type) {
+            field->data = cJSON_ParseWithLength((char *)&frame[pos], len);
+        } else if (AMP_TYPE_STRING == type) {
+            if (NULL != (field->data = malloc(len + 1))) {
+                memcpy(field->data, &frame[pos], len);
+                ((char *)field->data)[len] = '\0';
+            }
+        } else if ((AMP_TYPE_BLOB == type) || (AMP_TYPE_BIGINT == type)) {
+            if (NULL != (field->data = malloc((0 < len) ? len : 1))) {
+                memcpy(field->data, &frame[pos], len);
+            }
+        }
+        if (NULL == field->data) {
+            /* Invalid field or unable to allocate memory */
+            free(field);
+            amp_release(amp);
+            return NULL;
+        }
+        pos += len;
+
+        /* Append the field to the message */
+        if (NULL != amp->last) {
+            amp->last->next = field;
+        } else {
+            amp->first = field;
+        }
+        amp->last = field;
+        amp->count++;
+    }
+
+    return amp;
+}
+
+/**
+ * @brief Release the serialized JSON fields of a prepared frame
+ * @param frame Frame
+ */
+void
+cote_frame_clean(cote_frame_t *frame) {
+
+    assert(NULL != frame);
+
+    /* Release serialized JSON objects */
+    for (int index = 0; index < frame->count; index++) {
+        if (NULL != frame->texts[index]) {
+            cJSON_free(frame->texts[index]);
+            frame->texts[index] = NULL;
+        }
+    }
+}
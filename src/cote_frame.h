@@ -0,0 +1,97 @@
+/**
+ * @file      cote_frame.h
+ * @brief     Cote library - Frames
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+
+#ifndef __COTE_FRAME_H__
+#define __COTE_FRAME_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+/*
+ * Format of a frame, integers in the byte order of the host:
+ * - size of the frame (uint32_t, including this field)
+ * - amount of fields (uint8_t, including the topic)
+ * - for each field, type (uint8_t), size of the data (uint32_t) and data (string without null character, blob, int64_t or JSON text)
+ */
+#define COTE_FRAME_HEADER (sizeof(uint32_t) + sizeof(uint8_t))
+#define COTE_FIELD_HEADER (sizeof(uint8_t) + sizeof(uint32_t))
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Prepare the encoding of a message, only the JSON fields are serialized
+ * @param frame Frame
+ * @param topic Full topic of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_frame_prepare(cote_frame_t *frame, char *topic, cote_field_t *fields, int count);
+
+/**
+ * @brief Write a prepared frame to a buffer
+ * @param frame Frame
+ * @param buffer Buffer of at least frame->size bytes
+ * @return Position following the frame in the buffer
+ */
+uint8_t *cote_frame_write(cote_frame_t *frame, uint8_t *buffer);
+
+/**
+ * @brief Decode a frame
+ * @param frame Frame, size of the frame excluded
+ * @param size Size of the frame, size of the frame excluded
+ * @return AMP message if the function succeeded, NULL otherwise
+ */
+amp_msg_t *cote_frame_decode(uint8_t *frame, size_t size);
+
+/**
+ * @brief Release the serialized JSON fields of a prepared frame
+ * @param frame Frame
+ */
+void cote_frame_clean(cote_frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_FRAME_H__ */
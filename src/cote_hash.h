@@ -0,0 +1,87 @@
+/**
+ * @file      cote_hash.h
+ * @brief     Cote library - Hash of the strings
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __COTE_HASH_H__
+#define __COTE_HASH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdint.h>
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Compute the 32-bit hash of a string (FNV-1a), used to distribute the topics and the instance IDs
+ * @param str String
+ * @return Hash of the string
+ */
+static inline uint32_t
+cote_hash(char *str) {
+
+    uint32_t hash = 2166136261u;
+
+    /* Compute hash */
+    while ('\0' != *str) {
+        hash ^= (unsigned char)*str++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Compute the 64-bit hash of a string (FNV-1a), used by the tables which may hold many strings
+ * @param str String
+ * @return Hash of the string
+ */
+static inline uint64_t
+cote_hash64(char *str) {
+
+    uint64_t hash = 14695981039346656037ULL;
+
+    /* Compute hash */
+    while ('\0' != *str) {
+        hash ^= (unsigned char)*str++;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_HASH_H__ */
@@ -0,0 +1,577 @@
+/**
+ * @file      cote_hedge.c
+ * @brief     Cote library - Hedged requests
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "cote_hedge.h"
+#include "cote_peer.h"
+#include "cote_stats.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Start an attempt of a hedged request to a peer, the attempt is queued for the hedging threads and one of the reserved attempts is used
+ * A thread is created if all the threads are busy, the amount of threads is limited by the amount of attempts in flight
+ * @param cote Cote instance
+ * @param call Hedged request, a reference is taken for the attempt
+ * @param peer Peer entered by the caller, left once the attempt is completed
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise (the peer is left and the reserved attempt is released)
+ */
+static int cote_hedge_start(cote_t *cote, cote_hedge_call_t *call, cote_peer_t *peer, int timeout);
+
+/**
+ * @brief Thread used to send the queued attempts
+ * @param arg Cote instance
+ * @return Always returns NULL
+ */
+static void *cote_hedge_thread(void *arg);
+
+/**
+ * @brief Send an attempt, the attempt is not sent anymore if the caller has already returned
+ * @param attempt Attempt of the hedged request, released by the function
+ */
+static void cote_hedge_send(cote_hedge_attempt_t *attempt);
+
+/**
+ * @brief Release a reserved attempt
+ * @param hedge Hedged requests
+ */
+static void cote_hedge_leave(cote_hedge_t *hedge);
+
+/**
+ * @brief Release a reference to a hedged request, the request is released with the last reference
+ * @param call Hedged request
+ */
+static void cote_hedge_call_release(cote_hedge_call_t *call);
+
+/**
+ * @brief Get the absolute time following a delay, as expected by sem_timedwait
+ * @param ts Absolute time
+ * @param ms Delay (milliseconds)
+ */
+static void cote_hedge_timespec(struct timespec *ts, int ms);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Initialize hedged requests
+ * @param hedge Hedged requests
+ * @param fct Function invoked by the attempts to send the JSON text of a request to a peer
+ */
+void
+cote_hedge_init(cote_hedge_t *hedge, int (*fct)(cote_t *, cote_peer_t *, amp_type_e, char *, int64_t, amp_msg_t **, int)) {
+
+    assert(NULL != hedge);
+    assert(NULL != fct);
+
+    /* Initialize hedged requests */
+    memset(hedge, 0, sizeof(cote_hedge_t));
+    hedge->fct = fct;
+
+    /* Initialize semaphores */
+    sem_init(&hedge->pending, 0, 0);
+    sem_init(&hedge->idle, 0, 0);
+    sem_init(&hedge->sem, 0, 1);
+}
+
+/**
+ * @brief Get the delay before a duplicate request is sent, the percentile of the round-trip time is used once measured, the delay option otherwise
+ * @param cote Cote instance
+ * @return Delay (milliseconds), 0 if the requests are not hedged
+ */
+int
+cote_hedge_delay(cote_t *cote) {
+
+    assert(NULL != cote);
+
+    /* Use the percentile of the measured round-trip times if available, rounded up to the next millisecond */
+    if ((0 < cote->options.hedge.percentile) && (true == cote->options.statsHistograms)) {
+        uint64_t ns = cote_stats_requests_percentile(cote, cote->options.hedge.percentile, COTE_HEDGE_SAMPLES);
+        if (0 != ns) {
+            return (int)((ns + 999999) / 1000000);
+        }
+    }
+
+    return cote->options.hedge.delay;
+}
+
+/**
+ * @brief Set the maximum amount of attempts in flight and of threads sending them, it can not be changed once the threads are created
+ * @param cote Cote instance
+ * @param nb_threads Maximum amount of attempts in flight, the requests are not hedged if lower than 2
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_hedge_set_threads(cote_t *cote, int nb_threads) {
+
+    assert(NULL != cote);
+
+    cote_hedge_t *hedge = &cote->hedge;
+    int           ret   = -1;
+
+    /* Set the amount of threads if they are not created yet */
+    sem_wait(&hedge->sem);
+    if ((0 <= nb_threads) && (NULL == hedge->threads)) {
+        cote->options.hedge.threads = nb_threads;
+        ret                         = 0;
+    }
+    sem_post(&hedge->sem);
+
+    return ret;
+}
+
+/**
+ * @brief Reserve the attempts of a hedged request, the request is not hedged if too many attempts are already in flight
+ * @param cote Cote instance
+ * @return true if the attempts are reserved and cote_hedge_request must be called, false if the request must be sent without hedging
+ */
+bool
+cote_hedge_reserve(cote_t *cote) {
+
+    assert(NULL != cote);
+
+    cote_hedge_t *hedge = &cote->hedge;
+
+    /* Reserve the attempt sent to the first replier and the duplicate */
+    sem_wait(&hedge->sem);
+    bool reserved = ((false == hedge->terminate) && (hedge->inflight + 2 <= cote->options.hedge.threads)) ? true : false;
+    if (true == reserved) {
+        hedge->inflight += 2;
+    }
+    sem_post(&hedge->sem);
+
+    return reserved;
+}
+
+/**
+ * @brief Send a hedged request, a duplicate is sent to a second replier if no reply is received after the delay, the first reply is kept
+ * The attempts have been reserved with cote_hedge_reserve, the attempt still waiting for its reply when the caller returns is abandoned
+ * @param cote Cote instance
+ * @param type Type of the payload, AMP_TYPE_JSON or AMP_TYPE_STRING
+ * @param data Payload of the request, serialized once for all the attempts
+ * @param deadline Deadline of the request, 0 if no deadline is attached
+ * @param resp AMP response message
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @param delay Delay before the duplicate request is sent (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_hedge_request(cote_t *cote, amp_type_e type, void *data, int64_t deadline, amp_msg_t **resp, int timeout, int delay) {
+
+    assert(NULL != cote);
+    assert(NULL != data);
+
+    cote_hedge_t *hedge    = &cote->hedge;
+    int           reserved = 2;
+
+    /* Create hedged request, the payload is serialized once and the text is shared by the attempts, it is kept by the abandoned attempt */
+    cote_hedge_call_t *call = (cote_hedge_call_t *)malloc(sizeof(cote_hedge_call_t));
+    if (NULL == call) {
+        /* Unable to allocate memory */
+        cote_hedge_leave(hedge);
+        cote_hedge_leave(hedge);
+        return -1;
+    }
+    memset(call, 0, sizeof(cote_hedge_call_t));
+    call->type = type;
+    call->text = (AMP_TYPE_JSON == type) ? cJSON_PrintUnformatted((cJSON *)data) : strdup((char *)data);
+    if (NULL == call->text) {
+        /* Unable to allocate memory */
+        free(call);
+        cote_hedge_leave(hedge);
+        cote_hedge_leave(hedge);
+        return -1;
+    }
+    call->deadline = deadline;
+    call->refs     = 1;
+    sem_init(&call->done, 0, 0);
+    sem_init(&call->sem, 0, 1);
+
+    /* Send the request to the replier chosen by the load balancing */
+    uint64_t     start   = cote_stats_now();
+    cote_peer_t *primary = cote_peers_enter(&cote->peers);
+    int          issued  = 0;
+    if (NULL != primary) {
+        reserved--;
+        if (0 == cote_hedge_start(cote, call, primary, timeout)) {
+            issued++;
+        }
+    }
+    int completed = 0;
+
+    /* Wait for the first reply, the duplicate is sent after the delay, or at once if the first replier fails */
+    struct timespec ts_delay;
+    struct timespec ts_timeout;
+    cote_hedge_timespec(&ts_delay, delay);
+    cote_hedge_timespec(&ts_timeout, timeout);
+    bool hedged = (0 == issued) ? true : false;
+    while (completed < issued) {
+        int ret;
+        while ((0 != (ret = sem_timedwait(&call->done, (true == hedged) ? &ts_timeout : &ts_delay))) && (EINTR == errno))
+            ;
+        if (0 == ret) {
+            completed++;
+            sem_wait(&call->sem);
+            bool replied = (NULL != call->resp) ? true : false;
+            sem_post(&call->sem);
+            if (true == replied) {
+                /* Reply received */
+                break;
+            }
+            if ((completed < issued) || (true == hedged)) {
+                /* Waiting for the other replier, or all the repliers have failed */
+                continue;
+            }
+        } else if (true == hedged) {
+            /* Timeout */
+            break;
+        }
+
+        /* Send the duplicate to another replier, with the time remaining before the timeout */
+        hedged             = true;
+        int          left  = timeout - (int)((cote_stats_now() - start) / 1000000);
+        cote_peer_t *other = (0 < left) ? cote_peers_enter_other(&cote->peers, primary) : NULL;
+        if (NULL != other) {
+            reserved--;
+            if (0 == cote_hedge_start(cote, call, other, left)) {
+                COTE_STATS_INC(cote, requests_hedged);
+                issued++;
+            }
+        }
+    }
+
+    /* Release the attempts which have not been used */
+    while (0 < reserved--) {
+        cote_hedge_leave(hedge);
+    }
+
+    /* The replies received from now are released by the attempts, which are abandoned */
+    sem_wait(&call->sem);
+    call->finished = true;
+    amp_msg_t *amp = call->resp;
+    call->resp     = NULL;
+    sem_post(&call->sem);
+    cote_hedge_call_release(call);
+
+    /* Give the reply to the caller */
+    if (NULL == amp) {
+        return -1;
+    }
+    if (NULL != resp) {
+        *resp = amp;
+    } else {
+        amp_release(amp);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Release hedged requests, the attempts in flight are waited, they complete at the latest with their timeout, and the threads are stopped
+ * @param cote Cote instance
+ */
+void
+cote_hedge_release(cote_t *cote) {
+
+    assert(NULL != cote);
+
+    cote_hedge_t *hedge = &cote->hedge;
+
+    /* No attempt is started anymore, each attempt in flight posts the idle semaphore when it is completed */
+    sem_wait(&hedge->sem);
+    hedge->terminate = true;
+    int inflight     = hedge->inflight;
+    sem_post(&hedge->sem);
+    while (0 < inflight) {
+        if (0 == sem_wait(&hedge->idle)) {
+            inflight--;
+        }
+    }
+
+    /* Stop threads, the queue is empty once all the attempts are completed */
+    for (int index = 0; index < hedge->nb_threads; index++) {
+        sem_post(&hedge->pending);
+    }
+    for (int index = 0; index < hedge->nb_threads; index++) {
+        pthread_join(hedge->threads[index], NULL);
+    }
+    if (NULL != hedge->threads) {
+        free(hedge->threads);
+    }
+
+    /* Release semaphores */
+    sem_close(&hedge->pending);
+    sem_close(&hedge->idle);
+    sem_close(&hedge->sem);
+}
+
+/**
+ * @brief Start an attempt of a hedged request to a peer, the attempt is queued for the hedging threads and one of the reserved attempts is used
+ * A thread is created if all the threads are busy, the amount of threads is limited by the amount of attempts in flight
+ * @param cote Cote instance
+ * @param call Hedged request, a reference is taken for the attempt
+ * @param peer Peer entered by the caller, left once the attempt is completed
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise (the peer is left and the reserved attempt is released)
+ */
+static int
+cote_hedge_start(cote_t *cote, cote_hedge_call_t *call, cote_peer_t *peer, int timeout) {
+
+    assert(NULL != cote);
+    assert(NULL != call);
+    assert(NULL != peer);
+
+    cote_hedge_t *hedge = &cote->hedge;
+
+    /* Create attempt */
+    cote_hedge_attempt_t *attempt = (cote_hedge_attempt_t *)malloc(sizeof(cote_hedge_attempt_t));
+    if (NULL == attempt) {
+        /* Unable to allocate memory */
+        cote_peers_leave(&cote->peers, peer, 0);
+        cote_hedge_leave(hedge);
+        return -1;
+    }
+    attempt->next    = NULL;
+    attempt->cote    = cote;
+    attempt->call    = call;
+    attempt->peer    = peer;
+    attempt->timeout = timeout;
+    __atomic_add_fetch(&call->refs, 1, __ATOMIC_RELAXED);
+
+    /* Queue the attempt */
+    sem_wait(&hedge->sem);
+    if (NULL != hedge->last) {
+        hedge->last->next = attempt;
+    } else {
+        hedge->first = attempt;
+    }
+    hedge->last = attempt;
+    hedge->queued++;
+
+    /* Create a thread if all the threads are busy, the threads are kept for the next attempts */
+    if ((NULL == hedge->threads) && (NULL != (hedge->threads = (pthread_t *)malloc(cote->options.hedge.threads * sizeof(pthread_t))))) {
+        hedge->max_threads = cote->options.hedge.threads;
+    }
+    if ((hedge->waiting < hedge->queued) && (hedge->nb_threads < hedge->max_threads)
+        && (0 == pthread_create(&hedge->threads[hedge->nb_threads], NULL, cote_hedge_thread, cote))) {
+        hedge->nb_threads++;
+    }
+    if (0 == hedge->nb_threads) {
+        /* Unable to create the thread, the attempt is the only one queued */
+        hedge->first  = NULL;
+        hedge->last   = NULL;
+        hedge->queued = 0;
+        sem_post(&hedge->sem);
+        __atomic_sub_fetch(&call->refs, 1, __ATOMIC_RELAXED);
+        free(attempt);
+        cote_peers_leave(&cote->peers, peer, 0);
+        cote_hedge_leave(hedge);
+        return -1;
+    }
+    sem_post(&hedge->sem);
+
+    /* Wake up a thread */
+    sem_post(&hedge->pending);
+
+    return 0;
+}
+
+/**
+ * @brief Thread used to send the queued attempts
+ * @param arg Cote instance
+ * @return Always returns NULL
+ */
+static void *
+cote_hedge_thread(void *arg) {
+
+    assert(NULL != arg);
+
+    /* Retrieve cote instance */
+    cote_t *      cote  = (cote_t *)arg;
+    cote_hedge_t *hedge = &cote->hedge;
+
+    /* Send the attempts until termination, the queue is empty only when the threads are stopped */
+    while (1) {
+
+        /* Wait for an attempt */
+        sem_wait(&hedge->sem);
+        hedge->waiting++;
+        sem_post(&hedge->sem);
+        sem_wait(&hedge->pending);
+
+        /* Take the first attempt of the queue */
+        sem_wait(&hedge->sem);
+        hedge->waiting--;
+        cote_hedge_attempt_t *attempt = hedge->first;
+        if (NULL != attempt) {
+            hedge->first = attempt->next;
+            if (NULL == hedge->first) {
+                hedge->last = NULL;
+            }
+            hedge->queued--;
+        }
+        sem_post(&hedge->sem);
+        if (NULL == attempt) {
+            break;
+        }
+
+        /* Send the attempt */
+        cote_hedge_send(attempt);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Send an attempt, the attempt is not sent anymore if the caller has already returned
+ * @param attempt Attempt of the hedged request, released by the function
+ */
+static void
+cote_hedge_send(cote_hedge_attempt_t *attempt) {
+
+    assert(NULL != attempt);
+
+    /* Retrieve attempt */
+    cote_t *           cote = attempt->cote;
+    cote_hedge_call_t *call = attempt->call;
+    amp_msg_t *        amp  = NULL;
+    int                ret  = -1;
+    uint64_t           rtt  = 0;
+
+    /* Send the request if the caller is still waiting, the round-trip is measured to update the latency of the replier */
+    sem_wait(&call->sem);
+    bool finished = call->finished;
+    sem_post(&call->sem);
+    if (false == finished) {
+        uint64_t start = cote_stats_now();
+        ret            = cote->hedge.fct(cote, attempt->peer, call->type, call->text, call->deadline, &amp, attempt->timeout);
+        rtt            = cote_stats_now() - start;
+    }
+    cote_peers_leave(&cote->peers, attempt->peer, rtt);
+
+    /* Keep the first reply, the other ones are released */
+    sem_wait(&call->sem);
+    if ((0 == ret) && (NULL != amp) && (false == call->finished) && (NULL == call->resp)) {
+        call->resp = amp;
+        amp        = NULL;
+    }
+    sem_post(&call->sem);
+    if (NULL != amp) {
+        amp_release(amp);
+    }
+
+    /* Notify the caller */
+    sem_post(&call->done);
+    cote_hedge_call_release(call);
+    free(attempt);
+
+    /* Release the attempt */
+    cote_hedge_leave(&cote->hedge);
+}
+
+/**
+ * @brief Release a reserved attempt
+ * @param hedge Hedged requests
+ */
+static void
+cote_hedge_leave(cote_hedge_t *hedge) {
+
+    assert(NULL != hedge);
+
+    /* Release the attempt, the release of the instance is notified once terminating */
+    sem_wait(&hedge->sem);
+    hedge->inflight--;
+    if (true == hedge->terminate) {
+        sem_post(&hedge->idle);
+    }
+    sem_post(&hedge->sem);
+}
+
+/**
+ * @brief Release a reference to a hedged request, the request is released with the last reference
+ * @param call Hedged request
+ */
+static void
+cote_hedge_call_release(cote_hedge_call_t *call) {
+
+    assert(NULL != call);
+
+    /* Release the reference */
+    if (0 != __atomic_sub_fetch(&call->refs, 1, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+
+    /* Release hedged request */
+    if (NULL != call->resp) {
+        amp_release(call->resp);
+    }
+    if (AMP_TYPE_JSON == call->type) {
+        cJSON_free(call->text);
+    } else {
+        free(call->text);
+    }
+    sem_close(&call->done);
+    sem_close(&call->sem);
+    free(call);
+}
+
+/**
+ * @brief Get the absolute time following a delay, as expected by sem_timedwait
+ * @param ts Absolute time
+ * @param ms Delay (milliseconds)
+ */
+static void
+cote_hedge_timespec(struct timespec *ts, int ms) {
+
+    assert(NULL != ts);
+
+    /* Add the delay to the current time */
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (ms % 1000) * 1000000L;
+    if (1000000000L <= ts->tv_nsec) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
@@ -0,0 +1,107 @@
+/**
+ * @file      cote_hedge.h
+ * @brief     Cote library - Hedged requests
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_HEDGE_H__
+#define __COTE_HEDGE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define COTE_HEDGE_THREADS (64)  /* Default maximum amount of attempts of the hedged requests in flight, and of threads sending them */
+#define COTE_HEDGE_SAMPLES (100) /* Minimum amount of round-trip times recorded before the percentile is used as delay */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Initialize hedged requests
+ * @param hedge Hedged requests
+ * @param fct Function invoked by the attempts to send the JSON text of a request to a peer
+ */
+void cote_hedge_init(cote_hedge_t *hedge, int (*fct)(cote_t *, cote_peer_t *, amp_type_e, char *, int64_t, amp_msg_t **, int));
+
+/**
+ * @brief Get the delay before a duplicate request is sent, the percentile of the round-trip time is used once measured, the delay option otherwise
+ * @param cote Cote instance
+ * @return Delay (milliseconds), 0 if the requests are not hedged
+ */
+int cote_hedge_delay(cote_t *cote);
+
+/**
+ * @brief Set the maximum amount of attempts in flight and of threads sending them, it can not be changed once the threads are created
+ * @param cote Cote instance
+ * @param nb_threads Maximum amount of attempts in flight, the requests are not hedged if lower than 2
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_hedge_set_threads(cote_t *cote, int nb_threads);
+
+/**
+ * @brief Reserve the attempts of a hedged request, the request is not hedged if too many attempts are already in flight
+ * @param cote Cote instance
+ * @return true if the attempts are reserved and cote_hedge_request must be called, false if the request must be sent without hedging
+ */
+bool cote_hedge_reserve(cote_t *cote);
+
+/**
+ * @brief Send a hedged request, a duplicate is sent to a second replier if no reply is received after the delay, the first reply is kept
+ * The attempts have been reserved with cote_hedge_reserve, the attempt still waiting for its reply when the caller returns is abandoned
+ * @param cote Cote instance
+ * @param type Type of the payload, AMP_TYPE_JSON or AMP_TYPE_STRING
+ * @param data Payload of the request, serialized once for all the attempts
+ * @param deadline Deadline of the request, 0 if no deadline is attached
+ * @param resp AMP response message
+ * @param timeout Timeout waiting for the reply (milliseconds)
+ * @param delay Delay before the duplicate request is sent (milliseconds)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_hedge_request(cote_t *cote, amp_type_e type, void *data, int64_t deadline, amp_msg_t **resp, int timeout, int delay);
+
+/**
+ * @brief Release hedged requests, the attempts in flight are waited, they complete at the latest with their timeout, and the threads are stopped
+ * @param cote Cote instance
+ */
+void cote_hedge_release(cote_t *cote);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_HEDGE_H__ */
@@ -0,0 +1,444 @@
+/**
+ * @file      cote_ids.c
+ * @brief     Cote library - Topic IDs
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <assert.h>
+#include <semaphore.h>
+
+#include "cote_ids.h"
+#include "cote_sub.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Create a topic
+ * @param fulltopic Full topic
+ * @return Topic if the function succeeded, NULL otherwise
+ */
+static cote_ids_topic_t *cote_ids_topic_create(char *fulltopic);
+
+/**
+ * @brief Create a copy of a topic with the subscriptions matching it in a subscription table
+ * @param topic Topic
+ * @param table Subscription table
+ * @return Topic if the function succeeded, NULL otherwise
+ */
+static cote_ids_topic_t *cote_ids_topic_match(cote_ids_topic_t *topic, cote_sub_table_t *table);
+
+/**
+ * @brief Function invoked for each subscription matching a topic, the subscription is appended to the topic
+ * @param sub Subscription
+ * @param user Topic
+ */
+static void cote_ids_topic_match_cb(cote_sub_t *sub, void *user);
+
+/**
+ * @brief Release a topic table
+ * @param table Topic table
+ */
+static void cote_ids_table_release(cote_ids_table_t *table);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Initialize topic IDs
+ * @param ids Topic IDs
+ */
+void
+cote_ids_init(cote_ids_t *ids) {
+
+    assert(NULL != ids);
+
+    /* Initialize topic IDs */
+    memset(ids, 0, sizeof(cote_ids_t));
+    sem_init(&ids->sem, 0, 1);
+
+    /* Choose the owner of the topic tables, announced with the definitions and in the advertisement so that the subscribers release them with the node */
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    unsigned int salt = (unsigned int)ts.tv_nsec ^ (unsigned int)(uintptr_t)ids;
+    snprintf(ids->owner, sizeof(ids->owner), "%08x%08x%08x", (unsigned int)getpid(), (unsigned int)ts.tv_sec, salt);
+
+    /* Choose the tag of the topic table, it must be different for each publisher sending to the same subscriber */
+    cote_ids_renew(ids);
+}
+
+/**
+ * @brief Assign a topic ID to a topic handle (Publisher instance)
+ * @param ids Topic IDs
+ * @return Topic ID
+ */
+int
+cote_ids_assign(cote_ids_t *ids) {
+
+    assert(NULL != ids);
+
+    return __atomic_fetch_add(&ids->count, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Change tag of the topic table of the Publisher instance, the subscribers receive new definitions of the topics
+ * @param ids Topic IDs
+ */
+void
+cote_ids_renew(cote_ids_t *ids) {
+
+    assert(NULL != ids);
+
+    /* Mix time, process ID and previous tag, the tag is limited to 47 bits so that the keys are positive */
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t tag = __atomic_load_n(&ids->tag, __ATOMIC_RELAXED);
+    tag          = (tag * 0x9e3779b97f4a7c15ULL) ^ (uint64_t)ts.tv_nsec ^ ((uint64_t)ts.tv_sec << 20) ^ ((uint64_t)getpid() << 30);
+    tag &= COTE_IDS_TAG_MASK;
+    if (tag == __atomic_load_n(&ids->tag, __ATOMIC_RELAXED)) {
+        tag = (tag + 1) & COTE_IDS_TAG_MASK;
+    }
+    __atomic_store_n(&ids->tag, tag, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Define a topic received from a publisher (Subscriber instance)
+ * @param ids Topic IDs
+ * @param key Key of the topic
+ * @param fulltopic Full topic
+ * @param owner Owner of the topic table, as announced in the advertisement of the publisher
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_ids_define(cote_ids_t *ids, int64_t key, char *fulltopic, char *owner) {
+
+    assert(NULL != ids);
+    assert(NULL != fulltopic);
+
+    uint64_t tag = COTE_IDS_TAG(key);
+    uint32_t id  = COTE_IDS_ID(key);
+
+    /* Check topic ID and owner */
+    if ((0 > key) || (NULL == owner)) {
+        /* Invalid definition */
+        return -1;
+    }
+
+    /* Search for the topic table of the publisher, create it if it does not exist */
+    sem_wait(&ids->sem);
+    cote_ids_table_t *table = ids->first;
+    while ((NULL != table) && (strcmp(owner, table->owner))) {
+        table = table->next;
+    }
+    if (NULL == table) {
+        if (NULL == (table = (cote_ids_table_t *)malloc(sizeof(cote_ids_table_t)))) {
+            /* Unable to allocate memory */
+            sem_post(&ids->sem);
+            return -1;
+        }
+        memset(table, 0, sizeof(cote_ids_table_t));
+        if (NULL == (table->owner = strdup(owner))) {
+            /* Unable to allocate memory */
+            free(table);
+            sem_post(&ids->sem);
+            return -1;
+        }
+        table->tag  = tag;
+        table->next = ids->first;
+        ids->first  = table;
+    }
+
+    /* The publisher has changed its tag, the topics previously defined are not used anymore */
+    if (tag != table->tag) {
+        for (int index = 0; index < table->count; index++) {
+            cote_ids_put(table->topics[index]);
+            table->topics[index] = NULL;
+        }
+        table->tag = tag;
+    }
+
+    /* Grow the table if required */
+    if ((int)id >= table->count) {
+        int                count  = ((int)id < 2 * table->count) ? (2 * table->count) : ((int)id + 1);
+        cote_ids_topic_t **topics = (cote_ids_topic_t **)realloc(table->topics, count * sizeof(cote_ids_topic_t *));
+        if (NULL == topics) {
+            /* Unable to allocate memory */
+            sem_post(&ids->sem);
+            return -1;
+        }
+        memset(&topics[table->count], 0, (count - table->count) * sizeof(cote_ids_topic_t *));
+        table->topics = topics;
+        table->count  = count;
+    }
+
+    /* Define the topic, a topic already defined is not changed */
+    int ret = 0;
+    if (NULL == table->topics[id]) {
+        if (NULL == (table->topics[id] = cote_ids_topic_create(fulltopic))) {
+            /* Unable to allocate memory */
+            ret = -1;
+        }
+    } else if (strcmp(table->topics[id]->fulltopic, fulltopic)) {
+        /* The publisher must change its tag when the full topics are changed */
+        ret = -1;
+    }
+    sem_post(&ids->sem);
+
+    return ret;
+}
+
+/**
+ * @brief Retrieve the topic of a key received from a publisher (Subscriber instance)
+ * The subscriptions matching the topic are searched again in the subscription table if it has changed, they are valid as long as the table is
+ * @param ids Topic IDs
+ * @param key Key of the topic
+ * @param table Subscription table used to dispatch the message, NULL if the matching subscriptions are not required
+ * @return Topic, to be released with cote_ids_put, NULL if the key is not defined or if several publishers use the same tag
+ */
+cote_ids_topic_t *
+cote_ids_get(cote_ids_t *ids, int64_t key, cote_sub_table_t *table) {
+
+    assert(NULL != ids);
+
+    uint64_t tag = COTE_IDS_TAG(key);
+    uint32_t id  = COTE_IDS_ID(key);
+
+    /* Check topic ID */
+    if (0 > key) {
+        /* Invalid topic ID */
+        return NULL;
+    }
+
+    /* Search for the topic table of the tag, the messages of the publishers using the same tag can not be told apart and are not dispatched */
+    cote_ids_topic_t *topic = NULL;
+    sem_wait(&ids->sem);
+    cote_ids_table_t *found = NULL;
+    int               count = 0;
+    for (cote_ids_table_t *curr = ids->first; NULL != curr; curr = curr->next) {
+        if (tag == curr->tag) {
+            found = curr;
+            count++;
+        }
+    }
+    if ((1 == count) && ((int64_t)id < (int64_t)found->count)) {
+        topic = found->topics[id];
+    }
+
+    /* Search the subscriptions matching the topic if the subscription table has changed, the topic is kept unchanged if an error occurs */
+    if ((NULL != topic) && (NULL != table) && ((false == topic->matched) || (topic->version != table->version))) {
+        cote_ids_topic_t *matched = cote_ids_topic_match(topic, table);
+        if (NULL != matched) {
+            cote_ids_put(topic);
+            found->topics[id] = matched;
+            topic             = matched;
+        }
+    }
+
+    /* Reference the topic, it stays valid if the publisher is removed meanwhile */
+    if (NULL != topic) {
+        __atomic_fetch_add(&topic->refs, 1, __ATOMIC_RELAXED);
+    }
+    sem_post(&ids->sem);
+
+    return topic;
+}
+
+/**
+ * @brief Release a topic retrieved with cote_ids_get
+ * @param topic Topic
+ */
+void
+cote_ids_put(cote_ids_topic_t *topic) {
+
+    /* Release the topic with the last reference */
+    if ((NULL != topic) && (0 == __atomic_sub_fetch(&topic->refs, 1, __ATOMIC_ACQ_REL))) {
+        free(topic->subs);
+        free(topic->fulltopic);
+        free(topic);
+    }
+}
+
+/**
+ * @brief Release the topic tables of a publisher (Subscriber instance)
+ * @param ids Topic IDs
+ * @param owner Owner of the topic tables, as announced in the advertisement of the publisher
+ */
+void
+cote_ids_forget(cote_ids_t *ids, char *owner) {
+
+    assert(NULL != ids);
+    assert(NULL != owner);
+
+    /* Remove the topic tables of the publisher */
+    sem_wait(&ids->sem);
+    cote_ids_table_t **curr = &ids->first;
+    while (NULL != *curr) {
+        if (!strcmp(owner, (*curr)->owner)) {
+            cote_ids_table_t *tmp = *curr;
+            *curr                 = tmp->next;
+            cote_ids_table_release(tmp);
+        } else {
+            curr = &(*curr)->next;
+        }
+    }
+    sem_post(&ids->sem);
+}
+
+/**
+ * @brief Release topic IDs
+ * @param ids Topic IDs
+ */
+void
+cote_ids_release(cote_ids_t *ids) {
+
+    assert(NULL != ids);
+
+    /* Release topic tables */
+    while (NULL != ids->first) {
+        cote_ids_table_t *tmp = ids->first;
+        ids->first            = ids->first->next;
+        cote_ids_table_release(tmp);
+    }
+
+    /* Release semaphore */
+    sem_close(&ids->sem);
+}
+
+/**
+ * @brief Create a topic
+ * @param fulltopic Full topic
+ * @return Topic if the function succeeded, NULL otherwise
+ */
+static cote_ids_topic_t *
+cote_ids_topic_create(char *fulltopic) {
+
+    assert(NULL != fulltopic);
+
+    /* Create topic, referenced by the topic table */
+    cote_ids_topic_t *topic = (cote_ids_topic_t *)malloc(sizeof(cote_ids_topic_t));
+    if (NULL == topic) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+    memset(topic, 0, sizeof(cote_ids_topic_t));
+    if (NULL == (topic->fulltopic = strdup(fulltopic))) {
+        /* Unable to allocate memory */
+        free(topic);
+        return NULL;
+    }
+    topic->refs = 1;
+
+    return topic;
+}
+
+/**
+ * @brief Create a copy of a topic with the subscriptions matching it in a subscription table
+ * @param topic Topic
+ * @param table Subscription table
+ * @return Topic if the function succeeded, NULL otherwise
+ */
+static cote_ids_topic_t *
+cote_ids_topic_match(cote_ids_topic_t *topic, cote_sub_table_t *table) {
+
+    assert(NULL != topic);
+    assert(NULL != table);
+
+    /* Create the copy, the original topic may be used by dispatches in progress */
+    cote_ids_topic_t *matched = cote_ids_topic_create(topic->fulltopic);
+    if (NULL == matched) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+
+    /* Search the matching subscriptions, the flag is cleared if the subscriptions can not be stored */
+    matched->matched = true;
+    matched->version = table->version;
+    cote_sub_table_match(table, matched->fulltopic, &cote_ids_topic_match_cb, matched);
+    if (false == matched->matched) {
+        /* Unable to allocate memory */
+        cote_ids_put(matched);
+        return NULL;
+    }
+
+    return matched;
+}
+
+/**
+ * @brief Function invoked for each subscription matching a topic, the subscription is appended to the topic
+ * @param sub Subscription
+ * @param user Topic
+ */
+static void
+cote_ids_topic_match_cb(cote_sub_t *sub, void *user) {
+
+    assert(NULL != sub);
+    assert(NULL != user);
+
+    /* Retrieve topic using user data */
+    cote_ids_topic_t *topic = (cote_ids_topic_t *)user;
+
+    /* Append subscription */
+    if (true == topic->matched) {
+        cote_sub_t **subs = (cote_sub_t **)realloc(topic->subs, (topic->nb_subs + 1) * sizeof(cote_sub_t *));
+        if (NULL == subs) {
+            /* Unable to allocate memory */
+            topic->matched = false;
+            return;
+        }
+        topic->subs                   = subs;
+        topic->subs[topic->nb_subs++] = sub;
+    }
+}
+
+/**
+ * @brief Release a topic table
+ * @param table Topic table
+ */
+static void
+cote_ids_table_release(cote_ids_table_t *table) {
+
+    assert(NULL != table);
+
+    /* Release the topics, the ones used by dispatches in progress are released with their last reference */
+    for (int index = 0; index < table->count; index++) {
+        cote_ids_put(table->topics[index]);
+    }
+    free(table->topics);
+    free(table->owner);
+    free(table);
+}
@@ -0,0 +1,125 @@
+/**
+ * @file      cote_ids.h
+ * @brief     Cote library - Topic IDs
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_IDS_H__
+#define __COTE_IDS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+/* Maximum amount of topic IDs of a publisher topic table */
+#define COTE_IDS_MAX (65536)
+
+/*
+ * Key of a topic sent in the first field of the messages as AMP_TYPE_BIGINT, the tag of the publisher topic table (47 bits) followed by the topic ID (16 bits)
+ * A topic is defined to a subscriber with a message containing the complement of the key (a negative value), the full topic and the owner of the table
+ */
+#define COTE_IDS_TAG_MASK     (0x7fffffffffffULL)
+#define COTE_IDS_KEY(tag, id) ((int64_t)((((uint64_t)(tag)&COTE_IDS_TAG_MASK) << 16) | ((uint64_t)(id)&0xffff)))
+#define COTE_IDS_TAG(key)     ((uint64_t)(key) >> 16)
+#define COTE_IDS_ID(key)      ((uint32_t)((uint64_t)(key)&0xffff))
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Initialize topic IDs
+ * @param ids Topic IDs
+ */
+void cote_ids_init(cote_ids_t *ids);
+
+/**
+ * @brief Assign a topic ID to a topic handle (Publisher instance)
+ * @param ids Topic IDs
+ * @return Topic ID
+ */
+int cote_ids_assign(cote_ids_t *ids);
+
+/**
+ * @brief Change tag of the topic table of the Publisher instance, the subscribers receive new definitions of the topics
+ * @param ids Topic IDs
+ */
+void cote_ids_renew(cote_ids_t *ids);
+
+/**
+ * @brief Define a topic received from a publisher (Subscriber instance)
+ * @param ids Topic IDs
+ * @param key Key of the topic
+ * @param fulltopic Full topic
+ * @param owner Owner of the topic table, as announced in the advertisement of the publisher
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_ids_define(cote_ids_t *ids, int64_t key, char *fulltopic, char *owner);
+
+/**
+ * @brief Retrieve the topic of a key received from a publisher (Subscriber instance)
+ * The subscriptions matching the topic are searched again in the subscription table if it has changed, they are valid as long as the table is
+ * @param ids Topic IDs
+ * @param key Key of the topic
+ * @param table Subscription table used to dispatch the message, NULL if the matching subscriptions are not required
+ * @return Topic, to be released with cote_ids_put, NULL if the key is not defined or if several publishers use the same tag
+ */
+cote_ids_topic_t *cote_ids_get(cote_ids_t *ids, int64_t key, cote_sub_table_t *table);
+
+/**
+ * @brief Release a topic retrieved with cote_ids_get
+ * @param topic Topic
+ */
+void cote_ids_put(cote_ids_topic_t *topic);
+
+/**
+ * @brief Release the topic tables of a publisher (Subscriber instance)
+ * @param ids Topic IDs
+ * @param owner Owner of the topic tables, as announced in the advertisement of the publisher
+ */
+void cote_ids_forget(cote_ids_t *ids, char *owner);
+
+/**
+ * @brief Release topic IDs
+ * @param ids Topic IDs
+ */
+void cote_ids_release(cote_ids_t *ids);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_IDS_H__ */
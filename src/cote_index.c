@@ -0,0 +1,554 @@
+/**
+ * @file      cote_index.c
+ * @brief     Cote library - Index of the discovered nodes by topic
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <semaphore.h>
+#include <regex.h>
+#include <cJSON.h>
+
+#include "cote_index.h"
+#include "cote_hash.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Copy a string of the advertisement of a node to a fixed size buffer, the buffer is left empty if the string is not advertised
+ * @param dst Buffer
+ * @param size Size of the buffer
+ * @param src String, may be NULL
+ */
+static void cote_index_copy(char *dst, size_t size, char *src);
+
+/**
+ * @brief Retrieve a topic of the index, the semaphore must be taken by the caller
+ * @param index Index
+ * @param topic Topic
+ * @return Topic if it is indexed, NULL otherwise
+ */
+static cote_index_topic_t *cote_index_find_topic(cote_index_t *index, char *topic);
+
+/**
+ * @brief Copy the information of the nodes of a topic not retrieved yet by the current query, the semaphore must be taken by the caller
+ * @param index Index
+ * @param topic Topic
+ * @param nodes Array of node information, NULL to count the nodes only
+ * @param max Size of the array
+ * @param count Amount of node information already set, updated with the nodes of the topic
+ */
+static void cote_index_collect(cote_index_t *index, cote_index_topic_t *topic, cote_node_info_t *nodes, int max, int *count);
+
+/**
+ * @brief Link a node to a topic, the topic is created if it is not indexed, the semaphore must be taken by the caller
+ * @param index Index
+ * @param topic Topic
+ * @param node Node
+ * @param pattern Topic advertised in a subscribesTo/requests array, which is a regular expression
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_index_link(cote_index_t *index, char *topic, cote_index_node_t *node, bool pattern);
+
+/**
+ * @brief Unlink a node from its topics, the topics without nodes are released, the semaphore must be taken by the caller
+ * @param index Index
+ * @param node Node
+ */
+static void cote_index_unlink(cote_index_t *index, cote_index_node_t *node);
+
+/**
+ * @brief Release a node
+ * @param node Node
+ */
+static void cote_index_node_release(cote_index_node_t *node);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Initialize index
+ * @param index Index
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_index_init(cote_index_t *index) {
+
+    assert(NULL != index);
+
+    /* Allocate buckets */
+    memset(index, 0, sizeof(cote_index_t));
+    index->nodes  = (cote_index_node_t **)calloc(COTE_INDEX_BUCKETS, sizeof(cote_index_node_t *));
+    index->topics = (cote_index_topic_t **)calloc(COTE_INDEX_BUCKETS, sizeof(cote_index_topic_t *));
+    if ((NULL == index->nodes) || (NULL == index->topics)) {
+        /* Unable to allocate memory */
+        free(index->nodes);
+        free(index->topics);
+        index->nodes  = NULL;
+        index->topics = NULL;
+        return -1;
+    }
+
+    /* Initialize semaphore */
+    sem_init(&index->sem, 0, 1);
+
+    return 0;
+}
+
+/**
+ * @brief Add a discovered node to the index, a node already indexed with the same instance ID is replaced
+ * @param index Index
+ * @param node Node
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_index_add(cote_index_t *index, discover_node_t *node) {
+
+    assert(NULL != index);
+    assert(NULL != node);
+
+    /* Check if the index is initialized */
+    if ((NULL == index->nodes) || (NULL == node->iid) || (NULL == node->data.advertisement)) {
+        return -1;
+    }
+
+    /* Create node, the advertisement is parsed once */
+    cote_index_node_t *curr = (cote_index_node_t *)calloc(1, sizeof(cote_index_node_t));
+    if (NULL == curr) {
+        /* Unable to allocate memory */
+        return -1;
+    }
+    if (NULL == (curr->iid = strdup(node->iid))) {
+        /* Unable to allocate memory */
+        free(curr);
+        return -1;
+    }
+    cJSON *advertisement = node->data.advertisement;
+    cJSON *port          = cJSON_GetObjectItemCaseSensitive(advertisement, "port");
+    cote_index_copy(curr->info.iid, sizeof(curr->info.iid), node->iid);
+    cote_index_copy(curr->info.name, sizeof(curr->info.name), cJSON_GetStringValue(cJSON_GetObjectItemCaseSensitive(advertisement, "name")));
+    cote_index_copy(curr->info.address, sizeof(curr->info.address), node->address);
+    cote_index_copy(curr->info.hostname, sizeof(curr->info.hostname), node->hostname);
+    curr->info.port = (cJSON_IsNumber(port)) ? (uint16_t)cJSON_GetNumberValue(port) : 0;
+    cote_index_copy(curr->info.axon_type, sizeof(curr->info.axon_type), cJSON_GetStringValue(cJSON_GetObjectItemCaseSensitive(advertisement, "axon_type")));
+    cote_index_copy(curr->info.namespace_, sizeof(curr->info.namespace_), cJSON_GetStringValue(cJSON_GetObjectItemCaseSensitive(advertisement, "namespace")));
+
+    /* Retrieve the topics advertised by the node, the subscribesTo/requests topics are regular expressions */
+    static char *arrays[] = { "subscribesTo", "requests", "broadcasts", "respondsTo" };
+    for (size_t index_array = 0; index_array < sizeof(arrays) / sizeof(arrays[0]); index_array++) {
+        if (2 == index_array) {
+            curr->patterns = curr->count;
+        }
+        cJSON *topics = cJSON_GetObjectItemCaseSensitive(advertisement, arrays[index_array]);
+        cJSON *topic  = NULL;
+        cJSON_ArrayForEach(topic, topics) {
+            if (cJSON_IsString(topic)) {
+                char **tmp = (char **)realloc(curr->topics, (curr->count + 1) * sizeof(char *));
+                if ((NULL == tmp) || (NULL == (tmp[curr->count] = strdup(cJSON_GetStringValue(topic))))) {
+                    /* Unable to allocate memory */
+                    if (NULL != tmp) {
+                        curr->topics = tmp;
+                    }
+                    cote_index_node_release(curr);
+                    return -1;
+                }
+                curr->topics = tmp;
+                curr->count++;
+            }
+        }
+    }
+
+    /* Replace the node if it is already indexed */
+    cote_index_remove(index, node->iid);
+
+    /* Link the node to its topics and add it to its bucket */
+    sem_wait(&index->sem);
+    for (int index_topic = 0; index_topic < curr->count; index_topic++) {
+        if (0 != cote_index_link(index, curr->topics[index_topic], curr, (index_topic < curr->patterns) ? true : false)) {
+            /* Unable to allocate memory */
+            cote_index_unlink(index, curr);
+            sem_post(&index->sem);
+            cote_index_node_release(curr);
+            return -1;
+        }
+    }
+    unsigned int bucket  = cote_hash(curr->iid) & (COTE_INDEX_BUCKETS - 1);
+    curr->next           = index->nodes[bucket];
+    index->nodes[bucket] = curr;
+    index->count++;
+    sem_post(&index->sem);
+
+    return 0;
+}
+
+/**
+ * @brief Remove a discovered node from the index
+ * @param index Index
+ * @param iid Instance ID of the node
+ */
+void
+cote_index_remove(cote_index_t *index, char *iid) {
+
+    assert(NULL != index);
+
+    /* Check if the index is initialized */
+    if ((NULL == index->nodes) || (NULL == iid)) {
+        return;
+    }
+
+    /* Search the node in its bucket */
+    sem_wait(&index->sem);
+    cote_index_node_t **prev = &index->nodes[cote_hash(iid) & (COTE_INDEX_BUCKETS - 1)];
+    while ((NULL != *prev) && (strcmp((*prev)->iid, iid))) {
+        prev = &(*prev)->next;
+    }
+    cote_index_node_t *curr = *prev;
+    if (NULL != curr) {
+        *prev = curr->next;
+        cote_index_unlink(index, curr);
+        index->count--;
+    }
+    sem_post(&index->sem);
+
+    /* Release the node */
+    if (NULL != curr) {
+        cote_index_node_release(curr);
+    }
+}
+
+/**
+ * @brief Copy the information of the nodes advertising a topic, or a regular expression matching it
+ * @param index Index
+ * @param topic Topic, NULL to copy all the nodes
+ * @param nodes Array of node information, NULL to get the amount of nodes only
+ * @param max Size of the array
+ * @return Amount of node information set, or amount of nodes if nodes is NULL
+ */
+int
+cote_index_get(cote_index_t *index, char *topic, cote_node_info_t *nodes, int max) {
+
+    assert(NULL != index);
+
+    int count = 0;
+
+    /* Check if the index is initialized */
+    if (NULL == index->nodes) {
+        return 0;
+    }
+
+    sem_wait(&index->sem);
+    if (NULL != topic) {
+
+        /* Copy the nodes of the topic, then the nodes of the regular expressions matching it, each node is copied once */
+        if (0 == ++index->query) {
+            /* Wrapped around, forget the previous queries */
+            for (int bucket = 0; bucket < COTE_INDEX_BUCKETS; bucket++) {
+                for (cote_index_node_t *tmp = index->nodes[bucket]; NULL != tmp; tmp = tmp->next) {
+                    tmp->query = 0;
+                }
+            }
+            index->query = 1;
+        }
+        cote_index_topic_t *curr = cote_index_find_topic(index, topic);
+        if (NULL != curr) {
+            cote_index_collect(index, curr, nodes, max, &count);
+        }
+        for (curr = index->patterns; NULL != curr; curr = curr->pattern) {
+            if ((strcmp(curr->topic, topic)) && (0 == regexec(curr->regex, topic, 0, NULL, 0))) {
+                cote_index_collect(index, curr, nodes, max, &count);
+            }
+        }
+
+    } else if (NULL == nodes) {
+
+        /* Amount of nodes */
+        count = index->count;
+
+    } else {
+
+        /* Copy all the nodes */
+        for (int bucket = 0; (bucket < COTE_INDEX_BUCKETS) && (count < max); bucket++) {
+            for (cote_index_node_t *curr = index->nodes[bucket]; (NULL != curr) && (count < max); curr = curr->next) {
+                memcpy(&nodes[count], &curr->info, sizeof(cote_node_info_t));
+                count++;
+            }
+        }
+    }
+    sem_post(&index->sem);
+
+    return count;
+}
+
+/**
+ * @brief Release index
+ * @param index Index
+ */
+void
+cote_index_release(cote_index_t *index) {
+
+    assert(NULL != index);
+
+    /* Check if the index is initialized */
+    if (NULL == index->nodes) {
+        return;
+    }
+
+    /* Release all the nodes, the topics are released with their last node */
+    sem_wait(&index->sem);
+    for (int bucket = 0; bucket < COTE_INDEX_BUCKETS; bucket++) {
+        while (NULL != index->nodes[bucket]) {
+            cote_index_node_t *tmp = index->nodes[bucket];
+            index->nodes[bucket]   = tmp->next;
+            cote_index_unlink(index, tmp);
+            cote_index_node_release(tmp);
+        }
+    }
+    free(index->nodes);
+    free(index->topics);
+    index->nodes    = NULL;
+    index->topics   = NULL;
+    index->patterns = NULL;
+    index->count    = 0;
+    sem_post(&index->sem);
+
+    /* Release semaphore */
+    sem_close(&index->sem);
+}
+
+/**
+ * @brief Copy a string of the advertisement of a node to a fixed size buffer, the buffer is left empty if the string is not advertised
+ * @param dst Buffer
+ * @param size Size of the buffer
+ * @param src String, may be NULL
+ */
+static void
+cote_index_copy(char *dst, size_t size, char *src) {
+
+    assert(NULL != dst);
+    assert(0 < size);
+
+    /* Copy the string, truncated if too long */
+    if (NULL != src) {
+        strncpy(dst, src, size - 1);
+    }
+    dst[size - 1] = '\0';
+}
+
+/**
+ * @brief Retrieve a topic of the index, the semaphore must be taken by the caller
+ * @param index Index
+ * @param topic Topic
+ * @return Topic if it is indexed, NULL otherwise
+ */
+static cote_index_topic_t *
+cote_index_find_topic(cote_index_t *index, char *topic) {
+
+    assert(NULL != index);
+    assert(NULL != topic);
+
+    /* Search the topic in its bucket */
+    cote_index_topic_t *curr = index->topics[cote_hash(topic) & (COTE_INDEX_BUCKETS - 1)];
+    while ((NULL != curr) && (strcmp(curr->topic, topic))) {
+        curr = curr->next;
+    }
+
+    return curr;
+}
+
+/**
+ * @brief Copy the information of the nodes of a topic not retrieved yet by the current query, the semaphore must be taken by the caller
+ * @param index Index
+ * @param topic Topic
+ * @param nodes Array of node information, NULL to count the nodes only
+ * @param max Size of the array
+ * @param count Amount of node information already set, updated with the nodes of the topic
+ */
+static void
+cote_index_collect(cote_index_t *index, cote_index_topic_t *topic, cote_node_info_t *nodes, int max, int *count) {
+
+    assert(NULL != index);
+    assert(NULL != topic);
+    assert(NULL != count);
+
+    /* Mark the nodes with the current query so that a node advertising several matching topics is retrieved once */
+    for (int index_node = 0; (index_node < topic->count) && ((NULL == nodes) || (*count < max)); index_node++) {
+        cote_index_node_t *curr = topic->nodes[index_node];
+        if (index->query != curr->query) {
+            curr->query = index->query;
+            if (NULL != nodes) {
+                memcpy(&nodes[*count], &curr->info, sizeof(cote_node_info_t));
+            }
+            (*count)++;
+        }
+    }
+}
+
+/**
+ * @brief Link a node to a topic, the topic is created if it is not indexed, the semaphore must be taken by the caller
+ * @param index Index
+ * @param topic Topic
+ * @param node Node
+ * @param pattern Topic advertised in a subscribesTo/requests array, which is a regular expression
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_index_link(cote_index_t *index, char *topic, cote_index_node_t *node, bool pattern) {
+
+    assert(NULL != index);
+    assert(NULL != topic);
+    assert(NULL != node);
+
+    /* Retrieve the topic, it is created if it is not indexed */
+    cote_index_topic_t *curr = cote_index_find_topic(index, topic);
+    if (NULL == curr) {
+        if (NULL == (curr = (cote_index_topic_t *)calloc(1, sizeof(cote_index_topic_t)))) {
+            /* Unable to allocate memory */
+            return -1;
+        }
+        if (NULL == (curr->topic = strdup(topic))) {
+            /* Unable to allocate memory */
+            free(curr);
+            return -1;
+        }
+        unsigned int bucket   = cote_hash(topic) & (COTE_INDEX_BUCKETS - 1);
+        curr->next            = index->topics[bucket];
+        index->topics[bucket] = curr;
+    }
+
+    /* Compile the regular expression advertised in a subscribesTo/requests array, the topic is only compared as is if it is literal or invalid */
+    if ((true == pattern) && (NULL == curr->regex) && (NULL != strpbrk(topic, COTE_INDEX_METACHARACTERS))
+        && (NULL != (curr->regex = (regex_t *)malloc(sizeof(regex_t))))) {
+        if (0 == regcomp(curr->regex, topic, REG_NOSUB | REG_EXTENDED)) {
+            curr->pattern   = index->patterns;
+            index->patterns = curr;
+        } else {
+            free(curr->regex);
+            curr->regex = NULL;
+        }
+    }
+
+    /* Check if the node is already linked, a topic may be advertised in several arrays */
+    for (int index_node = 0; index_node < curr->count; index_node++) {
+        if (node == curr->nodes[index_node]) {
+            return 0;
+        }
+    }
+
+    /* Add the node to the topic, the array is doubled when it is full */
+    if (curr->count == curr->size) {
+        int                 size  = (0 < curr->size) ? 2 * curr->size : 4;
+        cote_index_node_t **nodes = (cote_index_node_t **)realloc(curr->nodes, size * sizeof(cote_index_node_t *));
+        if (NULL == nodes) {
+            /* Unable to allocate memory, a topic without nodes is released when the node is unlinked by the caller */
+            return -1;
+        }
+        curr->nodes = nodes;
+        curr->size  = size;
+    }
+    curr->nodes[curr->count++] = node;
+
+    return 0;
+}
+
+/**
+ * @brief Unlink a node from its topics, the topics without nodes are released, the semaphore must be taken by the caller
+ * @param index Index
+ * @param node Node
+ */
+static void
+cote_index_unlink(cote_index_t *index, cote_index_node_t *node) {
+
+    assert(NULL != index);
+    assert(NULL != node);
+
+    for (int index_topic = 0; index_topic < node->count; index_topic++) {
+
+        /* Search the topic in its bucket */
+        cote_index_topic_t **prev = &index->topics[cote_hash(node->topics[index_topic]) & (COTE_INDEX_BUCKETS - 1)];
+        while ((NULL != *prev) && (strcmp((*prev)->topic, node->topics[index_topic]))) {
+            prev = &(*prev)->next;
+        }
+        cote_index_topic_t *curr = *prev;
+        if (NULL == curr) {
+            /* Topic not linked, or already released */
+            continue;
+        }
+
+        /* Remove the node from the topic, the last node takes its place */
+        for (int index_node = 0; index_node < curr->count; index_node++) {
+            if (node == curr->nodes[index_node]) {
+                curr->nodes[index_node] = curr->nodes[--curr->count];
+                break;
+            }
+        }
+
+        /* Release the topic if it has no node anymore */
+        if (0 == curr->count) {
+            *prev = curr->next;
+            if (NULL != curr->regex) {
+                cote_index_topic_t **pattern = &index->patterns;
+                while (curr != *pattern) {
+                    pattern = &(*pattern)->pattern;
+                }
+                *pattern = curr->pattern;
+                regfree(curr->regex);
+                free(curr->regex);
+            }
+            free(curr->nodes);
+            free(curr->topic);
+            free(curr);
+        }
+    }
+}
+
+/**
+ * @brief Release a node
+ * @param node Node
+ */
+static void
+cote_index_node_release(cote_index_node_t *node) {
+
+    assert(NULL != node);
+
+    /* Release topics */
+    for (int index_topic = 0; index_topic < node->count; index_topic++) {
+        free(node->topics[index_topic]);
+    }
+    if (NULL != node->topics) {
+        free(node->topics);
+    }
+    free(node->iid);
+    free(node);
+}
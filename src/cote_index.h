@@ -0,0 +1,96 @@
+/**
+ * @file      cote_index.h
+ * @brief     Cote library - Index of the discovered nodes by topic
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_INDEX_H__
+#define __COTE_INDEX_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define COTE_INDEX_BUCKETS        (256)                /* Amount of buckets of the nodes and topics tables, must be a power of 2 */
+#define COTE_INDEX_METACHARACTERS ".[]()*+?{}|^$\\" /* Extended regular expression metacharacters, topics containing them are regular expressions */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Initialize index
+ * @param index Index
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_index_init(cote_index_t *index);
+
+/**
+ * @brief Add a discovered node to the index, a node already indexed with the same instance ID is replaced
+ * @param index Index
+ * @param node Node
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_index_add(cote_index_t *index, discover_node_t *node);
+
+/**
+ * @brief Remove a discovered node from the index
+ * @param index Index
+ * @param iid Instance ID of the node
+ */
+void cote_index_remove(cote_index_t *index, char *iid);
+
+/**
+ * @brief Copy the information of the nodes advertising a topic, or a regular expression matching it
+ * @param index Index
+ * @param topic Topic, NULL to copy all the nodes
+ * @param nodes Array of node information, NULL to get the amount of nodes only
+ * @param max Size of the array
+ * @return Amount of node information set, or amount of nodes if nodes is NULL
+ */
+int cote_index_get(cote_index_t *index, char *topic, cote_node_info_t *nodes, int max);
+
+/**
+ * @brief Release index
+ * @param index Index
+ */
+void cote_index_release(cote_index_t *index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_INDEX_H__ */
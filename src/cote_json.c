@@ -0,0 +1,441 @@
+/**
+ * @file      cote_json.c
+ * @brief     Cote library - JSON scanner
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#include "cote_json.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Search a top-level member of a JSON object without parsing the other members
+ * @param json JSON object as text
+ * @param len Length of the text
+ * @param key Key of the member
+ * @return Position of the value of the member, 0 if the member is not found or the object is invalid
+ */
+static size_t cote_json_find_member(char *json, size_t len, char *key);
+
+/**
+ * @brief Insert a member at the beginning of a JSON object without parsing the other members
+ * @param json JSON object as text
+ * @param key Key of the member, no character is escaped
+ * @param value Value of the member as JSON text
+ * @return New JSON object as text if the function succeeded (to be released by the caller), NULL otherwise
+ */
+static char *cote_json_insert_member(char *json, char *key, char *value);
+
+/**
+ * @brief Skip white spaces
+ * @param json JSON text
+ * @param len Length of the text
+ * @param pos Current position
+ * @return Position of the next character which is not a white space
+ */
+static size_t cote_json_skip_spaces(char *json, size_t len, size_t pos);
+
+/**
+ * @brief Skip a string
+ * @param json JSON text
+ * @param len Length of the text
+ * @param pos Position of the opening quote
+ * @return Position following the closing quote, 0 if the string is invalid
+ */
+static size_t cote_json_skip_string(char *json, size_t len, size_t pos);
+
+/**
+ * @brief Skip a value, nested objects and arrays are skipped without being parsed
+ * @param json JSON text
+ * @param len Length of the text
+ * @param pos Position of the value
+ * @return Position following the value, 0 if the value is invalid
+ */
+static size_t cote_json_skip_value(char *json, size_t len, size_t pos);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Get a string member of a JSON object without parsing the other members, only the top-level members are considered
+ * @param json JSON object as text, not necessarily terminated by a null character
+ * @param len Length of the text
+ * @param key Key of the member
+ * @return Value of the member if the function succeeded (to be released by the caller), NULL if the member is not found or is not a string
+ */
+char *
+cote_json_get_string(char *json, size_t len, char *key) {
+
+    assert(NULL != json);
+    assert(NULL != key);
+
+    /* Search the member */
+    size_t pos = cote_json_find_member(json, len, key);
+    size_t end = 0;
+    if ((0 == pos) || ('"' != json[pos]) || (0 == (end = cote_json_skip_string(json, len, pos)))) {
+        /* Not found, or not a string */
+        return NULL;
+    }
+
+    /* Extract value of the member */
+    if (NULL == memchr(&json[pos + 1], '\\', end - pos - 2)) {
+        /* No escaped character, the value is copied */
+        char *value = (char *)malloc(end - pos - 1);
+        if (NULL != value) {
+            memcpy(value, &json[pos + 1], end - pos - 2);
+            value[end - pos - 2] = '\0';
+        }
+        return value;
+    }
+
+    /* Escaped characters, the string only is parsed */
+    char * value = NULL;
+    cJSON *item  = cJSON_ParseWithLength(&json[pos], end - pos);
+    if (NULL != item) {
+        if (NULL != cJSON_GetStringValue(item)) {
+            value = strdup(cJSON_GetStringValue(item));
+        }
+        cJSON_Delete(item);
+    }
+
+    return value;
+}
+
+/**
+ * @brief Get an integer member of a JSON object without parsing the other members, only the top-level members are considered
+ * @param json JSON object as text, not necessarily terminated by a null character
+ * @param len Length of the text
+ * @param key Key of the member
+ * @param value Value of the member
+ * @return 0 if the function succeeded, -1 if the member is not found or is not an integer
+ */
+int
+cote_json_get_integer(char *json, size_t len, char *key, int64_t *value) {
+
+    assert(NULL != json);
+    assert(NULL != key);
+    assert(NULL != value);
+
+    /* Search the member */
+    size_t pos = cote_json_find_member(json, len, key);
+    size_t end = 0;
+    if ((0 == pos) || (0 == (end = cote_json_skip_value(json, len, pos)))) {
+        /* Not found */
+        return -1;
+    }
+
+    /* Convert the value, the text is copied because it is not necessarily terminated */
+    char buffer[24];
+    if (end - pos >= sizeof(buffer)) {
+        /* Not an integer */
+        return -1;
+    }
+    memcpy(buffer, &json[pos], end - pos);
+    buffer[end - pos] = '\0';
+    char *    last    = NULL;
+    long long integer = strtoll(buffer, &last, 10);
+    if ((last == buffer) || ('\0' != *last)) {
+        /* Not an integer */
+        return -1;
+    }
+    *value = (int64_t)integer;
+
+    return 0;
+}
+
+/**
+ * @brief Set a string member of a JSON object without parsing the other members, the value is replaced if the member exists, inserted first otherwise
+ * @param json JSON object as text
+ * @param key Key of the member, no character is escaped
+ * @param value Value of the member
+ * @return New JSON object as text if the function succeeded (to be released by the caller), NULL otherwise
+ */
+char *
+cote_json_set_string(char *json, char *key, char *value) {
+
+    assert(NULL != json);
+    assert(NULL != key);
+    assert(NULL != value);
+
+    /* Format value of the member, characters are escaped as required */
+    cJSON *item = cJSON_CreateString(value);
+    if (NULL == item) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+    char *str = cJSON_PrintUnformatted(item);
+    cJSON_Delete(item);
+    if (NULL == str) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+
+    /* Replace the value of the member if it exists, so that the key appears only once, insert the member otherwise */
+    char * result = NULL;
+    size_t len    = strlen(json);
+    size_t pos    = cote_json_find_member(json, len, key);
+    size_t end    = (0 != pos) ? cote_json_skip_value(json, len, pos) : 0;
+    if (0 == pos) {
+        result = cote_json_insert_member(json, key, str);
+    } else if (0 != end) {
+        size_t size = pos + strlen(str) + (len - end) + 1;
+        if (NULL != (result = (char *)malloc(size))) {
+            snprintf(result, size, "%.*s%s%s", (int)pos, json, str, &json[end]);
+        }
+    }
+    cJSON_free(str);
+
+    return result;
+}
+
+/**
+ * @brief Insert an integer member at the beginning of a JSON object without parsing the other members
+ * @param json JSON object as text
+ * @param key Key of the member, no character is escaped
+ * @param value Value of the member
+ * @return New JSON object as text if the function succeeded (to be released by the caller), NULL otherwise
+ */
+char *
+cote_json_insert_integer(char *json, char *key, int64_t value) {
+
+    assert(NULL != json);
+    assert(NULL != key);
+
+    /* Format value of the member */
+    char str[24];
+    snprintf(str, sizeof(str), "%" PRId64, value);
+
+    /* Insert the member */
+    return cote_json_insert_member(json, key, str);
+}
+
+/**
+ * @brief Search a top-level member of a JSON object without parsing the other members
+ * @param json JSON object as text
+ * @param len Length of the text
+ * @param key Key of the member
+ * @return Position of the value of the member, 0 if the member is not found or the object is invalid
+ */
+static size_t
+cote_json_find_member(char *json, size_t len, char *key) {
+
+    assert(NULL != json);
+    assert(NULL != key);
+
+    /* Check beginning of the object */
+    size_t pos = cote_json_skip_spaces(json, len, 0);
+    if ((pos >= len) || ('{' != json[pos])) {
+        /* Not an object */
+        return 0;
+    }
+
+    /* Parse the members of the object */
+    pos = cote_json_skip_spaces(json, len, pos + 1);
+    while ((pos < len) && ('"' == json[pos])) {
+
+        /* Parse key of the member */
+        size_t start = pos + 1;
+        size_t end   = cote_json_skip_string(json, len, pos);
+        if (0 == end) {
+            /* Invalid key */
+            return 0;
+        }
+        bool found = ((end - 1 - start == strlen(key)) && (!memcmp(&json[start], key, end - 1 - start))) ? true : false;
+        pos        = cote_json_skip_spaces(json, len, end);
+        if ((pos >= len) || (':' != json[pos])) {
+            /* Invalid member */
+            return 0;
+        }
+        pos = cote_json_skip_spaces(json, len, pos + 1);
+
+        /* Return position of the value of the member */
+        if (true == found) {
+            return (pos < len) ? pos : 0;
+        }
+
+        /* Skip value of the member */
+        if (0 == (pos = cote_json_skip_value(json, len, pos))) {
+            /* Invalid value */
+            return 0;
+        }
+        pos = cote_json_skip_spaces(json, len, pos);
+        if ((pos < len) && (',' == json[pos])) {
+            pos = cote_json_skip_spaces(json, len, pos + 1);
+        } else {
+            /* End of the object, or invalid object */
+            return 0;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Insert a member at the beginning of a JSON object without parsing the other members
+ * @param json JSON object as text
+ * @param key Key of the member, no character is escaped
+ * @param value Value of the member as JSON text
+ * @return New JSON object as text if the function succeeded (to be released by the caller), NULL otherwise
+ */
+static char *
+cote_json_insert_member(char *json, char *key, char *value) {
+
+    assert(NULL != json);
+    assert(NULL != key);
+    assert(NULL != value);
+
+    /* Check beginning of the object */
+    size_t len = strlen(json);
+    size_t pos = cote_json_skip_spaces(json, len, 0);
+    if ((pos >= len) || ('{' != json[pos])) {
+        /* Not an object */
+        return NULL;
+    }
+    size_t next  = cote_json_skip_spaces(json, len, pos + 1);
+    bool   empty = ((next < len) && ('}' == json[next])) ? true : false;
+
+    /* Format new object, the member is inserted after the opening brace */
+    size_t size   = 1 + strlen(key) + 3 + strlen(value) + 1 + (len - pos - 1) + 1;
+    char * result = (char *)malloc(size);
+    if (NULL != result) {
+        snprintf(result, size, "{\"%s\":%s%s%s", key, value, (true == empty) ? "" : ",", &json[pos + 1]);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Skip white spaces
+ * @param json JSON text
+ * @param len Length of the text
+ * @param pos Current position
+ * @return Position of the next character which is not a white space
+ */
+static size_t
+cote_json_skip_spaces(char *json, size_t len, size_t pos) {
+
+    assert(NULL != json);
+
+    /* Skip white spaces */
+    while ((pos < len) && ((' ' == json[pos]) || ('\t' == json[pos]) || ('\n' == json[pos]) || ('\r' == json[pos]))) {
+        pos++;
+    }
+
+    return pos;
+}
+
+/**
+ * @brief Skip a string
+ * @param json JSON text
+ * @param len Length of the text
+ * @param pos Position of the opening quote
+ * @return Position following the closing quote, 0 if the string is invalid
+ */
+static size_t
+cote_json_skip_string(char *json, size_t len, size_t pos) {
+
+    assert(NULL != json);
+
+    /* Search for the closing quote, escaped characters are skipped */
+    for (pos = pos + 1; pos < len; pos++) {
+        if ('\\' == json[pos]) {
+            pos++;
+        } else if ('"' == json[pos]) {
+            return pos + 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Skip a value, nested objects and arrays are skipped without being parsed
+ * @param json JSON text
+ * @param len Length of the text
+ * @param pos Position of the value
+ * @return Position following the value, 0 if the value is invalid
+ */
+static size_t
+cote_json_skip_value(char *json, size_t len, size_t pos) {
+
+    assert(NULL != json);
+
+    /* Check value */
+    if (pos >= len) {
+        /* No value */
+        return 0;
+    }
+
+    /* Treatment depending of the type of the value */
+    if ('"' == json[pos]) {
+
+        /* String */
+        return cote_json_skip_string(json, len, pos);
+
+    } else if (('{' == json[pos]) || ('[' == json[pos])) {
+
+        /* Object or array, search for the closing character of the same level */
+        int depth = 0;
+        while (pos < len) {
+            if ('"' == json[pos]) {
+                if (0 == (pos = cote_json_skip_string(json, len, pos))) {
+                    /* Invalid string */
+                    return 0;
+                }
+                continue;
+            }
+            if (('{' == json[pos]) || ('[' == json[pos])) {
+                depth++;
+            } else if ((('}' == json[pos]) || (']' == json[pos])) && (0 == --depth)) {
+                return pos + 1;
+            }
+            pos++;
+        }
+        return 0;
+    }
+
+    /* Number, true, false or null */
+    size_t start = pos;
+    while ((pos < len) && (',' != json[pos]) && ('}' != json[pos]) && (']' != json[pos]) && (' ' != json[pos]) && ('\t' != json[pos]) && ('\n' != json[pos])
+           && ('\r' != json[pos])) {
+        pos++;
+    }
+
+    return (pos > start) ? pos : 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file      cote_json.h
+ * @brief     Cote library - JSON scanner
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_JSON_H__
+#define __COTE_JSON_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Get a string member of a JSON object without parsing the other members, only the top-level members are considered
+ * @param json JSON object as text, not necessarily terminated by a null character
+ * @param len Length of the text
+ * @param key Key of the member
+ * @return Value of the member if the function succeeded (to be released by the caller), NULL if the member is not found or is not a string
+ */
+char *cote_json_get_string(char *json, size_t len, char *key);
+
+/**
+ * @brief Get an integer member of a JSON object without parsing the other members, only the top-level members are considered
+ * @param json JSON object as text, not necessarily terminated by a null character
+ * @param len Length of the text
+ * @param key Key of the member
+ * @param value Value of the member
+ * @return 0 if the function succeeded, -1 if the member is not found or is not an integer
+ */
+int cote_json_get_integer(char *json, size_t len, char *key, int64_t *value);
+
+/**
+ * @brief Set a string member of a JSON object without parsing the other members, the value is replaced if the member exists, inserted first otherwise
+ * @param json JSON object as text
+ * @param key Key of the member, no character is escaped
+ * @param value Value of the member
+ * @return New JSON object as text if the function succeeded (to be released by the caller), NULL otherwise
+ */
+char *cote_json_set_string(char *json, char *key, char *value);
+
+/**
+ * @brief Insert an integer member at the beginning of a JSON object without parsing the other members
+ * @param json JSON object as text
+ * @param key Key of the member, no character is escaped
+ * @param value Value of the member
+ * @return New JSON object as text if the function succeeded (to be released by the caller), NULL otherwise
+ */
+char *cote_json_insert_integer(char *json, char *key, int64_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_JSON_H__ */
@@ -0,0 +1,329 @@
+/**
+ * @file      cote_loop.c
+ * @brief     Cote library - Event loop integration
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <errno.h>
+#include <time.h>
+#include <semaphore.h>
+#include <sys/eventfd.h>
+
+#include "cote_loop.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Check if the next event of the ring is ready to be processed, called only by the thread calling cote_process
+ * @param loop Event loop
+ * @return true if the next event is ready, false otherwise
+ */
+static bool cote_loop_ready(cote_loop_t *loop);
+
+/**
+ * @brief Wait for space in the ring, the time waiting is limited to COTE_LOOP_WAIT
+ * @param loop Event loop
+ */
+static void cote_loop_wait(cote_loop_t *loop);
+
+/**
+ * @brief Make the event file descriptor readable
+ * @param loop Event loop
+ */
+static void cote_loop_signal(cote_loop_t *loop);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Initialize event loop, the event file descriptor is created when the event loop is started
+ * @param loop Event loop
+ */
+void
+cote_loop_init(cote_loop_t *loop) {
+
+    assert(NULL != loop);
+
+    /* Initialize event loop */
+    memset(loop, 0, sizeof(cote_loop_t));
+    loop->fd = -1;
+}
+
+/**
+ * @brief Start event loop, the ring of the events is allocated
+ * @param loop Event loop
+ * @param fct Function invoked by cote_loop_process to process an event, the AMP message and the request of the event are released by the function
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_loop_start(cote_loop_t *loop, void (*fct)(cote_t *, cote_event_t *)) {
+
+    assert(NULL != loop);
+    assert(NULL != fct);
+
+    /* Check if the event loop is already started */
+    if (0 <= loop->fd) {
+        return 0;
+    }
+
+    /* Allocate the ring, the sequence number of each slot is its position for the first round */
+    if (NULL == (loop->events = (cote_event_t *)calloc(COTE_LOOP_SIZE, sizeof(cote_event_t)))) {
+        /* Unable to allocate memory */
+        return -1;
+    }
+    loop->size = COTE_LOOP_SIZE;
+    for (size_t index = 0; index < loop->size; index++) {
+        loop->events[index].seq = index;
+    }
+
+    /* Create event file descriptor, it is read without blocking by cote_loop_process */
+    loop->fct = fct;
+    if (0 > (loop->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))) {
+        /* Unable to create event file descriptor */
+        free(loop->events);
+        loop->events = NULL;
+        loop->fd     = -1;
+        return -1;
+    }
+    sem_init(&loop->space, 0, 0);
+
+    return 0;
+}
+
+/**
+ * @brief Push an event, the event file descriptor becomes readable, this function is called by the library threads and does not lock
+ * A received message is dropped if the ring is full, a completed request waits for space until the event loop is closed
+ * @param loop Event loop
+ * @param amp AMP message, or reply of the request
+ * @param request Completed asynchronous request, NULL for a received message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_loop_push(cote_loop_t *loop, amp_msg_t *amp, cote_request_t *request) {
+
+    assert(NULL != loop);
+    assert((NULL != amp) || (NULL != request));
+
+    int ret = -1;
+
+    /* Reserve a slot, the slot is free once the event of the previous round has been processed */
+    bool          done = false;
+    cote_event_t *slot = NULL;
+    size_t        pos  = __atomic_load_n(&loop->tail, __ATOMIC_RELAXED);
+    while (false == done) {
+        slot          = &loop->events[pos & (loop->size - 1)];
+        intptr_t diff = (intptr_t)__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - (intptr_t)pos;
+        if (0 == diff) {
+            if (__atomic_compare_exchange_n(&loop->tail, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                ret  = 0;
+                done = true;
+            }
+        } else if (0 > diff) {
+            /* The ring is full, only the completed requests wait for space because their callback must be invoked */
+            if ((NULL == request) || (true == __atomic_load_n(&loop->closing, __ATOMIC_ACQUIRE))) {
+                done = true;
+            } else {
+                cote_loop_wait(loop);
+                pos = __atomic_load_n(&loop->tail, __ATOMIC_RELAXED);
+            }
+        } else {
+            /* The slot has been reserved by another thread meanwhile */
+            pos = __atomic_load_n(&loop->tail, __ATOMIC_RELAXED);
+        }
+    }
+    if (0 != ret) {
+        /* The event is not pushed */
+        return -1;
+    }
+
+    /* Write the event, it is ready to be processed once the sequence number of the slot is incremented */
+    slot->amp     = amp;
+    slot->request = request;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_SEQ_CST);
+
+    /* The file descriptor is written only for the first event pushed since the last process */
+    if (false == __atomic_exchange_n(&loop->signaled, true, __ATOMIC_SEQ_CST)) {
+        cote_loop_signal(loop);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Close event loop, the completed requests waiting for space in the ring are not pushed and are given back to the caller of cote_loop_push
+ * @param loop Event loop
+ */
+void
+cote_loop_close(cote_loop_t *loop) {
+
+    assert(NULL != loop);
+
+    /* Threads waiting for space check the flag at the latest after COTE_LOOP_WAIT */
+    __atomic_store_n(&loop->closing, true, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Process the waiting events, this function must always be called by the same thread
+ * The event file descriptor remains readable if events are still waiting once the budget is reached
+ * @param loop Event loop
+ * @param cote Cote instance
+ * @param budget Maximum amount of events to be processed, 0 to process all the waiting events
+ * @return Amount of events processed
+ */
+int
+cote_loop_process(cote_loop_t *loop, cote_t *cote, int budget) {
+
+    assert(NULL != loop);
+    assert(NULL != cote);
+
+    int count = 0;
+
+    /* Check if the event loop is started */
+    if (0 > loop->fd) {
+        return 0;
+    }
+
+    /* Clear the flag and the event file descriptor before processing the events, an event pushed meanwhile makes it readable again */
+    __atomic_store_n(&loop->signaled, false, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    uint64_t value;
+    if (sizeof(value) != read(loop->fd, &value, sizeof(value))) {
+        /* Nothing to read, the events not processed because of the budget may still be waiting */
+    }
+
+    /* Process the events, the slot is given back to the library threads before invoking the function */
+    while (((0 >= budget) || (count < budget)) && (true == cote_loop_ready(loop))) {
+        cote_event_t *slot  = &loop->events[loop->head & (loop->size - 1)];
+        cote_event_t  event = *slot;
+        __atomic_store_n(&slot->seq, loop->head + loop->size, __ATOMIC_RELEASE);
+        loop->head++;
+        if (0 < __atomic_load_n(&loop->waiting, __ATOMIC_ACQUIRE)) {
+            sem_post(&loop->space);
+        }
+        loop->fct(cote, &event);
+        count++;
+    }
+
+    /* Keep the event file descriptor readable if the budget is reached */
+    if (true == cote_loop_ready(loop)) {
+        cote_loop_signal(loop);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Release event loop, the waiting events are processed by the calling thread so that the callbacks of the completed requests are invoked
+ * @param loop Event loop
+ * @param cote Cote instance
+ */
+void
+cote_loop_release(cote_loop_t *loop, cote_t *cote) {
+
+    assert(NULL != loop);
+    assert(NULL != cote);
+
+    /* Check if the event loop is started */
+    if (0 > loop->fd) {
+        return;
+    }
+
+    /* Process the remaining events */
+    cote_loop_process(loop, cote, 0);
+
+    /* Close event file descriptor */
+    close(loop->fd);
+    loop->fd = -1;
+
+    /* Release the ring */
+    sem_close(&loop->space);
+    free(loop->events);
+    loop->events = NULL;
+}
+
+/**
+ * @brief Check if the next event of the ring is ready to be processed, called only by the thread calling cote_process
+ * @param loop Event loop
+ * @return true if the next event is ready, false otherwise
+ */
+static bool
+cote_loop_ready(cote_loop_t *loop) {
+
+    assert(NULL != loop);
+
+    return (__atomic_load_n(&loop->events[loop->head & (loop->size - 1)].seq, __ATOMIC_SEQ_CST) == loop->head + 1) ? true : false;
+}
+
+/**
+ * @brief Wait for space in the ring, the time waiting is limited to COTE_LOOP_WAIT
+ * @param loop Event loop
+ */
+static void
+cote_loop_wait(cote_loop_t *loop) {
+
+    assert(NULL != loop);
+
+    /* Wait until an event is processed, the ring may have been emptied before the thread is counted as waiting */
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += COTE_LOOP_WAIT * 1000000L;
+    if (1000000000L <= ts.tv_nsec) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    __atomic_add_fetch(&loop->waiting, 1, __ATOMIC_SEQ_CST);
+    while ((0 != sem_timedwait(&loop->space, &ts)) && (EINTR == errno))
+        ;
+    __atomic_sub_fetch(&loop->waiting, 1, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Make the event file descriptor readable
+ * @param loop Event loop
+ */
+static void
+cote_loop_signal(cote_loop_t *loop) {
+
+    assert(NULL != loop);
+
+    /* Write the event file descriptor, the counter is cleared by cote_loop_process */
+    uint64_t value = 1;
+    if (sizeof(value) != write(loop->fd, &value, sizeof(value))) {
+        /* The counter can not overflow, the file descriptor is already readable */
+    }
+}
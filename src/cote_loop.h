@@ -0,0 +1,105 @@
+/**
+ * @file      cote_loop.h
+ * @brief     Cote library - Event loop integration
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_LOOP_H__
+#define __COTE_LOOP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define COTE_LOOP_SIZE (4096) /* Size of the ring of the event loop, the received messages are dropped when it is full */
+#define COTE_LOOP_WAIT (10)   /* Maximum time waiting for space in the ring before checking again (milliseconds) */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Initialize event loop, the event file descriptor is created when the event loop is started
+ * @param loop Event loop
+ */
+void cote_loop_init(cote_loop_t *loop);
+
+/**
+ * @brief Start event loop, the ring of the events is allocated
+ * @param loop Event loop
+ * @param fct Function invoked by cote_loop_process to process an event, the AMP message and the request of the event are released by the function
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_loop_start(cote_loop_t *loop, void (*fct)(cote_t *, cote_event_t *));
+
+/**
+ * @brief Push an event, the event file descriptor becomes readable, this function is called by the library threads and does not lock
+ * A received message is dropped if the ring is full, a completed request waits for space until the event loop is closed
+ * @param loop Event loop
+ * @param amp AMP message, or reply of the request
+ * @param request Completed asynchronous request, NULL for a received message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_loop_push(cote_loop_t *loop, amp_msg_t *amp, cote_request_t *request);
+
+/**
+ * @brief Close event loop, the completed requests waiting for space in the ring are not pushed and are given back to the caller of cote_loop_push
+ * @param loop Event loop
+ */
+void cote_loop_close(cote_loop_t *loop);
+
+/**
+ * @brief Process the waiting events, this function must always be called by the same thread
+ * The event file descriptor remains readable if events are still waiting once the budget is reached
+ * @param loop Event loop
+ * @param cote Cote instance
+ * @param budget Maximum amount of events to be processed, 0 to process all the waiting events
+ * @return Amount of events processed
+ */
+int cote_loop_process(cote_loop_t *loop, cote_t *cote, int budget);
+
+/**
+ * @brief Release event loop, the waiting events are processed by the calling thread so that the callbacks of the completed requests are invoked
+ * @param loop Event loop
+ * @param cote Cote instance
+ */
+void cote_loop_release(cote_loop_t *loop, cote_t *cote);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_LOOP_H__ */
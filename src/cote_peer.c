@@ -0,0 +1,844 @@
+/**
+ * @file      cote_peer.c
+ * @brief     Cote library - Connections to discovered nodes
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <semaphore.h>
+#include <regex.h>
+
+#include "cote_peer.h"
+#include "cote_shm.h"
+#include "cote_queue.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Get the peer with the least pending requests, starting from the next peer in the round-robin order, the semaphore of the peers must be taken by the caller
+ * @param peers Peers
+ * @return Peer, NULL if there is no peer
+ */
+static cote_peer_t *cote_peers_least_outstanding(cote_peers_t *peers);
+
+/**
+ * @brief Get the best of two peers chosen randomly, the semaphore of the peers must be taken by the caller
+ * The cost of a peer is the moving average of its latency multiplied by its pending requests, peers without measured latency are preferred
+ * @param peers Peers
+ * @return Peer, NULL if there is no peer
+ */
+static cote_peer_t *cote_peers_power_of_two(cote_peers_t *peers);
+
+/**
+ * @brief Send a message to the peers matching a topic, the peers whose send queue has been closed are disconnected
+ * The matching peers are referenced under the semaphore of the peers, the message is sent once it is released so that a slow node
+ * or a blocking send queue does not stall the other publishers and the discovery of the nodes
+ * @param peers Peers
+ * @param iid Instance ID of the node, NULL to consider the peers of all the nodes
+ * @param topic Topic of the message, NULL to invoke the function for all the peers
+ * @param fct Function invoked to send the message to each peer
+ * @param user User data passed to the function
+ * @return 0 if the function succeeded, -1 if the message has not been sent to at least one peer
+ */
+static int cote_peers_send_each(cote_peers_t *peers, char *iid, char *topic, int (*fct)(cote_peer_t *, void *), void *user);
+
+/**
+ * @brief Compute a pseudo-random number (xorshift), the state is local to the calling thread
+ * @return Pseudo-random number
+ */
+static uint32_t cote_peer_random(void);
+
+/**
+ * @brief Create a topic filter
+ * @param topics Regular expressions of the topics sent to the node, NULL to send all the topics
+ * @return Filter if the function succeeded, NULL otherwise
+ */
+static cote_peer_filter_t *cote_peer_filter_create(cJSON *topics);
+
+/**
+ * @brief Release a topic filter and the filters it replaced
+ * @param filter Filter
+ */
+static void cote_peer_filter_release(cote_peer_filter_t *filter);
+
+/**
+ * @brief Release a peer and its axon instance
+ * @param peer Peer
+ */
+static void cote_peer_release(cote_peer_t *peer);
+
+/******************************************************************************/
+/* Variables                                                                  */
+/******************************************************************************/
+
+static __thread uint32_t cote_peer_seed = 0; /* State of the pseudo-random numbers of the calling thread */
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Initialize peers
+ * @param peers Peers
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_peers_init(cote_peers_t *peers) {
+
+    assert(NULL != peers);
+
+    /* Initialize peers */
+    memset(peers, 0, sizeof(cote_peers_t));
+
+    /* Initialize semaphore used to protect peers */
+    sem_init(&peers->sem, 0, 1);
+
+    return 0;
+}
+
+/**
+ * @brief Check if a peer is already connected to a node
+ * @param peers Peers
+ * @param address Address (or hostname) of the node
+ * @param port Port of the node
+ * @return true if a peer is connected to the node, false otherwise
+ */
+bool
+cote_peers_exists(cote_peers_t *peers, char *address, uint16_t port) {
+
+    assert(NULL != peers);
+    assert(NULL != address);
+
+    bool ret = false;
+
+    /* Search for the peer */
+    sem_wait(&peers->sem);
+    cote_peer_t *curr = peers->first;
+    while ((NULL != curr) && (false == ret)) {
+        if ((port == curr->port) && (!strcmp(address, curr->address))) {
+            ret = true;
+        }
+        curr = curr->next;
+    }
+    sem_post(&peers->sem);
+
+    return ret;
+}
+
+/**
+ * @brief Add a peer
+ * @param peers Peers
+ * @param axon Axon instance connected to the node, owned by the peer if the function succeeded, NULL if shm is used
+ * @param shm Shared memory of the node, owned by the peer if the function succeeded, NULL if axon is used
+ * @param queue Send queue of the axon instance, owned by the peer if the function succeeded, NULL to send the messages directly
+ * @param iid Instance ID of the node
+ * @param address Address (or hostname) of the node
+ * @param port Port of the node
+ * @param topics Regular expressions of the topics sent to the node with cote_peers_send, NULL to send all the topics
+ * @param caps Capabilities of the node (COTE_PEER_CAP_*)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_peers_add(cote_peers_t *peers, axon_t *axon, cote_shm_t *shm, cote_queue_t *queue, char *iid, char *address, uint16_t port, cJSON *topics, uint32_t caps) {
+
+    assert(NULL != peers);
+    assert((NULL != axon) || (NULL != shm));
+    assert(NULL != iid);
+    assert(NULL != address);
+
+    /* Create peer */
+    cote_peer_t *peer = (cote_peer_t *)malloc(sizeof(cote_peer_t));
+    if (NULL == peer) {
+        /* Unable to allocate memory */
+        return -1;
+    }
+    memset(peer, 0, sizeof(cote_peer_t));
+    if ((NULL == (peer->iid = strdup(iid))) || (NULL == (peer->address = strdup(address)))) {
+        /* Unable to allocate memory */
+        free(peer->iid);
+        free(peer);
+        return -1;
+    }
+    peer->port = port;
+    peer->refs = 1;
+    peer->caps = caps;
+    sem_init(&peer->sem, 0, 1);
+
+    /* Compile regular expressions of the topics sent to the node */
+    if (NULL == (peer->filter = cote_peer_filter_create(topics))) {
+        /* Unable to allocate memory, the axon instance, the shared memory and the send queue are not owned by the peer */
+        cote_peer_release(peer);
+        return -1;
+    }
+    peer->axon  = axon;
+    peer->shm   = shm;
+    peer->queue = queue;
+
+    /* Append the peer to the list */
+    sem_wait(&peers->sem);
+    cote_peer_t **curr = &peers->first;
+    while (NULL != *curr) {
+        curr = &(*curr)->next;
+    }
+    *curr = peer;
+    peers->count++;
+    sem_post(&peers->sem);
+
+    return 0;
+}
+
+/**
+ * @brief Remove the peer of a node, the axon instance is released immediately if the peer is not used, when the peer is left otherwise
+ * @param peers Peers
+ * @param iid Instance ID of the node
+ * @return 0 if the function succeeded, -1 if no peer is connected to the node
+ */
+int
+cote_peers_remove(cote_peers_t *peers, char *iid) {
+
+    assert(NULL != peers);
+    assert(NULL != iid);
+
+    cote_peer_t *peer = NULL;
+
+    /* Search for the peer and remove it from the list, new messages are not sent to it anymore */
+    sem_wait(&peers->sem);
+    cote_peer_t **curr = &peers->first;
+    while ((NULL != *curr) && (NULL == peer)) {
+        if (!strcmp(iid, (*curr)->iid)) {
+            peer  = *curr;
+            *curr = peer->next;
+            if (peers->next == peer) {
+                peers->next = peer->next;
+            }
+            peer->removed = true;
+            peer->refs--;
+            peers->count--;
+        } else {
+            curr = &(*curr)->next;
+        }
+    }
+    bool release = ((NULL != peer) && (0 == peer->refs));
+    sem_post(&peers->sem);
+
+    /* Release the peer if it is not used, the connection to the node is closed */
+    if (true == release) {
+        cote_peer_release(peer);
+    }
+
+    return (NULL != peer) ? 0 : -1;
+}
+
+/**
+ * @brief Set load balancing of the requests
+ * @param peers Peers
+ * @param balancing Load balancing as string ("round-robin", "least-outstanding" or "power-of-two-choices")
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_peers_set_balancing(cote_peers_t *peers, char *balancing) {
+
+    assert(NULL != peers);
+
+    int ret = 0;
+
+    /* Set load balancing */
+    sem_wait(&peers->sem);
+    if ((NULL == balancing) || (!strcmp("round-robin", balancing))) {
+        peers->balancing = COTE_BALANCING_ROUND_ROBIN;
+    } else if (!strcmp("least-outstanding", balancing)) {
+        peers->balancing = COTE_BALANCING_LEAST_OUTSTANDING;
+    } else if (!strcmp("power-of-two-choices", balancing)) {
+        peers->balancing = COTE_BALANCING_POWER_OF_TWO;
+    } else {
+        /* Invalid load balancing */
+        ret = -1;
+    }
+    sem_post(&peers->sem);
+
+    return ret;
+}
+
+/**
+ * @brief Set the topics sent to the peers of a node, the filter is replaced only if the topics advertised by the node have changed
+ * @param peers Peers
+ * @param iid Instance ID of the node
+ * @param topics Regular expressions of the topics sent to the node with cote_peers_send, NULL to send all the topics
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_peers_set_topics(cote_peers_t *peers, char *iid, cJSON *topics) {
+
+    assert(NULL != peers);
+    assert(NULL != iid);
+
+    int ret = 0;
+
+    /* Wait peers semaphore */
+    sem_wait(&peers->sem);
+
+    /* Replace the filter of the peers of the node, the messages being sent use the previous filter which is released with the peer */
+    cote_peer_t *curr = peers->first;
+    while (NULL != curr) {
+        cote_peer_filter_t *filter = curr->filter;
+        if ((!strcmp(iid, curr->iid))
+            && (((NULL == filter->topics) != (NULL == topics)) || ((NULL != topics) && (!cJSON_Compare(filter->topics, topics, true))))) {
+            cote_peer_filter_t *replace = cote_peer_filter_create(topics);
+            if (NULL != replace) {
+                replace->next = filter;
+                __atomic_store_n(&curr->filter, replace, __ATOMIC_RELEASE);
+            } else {
+                ret = -1;
+            }
+        }
+        curr = curr->next;
+    }
+
+    /* Release peers semaphore */
+    sem_post(&peers->sem);
+
+    return ret;
+}
+
+/**
+ * @brief Get the peer to be used to send a request depending of the load balancing, the peer remains valid until cote_peers_leave is called
+ * @param peers Peers
+ * @return Peer if the function succeeded, NULL if there is no peer
+ */
+cote_peer_t *
+cote_peers_enter(cote_peers_t *peers) {
+
+    assert(NULL != peers);
+
+    cote_peer_t *peer = NULL;
+
+    /* Get the peer depending of the load balancing */
+    sem_wait(&peers->sem);
+    if (COTE_BALANCING_LEAST_OUTSTANDING == peers->balancing) {
+        peer = cote_peers_least_outstanding(peers);
+    } else if (COTE_BALANCING_POWER_OF_TWO == peers->balancing) {
+        peer = cote_peers_power_of_two(peers);
+    } else {
+        peer = (NULL != peers->next) ? peers->next : peers->first;
+    }
+    if (NULL != peer) {
+        peer->refs++;
+        peer->pending++;
+        peers->next = peer->next;
+    }
+    sem_post(&peers->sem);
+
+    return peer;
+}
+
+/**
+ * @brief Get a peer other than the given one to send a duplicate of a request, the peer remains valid until cote_peers_leave is called
+ * @param peers Peers
+ * @param other Peer already used to send the request
+ * @return Peer if the function succeeded, NULL if there is no other peer
+ */
+cote_peer_t *
+cote_peers_enter_other(cote_peers_t *peers, cote_peer_t *other) {
+
+    assert(NULL != peers);
+
+    cote_peer_t *peer = NULL;
+
+    /* Get the peer depending of the load balancing, the next one is used if the load balancing chooses the same peer */
+    sem_wait(&peers->sem);
+    if (COTE_BALANCING_LEAST_OUTSTANDING == peers->balancing) {
+        peer = cote_peers_least_outstanding(peers);
+    } else if (COTE_BALANCING_POWER_OF_TWO == peers->balancing) {
+        peer = cote_peers_power_of_two(peers);
+    } else {
+        peer = (NULL != peers->next) ? peers->next : peers->first;
+    }
+    if ((NULL != peer) && (other == peer)) {
+        peer = (NULL != peer->next) ? peer->next : peers->first;
+    }
+    if ((NULL != peer) && (other != peer)) {
+        peer->refs++;
+        peer->pending++;
+        peers->next = peer->next;
+    } else {
+        peer = NULL;
+    }
+    sem_post(&peers->sem);
+
+    return peer;
+}
+
+/**
+ * @brief Get amount of peers
+ * @param peers Peers
+ * @return Amount of peers
+ */
+int
+cote_peers_count(cote_peers_t *peers) {
+
+    assert(NULL != peers);
+
+    /* Get amount of peers */
+    sem_wait(&peers->sem);
+    int count = peers->count;
+    sem_post(&peers->sem);
+
+    return count;
+}
+
+/**
+ * @brief Leave a peer returned by cote_peers_enter
+ * @param peers Peers
+ * @param peer Peer
+ * @param latency Response time of the request (nanoseconds), 0 if not measured
+ * @return true if the node has been removed while the peer was used, false otherwise
+ */
+bool
+cote_peers_leave(cote_peers_t *peers, cote_peer_t *peer, uint64_t latency) {
+
+    assert(NULL != peers);
+    assert(NULL != peer);
+
+    /* Update moving average of the latency */
+    sem_wait(&peers->sem);
+    peer->pending--;
+    if (0 != latency) {
+        peer->latency = (0 == peer->latency) ? latency : (peer->latency - (peer->latency >> COTE_PEER_LATENCY_SHIFT) + (latency >> COTE_PEER_LATENCY_SHIFT));
+    }
+
+    /* Release the reference, the last one releases the peer of a removed node */
+    bool removed = peer->removed;
+    bool release = (0 == --peer->refs);
+    sem_post(&peers->sem);
+    if (true == release) {
+        cote_peer_release(peer);
+    }
+
+    return removed;
+}
+
+/**
+ * @brief Send a message to the peers interested in a topic, the peers whose send queue has been closed are disconnected
+ * @param peers Peers
+ * @param topic Topic of the message, NULL to invoke the function for all the peers
+ * @param fct Function invoked to send the message to each peer
+ * @param user User data passed to the function
+ * @return 0 if the function succeeded, -1 if the message has not been sent to at least one peer
+ */
+int
+cote_peers_send(cote_peers_t *peers, char *topic, int (*fct)(cote_peer_t *, void *), void *user) {
+
+    assert(NULL != peers);
+    assert(NULL != fct);
+
+    /* Send the message to each peer matching the topic */
+    return cote_peers_send_each(peers, NULL, topic, fct, user);
+}
+
+/**
+ * @brief Check if a topic is sent to a peer
+ * @param peer Peer
+ * @param topic Topic
+ * @return true if the topic is matching the filter of the peer, false otherwise
+ */
+bool
+cote_peer_match(cote_peer_t *peer, char *topic) {
+
+    assert(NULL != peer);
+    assert(NULL != topic);
+
+    /* Check if all the topics are sent to the node, the filter may be replaced meanwhile but it is released with the peer */
+    cote_peer_filter_t *filter = __atomic_load_n(&peer->filter, __ATOMIC_ACQUIRE);
+    if (NULL == filter->topics) {
+        return true;
+    }
+
+    /* Match the topic with the regular expressions */
+    for (int index = 0; index < filter->count; index++) {
+        if (0 == regexec(&filter->regex[index], topic, 0, NULL, 0)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Send a message to the peers of a node interested in a topic, used to send messages to a node which has just been added
+ * @param peers Peers
+ * @param iid Instance ID of the node
+ * @param topic Topic of the message, NULL to invoke the function for all the peers of the node
+ * @param fct Function invoked to send the message to each peer
+ * @param user User data passed to the function
+ * @return 0 if the function succeeded, -1 if the message has not been sent to at least one peer
+ */
+int
+cote_peers_send_node(cote_peers_t *peers, char *iid, char *topic, int (*fct)(cote_peer_t *, void *), void *user) {
+
+    assert(NULL != peers);
+    assert(NULL != iid);
+    assert(NULL != fct);
+
+    /* Send the message to each peer of the node matching the topic */
+    return cote_peers_send_each(peers, iid, topic, fct, user);
+}
+
+/**
+ * @brief Retrieve statistics of the peers
+ * @param peers Peers
+ * @param stats Array of peer statistics
+ * @param max Size of the array
+ * @return Amount of peer statistics set
+ */
+int
+cote_peers_get_stats(cote_peers_t *peers, cote_peer_stats_t *stats, int max) {
+
+    assert(NULL != peers);
+    assert((NULL != stats) || (0 == max));
+
+    int count = 0;
+
+    /* Copy statistics of each peer */
+    sem_wait(&peers->sem);
+    cote_peer_t *curr = peers->first;
+    while ((NULL != curr) && (count < max)) {
+        memset(&stats[count], 0, sizeof(cote_peer_stats_t));
+        strncpy(stats[count].iid, curr->iid, sizeof(stats[count].iid) - 1);
+        strncpy(stats[count].address, curr->address, sizeof(stats[count].address) - 1);
+        stats[count].port = curr->port;
+        if (NULL != curr->queue) {
+            cote_queue_get_stats(curr->queue, &stats[count]);
+        }
+        count++;
+        curr = curr->next;
+    }
+    sem_post(&peers->sem);
+
+    return count;
+}
+
+/**
+ * @brief Release peers, the axon instances are released, no peer must remain used
+ * @param peers Peers
+ */
+void
+cote_peers_release(cote_peers_t *peers) {
+
+    assert(NULL != peers);
+
+    /* Release all the peers */
+    sem_wait(&peers->sem);
+    while (NULL != peers->first) {
+        cote_peer_t *tmp = peers->first;
+        peers->first     = peers->first->next;
+        cote_peer_release(tmp);
+    }
+    peers->next  = NULL;
+    peers->count = 0;
+    sem_post(&peers->sem);
+
+    /* Release semaphore */
+    sem_close(&peers->sem);
+}
+
+/**
+ * @brief Get the peer with the least pending requests, starting from the next peer in the round-robin order, the semaphore of the peers must be taken by the caller
+ * @param peers Peers
+ * @return Peer, NULL if there is no peer
+ */
+static cote_peer_t *
+cote_peers_least_outstanding(cote_peers_t *peers) {
+
+    assert(NULL != peers);
+
+    cote_peer_t *peer = NULL;
+
+    /* Parse all the peers once, the first peer found with the least pending requests is kept so that ties are balanced */
+    cote_peer_t *curr = (NULL != peers->next) ? peers->next : peers->first;
+    for (int index = 0; index < peers->count; index++) {
+        if ((NULL == peer) || (curr->pending < peer->pending)) {
+            peer = curr;
+        }
+        curr = (NULL != curr->next) ? curr->next : peers->first;
+    }
+
+    return peer;
+}
+
+/**
+ * @brief Get the best of two peers chosen randomly, the semaphore of the peers must be taken by the caller
+ * The cost of a peer is the moving average of its latency multiplied by its pending requests, peers without measured latency are preferred
+ * @param peers Peers
+ * @return Peer, NULL if there is no peer
+ */
+static cote_peer_t *
+cote_peers_power_of_two(cote_peers_t *peers) {
+
+    assert(NULL != peers);
+
+    /* Check amount of peers */
+    if (2 > peers->count) {
+        return peers->first;
+    }
+
+    /* Choose two different peers */
+    int first  = (int)(cote_peer_random() % (uint32_t)peers->count);
+    int second = (int)(cote_peer_random() % (uint32_t)(peers->count - 1));
+    if (second >= first) {
+        second++;
+    }
+    cote_peer_t *peer1 = NULL;
+    cote_peer_t *peer2 = NULL;
+    cote_peer_t *curr  = peers->first;
+    for (int index = 0; NULL != curr; index++) {
+        if (first == index) {
+            peer1 = curr;
+        } else if (second == index) {
+            peer2 = curr;
+        }
+        curr = curr->next;
+    }
+    assert((NULL != peer1) && (NULL != peer2));
+
+    /* Keep the peer with the lowest cost, the latency of the other one is decreased so that a slow peer is eventually tried again */
+    uint64_t     cost1 = peer1->latency * (uint64_t)(peer1->pending + 1);
+    uint64_t     cost2 = peer2->latency * (uint64_t)(peer2->pending + 1);
+    cote_peer_t *peer  = (cost1 <= cost2) ? peer1 : peer2;
+    cote_peer_t *other = (peer == peer1) ? peer2 : peer1;
+    other->latency -= other->latency >> COTE_PEER_LATENCY_DECAY_SHIFT;
+
+    return peer;
+}
+
+/**
+ * @brief Send a message to the peers matching a topic, the peers whose send queue has been closed are disconnected
+ * The matching peers are referenced under the semaphore of the peers, the message is sent once it is released so that a slow node
+ * or a blocking send queue does not stall the other publishers and the discovery of the nodes
+ * @param peers Peers
+ * @param iid Instance ID of the node, NULL to consider the peers of all the nodes
+ * @param topic Topic of the message, NULL to invoke the function for all the peers
+ * @param fct Function invoked to send the message to each peer
+ * @param user User data passed to the function
+ * @return 0 if the function succeeded, -1 if the message has not been sent to at least one peer
+ */
+static int
+cote_peers_send_each(cote_peers_t *peers, char *iid, char *topic, int (*fct)(cote_peer_t *, void *), void *user) {
+
+    assert(NULL != peers);
+    assert(NULL != fct);
+
+    int          ret      = 0;
+    int          count    = 0;
+    cote_peer_t *released = NULL;
+
+    /* The references to the peers are kept on the stack, unless there are too many peers */
+    cote_peer_t * stack[COTE_PEER_SNAPSHOT];
+    cote_peer_t **snapshot = stack;
+
+    /* Reference the peers matching the topic, they can not be released until the message is sent */
+    sem_wait(&peers->sem);
+    if ((COTE_PEER_SNAPSHOT < peers->count) && (NULL == (snapshot = (cote_peer_t **)malloc(peers->count * sizeof(cote_peer_t *))))) {
+        /* Unable to allocate memory */
+        sem_post(&peers->sem);
+        return -1;
+    }
+    for (cote_peer_t *peer = peers->first; NULL != peer; peer = peer->next) {
+        if (((NULL == iid) || (!strcmp(iid, peer->iid))) && ((NULL == topic) || (true == cote_peer_match(peer, topic)))) {
+            peer->refs++;
+            snapshot[count++] = peer;
+        }
+    }
+    sem_post(&peers->sem);
+
+    /* Send the message to each peer, the semaphore of the peers is not held */
+    for (int index = 0; index < count; index++) {
+        if (0 != fct(snapshot[index], user)) {
+            ret = -1;
+        }
+    }
+
+    /* Leave the peers, those whose send queue has been closed because the node is too slow to consume the messages are removed */
+    sem_wait(&peers->sem);
+    for (int index = 0; index < count; index++) {
+        cote_peer_t *peer = snapshot[index];
+        if ((false == peer->removed) && (NULL != peer->queue) && (true == cote_queue_is_closed(peer->queue))) {
+            cote_peer_t **curr = &peers->first;
+            while (peer != *curr) {
+                curr = &(*curr)->next;
+            }
+            *curr = peer->next;
+            if (peers->next == peer) {
+                peers->next = peer->next;
+            }
+            peer->removed = true;
+            peer->refs--;
+            peers->count--;
+        }
+        if (0 == --peer->refs) {
+            peer->next = released;
+            released   = peer;
+        }
+    }
+    sem_post(&peers->sem);
+
+    /* Release the peers not used anymore, the connections to the nodes are closed */
+    while (NULL != released) {
+        cote_peer_t *tmp = released;
+        released         = released->next;
+        cote_peer_release(tmp);
+    }
+    if (stack != snapshot) {
+        free(snapshot);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Compute a pseudo-random number (xorshift), the state is local to the calling thread
+ * @return Pseudo-random number
+ */
+static uint32_t
+cote_peer_random(void) {
+
+    /* Initialize the state of the thread, it must not be 0 */
+    if (0 == cote_peer_seed) {
+        cote_peer_seed = (uint32_t)(uintptr_t)&cote_peer_seed | 1;
+    }
+
+    /* Compute next pseudo-random number */
+    cote_peer_seed ^= cote_peer_seed << 13;
+    cote_peer_seed ^= cote_peer_seed >> 17;
+    cote_peer_seed ^= cote_peer_seed << 5;
+
+    return cote_peer_seed;
+}
+
+/**
+ * @brief Create a topic filter
+ * @param topics Regular expressions of the topics sent to the node, NULL to send all the topics
+ * @return Filter if the function succeeded, NULL otherwise
+ */
+static cote_peer_filter_t *
+cote_peer_filter_create(cJSON *topics) {
+
+    /* Create filter */
+    cote_peer_filter_t *filter = (cote_peer_filter_t *)calloc(1, sizeof(cote_peer_filter_t));
+    if (NULL == filter) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+
+    /* Check if all the topics are sent to the node */
+    if (NULL == topics) {
+        return filter;
+    }
+
+    /* Copy the topics, they are compared with the next advertisements of the node */
+    if (NULL == (filter->topics = cJSON_Duplicate(topics, 1))) {
+        /* Unable to allocate memory */
+        free(filter);
+        return NULL;
+    }
+
+    /* Compile regular expressions of the topics sent to the node */
+    if (0 < cJSON_GetArraySize(topics)) {
+        if (NULL == (filter->regex = (regex_t *)malloc(cJSON_GetArraySize(topics) * sizeof(regex_t)))) {
+            /* Unable to allocate memory */
+            cote_peer_filter_release(filter);
+            return NULL;
+        }
+        cJSON *tmp = NULL;
+        cJSON_ArrayForEach(tmp, topics) {
+            char *str = cJSON_GetStringValue(tmp);
+            if ((NULL != str) && (0 == regcomp(&filter->regex[filter->count], str, REG_NOSUB | REG_EXTENDED))) {
+                filter->count++;
+            }
+        }
+    }
+
+    return filter;
+}
+
+/**
+ * @brief Release a topic filter and the filters it replaced
+ * @param filter Filter
+ */
+static void
+cote_peer_filter_release(cote_peer_filter_t *filter) {
+
+    /* Release all the filters */
+    while (NULL != filter) {
+        cote_peer_filter_t *next = filter->next;
+        for (int index = 0; index < filter->count; index++) {
+            regfree(&filter->regex[index]);
+        }
+        free(filter->regex);
+        if (NULL != filter->topics) {
+            cJSON_Delete(filter->topics);
+        }
+        free(filter);
+        filter = next;
+    }
+}
+
+/**
+ * @brief Release a peer and its axon instance
+ * @param peer Peer
+ */
+static void
+cote_peer_release(cote_peer_t *peer) {
+
+    assert(NULL != peer);
+
+    /* Release send queue, it may be sending a message to the axon instance */
+    cote_queue_release(peer->queue);
+
+    /* Release axon instance or shared memory, the connection to the node is closed */
+    axon_release(peer->axon);
+    cote_shm_release(peer->shm);
+
+    /* Release current and replaced filters */
+    cote_peer_filter_release(peer->filter);
+
+    /* Release semaphore */
+    sem_close(&peer->sem);
+
+    /* Release memory */
+    free(peer->ids.defined);
+    free(peer->address);
+    free(peer->iid);
+    free(peer);
+}
@@ -0,0 +1,202 @@
+/**
+ * @file      cote_peer.h
+ * @brief     Cote library - Connections to discovered nodes
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_PEER_H__
+#define __COTE_PEER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+/* Weight of a new response time in the moving average of the latency of a peer (1 / 2^COTE_PEER_LATENCY_SHIFT) */
+#define COTE_PEER_LATENCY_SHIFT (3)
+
+/* Decrease of the latency of a peer each time it is not chosen (1 / 2^COTE_PEER_LATENCY_DECAY_SHIFT) */
+#define COTE_PEER_LATENCY_DECAY_SHIFT (6)
+
+/* Amount of peers a message is sent to without allocating memory, their references are kept on the stack while sending */
+#define COTE_PEER_SNAPSHOT (32)
+
+/* Capabilities of a node, announced in its advertisement, the compression bits are (1 << cote_compression_e) */
+#define COTE_PEER_CAP_IDS      (1 << 0) /* The node decodes topic IDs */
+#define COTE_PEER_CAP_LZ4      (1 << 1) /* The node decodes LZ4 compressed messages */
+#define COTE_PEER_CAP_ZSTD     (1 << 2) /* The node decodes zstd compressed messages */
+#define COTE_PEER_CAP_DEADLINE (1 << 3) /* The node enforces the deadline of the requests */
+#define COTE_PEER_CAP_BATCH    (1 << 4) /* The node decodes batches of messages */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Initialize peers
+ * @param peers Peers
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_peers_init(cote_peers_t *peers);
+
+/**
+ * @brief Check if a peer is already connected to a node
+ * @param peers Peers
+ * @param address Address (or hostname) of the node
+ * @param port Port of the node
+ * @return true if a peer is connected to the node, false otherwise
+ */
+bool cote_peers_exists(cote_peers_t *peers, char *address, uint16_t port);
+
+/**
+ * @brief Add a peer
+ * @param peers Peers
+ * @param axon Axon instance connected to the node, owned by the peer if the function succeeded, NULL if shm is used
+ * @param shm Shared memory of the node, owned by the peer if the function succeeded, NULL if axon is used
+ * @param queue Send queue of the axon instance, owned by the peer if the function succeeded, NULL to send the messages directly
+ * @param iid Instance ID of the node
+ * @param address Address (or hostname) of the node
+ * @param port Port of the node
+ * @param topics Regular expressions of the topics sent to the node with cote_peers_send, NULL to send all the topics
+ * @param caps Capabilities of the node (COTE_PEER_CAP_*)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_peers_add(cote_peers_t *peers, axon_t *axon, cote_shm_t *shm, cote_queue_t *queue, char *iid, char *address, uint16_t port, cJSON *topics, uint32_t caps);
+
+/**
+ * @brief Remove the peer of a node, the axon instance is released immediately if the peer is not used, when the peer is left otherwise
+ * @param peers Peers
+ * @param iid Instance ID of the node
+ * @return 0 if the function succeeded, -1 if no peer is connected to the node
+ */
+int cote_peers_remove(cote_peers_t *peers, char *iid);
+
+/**
+ * @brief Set load balancing of the requests
+ * @param peers Peers
+ * @param balancing Load balancing as string ("round-robin", "least-outstanding" or "power-of-two-choices")
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_peers_set_balancing(cote_peers_t *peers, char *balancing);
+
+/**
+ * @brief Set the topics sent to the peers of a node, the filter is replaced only if the topics advertised by the node have changed
+ * @param peers Peers
+ * @param iid Instance ID of the node
+ * @param topics Regular expressions of the topics sent to the node with cote_peers_send, NULL to send all the topics
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_peers_set_topics(cote_peers_t *peers, char *iid, cJSON *topics);
+
+/**
+ * @brief Get the peer to be used to send a request depending of the load balancing, the peer remains valid until cote_peers_leave is called
+ * @param peers Peers
+ * @return Peer if the function succeeded, NULL if there is no peer
+ */
+cote_peer_t *cote_peers_enter(cote_peers_t *peers);
+
+/**
+ * @brief Get a peer other than the given one to send a duplicate of a request, the peer remains valid until cote_peers_leave is called
+ * @param peers Peers
+ * @param other Peer already used to send the request
+ * @return Peer if the function succeeded, NULL if there is no other peer
+ */
+cote_peer_t *cote_peers_enter_other(cote_peers_t *peers, cote_peer_t *other);
+
+/**
+ * @brief Get amount of peers
+ * @param peers Peers
+ * @return Amount of peers
+ */
+int cote_peers_count(cote_peers_t *peers);
+
+/**
+ * @brief Leave a peer returned by cote_peers_enter
+ * @param peers Peers
+ * @param peer Peer
+ * @param latency Response time of the request (nanoseconds), 0 if not measured
+ * @return true if the node has been removed while the peer was used, false otherwise
+ */
+bool cote_peers_leave(cote_peers_t *peers, cote_peer_t *peer, uint64_t latency);
+
+/**
+ * @brief Send a message to the peers interested in a topic, the peers whose send queue has been closed are disconnected
+ * @param peers Peers
+ * @param topic Topic of the message, NULL to invoke the function for all the peers
+ * @param fct Function invoked to send the message to each peer
+ * @param user User data passed to the function
+ * @return 0 if the function succeeded, -1 if the message has not been sent to at least one peer
+ */
+int cote_peers_send(cote_peers_t *peers, char *topic, int (*fct)(cote_peer_t *, void *), void *user);
+
+/**
+ * @brief Check if a topic is sent to a peer
+ * @param peer Peer
+ * @param topic Topic
+ * @return true if the topic is matching the filter of the peer, false otherwise
+ */
+bool cote_peer_match(cote_peer_t *peer, char *topic);
+
+/**
+ * @brief Send a message to the peers of a node interested in a topic, used to send messages to a node which has just been added
+ * @param peers Peers
+ * @param iid Instance ID of the node
+ * @param topic Topic of the message, NULL to invoke the function for all the peers of the node
+ * @param fct Function invoked to send the message to each peer
+ * @param user User data passed to the function
+ * @return 0 if the function succeeded, -1 if the message has not been sent to at least one peer
+ */
+int cote_peers_send_node(cote_peers_t *peers, char *iid, char *topic, int (*fct)(cote_peer_t *, void *), void *user);
+
+/**
+ * @brief Retrieve statistics of the peers
+ * @param peers Peers
+ * @param stats Array of peer statistics
+ * @param max Size of the array
+ * @return Amount of peer statistics set
+ */
+int cote_peers_get_stats(cote_peers_t *peers, cote_peer_stats_t *stats, int max);
+
+/**
+ * @brief Release peers, the axon instances are released, no peer must remain used
+ * @param peers Peers
+ */
+void cote_peers_release(cote_peers_t *peers);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_PEER_H__ */
@@ -0,0 +1,335 @@
+/**
+ * @file      cote_pool.c
+ * @brief     Cote library - Dispatch threads
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "cote_pool.h"
+#include "cote_hash.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Queue the fields of a message to a worker
+ * @param worker Worker
+ * @param amp AMP message, its fields are moved to the job if the function succeeded
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_pool_queue(cote_worker_t *worker, amp_msg_t *amp);
+
+/**
+ * @brief Release the fields of a job
+ * @param job Job
+ */
+static void cote_pool_release_fields(cote_job_t *job);
+
+/**
+ * @brief Thread of a dispatch worker
+ * @param arg Worker
+ * @return Always returns NULL
+ */
+static void *cote_pool_thread(void *arg);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Start dispatch threads
+ * @param cote Cote instance
+ * @param pool Dispatch pool
+ * @param nb_workers Amount of threads
+ * @param fct Function invoked by the threads to dispatch a message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_pool_start(cote_t *cote, cote_pool_t *pool, int nb_workers, void (*fct)(cote_t *, amp_msg_t *)) {
+
+    assert(NULL != cote);
+    assert(NULL != pool);
+    assert(0 < nb_workers);
+    assert(NULL != fct);
+
+    /* Check if the threads are already started */
+    if (NULL != pool->workers) {
+        return 0;
+    }
+
+    /* Create workers */
+    memset(pool, 0, sizeof(cote_pool_t));
+    pool->cote = cote;
+    pool->fct  = fct;
+    if (NULL == (pool->workers = (cote_worker_t *)malloc(nb_workers * sizeof(cote_worker_t)))) {
+        /* Unable to allocate memory */
+        return -1;
+    }
+    memset(pool->workers, 0, nb_workers * sizeof(cote_worker_t));
+
+    /* Start threads */
+    while (pool->nb_workers < nb_workers) {
+        cote_worker_t *worker = &pool->workers[pool->nb_workers];
+        worker->pool          = pool;
+        sem_init(&worker->pending, 0, 0);
+        sem_init(&worker->sem, 0, 1);
+        if (0 != pthread_create(&worker->thread, NULL, cote_pool_thread, worker)) {
+            /* Unable to create thread */
+            sem_close(&worker->pending);
+            sem_close(&worker->sem);
+            cote_pool_release(pool);
+            return -1;
+        }
+        pool->nb_workers++;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Queue a message to be dispatched, messages with the same key are dispatched in order by the same thread
+ * @param pool Dispatch pool
+ * @param amp AMP message, its fields are moved to the queue and released once dispatched if the function succeeded
+ * @param key Key of the message (topic), NULL to use the first thread
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_pool_push(cote_pool_t *pool, amp_msg_t *amp, char *key) {
+
+    assert(NULL != pool);
+    assert(NULL != amp);
+
+    /* Check if the threads are started */
+    if (0 == pool->nb_workers) {
+        return -1;
+    }
+
+    /* Queue the message to the worker of the key */
+    return cote_pool_queue(&pool->workers[(NULL != key) ? (cote_hash(key) % pool->nb_workers) : 0], amp);
+}
+
+/**
+ * @brief Stop dispatch threads, the messages remaining in the queues are released without being dispatched
+ * @param pool Dispatch pool
+ */
+void
+cote_pool_release(cote_pool_t *pool) {
+
+    assert(NULL != pool);
+
+    /* Stop threads */
+    __atomic_store_n(&pool->terminate, true, __ATOMIC_SEQ_CST);
+    for (int index = 0; index < pool->nb_workers; index++) {
+        sem_post(&pool->workers[index].pending);
+    }
+    for (int index = 0; index < pool->nb_workers; index++) {
+        pthread_join(pool->workers[index].thread, NULL);
+    }
+
+    /* Release remaining jobs */
+    for (int index = 0; index < pool->nb_workers; index++) {
+        cote_worker_t *worker = &pool->workers[index];
+        while (NULL != worker->first) {
+            cote_job_t *tmp = worker->first;
+            worker->first   = worker->first->next;
+            cote_pool_release_fields(tmp);
+            free(tmp);
+        }
+        while (NULL != worker->cache) {
+            cote_job_t *tmp = worker->cache;
+            worker->cache   = worker->cache->next;
+            free(tmp);
+        }
+        worker->cached = 0;
+        sem_close(&worker->pending);
+        sem_close(&worker->sem);
+    }
+
+    /* Release workers */
+    if (NULL != pool->workers) {
+        free(pool->workers);
+    }
+    pool->workers    = NULL;
+    pool->nb_workers = 0;
+}
+
+/**
+ * @brief Queue the fields of a message to a worker
+ * @param worker Worker
+ * @param amp AMP message, its fields are moved to the job if the function succeeded
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_pool_queue(cote_worker_t *worker, amp_msg_t *amp) {
+
+    assert(NULL != worker);
+    assert(NULL != amp);
+
+    /* Take a job from the cache of the worker, a new job is allocated if the cache is empty */
+    sem_wait(&worker->sem);
+    cote_job_t *job = worker->cache;
+    if (NULL != job) {
+        worker->cache = job->next;
+        worker->cached--;
+    } else {
+        sem_post(&worker->sem);
+        if (NULL == (job = (cote_job_t *)malloc(sizeof(cote_job_t)))) {
+            /* Unable to allocate memory */
+            return -1;
+        }
+        sem_wait(&worker->sem);
+    }
+
+    /* Move the fields of the message to the job, the message is released by its owner without the fields */
+    job->next    = NULL;
+    job->first   = amp->first;
+    job->last    = amp->last;
+    job->count   = amp->count;
+    amp->first   = NULL;
+    amp->last    = NULL;
+    amp->current = NULL;
+    amp->count   = 0;
+
+    /* Append job to the queue of the worker */
+    if (NULL != worker->last) {
+        worker->last->next = job;
+    } else {
+        worker->first = job;
+    }
+    worker->last = job;
+    sem_post(&worker->sem);
+
+    /* Wake up the worker */
+    sem_post(&worker->pending);
+
+    return 0;
+}
+
+/**
+ * @brief Release the fields of a job
+ * @param job Job
+ */
+static void
+cote_pool_release_fields(cote_job_t *job) {
+
+    assert(NULL != job);
+
+    /* Release the fields */
+    while (NULL != job->first) {
+        amp_field_t *tmp = job->first;
+        job->first       = job->first->next;
+        if (AMP_TYPE_JSON == tmp->type) {
+            cJSON_Delete((cJSON *)tmp->data);
+        } else if (NULL != tmp->data) {
+            free(tmp->data);
+        }
+        free(tmp);
+    }
+    job->last  = NULL;
+    job->count = 0;
+}
+
+/**
+ * @brief Thread of a dispatch worker
+ * @param arg Worker
+ * @return Always returns NULL
+ */
+static void *
+cote_pool_thread(void *arg) {
+
+    assert(NULL != arg);
+
+    /* Retrieve worker */
+    cote_worker_t *worker = (cote_worker_t *)arg;
+    cote_pool_t *  pool   = worker->pool;
+    cote_job_t *   done   = NULL;
+
+    /* Dispatch the messages until termination */
+    while (1) {
+
+        /* Wait for a job */
+        sem_wait(&worker->pending);
+        if (true == __atomic_load_n(&pool->terminate, __ATOMIC_SEQ_CST)) {
+            break;
+        }
+
+        /* Put the job previously dispatched in the cache, and take the first job of the queue */
+        sem_wait(&worker->sem);
+        if ((NULL != done) && (COTE_POOL_CACHE > worker->cached)) {
+            done->next    = worker->cache;
+            worker->cache = done;
+            worker->cached++;
+            done = NULL;
+        }
+        cote_job_t *job = worker->first;
+        if (NULL != job) {
+            worker->first = job->next;
+            if (NULL == worker->first) {
+                worker->last = NULL;
+            }
+        }
+        sem_post(&worker->sem);
+
+        /* Release the job previously dispatched if the cache is full */
+        if (NULL != done) {
+            free(done);
+            done = NULL;
+        }
+
+        /* Dispatch the message, the job is put in the cache next time the queue is accessed */
+        if (NULL != job) {
+            amp_msg_t amp;
+            memset(&amp, 0, sizeof(amp_msg_t));
+            amp.first      = job->first;
+            amp.last       = job->last;
+            amp.count = job->count;
+            pool->fct(pool->cote, &amp);
+
+            /* Release the fields remaining in the message, they may have been modified by the dispatch function */
+            job->first = amp.first;
+            cote_pool_release_fields(job);
+            done = job;
+        }
+    }
+
+    /* Release the job previously dispatched */
+    if (NULL != done) {
+        free(done);
+    }
+
+    return NULL;
+}
+
@@ -0,0 +1,83 @@
+/**
+ * @file      cote_pool.h
+ * @brief     Cote library - Dispatch threads
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_POOL_H__
+#define __COTE_POOL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+/* Maximum amount of jobs kept in the cache of each worker, only the jobs are recycled, the fields are allocated and released as decoded by amp */
+#define COTE_POOL_CACHE (256)
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Start dispatch threads
+ * @param cote Cote instance
+ * @param pool Dispatch pool
+ * @param nb_workers Amount of threads
+ * @param fct Function invoked by the threads to dispatch a message
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_pool_start(cote_t *cote, cote_pool_t *pool, int nb_workers, void (*fct)(cote_t *, amp_msg_t *));
+
+/**
+ * @brief Queue a message to be dispatched, messages with the same key are dispatched in order by the same thread
+ * @param pool Dispatch pool
+ * @param amp AMP message, its fields are moved to the queue and released once dispatched if the function succeeded
+ * @param key Key of the message (topic), NULL to use the first thread
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_pool_push(cote_pool_t *pool, amp_msg_t *amp, char *key);
+
+/**
+ * @brief Stop dispatch threads, the messages remaining in the queues are released without being dispatched
+ * @param pool Dispatch pool
+ */
+void cote_pool_release(cote_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_POOL_H__ */
@@ -0,0 +1,226 @@
+/**
+ * @file      cote_probe.c
+ * @brief     Cote library - Startup probing of the discovery
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <assert.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "cote_probe.h"
+#include "cote_stats.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Schedule fast hellos, the thread increasing the hello interval is started if required, the options semaphore must be taken by the caller
+ * @param cote Cote instance
+ * @param answer true to send a single fast hello answering a probing node, false to start the exponential schedule
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_probe_schedule(cote_t *cote, bool answer);
+
+/**
+ * @brief Thread increasing the hello interval
+ * @param arg Cote instance
+ * @return Always returns NULL
+ */
+static void *cote_probe_thread(void *arg);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Start probing, the hello interval is set to COTE_PROBE_START_INTERVAL and doubled after each hello until it reaches the hello interval option
+ * @param cote Cote instance
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_probe_start(cote_t *cote) {
+
+    assert(NULL != cote);
+
+    /* Start the exponential schedule, it is applied before the discover instance is started */
+    cote_stats_sem_wait(cote, &cote->options.sem);
+    int ret = cote_probe_schedule(cote, false);
+    sem_post(&cote->options.sem);
+
+    return ret;
+}
+
+/**
+ * @brief Answer a probing node, a single hello is sent after COTE_PROBE_START_INTERVAL and the hello interval option is then restored
+ * Nothing is done if the hellos are already sent every COTE_PROBE_START_INTERVAL, a startup schedule in progress is restarted
+ * @param cote Cote instance
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_probe_answer(cote_t *cote) {
+
+    assert(NULL != cote);
+
+    /* Send a single fast hello so that the probing node discovers the instance at once */
+    cote_stats_sem_wait(cote, &cote->options.sem);
+    int ret = cote_probe_schedule(cote, true);
+    sem_post(&cote->options.sem);
+
+    return ret;
+}
+
+/**
+ * @brief Stop probing, the hello interval is left to its current value
+ * @param cote Cote instance
+ */
+void
+cote_probe_release(cote_t *cote) {
+
+    assert(NULL != cote);
+
+    cote_probe_t *probe = &cote->probe;
+
+    /* Stop the thread */
+    if (true == probe->started) {
+        cote_stats_sem_wait(cote, &cote->options.sem);
+        probe->terminate = true;
+        sem_post(&cote->options.sem);
+        sem_post(&probe->wakeup);
+        pthread_join(probe->thread, NULL);
+        sem_close(&probe->wakeup);
+        probe->started  = false;
+        probe->interval = 0;
+    }
+}
+
+/**
+ * @brief Schedule fast hellos, the thread increasing the hello interval is started if required, the options semaphore must be taken by the caller
+ * @param cote Cote instance
+ * @param answer true to send a single fast hello answering a probing node, false to start the exponential schedule
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_probe_schedule(cote_t *cote, bool answer) {
+
+    assert(NULL != cote);
+
+    cote_probe_t *probe    = &cote->probe;
+    int           interval = COTE_PROBE_START_INTERVAL;
+
+    /* Check if fast hellos are not required, or if they are already sent fast enough to answer a probing node */
+    if ((COTE_PROBE_START_INTERVAL >= cote->options.discovery.helloInterval)
+        || ((true == answer) && (0 != probe->interval) && (COTE_PROBE_START_INTERVAL >= probe->interval))) {
+        return 0;
+    }
+
+    /* Start the thread increasing the interval, it waits for the options semaphore */
+    if (false == probe->started) {
+        sem_init(&probe->wakeup, 0, 0);
+        probe->terminate = false;
+        probe->interval  = 0;
+        if (0 != pthread_create(&probe->thread, NULL, cote_probe_thread, cote)) {
+            /* Unable to create thread */
+            sem_close(&probe->wakeup);
+            return -1;
+        }
+        probe->started = true;
+    }
+
+    /* Set the interval of the next hellos */
+    if (0 != discover_set_option(cote->discover, "helloInterval", &interval)) {
+        /* Unable to set hello interval */
+        return -1;
+    }
+    probe->answer   = ((true == answer) && (0 == probe->interval)) ? true : false;
+    probe->interval = interval;
+
+    /* Wake up the thread, the schedule has changed */
+    sem_post(&probe->wakeup);
+
+    return 0;
+}
+
+/**
+ * @brief Thread increasing the hello interval
+ * @param arg Cote instance
+ * @return Always returns NULL
+ */
+static void *
+cote_probe_thread(void *arg) {
+
+    assert(NULL != arg);
+
+    /* Retrieve cote instance */
+    cote_t *      cote  = (cote_t *)arg;
+    cote_probe_t *probe = &cote->probe;
+
+    /* Follow the schedule until termination, the hello interval option may be changed meanwhile */
+    cote_stats_sem_wait(cote, &cote->options.sem);
+    while (false == probe->terminate) {
+        int interval = probe->interval;
+        sem_post(&cote->options.sem);
+
+        /* Wait for the next hello, for a change of the schedule or for termination */
+        int ret;
+        if (0 == interval) {
+            while ((0 != (ret = sem_wait(&probe->wakeup))) && (EINTR == errno))
+                ;
+        } else {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += interval / 1000;
+            ts.tv_nsec += (interval % 1000) * 1000000L;
+            if (1000000000L <= ts.tv_nsec) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            while ((0 != (ret = sem_timedwait(&probe->wakeup, &ts))) && (EINTR == errno))
+                ;
+        }
+
+        /* Double the interval after each hello until it reaches the hello interval option, it is restored after the hello answering a probing node */
+        cote_stats_sem_wait(cote, &cote->options.sem);
+        if ((0 != ret) && (false == probe->terminate) && (interval == probe->interval)) {
+            int steady      = cote->options.discovery.helloInterval;
+            probe->interval = ((false == probe->answer) && (steady > 2 * interval)) ? 2 * interval : 0;
+            probe->answer   = false;
+            int value       = (0 != probe->interval) ? probe->interval : steady;
+            discover_set_option(cote->discover, "helloInterval", &value);
+        }
+    }
+    sem_post(&cote->options.sem);
+
+    return NULL;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file      cote_probe.h
+ * @brief     Cote library - Startup probing of the discovery
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_PROBE_H__
+#define __COTE_PROBE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define COTE_PROBE_HELLO_INTERVAL (2000) /* Default interval between the hellos once started (milliseconds) */
+#define COTE_PROBE_START_INTERVAL (100)  /* Interval between the first hellos in fast discovery mode (milliseconds) */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Start probing, the hello interval is set to COTE_PROBE_START_INTERVAL and doubled after each hello until it reaches the hello interval option
+ * @param cote Cote instance
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_probe_start(cote_t *cote);
+
+/**
+ * @brief Answer a probing node, a single hello is sent after COTE_PROBE_START_INTERVAL and the hello interval option is then restored
+ * Nothing is done if the hellos are already sent every COTE_PROBE_START_INTERVAL, a startup schedule in progress is restarted
+ * @param cote Cote instance
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_probe_answer(cote_t *cote);
+
+/**
+ * @brief Stop probing, the hello interval is left to its current value
+ * @param cote Cote instance
+ */
+void cote_probe_release(cote_t *cote);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_PROBE_H__ */
@@ -0,0 +1,401 @@
+/**
+ * @file      cote_queue.c
+ * @brief     Cote library - Send queues of the peers
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "cote_queue.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Thread sending the queued messages
+ * @param arg Send queue
+ * @return Always returns NULL
+ */
+static void *cote_queue_thread(void *arg);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Create a send queue and start the thread sending the messages
+ * @param size Maximum amount of queued messages (high water mark)
+ * @param policy Policy when the high water mark is reached
+ * @param fct Function invoked to send a message
+ * @param axon Axon instance the messages are sent to, it is not owned by the queue
+ * @return Send queue if the function succeeded, NULL otherwise
+ */
+cote_queue_t *
+cote_queue_create(int size, cote_drop_e policy, int (*fct)(axon_t *, char *, cote_field_t *, int), axon_t *axon) {
+
+    assert(0 < size);
+    assert(NULL != fct);
+    assert(NULL != axon);
+
+    /* Create send queue */
+    cote_queue_t *queue = (cote_queue_t *)malloc(sizeof(cote_queue_t));
+    if (NULL == queue) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+    memset(queue, 0, sizeof(cote_queue_t));
+    if (NULL == (queue->msgs = (cote_queue_msg_t **)malloc(size * sizeof(cote_queue_msg_t *)))) {
+        /* Unable to allocate memory */
+        free(queue);
+        return NULL;
+    }
+    queue->size   = size;
+    queue->policy = policy;
+    queue->fct    = fct;
+    queue->axon   = axon;
+    sem_init(&queue->sem, 0, 1);
+    sem_init(&queue->items, 0, 0);
+    sem_init(&queue->space, 0, (unsigned int)size);
+
+    /* Start thread sending the messages */
+    if (0 != pthread_create(&queue->thread, NULL, cote_queue_thread, queue)) {
+        /* Unable to create thread */
+        sem_close(&queue->sem);
+        sem_close(&queue->items);
+        sem_close(&queue->space);
+        free(queue->msgs);
+        free(queue);
+        return NULL;
+    }
+
+    return queue;
+}
+
+/**
+ * @brief Create a queued message, the topic and the data of the fields are copied once and the copy is shared by the send queues
+ * @param fulltopic Full topic of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_FIELDS_MAX)
+ * @return Queued message with one reference if the function succeeded, NULL otherwise
+ */
+cote_queue_msg_t *
+cote_queue_msg_create(char *fulltopic, cote_field_t *fields, int count) {
+
+    assert(NULL != fulltopic);
+    assert((NULL != fields) || (0 == count));
+
+    /* Check amount of fields */
+    if ((0 > count) || (COTE_FIELDS_MAX < count)) {
+        /* Too many fields */
+        return NULL;
+    }
+
+    /* The topic, the strings and the blobs are stored after the message, in the same allocation */
+    size_t sizes[COTE_FIELDS_MAX];
+    size_t len  = strlen(fulltopic) + 1;
+    size_t size = sizeof(cote_queue_msg_t) + len;
+    for (int index = 0; index < count; index++) {
+        sizes[index] = 0;
+        if (AMP_TYPE_BLOB == fields[index].type) {
+            sizes[index] = (0 < fields[index].size) ? (size_t)fields[index].size : 0;
+        } else if ((AMP_TYPE_STRING == fields[index].type) && (NULL != fields[index].data)) {
+            sizes[index] = strlen((char *)fields[index].data) + 1;
+        }
+        size += sizes[index];
+    }
+
+    /* Create message */
+    cote_queue_msg_t *msg = (cote_queue_msg_t *)malloc(size);
+    if (NULL == msg) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+    memset(msg, 0, sizeof(cote_queue_msg_t));
+    msg->refs      = 1;
+    msg->fulltopic = (char *)&msg[1];
+    char *data     = (char *)memcpy(msg->fulltopic, fulltopic, len) + len;
+
+    /* Copy the fields, only the JSON objects are duplicated separately */
+    for (int index = 0; index < count; index++) {
+        msg->fields[index].type = fields[index].type;
+        msg->fields[index].size = fields[index].size;
+        switch (fields[index].type) {
+            case AMP_TYPE_BLOB:
+            case AMP_TYPE_STRING:
+                if ((NULL != fields[index].data) || (AMP_TYPE_BLOB == fields[index].type)) {
+                    msg->fields[index].data = (0 < sizes[index]) ? memcpy(data, fields[index].data, sizes[index]) : data;
+                    data += sizes[index];
+                }
+                break;
+            case AMP_TYPE_BIGINT:
+                msg->bigints[index]     = *((int64_t *)fields[index].data);
+                msg->fields[index].data = &msg->bigints[index];
+                break;
+            case AMP_TYPE_JSON:
+                msg->fields[index].data = cJSON_Duplicate((cJSON *)fields[index].data, 1);
+                break;
+            default:
+                break;
+        }
+        if (NULL == msg->fields[index].data) {
+            /* Invalid field or unable to allocate memory */
+            msg->count = index;
+            cote_queue_msg_put(msg);
+            return NULL;
+        }
+    }
+    msg->count = count;
+
+    return msg;
+}
+
+/**
+ * @brief Queue a message, a reference to the message is taken by the queue
+ * @param queue Send queue
+ * @param msg Queued message, NULL if the message could not be created (it is counted as dropped)
+ * @return 0 if the function succeeded (the message is queued), -1 if the message has been dropped
+ */
+int
+cote_queue_push(cote_queue_t *queue, cote_queue_msg_t *msg) {
+
+    assert(NULL != queue);
+
+    /* The message could not be copied */
+    if (NULL == msg) {
+        /* Unable to allocate memory or too many fields */
+        __atomic_add_fetch(&queue->dropped, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+
+    /* Wait for a free place of the queue if the publisher must be blocked, the peers are not locked while sending */
+    if (COTE_DROP_BLOCK == queue->policy) {
+        sem_wait(&queue->space);
+    }
+
+    /* Append the message, or apply the policy if the high water mark is reached */
+    cote_queue_msg_t *dropped = NULL;
+    int               ret     = 0;
+    sem_wait(&queue->sem);
+    if ((true == queue->closed) || (true == queue->terminate)) {
+        /* Queue closed, the message is dropped */
+        ret = -1;
+    } else if ((COTE_DROP_BLOCK != queue->policy) && (queue->count >= queue->size)) {
+        if (COTE_DROP_OLDEST == queue->policy) {
+            /* Replace the oldest message, the amount of queued messages is unchanged */
+            dropped                   = queue->msgs[queue->first];
+            queue->msgs[queue->first] = msg;
+            queue->first              = (queue->first + 1) % queue->size;
+            __atomic_add_fetch(&msg->refs, 1, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&queue->dropped, 1, __ATOMIC_RELAXED);
+        } else if (COTE_DROP_DISCONNECT == queue->policy) {
+            /* Close the queue, all the queued messages are dropped with the new one, releasing them only frees the last references */
+            queue->closed = true;
+            while (0 < queue->count) {
+                cote_queue_msg_put(queue->msgs[queue->first]);
+                queue->first = (queue->first + 1) % queue->size;
+                queue->count--;
+                __atomic_add_fetch(&queue->dropped, 1, __ATOMIC_RELAXED);
+            }
+            ret = -1;
+        } else {
+            /* Drop the new message */
+            ret = -1;
+        }
+    } else {
+        /* Append the message */
+        queue->msgs[(queue->first + queue->count) % queue->size] = msg;
+        queue->count++;
+        __atomic_add_fetch(&msg->refs, 1, __ATOMIC_RELAXED);
+    }
+    sem_post(&queue->sem);
+
+    /* Wake up the thread sending the messages if a message has been appended */
+    if ((0 == ret) && (NULL == dropped)) {
+        sem_post(&queue->items);
+    }
+
+    /* Release the oldest message replaced by the new one, this is not an error of the caller */
+    cote_queue_msg_put(dropped);
+    if (0 != ret) {
+        __atomic_add_fetch(&queue->dropped, 1, __ATOMIC_RELAXED);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Release a reference to a queued message, the message is released with the last reference
+ * @param msg Queued message, nothing is done if NULL
+ */
+void
+cote_queue_msg_put(cote_queue_msg_t *msg) {
+
+    /* Release the message with the last reference */
+    if ((NULL != msg) && (0 == __atomic_sub_fetch(&msg->refs, 1, __ATOMIC_ACQ_REL))) {
+
+        /* Release the JSON objects, the other data are stored with the message */
+        for (int index = 0; index < msg->count; index++) {
+            if (AMP_TYPE_JSON == msg->fields[index].type) {
+                cJSON_Delete((cJSON *)msg->fields[index].data);
+            }
+        }
+
+        /* Release memory */
+        free(msg);
+    }
+}
+
+/**
+ * @brief Check if a send queue has been closed because the high water mark has been reached (COTE_DROP_DISCONNECT)
+ * @param queue Send queue
+ * @return true if the queue is closed, false otherwise
+ */
+bool
+cote_queue_is_closed(cote_queue_t *queue) {
+
+    assert(NULL != queue);
+
+    sem_wait(&queue->sem);
+    bool closed = queue->closed;
+    sem_post(&queue->sem);
+
+    return closed;
+}
+
+/**
+ * @brief Retrieve statistics of a send queue
+ * @param queue Send queue
+ * @param stats Peer statistics, the queued, sent and dropped counters are set
+ */
+void
+cote_queue_get_stats(cote_queue_t *queue, cote_peer_stats_t *stats) {
+
+    assert(NULL != queue);
+    assert(NULL != stats);
+
+    sem_wait(&queue->sem);
+    stats->queued = queue->count;
+    sem_post(&queue->sem);
+    stats->sent    = __atomic_load_n(&queue->sent, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&queue->dropped, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Release send queue, the thread is stopped and the messages remaining in the queue are dropped
+ * @param queue Send queue
+ */
+void
+cote_queue_release(cote_queue_t *queue) {
+
+    /* Release send queue */
+    if (NULL != queue) {
+
+        /* Stop thread sending the messages, it terminates once the message being sent is done */
+        sem_wait(&queue->sem);
+        queue->terminate = true;
+        sem_post(&queue->sem);
+        sem_post(&queue->items);
+        pthread_join(queue->thread, NULL);
+
+        /* Release the messages remaining in the queue */
+        while (0 < queue->count) {
+            cote_queue_msg_put(queue->msgs[queue->first]);
+            queue->first = (queue->first + 1) % queue->size;
+            queue->count--;
+        }
+
+        /* Release semaphores */
+        sem_close(&queue->sem);
+        sem_close(&queue->items);
+        sem_close(&queue->space);
+
+        /* Release memory */
+        free(queue->msgs);
+        free(queue);
+    }
+}
+
+/**
+ * @brief Thread sending the queued messages
+ * @param arg Send queue
+ * @return Always returns NULL
+ */
+static void *
+cote_queue_thread(void *arg) {
+
+    assert(NULL != arg);
+
+    /* Retrieve send queue */
+    cote_queue_t *queue = (cote_queue_t *)arg;
+
+    /* Send the messages until termination */
+    while (1) {
+
+        /* Wait for a message, the queue may be empty if it has been closed */
+        sem_wait(&queue->items);
+        sem_wait(&queue->sem);
+        if (true == queue->terminate) {
+            sem_post(&queue->sem);
+            break;
+        }
+        cote_queue_msg_t *msg = NULL;
+        if (0 < queue->count) {
+            msg          = queue->msgs[queue->first];
+            queue->first = (queue->first + 1) % queue->size;
+            queue->count--;
+        }
+        sem_post(&queue->sem);
+
+        /* Send the message */
+        if (NULL != msg) {
+
+            /* The place of the message is free, a blocked publisher can continue */
+            if (COTE_DROP_BLOCK == queue->policy) {
+                sem_post(&queue->space);
+            }
+
+            /* Send the message, this may block if the node is slow to consume */
+            if (0 == queue->fct(queue->axon, msg->fulltopic, msg->fields, msg->count)) {
+                __atomic_add_fetch(&queue->sent, 1, __ATOMIC_RELAXED);
+            } else {
+                __atomic_add_fetch(&queue->dropped, 1, __ATOMIC_RELAXED);
+            }
+            cote_queue_msg_put(msg);
+        }
+    }
+
+    return NULL;
+}
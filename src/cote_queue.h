@@ -0,0 +1,104 @@
+/**
+ * @file      cote_queue.h
+ * @brief     Cote library - Send queues of the peers
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_QUEUE_H__
+#define __COTE_QUEUE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Create a send queue and start the thread sending the messages
+ * @param size Maximum amount of queued messages (high water mark)
+ * @param policy Policy when the high water mark is reached
+ * @param fct Function invoked to send a message
+ * @param axon Axon instance the messages are sent to, it is not owned by the queue
+ * @return Send queue if the function succeeded, NULL otherwise
+ */
+cote_queue_t *cote_queue_create(int size, cote_drop_e policy, int (*fct)(axon_t *, char *, cote_field_t *, int), axon_t *axon);
+
+/**
+ * @brief Create a queued message, the topic and the data of the fields are copied once and the copy is shared by the send queues
+ * @param fulltopic Full topic of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_FIELDS_MAX)
+ * @return Queued message with one reference if the function succeeded, NULL otherwise
+ */
+cote_queue_msg_t *cote_queue_msg_create(char *fulltopic, cote_field_t *fields, int count);
+
+/**
+ * @brief Queue a message, a reference to the message is taken by the queue
+ * @param queue Send queue
+ * @param msg Queued message, NULL if the message could not be created (it is counted as dropped)
+ * @return 0 if the function succeeded (the message is queued), -1 if the message has been dropped
+ */
+int cote_queue_push(cote_queue_t *queue, cote_queue_msg_t *msg);
+
+/**
+ * @brief Release a reference to a queued message, the message is released with the last reference
+ * @param msg Queued message, nothing is done if NULL
+ */
+void cote_queue_msg_put(cote_queue_msg_t *msg);
+
+/**
+ * @brief Check if a send queue has been closed because the high water mark has been reached (COTE_DROP_DISCONNECT)
+ * @param queue Send queue
+ * @return true if the queue is closed, false otherwise
+ */
+bool cote_queue_is_closed(cote_queue_t *queue);
+
+/**
+ * @brief Retrieve statistics of a send queue
+ * @param queue Send queue
+ * @param stats Peer statistics, the queued, sent and dropped counters are set
+ */
+void cote_queue_get_stats(cote_queue_t *queue, cote_peer_stats_t *stats);
+
+/**
+ * @brief Release send queue, the thread is stopped and the messages remaining in the queue are dropped
+ * @param queue Send queue
+ */
+void cote_queue_release(cote_queue_t *queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_QUEUE_H__ */
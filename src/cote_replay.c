@@ -0,0 +1,361 @@
+/**
+ * @file      cote_replay.c
+ * @brief     Cote library - Replay of the recent messages
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "cote_replay.h"
+#include "cote_frame.h"
+#include "cote_hash.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Search a topic, it is created if not found and becomes the most recently published, the semaphore of the replay must be taken by the caller
+ * @param replay Replay
+ * @param topic Topic
+ * @return Topic if the function succeeded, NULL otherwise
+ */
+static cote_replay_topic_t *cote_replay_get_topic(cote_replay_t *replay, char *topic);
+
+/**
+ * @brief Evict the topic published the least recently and its messages, the semaphore of the replay must be taken by the caller
+ * @param replay Replay
+ */
+static void cote_replay_evict(cote_replay_t *replay);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Create the topics table of the replay
+ * @param replay Replay
+ * @param depth Amount of messages kept per topic
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_replay_create(cote_replay_t *replay, int depth) {
+
+    assert(NULL != replay);
+
+    /* Check amount of messages kept per topic */
+    if ((1 > depth) || (COTE_REPLAY_DEPTH_MAX < depth)) {
+        /* Invalid amount of messages */
+        return -1;
+    }
+
+    /* Create topics table */
+    memset(replay, 0, sizeof(cote_replay_t));
+    if (NULL == (replay->topics = (cote_replay_topic_t **)malloc(COTE_REPLAY_BUCKETS * sizeof(cote_replay_topic_t *)))) {
+        /* Unable to allocate memory */
+        return -1;
+    }
+    memset(replay->topics, 0, COTE_REPLAY_BUCKETS * sizeof(cote_replay_topic_t *));
+    replay->depth = depth;
+    sem_init(&replay->sem, 0, 1);
+
+    return 0;
+}
+
+/**
+ * @brief Keep a message in the ring of its topic, the oldest message of the topic is replaced once the ring is full
+ * @param replay Replay
+ * @param topic Topic of the message
+ * @param fulltopic Full topic of the message
+ * @param fields Fields of the message, they are encoded in a frame
+ * @param count Amount of fields (up to COTE_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 if the message is not kept (too many fields or unable to allocate memory)
+ */
+int
+cote_replay_store(cote_replay_t *replay, char *topic, char *fulltopic, cote_field_t *fields, int count) {
+
+    assert(NULL != replay);
+    assert(NULL != replay->topics);
+    assert(NULL != topic);
+    assert(NULL != fulltopic);
+    assert((NULL != fields) || (0 == count));
+
+    /* Prepare the frame of the message, the JSON objects are serialized so that no tree is kept and the frame is replayed as is */
+    cote_frame_t frame;
+    if (0 != cote_frame_prepare(&frame, fulltopic, fields, count)) {
+        /* Too many fields or unable to serialize the fields */
+        return -1;
+    }
+    size_t size = sizeof(cote_replay_msg_t) + frame.size;
+
+    /* Wait replay semaphore */
+    sem_wait(&replay->sem);
+
+    /* Retrieve the message of the ring replaced, its allocation is reused if it is large enough */
+    cote_replay_topic_t *curr = cote_replay_get_topic(replay, topic);
+    cote_replay_msg_t *  msg  = NULL;
+    if (NULL != curr) {
+        int index = (curr->count < replay->depth) ? ((curr->first + curr->count) % replay->depth) : curr->first;
+        if ((NULL == curr->msgs[index]) || (size > curr->msgs[index]->size)) {
+            if (NULL != (msg = (cote_replay_msg_t *)malloc(size))) {
+                free(curr->msgs[index]);
+                curr->msgs[index] = msg;
+                msg->size         = size;
+            }
+        } else {
+            msg = curr->msgs[index];
+        }
+        if (NULL != msg) {
+            if (curr->count < replay->depth) {
+                curr->count++;
+            } else {
+                curr->first = (curr->first + 1) % replay->depth;
+            }
+        }
+    }
+
+    /* Write the frame after the structure */
+    if (NULL != msg) {
+        msg->length = frame.size;
+        (void)cote_frame_write(&frame, (uint8_t *)(msg + 1));
+    }
+
+    /* Release replay semaphore */
+    sem_post(&replay->sem);
+
+    /* Release serialized JSON objects */
+    cote_frame_clean(&frame);
+
+    return (NULL != msg) ? 0 : -1;
+}
+
+/**
+ * @brief Copy the messages kept, oldest topic first and oldest message first for each topic, the semaphore of the replay must be taken by the caller
+ * @param replay Replay
+ * @param snapshot Snapshot, released with cote_replay_snapshot_release
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_replay_snapshot(cote_replay_t *replay, cote_replay_snapshot_t *snapshot) {
+
+    assert(NULL != replay);
+    assert(NULL != replay->topics);
+    assert(NULL != snapshot);
+
+    /* Compute the size of the frames and of the topics, each topic is copied once */
+    memset(snapshot, 0, sizeof(cote_replay_snapshot_t));
+    size_t frames = 0;
+    size_t size   = 0;
+    for (cote_replay_topic_t *curr = replay->oldest; NULL != curr; curr = curr->newer) {
+        for (int index = 0; index < curr->count; index++) {
+            frames += curr->msgs[(curr->first + index) % replay->depth]->length;
+        }
+        size += (0 < curr->count) ? strlen(curr->topic) + 1 : 0;
+        snapshot->count += curr->count;
+    }
+    if (0 == snapshot->count) {
+        /* No message kept */
+        return 0;
+    }
+
+    /* Allocate the copy */
+    snapshot->buffer  = (uint8_t *)malloc(frames + size);
+    snapshot->offsets = (size_t *)malloc((snapshot->count + 1) * sizeof(size_t));
+    snapshot->topics  = (char **)malloc(snapshot->count * sizeof(char *));
+    if ((NULL == snapshot->buffer) || (NULL == snapshot->offsets) || (NULL == snapshot->topics)) {
+        /* Unable to allocate memory */
+        cote_replay_snapshot_release(snapshot);
+        return -1;
+    }
+
+    /* Copy the frames, followed by the topics */
+    int    count = 0;
+    size_t pos   = 0;
+    char * topic = (char *)&snapshot->buffer[frames];
+    for (cote_replay_topic_t *curr = replay->oldest; NULL != curr; curr = curr->newer) {
+        if (0 < curr->count) {
+            strcpy(topic, curr->topic);
+        }
+        for (int index = 0; index < curr->count; index++) {
+            cote_replay_msg_t *msg = curr->msgs[(curr->first + index) % replay->depth];
+            memcpy(&snapshot->buffer[pos], msg + 1, msg->length);
+            snapshot->offsets[count] = pos;
+            snapshot->topics[count]  = topic;
+            pos += msg->length;
+            count++;
+        }
+        topic += (0 < curr->count) ? strlen(topic) + 1 : 0;
+    }
+    snapshot->offsets[count] = pos;
+
+    return 0;
+}
+
+/**
+ * @brief Release the copy of the messages kept
+ * @param snapshot Snapshot
+ */
+void
+cote_replay_snapshot_release(cote_replay_snapshot_t *snapshot) {
+
+    assert(NULL != snapshot);
+
+    /* Release memory */
+    free(snapshot->buffer);
+    free(snapshot->offsets);
+    free(snapshot->topics);
+    memset(snapshot, 0, sizeof(cote_replay_snapshot_t));
+}
+
+/**
+ * @brief Release the topics table and the messages kept
+ * @param replay Replay
+ */
+void
+cote_replay_release(cote_replay_t *replay) {
+
+    assert(NULL != replay);
+
+    /* Release topics and their messages */
+    if (NULL != replay->topics) {
+        while (NULL != replay->oldest) {
+            cote_replay_evict(replay);
+        }
+        free(replay->topics);
+        sem_close(&replay->sem);
+    }
+    memset(replay, 0, sizeof(cote_replay_t));
+}
+
+/**
+ * @brief Search a topic, it is created if not found and becomes the most recently published, the semaphore of the replay must be taken by the caller
+ * @param replay Replay
+ * @param topic Topic
+ * @return Topic if the function succeeded, NULL otherwise
+ */
+static cote_replay_topic_t *
+cote_replay_get_topic(cote_replay_t *replay, char *topic) {
+
+    assert(NULL != replay);
+    assert(NULL != topic);
+
+    /* Search the topic in its bucket */
+    unsigned int         bucket = cote_hash(topic) & (COTE_REPLAY_BUCKETS - 1);
+    cote_replay_topic_t *curr   = replay->topics[bucket];
+    while ((NULL != curr) && (0 != strcmp(topic, curr->topic))) {
+        curr = curr->next;
+    }
+
+    if (NULL != curr) {
+
+        /* Remove the topic from the order of publication */
+        if (NULL != curr->older) {
+            curr->older->newer = curr->newer;
+        } else {
+            replay->oldest = curr->newer;
+        }
+        if (NULL != curr->newer) {
+            curr->newer->older = curr->older;
+        } else {
+            replay->newest = curr->older;
+        }
+
+    } else {
+
+        /* Evict the topic published the least recently if there are too many topics */
+        if (COTE_REPLAY_TOPICS <= replay->count) {
+            cote_replay_evict(replay);
+        }
+
+        /* Create the topic, the ring and the topic are allocated after the structure */
+        size_t size = sizeof(cote_replay_topic_t) + replay->depth * sizeof(cote_replay_msg_t *) + strlen(topic) + 1;
+        if (NULL == (curr = (cote_replay_topic_t *)malloc(size))) {
+            /* Unable to allocate memory */
+            return NULL;
+        }
+        memset(curr, 0, size);
+        curr->msgs  = (cote_replay_msg_t **)(curr + 1);
+        curr->topic = strcpy((char *)(curr->msgs + replay->depth), topic);
+
+        /* Add the topic to its bucket */
+        curr->next             = replay->topics[bucket];
+        replay->topics[bucket] = curr;
+        replay->count++;
+    }
+
+    /* The topic is the one published the most recently */
+    curr->older = replay->newest;
+    curr->newer = NULL;
+    if (NULL != replay->newest) {
+        replay->newest->newer = curr;
+    } else {
+        replay->oldest = curr;
+    }
+    replay->newest = curr;
+
+    return curr;
+}
+
+/**
+ * @brief Evict the topic published the least recently and its messages, the semaphore of the replay must be taken by the caller
+ * @param replay Replay
+ */
+static void
+cote_replay_evict(cote_replay_t *replay) {
+
+    assert(NULL != replay);
+    assert(NULL != replay->oldest);
+
+    /* Remove the topic from the order of publication */
+    cote_replay_topic_t *curr = replay->oldest;
+    replay->oldest            = curr->newer;
+    if (NULL != replay->oldest) {
+        replay->oldest->older = NULL;
+    } else {
+        replay->newest = NULL;
+    }
+
+    /* Remove the topic from its bucket */
+    cote_replay_topic_t **prev = &replay->topics[cote_hash(curr->topic) & (COTE_REPLAY_BUCKETS - 1)];
+    while (curr != *prev) {
+        prev = &(*prev)->next;
+    }
+    *prev = curr->next;
+    replay->count--;
+
+    /* Release the messages and the topic */
+    for (int index = 0; index < replay->depth; index++) {
+        free(curr->msgs[index]);
+    }
+    free(curr);
+}
+
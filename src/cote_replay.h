@@ -0,0 +1,98 @@
+/**
+ * @file      cote_replay.h
+ * @brief     Cote library - Replay of the recent messages
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_REPLAY_H__
+#define __COTE_REPLAY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define COTE_REPLAY_BUCKETS   (256)  /* Amount of buckets of the topics table, must be a power of 2 */
+#define COTE_REPLAY_DEPTH_MAX (1024) /* Maximum amount of messages kept per topic */
+#define COTE_REPLAY_TOPICS    (4096) /* Maximum amount of topics kept, the topic published the least recently is evicted */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Create the topics table of the replay
+ * @param replay Replay
+ * @param depth Amount of messages kept per topic
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_replay_create(cote_replay_t *replay, int depth);
+
+/**
+ * @brief Keep a message in the ring of its topic, the oldest message of the topic is replaced once the ring is full
+ * @param replay Replay
+ * @param topic Topic of the message
+ * @param fulltopic Full topic of the message
+ * @param fields Fields of the message, they are encoded in a frame
+ * @param count Amount of fields (up to COTE_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 if the message is not kept (too many fields or unable to allocate memory)
+ */
+int cote_replay_store(cote_replay_t *replay, char *topic, char *fulltopic, cote_field_t *fields, int count);
+
+/**
+ * @brief Copy the messages kept, oldest topic first and oldest message first for each topic, the semaphore of the replay must be taken by the caller
+ * @param replay Replay
+ * @param snapshot Snapshot, released with cote_replay_snapshot_release
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_replay_snapshot(cote_replay_t *replay, cote_replay_snapshot_t *snapshot);
+
+/**
+ * @brief Release the copy of the messages kept
+ * @param snapshot Snapshot
+ */
+void cote_replay_snapshot_release(cote_replay_snapshot_t *snapshot);
+
+/**
+ * @brief Release the topics table and the messages kept
+ * @param replay Replay
+ */
+void cote_replay_release(cote_replay_t *replay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_REPLAY_H__ */
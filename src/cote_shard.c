@@ -0,0 +1,206 @@
+/**
+ * @file      cote_shard.c
+ * @brief     Cote library - Publisher shards
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "cote_shard.h"
+#include "cote_hash.h"
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Create the axon instances of the shards, the first shard is the axon instance of the Publisher instance
+ * @param cote Cote instance
+ * @param count Amount of shards
+ * @param bind Callback function invoked when a shard is bound
+ * @param error Callback function invoked when an error occurs on a shard
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_shards_create(cote_t *cote, int count, void *bind, void *error) {
+
+    assert(NULL != cote);
+    assert(NULL != cote->axon);
+    assert(NULL != bind);
+    assert(NULL != error);
+
+    cote_shards_t *shards = &cote->shards;
+
+    /* Check amount of shards */
+    if ((2 > count) || (COTE_SHARDS_MAX < count)) {
+        /* Invalid amount of shards */
+        return -1;
+    }
+
+    /* Create shards */
+    if (NULL == (shards->axons = (axon_t **)malloc(count * sizeof(axon_t *)))) {
+        /* Unable to allocate memory */
+        return -1;
+    }
+    memset(shards->axons, 0, count * sizeof(axon_t *));
+    if (NULL == (shards->ports = (uint16_t *)malloc(count * sizeof(uint16_t)))) {
+        /* Unable to allocate memory */
+        free(shards->axons);
+        shards->axons = NULL;
+        return -1;
+    }
+    memset(shards->ports, 0, count * sizeof(uint16_t));
+    shards->axons[0] = cote->axon;
+    shards->count    = count;
+
+    /* Create the axon instances of the other shards, the callbacks are defined before any shard is bound */
+    for (int index = 1; index < count; index++) {
+        if (NULL == (shards->axons[index] = axon_create("pub"))) {
+            /* Unable to create Axon instance */
+            cote_shards_release(shards);
+            return -1;
+        }
+        axon_on(shards->axons[index], "error", error, cote);
+        axon_on(shards->axons[index], "bind", bind, cote);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Bind the axon instances of the shards to any available port, the first shard is bound by the caller
+ * @param shards Shards
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_shards_bind(cote_shards_t *shards) {
+
+    assert(NULL != shards);
+
+    /* Bind the other shards */
+    for (int index = 1; index < shards->count; index++) {
+        if (0 != axon_bind(shards->axons[index], 0)) {
+            /* Unable to bind Axon instance */
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Record the port of a bound shard
+ * @param shards Shards
+ * @param axon Axon instance of the shard
+ * @param port Port of the shard
+ * @return true once all the shards are bound (returned only once), false otherwise
+ */
+bool
+cote_shards_bound(cote_shards_t *shards, axon_t *axon, uint16_t port) {
+
+    assert(NULL != shards);
+
+    /* Search the shard */
+    for (int index = 0; index < shards->count; index++) {
+        if (axon == shards->axons[index]) {
+            __atomic_store_n(&shards->ports[index], port, __ATOMIC_RELAXED);
+            return (shards->count == __atomic_add_fetch(&shards->bound, 1, __ATOMIC_ACQ_REL)) ? true : false;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Count a discovered subscriber connecting only to the first shard (Node.js cote or older c-cote subscriber)
+ * @param shards Shards
+ * @param added true when the subscriber is added, false when it is removed
+ */
+void
+cote_shards_set_legacy(cote_shards_t *shards, bool added) {
+
+    assert(NULL != shards);
+
+    /* Update the amount of subscribers, it is read by the publishing threads without lock */
+    if (true == added) {
+        __atomic_add_fetch(&shards->legacy, 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_sub_fetch(&shards->legacy, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Get the axon instance of the shard sending a topic, the same shard is always used for a topic so that the order of its messages is kept
+ * All the topics are sent by the first shard while subscribers connecting only to it are discovered
+ * @param shards Shards
+ * @param topic Topic
+ * @return Axon instance of the shard
+ */
+axon_t *
+cote_shards_get(cote_shards_t *shards, char *topic) {
+
+    assert(NULL != shards);
+    assert(NULL != shards->axons);
+    assert(NULL != topic);
+
+    /* The subscribers connecting only to the first shard receive all the topics from it */
+    if (0 < __atomic_load_n(&shards->legacy, __ATOMIC_RELAXED)) {
+        return shards->axons[0];
+    }
+
+    return shards->axons[cote_hash(topic) % (uint32_t)shards->count];
+}
+
+/**
+ * @brief Release the axon instances of the shards, except the first one which is the axon instance of the Publisher instance
+ * @param shards Shards
+ */
+void
+cote_shards_release(cote_shards_t *shards) {
+
+    assert(NULL != shards);
+
+    /* Release the other shards */
+    if (NULL != shards->axons) {
+        for (int index = 1; index < shards->count; index++) {
+            if (NULL != shards->axons[index]) {
+                axon_release(shards->axons[index]);
+            }
+        }
+        free(shards->axons);
+    }
+    if (NULL != shards->ports) {
+        free(shards->ports);
+    }
+    memset(shards, 0, sizeof(cote_shards_t));
+}
+
@@ -0,0 +1,105 @@
+/**
+ * @file      cote_shard.h
+ * @brief     Cote library - Publisher shards
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_SHARD_H__
+#define __COTE_SHARD_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define COTE_SHARDS_MAX (64) /* Maximum amount of shards of a Publisher instance */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Create the axon instances of the shards, the first shard is the axon instance of the Publisher instance
+ * @param cote Cote instance
+ * @param count Amount of shards
+ * @param bind Callback function invoked when a shard is bound
+ * @param error Callback function invoked when an error occurs on a shard
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_shards_create(cote_t *cote, int count, void *bind, void *error);
+
+/**
+ * @brief Bind the axon instances of the shards to any available port, the first shard is bound by the caller
+ * @param shards Shards
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_shards_bind(cote_shards_t *shards);
+
+/**
+ * @brief Record the port of a bound shard
+ * @param shards Shards
+ * @param axon Axon instance of the shard
+ * @param port Port of the shard
+ * @return true once all the shards are bound (returned only once), false otherwise
+ */
+bool cote_shards_bound(cote_shards_t *shards, axon_t *axon, uint16_t port);
+
+/**
+ * @brief Count a discovered subscriber connecting only to the first shard (Node.js cote or older c-cote subscriber)
+ * @param shards Shards
+ * @param added true when the subscriber is added, false when it is removed
+ */
+void cote_shards_set_legacy(cote_shards_t *shards, bool added);
+
+/**
+ * @brief Get the axon instance of the shard sending a topic, the same shard is always used for a topic so that the order of its messages is kept
+ * All the topics are sent by the first shard while subscribers connecting only to it are discovered
+ * @param shards Shards
+ * @param topic Topic
+ * @return Axon instance of the shard
+ */
+axon_t *cote_shards_get(cote_shards_t *shards, char *topic);
+
+/**
+ * @brief Release the axon instances of the shards, except the first one which is the axon instance of the Publisher instance
+ * @param shards Shards
+ */
+void cote_shards_release(cote_shards_t *shards);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_SHARD_H__ */
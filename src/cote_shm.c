@@ -0,0 +1,827 @@
+/**
+ * @file      cote_shm.c
+ * @brief     Cote library - Shared memory transport
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cote_frame.h"
+#include "cote_shm.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define COTE_SHM_MAGIC (0x434f5446) /* Magic number of the ring buffer, changed with its layout */
+
+/******************************************************************************/
+/* Variables                                                                  */
+/******************************************************************************/
+
+static unsigned int   cote_shm_counter   = 0;                 /* Amount of shared memories created by the process, used to name them */
+static pthread_once_t cote_shm_host_once = PTHREAD_ONCE_INIT; /* Initialization of the host token */
+static char           cote_shm_host_token[256];               /* Token of the host, empty if it can not be retrieved */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Map a shared memory
+ * @param name Name of the shared memory
+ * @param fd File descriptor of the shared memory
+ * @param length Length of the shared memory
+ * @param owner The shared memory is created by the instance
+ * @return Shared memory transport if the function succeeded, NULL otherwise
+ */
+static cote_shm_t *cote_shm_map(char *name, int fd, size_t length, bool owner);
+
+/**
+ * @brief Lock the ring buffer, the lock is recovered if its owner has died while holding it
+ * @param ring Ring buffer
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_shm_lock(cote_shm_ring_t *ring);
+
+/**
+ * @brief Lock the ring buffer once there is enough space to write a frame, the writer waits for space up to COTE_SHM_WAIT
+ * @param shm Shared memory transport
+ * @param size Size of the frame
+ * @return 0 if the function succeeded (the ring buffer is locked), -1 otherwise (the ring buffer is not locked)
+ */
+static int cote_shm_lock_space(cote_shm_t *shm, uint32_t size);
+
+/**
+ * @brief Search a publisher attached or to be attached to the shared memory, the semaphore must be taken by the caller
+ * @param shm Shared memory transport
+ * @param id Identifier of the publisher
+ * @return Publisher, added if not found, NULL if it can not be added
+ */
+static cote_shm_attached_t *cote_shm_find(cote_shm_t *shm, char *id);
+
+/**
+ * @brief Format the token of the host, invoked once
+ */
+static void cote_shm_host_init(void);
+
+/**
+ * @brief Read the first line of a file
+ * @param path Path of the file
+ * @param line Line, without the end of line character
+ * @param size Size of the line
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_shm_read_line(char *path, char *line, size_t size);
+
+/**
+ * @brief Copy data to the ring buffer
+ * @param ring Ring buffer
+ * @param pos Position in the ring buffer
+ * @param src Data
+ * @param len Length of the data
+ * @return Position following the data
+ */
+static uint64_t cote_shm_write(cote_shm_ring_t *ring, uint64_t pos, void *src, size_t len);
+
+/**
+ * @brief Copy data from the ring buffer
+ * @param ring Ring buffer
+ * @param pos Position in the ring buffer
+ * @param dst Data
+ * @param len Length of the data
+ */
+static void cote_shm_read(cote_shm_ring_t *ring, uint64_t pos, void *dst, size_t len);
+
+/**
+ * @brief Thread reading the frames
+ * @param arg Shared memory transport
+ * @return Always returns NULL
+ */
+static void *cote_shm_thread(void *arg);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Create a shared memory and start the thread reading the frames
+ * @param size Size of the data of the ring buffer
+ * @param fct Function invoked with each message read, the message is released once the function returns
+ * @param user User data passed to the function
+ * @return Shared memory transport if the function succeeded, NULL otherwise
+ */
+cote_shm_t *
+cote_shm_create(size_t size, void (*fct)(amp_msg_t *, void *), void *user) {
+
+    assert(0 < size);
+    assert(NULL != fct);
+
+    /* Format name of the shared memory */
+    char name[64];
+    snprintf(name, sizeof(name), "/cote-%d-%u", (int)getpid(), __atomic_fetch_add(&cote_shm_counter, 1, __ATOMIC_RELAXED));
+
+    /* Create shared memory, only accessible by the user of the process */
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (0 > fd) {
+        /* Unable to create shared memory */
+        return NULL;
+    }
+    size_t length = sizeof(cote_shm_ring_t) + size;
+    if (0 != ftruncate(fd, (off_t)length)) {
+        /* Unable to set size of the shared memory */
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    cote_shm_t *shm = cote_shm_map(name, fd, length, true);
+    if (NULL == shm) {
+        /* Unable to map shared memory */
+        shm_unlink(name);
+        return NULL;
+    }
+
+    /* Initialize ring buffer, the magic number is set last so that writers never use a ring buffer which is not initialized */
+    shm->ring->size = (uint32_t)size;
+    shm->ring->head = 0;
+    shm->ring->tail = 0;
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    int ret = pthread_mutex_init(&shm->ring->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    if (0 != ret) {
+        /* Unable to initialize the lock */
+        shm->owner = false;
+        cote_shm_release(shm);
+        shm_unlink(name);
+        return NULL;
+    }
+    sem_init(&shm->ring->frames, 1, 0);
+    sem_init(&shm->ring->space, 1, 0);
+    shm->ring->waiting = 0;
+    __atomic_store_n(&shm->ring->magic, COTE_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    /* Start thread reading the frames */
+    shm->fct  = fct;
+    shm->user = user;
+    sem_init(&shm->sem, 0, 1);
+    if (0 != pthread_create(&shm->thread, NULL, cote_shm_thread, shm)) {
+        /* Unable to create thread */
+        shm->owner = false;
+        pthread_mutex_destroy(&shm->ring->lock);
+        sem_destroy(&shm->ring->frames);
+        sem_destroy(&shm->ring->space);
+        sem_destroy(&shm->sem);
+        cote_shm_release(shm);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    return shm;
+}
+
+/**
+ * @brief Open a shared memory created by another instance to write frames
+ * @param name Name of the shared memory
+ * @return Shared memory transport if the function succeeded, NULL otherwise
+ */
+cote_shm_t *
+cote_shm_open(char *name) {
+
+    assert(NULL != name);
+
+    /* Open shared memory */
+    int fd = shm_open(name, O_RDWR, 0);
+    if (0 > fd) {
+        /* Unable to open shared memory */
+        return NULL;
+    }
+    struct stat st;
+    if ((0 != fstat(fd, &st)) || ((size_t)st.st_size <= sizeof(cote_shm_ring_t))) {
+        /* Invalid shared memory */
+        close(fd);
+        return NULL;
+    }
+    cote_shm_t *shm = cote_shm_map(name, fd, (size_t)st.st_size, false);
+    if (NULL == shm) {
+        /* Unable to map shared memory */
+        return NULL;
+    }
+
+    /* Check ring buffer */
+    if ((COTE_SHM_MAGIC != __atomic_load_n(&shm->ring->magic, __ATOMIC_ACQUIRE)) || (shm->length - sizeof(cote_shm_ring_t) < shm->ring->size)) {
+        /* Invalid ring buffer */
+        cote_shm_release(shm);
+        return NULL;
+    }
+
+    return shm;
+}
+
+/**
+ * @brief Write a message to the shared memory, the writer waits for space up to COTE_SHM_WAIT if the ring buffer is full, the message is dropped then
+ * @param shm Shared memory transport
+ * @param topic Full topic of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_shm_send(cote_shm_t *shm, char *topic, cote_field_t *fields, int count) {
+
+    assert(NULL != shm);
+    assert(NULL != topic);
+    assert((NULL != fields) || (0 == count));
+
+    /* Prepare the frame, JSON objects are serialized */
+    cote_frame_t frame;
+    if (0 != cote_frame_prepare(&frame, topic, fields, count)) {
+        /* Too many fields or unable to serialize the fields */
+        return -1;
+    }
+
+    /* Write the frame once there is enough space in the ring buffer */
+    cote_shm_ring_t *ring = shm->ring;
+    int              ret  = cote_shm_lock_space(shm, frame.size);
+    if (0 == ret) {
+        uint8_t  nb   = (uint8_t)frame.count;
+        uint64_t head = cote_shm_write(ring, ring->head, &frame.size, sizeof(uint32_t));
+        head          = cote_shm_write(ring, head, &nb, sizeof(uint8_t));
+        for (int index = 0; index < frame.count; index++) {
+            head = cote_shm_write(ring, head, &frame.types[index], sizeof(uint8_t));
+            head = cote_shm_write(ring, head, &frame.sizes[index], sizeof(uint32_t));
+            head = cote_shm_write(ring, head, frame.data[index], frame.sizes[index]);
+        }
+        __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&ring->lock);
+
+        /* Wake up the reader */
+        sem_post(&ring->frames);
+    }
+
+    /* Release serialized JSON objects */
+    cote_frame_clean(&frame);
+
+    return ret;
+}
+
+/**
+ * @brief Write a message already encoded as a frame to the shared memory, the writer waits for space up to COTE_SHM_WAIT if the ring buffer is full
+ * @param shm Shared memory transport
+ * @param frame Frame of the message, size of the frame included
+ * @param size Size of the frame
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_shm_send_frame(cote_shm_t *shm, uint8_t *frame, uint32_t size) {
+
+    assert(NULL != shm);
+    assert(NULL != frame);
+
+    /* Write the frame once there is enough space in the ring buffer */
+    cote_shm_ring_t *ring = shm->ring;
+    int              ret  = cote_shm_lock_space(shm, size);
+    if (0 == ret) {
+        __atomic_store_n(&ring->head, cote_shm_write(ring, ring->head, frame, size), __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&ring->lock);
+
+        /* Wake up the reader */
+        sem_post(&ring->frames);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Release shared memory transport, the shared memory is removed if it has been created by the instance
+ * @param shm Shared memory transport
+ */
+void
+cote_shm_release(cote_shm_t *shm) {
+
+    /* Release shared memory transport */
+    if (NULL != shm) {
+
+        /* Stop thread reading the frames */
+        if (true == shm->owner) {
+            __atomic_store_n(&shm->terminate, true, __ATOMIC_SEQ_CST);
+            sem_post(&shm->ring->frames);
+            pthread_join(shm->thread, NULL);
+            pthread_mutex_destroy(&shm->ring->lock);
+            sem_destroy(&shm->ring->frames);
+            sem_destroy(&shm->ring->space);
+            shm_unlink(shm->name);
+            sem_destroy(&shm->sem);
+        }
+
+        /* Release the publishers attached */
+        while (NULL != shm->attached) {
+            cote_shm_attached_t *tmp = shm->attached;
+            shm->attached            = shm->attached->next;
+            free(tmp->id);
+            free(tmp->iid);
+            free(tmp);
+        }
+
+        /* Release memory */
+        munmap(shm->ring, shm->length);
+        free(shm->name);
+        free(shm);
+    }
+}
+
+/**
+ * @brief Write the frame announcing a publisher to the shared memory, the subscriber stops receiving the messages of the publisher with TCP once read
+ * @param shm Shared memory transport
+ * @param id Identifier of the publisher, as announced in its advertisement
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_shm_attach(cote_shm_t *shm, char *id) {
+
+    assert(NULL != shm);
+    assert(NULL != id);
+
+    /* Write the frame, the topic can not be a full topic */
+    cote_field_t field = { AMP_TYPE_STRING, id, 0 };
+
+    return cote_shm_send(shm, COTE_SHM_ATTACH, &field, 1);
+}
+
+/**
+ * @brief Check if a publisher is attached to the shared memory, and associate its identifier to its instance ID (owner only)
+ * @param shm Shared memory transport
+ * @param id Identifier of the publisher, as announced in its advertisement
+ * @param iid Instance ID of the publisher
+ * @return true if the frame announcing the publisher has been read, false otherwise
+ */
+bool
+cote_shm_is_attached(cote_shm_t *shm, char *id, char *iid) {
+
+    assert(NULL != shm);
+    assert(NULL != id);
+    assert(NULL != iid);
+
+    /* Wait shared memory semaphore */
+    sem_wait(&shm->sem);
+
+    /* Search the publisher, it is added if not found */
+    cote_shm_attached_t *curr = cote_shm_find(shm, id);
+    if ((NULL != curr) && (NULL == curr->iid)) {
+        curr->iid = strdup(iid);
+    }
+    bool attached = ((NULL != curr) && (true == curr->attached)) ? true : false;
+
+    /* Release shared memory semaphore */
+    sem_post(&shm->sem);
+
+    return attached;
+}
+
+/**
+ * @brief Set a publisher as attached to the shared memory when the frame announcing it is read (owner only)
+ * @param shm Shared memory transport
+ * @param id Identifier of the publisher, as written in the frame
+ * @return Instance ID of the publisher if it is known (to be released by the caller), NULL otherwise
+ */
+char *
+cote_shm_set_attached(cote_shm_t *shm, char *id) {
+
+    assert(NULL != shm);
+    assert(NULL != id);
+
+    char *iid = NULL;
+
+    /* Wait shared memory semaphore */
+    sem_wait(&shm->sem);
+
+    /* Search the publisher, it is added if not found */
+    cote_shm_attached_t *curr = cote_shm_find(shm, id);
+    if (NULL != curr) {
+        curr->attached = true;
+        if (NULL != curr->iid) {
+            iid = strdup(curr->iid);
+        }
+    }
+
+    /* Release shared memory semaphore */
+    sem_post(&shm->sem);
+
+    return iid;
+}
+
+/**
+ * @brief Forget a publisher removed (owner only)
+ * @param shm Shared memory transport
+ * @param iid Instance ID of the publisher
+ */
+void
+cote_shm_forget(cote_shm_t *shm, char *iid) {
+
+    assert(NULL != shm);
+    assert(NULL != iid);
+
+    /* Wait shared memory semaphore */
+    sem_wait(&shm->sem);
+
+    /* Remove the publisher */
+    cote_shm_attached_t *curr = shm->attached, *prev = NULL;
+    while ((NULL != curr) && ((NULL == curr->iid) || (strcmp(curr->iid, iid)))) {
+        prev = curr;
+        curr = curr->next;
+    }
+    if (NULL != curr) {
+        if (NULL != prev) {
+            prev->next = curr->next;
+        } else {
+            shm->attached = curr->next;
+        }
+        free(curr->id);
+        free(curr->iid);
+        free(curr);
+    }
+
+    /* Release shared memory semaphore */
+    sem_post(&shm->sem);
+}
+
+/**
+ * @brief Get the token of the host, processes which can share memory have the same token
+ * The token is made of the machine ID, the boot ID, the IPC namespace and the device of /dev/shm, so that containers and virtual machines are told apart
+ * @return Token of the host, empty if it can not be retrieved and the shared memory must not be used
+ */
+char *
+cote_shm_get_host(void) {
+
+    /* Format the token once */
+    pthread_once(&cote_shm_host_once, &cote_shm_host_init);
+
+    return cote_shm_host_token;
+}
+
+/**
+ * @brief Map a shared memory
+ * @param name Name of the shared memory
+ * @param fd File descriptor of the shared memory
+ * @param length Length of the shared memory
+ * @param owner The shared memory is created by the instance
+ * @return Shared memory transport if the function succeeded, NULL otherwise
+ */
+static cote_shm_t *
+cote_shm_map(char *name, int fd, size_t length, bool owner) {
+
+    assert(NULL != name);
+
+    /* Create shared memory transport */
+    cote_shm_t *shm = (cote_shm_t *)malloc(sizeof(cote_shm_t));
+    if (NULL == shm) {
+        /* Unable to allocate memory */
+        close(fd);
+        return NULL;
+    }
+    memset(shm, 0, sizeof(cote_shm_t));
+    if (NULL == (shm->name = strdup(name))) {
+        /* Unable to allocate memory */
+        close(fd);
+        free(shm);
+        return NULL;
+    }
+
+    /* Map shared memory, the file descriptor is not needed anymore */
+    shm->ring = (cote_shm_ring_t *)mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == shm->ring) {
+        /* Unable to map shared memory */
+        free(shm->name);
+        free(shm);
+        return NULL;
+    }
+    shm->length = length;
+    shm->owner  = owner;
+
+    return shm;
+}
+
+/**
+ * @brief Lock the ring buffer, the lock is recovered if its owner has died while holding it
+ * @param ring Ring buffer
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_shm_lock(cote_shm_ring_t *ring) {
+
+    assert(NULL != ring);
+
+    /* Lock the ring buffer, the head is only published once a frame is complete so a writer dying while holding the lock leaves no partial frame */
+    int ret = pthread_mutex_lock(&ring->lock);
+    if (EOWNERDEAD == ret) {
+        ret = pthread_mutex_consistent(&ring->lock);
+    }
+
+    return (0 == ret) ? 0 : -1;
+}
+
+/**
+ * @brief Lock the ring buffer once there is enough space to write a frame, the writer waits for space up to COTE_SHM_WAIT
+ * @param shm Shared memory transport
+ * @param size Size of the frame
+ * @return 0 if the function succeeded (the ring buffer is locked), -1 otherwise (the ring buffer is not locked)
+ */
+static int
+cote_shm_lock_space(cote_shm_t *shm, uint32_t size) {
+
+    assert(NULL != shm);
+
+    cote_shm_ring_t *ring    = shm->ring;
+    int              ret     = 1;
+    bool             waited  = false;
+    bool             expired = false;
+    struct timespec  ts;
+
+    /* Wait until the reader frees enough space, the writers do not wait anymore once the reader is stalled until a frame is written again */
+    while (1 == ret) {
+        if (0 != cote_shm_lock(ring)) {
+            /* Unable to lock the ring buffer */
+            ret = -1;
+        } else if ((uint64_t)ring->size - (ring->head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) >= size) {
+            /* Enough space, the ring buffer is kept locked */
+            __atomic_store_n(&shm->stalled, false, __ATOMIC_RELAXED);
+            ret = 0;
+        } else {
+            pthread_mutex_unlock(&ring->lock);
+            if ((true == expired) || (true == __atomic_load_n(&shm->stalled, __ATOMIC_RELAXED))) {
+                /* Ring buffer is full */
+                __atomic_store_n(&shm->stalled, true, __ATOMIC_RELAXED);
+                ret = -1;
+            } else {
+                /* Wait until a frame is read, the reader may have freed space before the writer is counted as waiting */
+                if (false == waited) {
+                    clock_gettime(CLOCK_REALTIME, &ts);
+                    ts.tv_nsec += COTE_SHM_WAIT * 1000000L;
+                    if (1000000000L <= ts.tv_nsec) {
+                        ts.tv_sec++;
+                        ts.tv_nsec -= 1000000000L;
+                    }
+                    waited = true;
+                }
+                __atomic_add_fetch(&ring->waiting, 1, __ATOMIC_SEQ_CST);
+                int err;
+                while ((0 != (err = sem_timedwait(&ring->space, &ts))) && (EINTR == errno))
+                    ;
+                expired = (0 != err) ? true : false;
+                __atomic_sub_fetch(&ring->waiting, 1, __ATOMIC_SEQ_CST);
+            }
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Search a publisher attached or to be attached to the shared memory, the semaphore must be taken by the caller
+ * @param shm Shared memory transport
+ * @param id Identifier of the publisher
+ * @return Publisher, added if not found, NULL if it can not be added
+ */
+static cote_shm_attached_t *
+cote_shm_find(cote_shm_t *shm, char *id) {
+
+    assert(NULL != shm);
+    assert(NULL != id);
+
+    /* Search the publisher */
+    cote_shm_attached_t *curr = shm->attached;
+    while ((NULL != curr) && (strcmp(curr->id, id))) {
+        curr = curr->next;
+    }
+    if (NULL != curr) {
+        return curr;
+    }
+
+    /* Add the publisher */
+    if (NULL == (curr = (cote_shm_attached_t *)malloc(sizeof(cote_shm_attached_t)))) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+    memset(curr, 0, sizeof(cote_shm_attached_t));
+    if (NULL == (curr->id = strdup(id))) {
+        /* Unable to allocate memory */
+        free(curr);
+        return NULL;
+    }
+    curr->next    = shm->attached;
+    shm->attached = curr;
+
+    return curr;
+}
+
+/**
+ * @brief Format the token of the host, invoked once
+ */
+static void
+cote_shm_host_init(void) {
+
+    char        machine[64];
+    char        boot[64];
+    char        ipc[64];
+    struct stat st;
+
+    /* Retrieve the machine ID, the boot ID, the IPC namespace and the device of the shared memories */
+    ssize_t len = readlink("/proc/self/ns/ipc", ipc, sizeof(ipc) - 1);
+    if ((0 != cote_shm_read_line("/etc/machine-id", machine, sizeof(machine)))
+        && (0 != cote_shm_read_line("/var/lib/dbus/machine-id", machine, sizeof(machine)))) {
+        /* Unable to retrieve the machine ID */
+        machine[0] = '\0';
+    }
+    if ((0 != cote_shm_read_line("/proc/sys/kernel/random/boot_id", boot, sizeof(boot))) || (0 >= len) || (0 != stat("/dev/shm", &st))) {
+        /* Unable to identify the host, the shared memory is not used */
+        cote_shm_host_token[0] = '\0';
+        return;
+    }
+    ipc[len] = '\0';
+
+    /* Format the token */
+    snprintf(cote_shm_host_token, sizeof(cote_shm_host_token), "%s/%s/%s/%lx:%lx", machine, boot, ipc, (unsigned long)st.st_dev, (unsigned long)st.st_ino);
+}
+
+/**
+ * @brief Read the first line of a file
+ * @param path Path of the file
+ * @param line Line, without the end of line character
+ * @param size Size of the line
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_shm_read_line(char *path, char *line, size_t size) {
+
+    assert(NULL != path);
+    assert(NULL != line);
+
+    /* Read the file */
+    FILE *file = fopen(path, "r");
+    if (NULL == file) {
+        /* Unable to open the file */
+        return -1;
+    }
+    char *ret = fgets(line, (int)size, file);
+    fclose(file);
+    if (NULL == ret) {
+        /* Empty file */
+        return -1;
+    }
+
+    /* Remove the end of line character */
+    line[strcspn(line, "\n")] = '\0';
+
+    return ('\0' != line[0]) ? 0 : -1;
+}
+
+/**
+ * @brief Copy data to the ring buffer
+ * @param ring Ring buffer
+ * @param pos Position in the ring buffer
+ * @param src Data
+ * @param len Length of the data
+ * @return Position following the data
+ */
+static uint64_t
+cote_shm_write(cote_shm_ring_t *ring, uint64_t pos, void *src, size_t len) {
+
+    assert(NULL != ring);
+    assert((NULL != src) || (0 == len));
+
+    /* Copy data, in two parts if the end of the ring buffer is reached */
+    uint8_t *data   = (uint8_t *)(ring + 1);
+    size_t   offset = (size_t)(pos % ring->size);
+    size_t   first  = (len < ring->size - offset) ? len : (ring->size - offset);
+    memcpy(&data[offset], src, first);
+    memcpy(data, (uint8_t *)src + first, len - first);
+
+    return pos + len;
+}
+
+/**
+ * @brief Copy data from the ring buffer
+ * @param ring Ring buffer
+ * @param pos Position in the ring buffer
+ * @param dst Data
+ * @param len Length of the data
+ */
+static void
+cote_shm_read(cote_shm_ring_t *ring, uint64_t pos, void *dst, size_t len) {
+
+    assert(NULL != ring);
+    assert(NULL != dst);
+
+    /* Copy data, in two parts if the end of the ring buffer is reached */
+    uint8_t *data   = (uint8_t *)(ring + 1);
+    size_t   offset = (size_t)(pos % ring->size);
+    size_t   first  = (len < ring->size - offset) ? len : (ring->size - offset);
+    memcpy(dst, &data[offset], first);
+    memcpy((uint8_t *)dst + first, data, len - first);
+}
+
+/**
+ * @brief Thread reading the frames
+ * @param arg Shared memory transport
+ * @return Always returns NULL
+ */
+static void *
+cote_shm_thread(void *arg) {
+
+    assert(NULL != arg);
+
+    /* Retrieve shared memory transport */
+    cote_shm_t *     shm  = (cote_shm_t *)arg;
+    cote_shm_ring_t *ring = shm->ring;
+
+    /* Read the frames until termination */
+    while (1) {
+
+        /* Wait for a frame */
+        sem_wait(&ring->frames);
+        if (true == __atomic_load_n(&shm->terminate, __ATOMIC_SEQ_CST)) {
+            break;
+        }
+
+        /* Check size of the frame, the ring buffer is reset if it is invalid, the frames pending are lost */
+        uint64_t tail = ring->tail;
+        uint32_t size = 0;
+        if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail >= sizeof(uint32_t)) {
+            cote_shm_read(ring, tail, &size, sizeof(uint32_t));
+        }
+        if ((COTE_FRAME_HEADER > size) || (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail < size)) {
+            if (0 == cote_shm_lock(ring)) {
+                __atomic_store_n(&ring->tail, ring->head, __ATOMIC_RELEASE);
+                pthread_mutex_unlock(&ring->lock);
+            }
+            if (0 < __atomic_load_n(&ring->waiting, __ATOMIC_SEQ_CST)) {
+                sem_post(&ring->space);
+            }
+            continue;
+        }
+
+        /* Copy the frame and free its space in the ring buffer */
+        uint8_t *frame = (uint8_t *)malloc(size - sizeof(uint32_t));
+        if (NULL != frame) {
+            cote_shm_read(ring, tail + sizeof(uint32_t), frame, size - sizeof(uint32_t));
+        }
+        __atomic_store_n(&ring->tail, tail + size, __ATOMIC_SEQ_CST);
+        if (0 < __atomic_load_n(&ring->waiting, __ATOMIC_SEQ_CST)) {
+            sem_post(&ring->space);
+        }
+
+        /* Decode the frame and invoke the function with the message */
+        if (NULL != frame) {
+            amp_msg_t *amp = cote_frame_decode(frame, size - sizeof(uint32_t));
+            if (NULL != amp) {
+                shm->fct(amp, shm->user);
+                amp_release(amp);
+            }
+            free(frame);
+        }
+    }
+
+    return NULL;
+}
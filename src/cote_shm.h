@@ -0,0 +1,140 @@
+/**
+ * @file      cote_shm.h
+ * @brief     Cote library - Shared memory transport
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_SHM_H__
+#define __COTE_SHM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define COTE_SHM_SIZE   (4 * 1024 * 1024)   /* Size of the data of the ring buffer */
+#define COTE_SHM_ATTACH "__cote_shm_attach" /* Topic of the frame announcing a publisher, followed by its identifier */
+#define COTE_SHM_WAIT   (100)               /* Maximum time a writer waits for space in the ring buffer before the message is dropped (milliseconds) */
+#define COTE_SHM_HELLOS (2)                 /* Hello intervals a subscriber waits for a publisher on the same host to attach before using TCP */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Create a shared memory and start the thread reading the frames
+ * @param size Size of the data of the ring buffer
+ * @param fct Function invoked with each message read, the message is released once the function returns
+ * @param user User data passed to the function
+ * @return Shared memory transport if the function succeeded, NULL otherwise
+ */
+cote_shm_t *cote_shm_create(size_t size, void (*fct)(amp_msg_t *, void *), void *user);
+
+/**
+ * @brief Open a shared memory created by another instance to write frames
+ * @param name Name of the shared memory
+ * @return Shared memory transport if the function succeeded, NULL otherwise
+ */
+cote_shm_t *cote_shm_open(char *name);
+
+/**
+ * @brief Write a message to the shared memory, the writer waits for space up to COTE_SHM_WAIT if the ring buffer is full, the message is dropped then
+ * @param shm Shared memory transport
+ * @param topic Full topic of the message
+ * @param fields Fields of the message
+ * @param count Amount of fields (up to COTE_FIELDS_MAX)
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_shm_send(cote_shm_t *shm, char *topic, cote_field_t *fields, int count);
+
+/**
+ * @brief Write a message already encoded as a frame to the shared memory, the writer waits for space up to COTE_SHM_WAIT if the ring buffer is full
+ * @param shm Shared memory transport
+ * @param frame Frame of the message, size of the frame included
+ * @param size Size of the frame
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_shm_send_frame(cote_shm_t *shm, uint8_t *frame, uint32_t size);
+
+/**
+ * @brief Write the frame announcing a publisher to the shared memory, the subscriber stops receiving the messages of the publisher with TCP once read
+ * @param shm Shared memory transport
+ * @param id Identifier of the publisher, as announced in its advertisement
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_shm_attach(cote_shm_t *shm, char *id);
+
+/**
+ * @brief Check if a publisher is attached to the shared memory, and associate its identifier to its instance ID (owner only)
+ * @param shm Shared memory transport
+ * @param id Identifier of the publisher, as announced in its advertisement
+ * @param iid Instance ID of the publisher
+ * @return true if the frame announcing the publisher has been read, false otherwise
+ */
+bool cote_shm_is_attached(cote_shm_t *shm, char *id, char *iid);
+
+/**
+ * @brief Set a publisher as attached to the shared memory when the frame announcing it is read (owner only)
+ * @param shm Shared memory transport
+ * @param id Identifier of the publisher, as written in the frame
+ * @return Instance ID of the publisher if it is known (to be released by the caller), NULL otherwise
+ */
+char *cote_shm_set_attached(cote_shm_t *shm, char *id);
+
+/**
+ * @brief Forget a publisher removed (owner only)
+ * @param shm Shared memory transport
+ * @param iid Instance ID of the publisher
+ */
+void cote_shm_forget(cote_shm_t *shm, char *iid);
+
+/**
+ * @brief Get the token of the host, processes which can share memory have the same token
+ * The token is made of the machine ID, the boot ID, the IPC namespace and the device of /dev/shm, so that containers and virtual machines are told apart
+ * @return Token of the host, empty if it can not be retrieved and the shared memory must not be used
+ */
+char *cote_shm_get_host(void);
+
+/**
+ * @brief Release shared memory transport, the shared memory is removed if it has been created by the instance
+ * @param shm Shared memory transport
+ */
+void cote_shm_release(cote_shm_t *shm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_SHM_H__ */
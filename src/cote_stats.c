@@ -0,0 +1,204 @@
+/**
+ * @file      cote_stats.c
+ * @brief     Cote library - Statistics
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <semaphore.h>
+
+#include "cote_stats.h"
+
+/******************************************************************************/
+/* Variables                                                                  */
+/******************************************************************************/
+
+static unsigned int cote_stats_threads = 0;  /* Amount of threads which have been given a statistics shard */
+static __thread int cote_stats_index   = -1; /* Statistics shard of the calling thread */
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Create statistics shards
+ * @param cote Cote instance
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_stats_init(cote_t *cote) {
+
+    assert(NULL != cote);
+
+    /* Create statistics shards, aligned on cache lines to avoid false sharing between threads */
+    if (0 != posix_memalign((void **)&cote->stats, COTE_STATS_CACHE_LINE, COTE_STATS_SHARDS * sizeof(cote_stats_shard_t))) {
+        /* Unable to allocate memory */
+        cote->stats = NULL;
+        return -1;
+    }
+    memset(cote->stats, 0, COTE_STATS_SHARDS * sizeof(cote_stats_shard_t));
+
+    return 0;
+}
+
+/**
+ * @brief Get statistics shard of the calling thread
+ * @param cote Cote instance
+ * @return Statistics shard
+ */
+cote_stats_shard_t *
+cote_stats_shard(cote_t *cote) {
+
+    assert(NULL != cote);
+    assert(NULL != cote->stats);
+
+    /* Give a shard to the calling thread the first time it updates statistics */
+    if (0 > cote_stats_index) {
+        cote_stats_index = (int)(__atomic_fetch_add(&cote_stats_threads, 1, __ATOMIC_RELAXED) % COTE_STATS_SHARDS);
+    }
+
+    return &cote->stats[cote_stats_index];
+}
+
+/**
+ * @brief Get monotonic time
+ * @return Time in nanoseconds
+ */
+uint64_t
+cote_stats_now(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Record a duration in a histogram of the statistics shard of the calling thread
+ * @param histogram Histogram of the statistics shard
+ * @param ns Duration in nanoseconds
+ */
+void
+cote_stats_record(uint64_t *histogram, uint64_t ns) {
+
+    assert(NULL != histogram);
+
+    /* Bucket is the position of the most significant bit of the duration */
+    int bucket = (0 != ns) ? (63 - __builtin_clzll(ns)) : 0;
+    if (COTE_STATS_BUCKETS <= bucket) {
+        bucket = COTE_STATS_BUCKETS - 1;
+    }
+    __atomic_fetch_add(&histogram[bucket], 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Estimate a percentile of the requests round-trip time from the histograms of all the shards
+ * @param cote Cote instance
+ * @param percentile Percentile (1 to 100)
+ * @param samples Minimum amount of round-trip times recorded for the estimation
+ * @return Round-trip time in nanoseconds, interpolated within the bucket of the percentile, 0 if not enough round-trip times have been recorded
+ */
+uint64_t
+cote_stats_requests_percentile(cote_t *cote, int percentile, uint64_t samples) {
+
+    assert(NULL != cote);
+    assert(NULL != cote->stats);
+    assert((0 < percentile) && (100 >= percentile));
+
+    /* Sum the histograms of all the shards */
+    uint64_t histogram[COTE_STATS_BUCKETS];
+    uint64_t total = 0;
+    for (int bucket = 0; bucket < COTE_STATS_BUCKETS; bucket++) {
+        histogram[bucket] = 0;
+        for (int index = 0; index < COTE_STATS_SHARDS; index++) {
+            histogram[bucket] += __atomic_load_n(&cote->stats[index].stats.requests[bucket], __ATOMIC_RELAXED);
+        }
+        total += histogram[bucket];
+    }
+    if ((0 == total) || (total < samples)) {
+        /* Not enough round-trip times */
+        return 0;
+    }
+
+    /* Search the bucket of the percentile, the round-trip time is interpolated in the range [2^i, 2^(i+1)[ of the bucket */
+    uint64_t rank = (total * (uint64_t)percentile + 99) / 100;
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < COTE_STATS_BUCKETS; bucket++) {
+        if ((0 != histogram[bucket]) && (seen + histogram[bucket] >= rank)) {
+            uint64_t low = (uint64_t)1 << bucket;
+            return low + (low * (rank - seen)) / histogram[bucket];
+        }
+        seen += histogram[bucket];
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Wait semaphore, the time spent is recorded only if the semaphore is not immediately available
+ * @param cote Cote instance
+ * @param sem Semaphore
+ */
+void
+cote_stats_sem_wait(cote_t *cote, sem_t *sem) {
+
+    assert(NULL != cote);
+    assert(NULL != sem);
+
+    /* Try to take the semaphore without blocking first */
+    if (0 == sem_trywait(sem)) {
+        return;
+    }
+
+    /* Wait semaphore and record the time spent */
+    uint64_t start = cote_stats_now();
+    sem_wait(sem);
+    COTE_STATS_INC(cote, sem_contended);
+    COTE_STATS_ADD(cote, sem_wait_ns, cote_stats_now() - start);
+}
+
+/**
+ * @brief Release statistics shards
+ * @param cote Cote instance
+ */
+void
+cote_stats_release(cote_t *cote) {
+
+    assert(NULL != cote);
+
+    /* Release statistics shards */
+    if (NULL != cote->stats) {
+        free(cote->stats);
+        cote->stats = NULL;
+    }
+}
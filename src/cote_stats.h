@@ -0,0 +1,113 @@
+/**
+ * @file      cote_stats.h
+ * @brief     Cote library - Statistics
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef __COTE_STATS_H__
+#define __COTE_STATS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdint.h>
+#include <semaphore.h>
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+/* Add a value to a counter of the statistics shard of the calling thread */
+#define COTE_STATS_ADD(cote, counter, value) __atomic_fetch_add(&cote_stats_shard(cote)->stats.counter, (value), __ATOMIC_RELAXED)
+
+/* Increment a counter of the statistics shard of the calling thread */
+#define COTE_STATS_INC(cote, counter) COTE_STATS_ADD(cote, counter, 1)
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Create statistics shards
+ * @param cote Cote instance
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_stats_init(cote_t *cote);
+
+/**
+ * @brief Get statistics shard of the calling thread
+ * @param cote Cote instance
+ * @return Statistics shard
+ */
+cote_stats_shard_t *cote_stats_shard(cote_t *cote);
+
+/**
+ * @brief Get monotonic time
+ * @return Time in nanoseconds
+ */
+uint64_t cote_stats_now(void);
+
+/**
+ * @brief Record a duration in a histogram of the statistics shard of the calling thread
+ * @param histogram Histogram of the statistics shard
+ * @param ns Duration in nanoseconds
+ */
+void cote_stats_record(uint64_t *histogram, uint64_t ns);
+
+/**
+ * @brief Estimate a percentile of the requests round-trip time from the histograms of all the shards
+ * @param cote Cote instance
+ * @param percentile Percentile (1 to 100)
+ * @param samples Minimum amount of round-trip times recorded for the estimation
+ * @return Round-trip time in nanoseconds, interpolated within the bucket of the percentile, 0 if not enough round-trip times have been recorded
+ */
+uint64_t cote_stats_requests_percentile(cote_t *cote, int percentile, uint64_t samples);
+
+/**
+ * @brief Wait semaphore, the time spent is recorded only if the semaphore is not immediately available
+ * @param cote Cote instance
+ * @param sem Semaphore
+ */
+void cote_stats_sem_wait(cote_t *cote, sem_t *sem);
+
+/**
+ * @brief Release statistics shards
+ * @param cote Cote instance
+ */
+void cote_stats_release(cote_t *cote);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_STATS_H__ */
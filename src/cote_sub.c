@@ -0,0 +1,1136 @@
+/**
+ * @file      cote_sub.c
+ * @brief     Cote library - Subscriptions
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <regex.h>
+#include <semaphore.h>
+
+#include "cote_sub.h"
+#include "cote_hash.h"
+
+/******************************************************************************/
+/* Definitions                                                                */
+/******************************************************************************/
+
+#define COTE_SUB_METACHARACTERS ".[]()*+?{}|^$\\" /* Extended regular expression metacharacters */
+#define COTE_SUB_SEPARATOR      "::"             /* Separator of the topic segments */
+#define COTE_SUB_QUANTIFIERS    "*+?{"           /* Extended regular expression quantifiers */
+#define COTE_SUB_EXACT_MIN_SIZE (16)             /* Minimum size of the literal subscriptions hash table */
+#define COTE_SUB_PREFIX         "message::"      /* Prefix of the Subscriber topics, the received topics start with it */
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Create a copy of the literal subscriptions hash table
+ * @param table Subscription table
+ * @param size Size of the new hash table
+ * @param skip Subscription which is not copied, NULL to copy all subscriptions
+ * @return New hash table if the function succeeded, NULL otherwise
+ */
+static cote_sub_t **cote_sub_exact_copy(cote_sub_table_t *table, size_t size, cote_sub_t *skip);
+
+/**
+ * @brief Insert a subscription in a literal subscriptions hash table
+ * @param exact Hash table
+ * @param size Size of the hash table
+ * @param sub Subscription
+ * @return Subscription replaced if the topic was already present, NULL otherwise
+ */
+static cote_sub_t *cote_sub_exact_insert(cote_sub_t **exact, size_t size, cote_sub_t *sub);
+
+/**
+ * @brief Search a subscription in a literal subscriptions hash table
+ * @param exact Hash table
+ * @param size Size of the hash table
+ * @param topic Topic
+ * @return Subscription if the topic is found, NULL otherwise
+ */
+static cote_sub_t *cote_sub_exact_search(cote_sub_t **exact, size_t size, char *topic);
+
+/**
+ * @brief Check if a regular expression topic is matched from the start of the topic
+ * The regular expressions anchored with "^" and the Subscriber topics are, unless they contain an alternation outside of a group
+ * @param topic Topic
+ * @return true if the regular expression is matched from the start of the topic, false otherwise
+ */
+static bool cote_sub_is_anchored(char *topic);
+
+/**
+ * @brief Get the next literal segment of a regular expression topic used as trie key
+ * @param topic Topic
+ * @param pos Position in the topic, updated to the following segment
+ * @param segment Segment found
+ * @param len Length of the segment found
+ * @return true if a segment is found, false otherwise
+ */
+static bool cote_sub_next_key(char *topic, size_t *pos, char **segment, size_t *len);
+
+/**
+ * @brief Search a child of a trie node
+ * @param node Node
+ * @param segment Segment of the child
+ * @param len Length of the segment
+ * @param found Set to true if the child is found, false otherwise
+ * @return Index of the child if found, index where to insert it otherwise
+ */
+static int cote_sub_node_search(cote_sub_node_t *node, char *segment, size_t len, bool *found);
+
+/**
+ * @brief Create a copy of a trie node (children and subscriptions arrays are copied, children and subscriptions are shared)
+ * @param node Node, NULL to create a new node
+ * @param segment Segment of the new node (used only if node is NULL)
+ * @param len Length of the segment
+ * @param extra_children Amount of additional children to allocate
+ * @param extra_subs Amount of additional subscriptions to allocate
+ * @return New node if the function succeeded, NULL otherwise
+ */
+static cote_sub_node_t *cote_sub_node_copy(cote_sub_node_t *node, char *segment, size_t len, int extra_children, int extra_subs);
+
+/**
+ * @brief Insert a subscription under a trie node, the node is copied and the original node is not modified
+ * @param node Node, NULL to create a new node
+ * @param segment Segment of the node (used only if node is NULL)
+ * @param len Length of the segment
+ * @param pos Position of the next segment in the topic of the subscription
+ * @param sub Subscription
+ * @param table Subscription table receiving the nodes and subscription replaced
+ * @return New node if the function succeeded, NULL otherwise
+ */
+static cote_sub_node_t *cote_sub_node_insert(cote_sub_node_t *node, char *segment, size_t len, size_t pos, cote_sub_t *sub, cote_sub_table_t *table);
+
+/**
+ * @brief Remove a subscription under a trie node, the node is copied and the original node is not modified
+ * @param node Node
+ * @param topic Topic of the subscription
+ * @param pos Position of the next segment in the topic of the subscription
+ * @param table Subscription table receiving the nodes and subscription removed
+ * @param result New node, NULL if the new node is empty
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int cote_sub_node_remove(cote_sub_node_t *node, char *topic, size_t pos, cote_sub_table_t *table, cote_sub_node_t **result);
+
+/**
+ * @brief Release a trie node (children and subscriptions are not released)
+ * @param node Node
+ */
+static void cote_sub_node_release(cote_sub_node_t *node);
+
+/**
+ * @brief Release a trie node, its children and its subscriptions
+ * @param node Node
+ */
+static void cote_sub_node_release_all(cote_sub_node_t *node);
+
+/**
+ * @brief Advance the epoch when possible and release the replaced tables which can not be used anymore
+ * @param subs Topic subscriptions
+ */
+static void cote_subs_reclaim(cote_subs_t *subs);
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief Create a subscription
+ * @param topic Full topic of the subscription
+ * @param fct Callback function
+ * @param user User data
+ * @return Subscription if the function succeeded, NULL otherwise
+ */
+cote_sub_t *
+cote_sub_create(char *topic, void *fct, void *user) {
+
+    assert(NULL != topic);
+
+    /* Create subscription */
+    cote_sub_t *sub = (cote_sub_t *)malloc(sizeof(cote_sub_t));
+    if (NULL == sub) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+    memset(sub, 0, sizeof(cote_sub_t));
+    if (NULL == (sub->topic = strdup(topic))) {
+        /* Unable to allocate memory */
+        free(sub);
+        return NULL;
+    }
+
+    /* Literal topics are compared directly, others are compiled once */
+    sub->literal = (NULL == strpbrk(topic, COTE_SUB_METACHARACTERS)) ? true : false;
+    if (false == sub->literal) {
+
+        /* Subscriber topics are anchored at the start of the received topics, which always start with the prefix, so that they are indexed by the trie */
+        char *regex = topic;
+        if ((!strncmp(topic, COTE_SUB_PREFIX, strlen(COTE_SUB_PREFIX))) && (true == cote_sub_is_anchored(topic))) {
+            if (NULL == (regex = (char *)malloc(strlen(topic) + 2))) {
+                /* Unable to allocate memory */
+                free(sub->topic);
+                free(sub);
+                return NULL;
+            }
+            regex[0] = '^';
+            strcpy(regex + 1, topic);
+        }
+        int ret = regcomp(&sub->regex, regex, REG_NOSUB | REG_EXTENDED);
+        if (regex != topic) {
+            free(regex);
+        }
+        if (0 != ret) {
+            /* Invalid regular expression */
+            free(sub->topic);
+            free(sub);
+            return NULL;
+        }
+    }
+    sub->fct  = fct;
+    sub->user = user;
+
+    return sub;
+}
+
+/**
+ * @brief Check if a topic match a subscription
+ * @param sub Subscription
+ * @param topic Topic
+ * @return true if the topic match the subscription, false otherwise
+ */
+bool
+cote_sub_match(cote_sub_t *sub, char *topic) {
+
+    assert(NULL != sub);
+    assert(NULL != topic);
+
+    /* Literal topics are matching the same topic only, others use the regular expression compiled on subscription */
+    if (true == sub->literal) {
+        return (!strcmp(topic, sub->topic)) ? true : false;
+    }
+    return (0 == regexec(&sub->regex, topic, 0, NULL, 0)) ? true : false;
+}
+
+/**
+ * @brief Release a subscription
+ * @param sub Subscription
+ */
+void
+cote_sub_release(cote_sub_t *sub) {
+
+    /* Release subscription */
+    if (NULL != sub) {
+        if (false == sub->literal) {
+            regfree(&sub->regex);
+        }
+        if (NULL != sub->topic) {
+            free(sub->topic);
+        }
+        free(sub);
+    }
+}
+
+/**
+ * @brief Create an empty subscription table
+ * @return Subscription table if the function succeeded, NULL otherwise
+ */
+cote_sub_table_t *
+cote_sub_table_create(void) {
+
+    /* Create subscription table */
+    cote_sub_table_t *table = (cote_sub_table_t *)malloc(sizeof(cote_sub_table_t));
+    if (NULL == table) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+    memset(table, 0, sizeof(cote_sub_table_t));
+
+    /* Create literal subscriptions hash table */
+    table->size = COTE_SUB_EXACT_MIN_SIZE;
+    if (NULL == (table->exact = (cote_sub_t **)calloc(table->size, sizeof(cote_sub_t *)))) {
+        /* Unable to allocate memory */
+        free(table);
+        return NULL;
+    }
+
+    return table;
+}
+
+/**
+ * @brief Create a new subscription table with the subscription added (or replacing the subscription with the same topic)
+ * The original table is not modified and must be released with cote_sub_table_release once it is not used anymore
+ * @param table Subscription table
+ * @param sub Subscription
+ * @return New subscription table if the function succeeded, NULL otherwise
+ */
+cote_sub_table_t *
+cote_sub_table_add(cote_sub_table_t *table, cote_sub_t *sub) {
+
+    assert(NULL != table);
+    assert(NULL != sub);
+
+    /* Create new table, sharing the content of the original table */
+    cote_sub_table_t *new_table = (cote_sub_table_t *)malloc(sizeof(cote_sub_table_t));
+    if (NULL == new_table) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+    memcpy(new_table, table, sizeof(cote_sub_table_t));
+    memset(&new_table->garbage, 0, sizeof(new_table->garbage));
+    new_table->version++;
+
+    /* Treatment depending of the subscription */
+    if (true == sub->literal) {
+
+        /* Copy literal subscriptions hash table, growing it if required to keep a load factor lower than 50% */
+        size_t size = (2 * (size_t)(table->count + 1) > table->size) ? 2 * table->size : table->size;
+        if (NULL == (new_table->exact = cote_sub_exact_copy(table, size, NULL))) {
+            /* Unable to allocate memory */
+            free(new_table);
+            return NULL;
+        }
+        new_table->size = size;
+
+        /* Insert subscription */
+        cote_sub_t *replaced = cote_sub_exact_insert(new_table->exact, new_table->size, sub);
+        if (NULL != replaced) {
+            replaced->next      = table->garbage.subs;
+            table->garbage.subs = replaced;
+        } else {
+            new_table->count++;
+        }
+        table->garbage.exact = table->exact;
+
+    } else {
+
+        /* Insert subscription in the trie */
+        if (NULL == (new_table->root = cote_sub_node_insert(table->root, NULL, 0, 0, sub, table))) {
+            /* Unable to allocate memory */
+            free(new_table);
+            return NULL;
+        }
+    }
+
+    return new_table;
+}
+
+/**
+ * @brief Create a new subscription table with the subscription removed
+ * The original table is not modified and must be released with cote_sub_table_release once it is not used anymore
+ * @param table Subscription table
+ * @param topic Full topic of the subscription
+ * @return New subscription table if the function succeeded, NULL if the topic is not found or if an error occured
+ */
+cote_sub_table_t *
+cote_sub_table_remove(cote_sub_table_t *table, char *topic) {
+
+    assert(NULL != table);
+    assert(NULL != topic);
+
+    /* Create new table, sharing the content of the original table */
+    cote_sub_table_t *new_table = (cote_sub_table_t *)malloc(sizeof(cote_sub_table_t));
+    if (NULL == new_table) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+    memcpy(new_table, table, sizeof(cote_sub_table_t));
+    memset(&new_table->garbage, 0, sizeof(new_table->garbage));
+    new_table->version++;
+
+    /* Treatment depending of the topic */
+    if (NULL == strpbrk(topic, COTE_SUB_METACHARACTERS)) {
+
+        /* Search subscription */
+        cote_sub_t *sub = cote_sub_exact_search(table->exact, table->size, topic);
+        if (NULL == sub) {
+            /* Subscription not found */
+            free(new_table);
+            return NULL;
+        }
+
+        /* Copy literal subscriptions hash table without the subscription */
+        if (NULL == (new_table->exact = cote_sub_exact_copy(table, table->size, sub))) {
+            /* Unable to allocate memory */
+            free(new_table);
+            return NULL;
+        }
+        new_table->count--;
+        table->garbage.exact = table->exact;
+        sub->next            = table->garbage.subs;
+        table->garbage.subs  = sub;
+
+    } else {
+
+        /* Remove subscription from the trie */
+        if (0 != cote_sub_node_remove(table->root, topic, 0, table, &new_table->root)) {
+            /* Subscription not found or unable to allocate memory */
+            free(new_table);
+            return NULL;
+        }
+    }
+
+    return new_table;
+}
+
+/**
+ * @brief Check if a subscription table is empty
+ * @param table Subscription table
+ * @return true if the table contains no subscription, false otherwise
+ */
+bool
+cote_sub_table_is_empty(cote_sub_table_t *table) {
+
+    assert(NULL != table);
+
+    return ((0 == table->count) && (NULL == table->root)) ? true : false;
+}
+
+/**
+ * @brief Invoke a function for each subscription matching the topic
+ * @param table Subscription table
+ * @param topic Full topic
+ * @param fct Function invoked for each subscription matching the topic
+ * @param user User data passed to the function
+ * @return Amount of subscriptions matching the topic
+ */
+int
+cote_sub_table_match(cote_sub_table_t *table, char *topic, void (*fct)(cote_sub_t *, void *), void *user) {
+
+    assert(NULL != table);
+    assert(NULL != topic);
+    assert(NULL != fct);
+
+    int count = 0;
+
+    /* Search the literal subscription of the topic, literal subscriptions match the same topic only */
+    cote_sub_t *sub = (0 < table->count) ? cote_sub_exact_search(table->exact, table->size, topic) : NULL;
+    if (NULL != sub) {
+        fct(sub, user);
+        count++;
+    }
+
+    /* Parse the trie following the segments of the topic, regular expressions of each node are evaluated */
+    cote_sub_node_t *node = table->root;
+    size_t           pos  = 0;
+    while (NULL != node) {
+        for (int index = 0; index < node->nb_subs; index++) {
+            if (0 == regexec(&node->subs[index]->regex, topic, 0, NULL, 0)) {
+                fct(node->subs[index], user);
+                count++;
+            }
+        }
+        char *end = strstr(topic + pos, COTE_SUB_SEPARATOR);
+        if (NULL == end) {
+            break;
+        }
+        bool found = false;
+        int  index = cote_sub_node_search(node, topic + pos, end - (topic + pos), &found);
+        node       = (true == found) ? node->children[index] : NULL;
+        pos        = end - topic + strlen(COTE_SUB_SEPARATOR);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Release a subscription table which has been replaced by a newer table (content shared with the newer table is kept)
+ * @param table Subscription table
+ */
+void
+cote_sub_table_release(cote_sub_table_t *table) {
+
+    /* Release subscription table */
+    if (NULL != table) {
+
+        /* Release nodes replaced or removed by the newer table */
+        cote_sub_node_t *node = table->garbage.nodes;
+        while (NULL != node) {
+            cote_sub_node_t *tmp = node;
+            node                 = node->next;
+            cote_sub_node_release(tmp);
+        }
+
+        /* Release subscriptions replaced or removed by the newer table */
+        cote_sub_t *sub = table->garbage.subs;
+        while (NULL != sub) {
+            cote_sub_t *tmp = sub;
+            sub             = sub->next;
+            cote_sub_release(tmp);
+        }
+
+        /* Release hash table if it has been replaced by the newer table */
+        if (NULL != table->garbage.exact) {
+            free(table->garbage.exact);
+        }
+
+        /* Release table */
+        free(table);
+    }
+}
+
+/**
+ * @brief Release the current subscription table and all its content
+ * @param table Subscription table
+ */
+void
+cote_sub_table_release_all(cote_sub_table_t *table) {
+
+    /* Release subscription table */
+    if (NULL != table) {
+
+        /* Release literal subscriptions */
+        if (NULL != table->exact) {
+            for (size_t index = 0; index < table->size; index++) {
+                cote_sub_release(table->exact[index]);
+            }
+            free(table->exact);
+            table->exact = NULL;
+        }
+
+        /* Release trie */
+        cote_sub_node_release_all(table->root);
+        table->root = NULL;
+
+        /* Release remaining garbage and table */
+        cote_sub_table_release(table);
+    }
+}
+
+/**
+ * @brief Initialize topic subscriptions with an empty subscription table
+ * @param subs Topic subscriptions
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int
+cote_subs_init(cote_subs_t *subs) {
+
+    assert(NULL != subs);
+
+    /* Create empty subscription table */
+    memset(subs, 0, sizeof(cote_subs_t));
+    if (NULL == (subs->table = cote_sub_table_create())) {
+        /* Unable to allocate memory */
+        return -1;
+    }
+
+    /* Initialize semaphore used to serialize subscription changes */
+    sem_init(&subs->sem, 0, 1);
+
+    return 0;
+}
+
+/**
+ * @brief Enter a read-side section and get the current subscription table
+ * The table remains valid until cote_subs_leave is called, no lock is taken
+ * @param subs Topic subscriptions
+ * @param epoch Epoch of the read-side section, to be given to cote_subs_leave
+ * @return Current subscription table
+ */
+cote_sub_table_t *
+cote_subs_enter(cote_subs_t *subs, unsigned int *epoch) {
+
+    assert(NULL != subs);
+    assert(NULL != epoch);
+
+    /* Register the reader in the current epoch, retry if the epoch has changed meanwhile */
+    while (1) {
+        *epoch = __atomic_load_n(&subs->epoch, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&subs->readers[*epoch & 1], 1, __ATOMIC_SEQ_CST);
+        if (*epoch == __atomic_load_n(&subs->epoch, __ATOMIC_SEQ_CST)) {
+            break;
+        }
+        __atomic_fetch_sub(&subs->readers[*epoch & 1], 1, __ATOMIC_SEQ_CST);
+    }
+
+    return __atomic_load_n(&subs->table, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Leave a read-side section
+ * @param subs Topic subscriptions
+ * @param epoch Epoch of the read-side section returned by cote_subs_enter
+ */
+void
+cote_subs_leave(cote_subs_t *subs, unsigned int epoch) {
+
+    assert(NULL != subs);
+
+    /* Unregister the reader */
+    __atomic_fetch_sub(&subs->readers[epoch & 1], 1, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Replace the current subscription table, the semaphore of the subscriptions must be taken by the caller
+ * The previous table is released later, once all the readers which may use it have left, the function never waits for them
+ * @param subs Topic subscriptions
+ * @param table New subscription table
+ */
+void
+cote_subs_replace(cote_subs_t *subs, cote_sub_table_t *table) {
+
+    assert(NULL != subs);
+    assert(NULL != table);
+
+    /* Publish the new table */
+    cote_sub_table_t *old = __atomic_exchange_n(&subs->table, table, __ATOMIC_SEQ_CST);
+
+    /* Append the previous table to the replaced tables */
+    old->epoch                 = __atomic_load_n(&subs->epoch, __ATOMIC_SEQ_CST);
+    old->next                  = NULL;
+    cote_sub_table_t **retired = &subs->retired;
+    while (NULL != *retired) {
+        retired = &(*retired)->next;
+    }
+    *retired = old;
+
+    /* Release the replaced tables which are not used anymore */
+    cote_subs_reclaim(subs);
+}
+
+/**
+ * @brief Release topic subscriptions, no reader must remain
+ * @param subs Topic subscriptions
+ */
+void
+cote_subs_release(cote_subs_t *subs) {
+
+    assert(NULL != subs);
+
+    /* Release replaced tables */
+    while (NULL != subs->retired) {
+        cote_sub_table_t *tmp = subs->retired;
+        subs->retired         = subs->retired->next;
+        cote_sub_table_release(tmp);
+    }
+
+    /* Release current table */
+    cote_sub_table_release_all(subs->table);
+    subs->table = NULL;
+
+    /* Release semaphore */
+    sem_close(&subs->sem);
+}
+
+/**
+ * @brief Advance the epoch when possible and release the replaced tables which can not be used anymore
+ * @param subs Topic subscriptions
+ */
+static void
+cote_subs_reclaim(cote_subs_t *subs) {
+
+    /* The epoch E can be advanced once all the readers entered during epoch E-1 have left */
+    for (int index = 0; index < 2; index++) {
+        unsigned int epoch = __atomic_load_n(&subs->epoch, __ATOMIC_SEQ_CST);
+        if (0 != __atomic_load_n(&subs->readers[(epoch + 1) & 1], __ATOMIC_SEQ_CST)) {
+            break;
+        }
+        __atomic_store_n(&subs->epoch, epoch + 1, __ATOMIC_SEQ_CST);
+    }
+
+    /* A table replaced during epoch E may be used by readers entered during epochs E-1 and E, it can be released from epoch E+2 */
+    unsigned int epoch = __atomic_load_n(&subs->epoch, __ATOMIC_SEQ_CST);
+    while ((NULL != subs->retired) && (2 <= epoch - subs->retired->epoch)) {
+        cote_sub_table_t *tmp = subs->retired;
+        subs->retired         = subs->retired->next;
+        cote_sub_table_release(tmp);
+    }
+}
+
+/**
+ * @brief Create a copy of the literal subscriptions hash table
+ * @param table Subscription table
+ * @param size Size of the new hash table
+ * @param skip Subscription which is not copied, NULL to copy all subscriptions
+ * @return New hash table if the function succeeded, NULL otherwise
+ */
+static cote_sub_t **
+cote_sub_exact_copy(cote_sub_table_t *table, size_t size, cote_sub_t *skip) {
+
+    /* Create hash table */
+    cote_sub_t **exact = (cote_sub_t **)calloc(size, sizeof(cote_sub_t *));
+    if (NULL == exact) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+
+    /* Insert all subscriptions (a new insertion is required to remove subscriptions or resize the table) */
+    for (size_t index = 0; index < table->size; index++) {
+        if ((NULL != table->exact[index]) && (skip != table->exact[index])) {
+            cote_sub_exact_insert(exact, size, table->exact[index]);
+        }
+    }
+
+    return exact;
+}
+
+/**
+ * @brief Insert a subscription in a literal subscriptions hash table
+ * @param exact Hash table
+ * @param size Size of the hash table
+ * @param sub Subscription
+ * @return Subscription replaced if the topic was already present, NULL otherwise
+ */
+static cote_sub_t *
+cote_sub_exact_insert(cote_sub_t **exact, size_t size, cote_sub_t *sub) {
+
+    /* Linear probing */
+    size_t index = (size_t)cote_hash64(sub->topic) & (size - 1);
+    while (NULL != exact[index]) {
+        if (!strcmp(exact[index]->topic, sub->topic)) {
+            cote_sub_t *replaced = exact[index];
+            exact[index]         = sub;
+            return replaced;
+        }
+        index = (index + 1) & (size - 1);
+    }
+    exact[index] = sub;
+
+    return NULL;
+}
+
+/**
+ * @brief Search a subscription in a literal subscriptions hash table
+ * @param exact Hash table
+ * @param size Size of the hash table
+ * @param topic Topic
+ * @return Subscription if the topic is found, NULL otherwise
+ */
+static cote_sub_t *
+cote_sub_exact_search(cote_sub_t **exact, size_t size, char *topic) {
+
+    /* Linear probing */
+    size_t index = (size_t)cote_hash64(topic) & (size - 1);
+    while (NULL != exact[index]) {
+        if (!strcmp(exact[index]->topic, topic)) {
+            return exact[index];
+        }
+        index = (index + 1) & (size - 1);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Check if a regular expression topic is matched from the start of the topic
+ * The regular expressions anchored with "^" and the Subscriber topics are, unless they contain an alternation outside of a group
+ * @param topic Topic
+ * @return true if the regular expression is matched from the start of the topic, false otherwise
+ */
+static bool
+cote_sub_is_anchored(char *topic) {
+
+    /* Check the start of the topic */
+    if (('^' != topic[0]) && (strncmp(topic, COTE_SUB_PREFIX, strlen(COTE_SUB_PREFIX)))) {
+        return false;
+    }
+
+    /* Search an alternation outside of the groups, the escaped characters and the bracket expressions are skipped */
+    int    depth = 0;
+    size_t pos   = 0;
+    while ('\0' != topic[pos]) {
+        if (('\\' == topic[pos]) && ('\0' != topic[pos + 1])) {
+            pos++;
+        } else if ('[' == topic[pos]) {
+            /* A closing bracket at the start of the expression is a character, the classes "[:alpha:]", "[.x.]" and "[=x=]" are skipped */
+            size_t end = pos + 1;
+            end += ('^' == topic[end]) ? 1 : 0;
+            end += (']' == topic[end]) ? 1 : 0;
+            while (('\0' != topic[end]) && (']' != topic[end])) {
+                char  delimiter[3] = { topic[end + 1], ']', '\0' };
+                char *name         = (('[' == topic[end]) && ('\0' != topic[end + 1]) && (NULL != strchr(":.=", topic[end + 1])))
+                                         ? strstr(topic + end + 2, delimiter)
+                                         : NULL;
+                end                = (NULL != name) ? (size_t)(name - topic) + 2 : end + 1;
+            }
+            pos = ('\0' != topic[end]) ? end : end - 1;
+        } else if ('(' == topic[pos]) {
+            depth++;
+        } else if (')' == topic[pos]) {
+            depth--;
+        } else if (('|' == topic[pos]) && (0 >= depth)) {
+            return false;
+        }
+        pos++;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Get the next literal segment of a regular expression topic used as trie key
+ * @param topic Topic
+ * @param pos Position in the topic, updated to the following segment
+ * @param segment Segment found
+ * @param len Length of the segment found
+ * @return true if a segment is found, false otherwise
+ */
+static bool
+cote_sub_next_key(char *topic, size_t *pos, char **segment, size_t *len) {
+
+    /* Only the regular expressions matched from the start of the topic have a prefix, the others may match anywhere in the topic */
+    if (false == cote_sub_is_anchored(topic)) {
+        return false;
+    }
+
+    /* Only complete segments without metacharacter are keys, the first segment follows the anchor if any */
+    char *start = topic + ((0 < *pos) ? *pos : (('^' == topic[0]) ? 1 : 0));
+    char *end   = strstr(start, COTE_SUB_SEPARATOR);
+    if (NULL == end) {
+        return false;
+    }
+    for (char *curr = start; curr < end; curr++) {
+        if (NULL != strchr(COTE_SUB_METACHARACTERS, *curr)) {
+            return false;
+        }
+    }
+
+    /* A quantifier following the separator applies to its last character, the separator may then be absent of the matching topics */
+    if (('\0' != end[strlen(COTE_SUB_SEPARATOR)]) && (NULL != strchr(COTE_SUB_QUANTIFIERS, end[strlen(COTE_SUB_SEPARATOR)]))) {
+        return false;
+    }
+    *segment = start;
+    *len     = end - start;
+    *pos     = end - topic + strlen(COTE_SUB_SEPARATOR);
+
+    return true;
+}
+
+/**
+ * @brief Search a child of a trie node
+ * @param node Node
+ * @param segment Segment of the child
+ * @param len Length of the segment
+ * @param found Set to true if the child is found, false otherwise
+ * @return Index of the child if found, index where to insert it otherwise
+ */
+static int
+cote_sub_node_search(cote_sub_node_t *node, char *segment, size_t len, bool *found) {
+
+    /* Binary search, children are sorted by segment */
+    int low  = 0;
+    int high = node->nb_children;
+    while (low < high) {
+        int              middle = low + (high - low) / 2;
+        cote_sub_node_t *child  = node->children[middle];
+        int              cmp    = memcmp(child->segment, segment, (child->len < len) ? child->len : len);
+        if (0 == cmp) {
+            cmp = (child->len < len) ? -1 : ((child->len > len) ? 1 : 0);
+        }
+        if (0 == cmp) {
+            *found = true;
+            return middle;
+        } else if (0 > cmp) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    *found = false;
+
+    return low;
+}
+
+/**
+ * @brief Create a copy of a trie node (children and subscriptions arrays are copied, children and subscriptions are shared)
+ * @param node Node, NULL to create a new node
+ * @param segment Segment of the new node (used only if node is NULL)
+ * @param len Length of the segment
+ * @param extra_children Amount of additional children to allocate
+ * @param extra_subs Amount of additional subscriptions to allocate
+ * @return New node if the function succeeded, NULL otherwise
+ */
+static cote_sub_node_t *
+cote_sub_node_copy(cote_sub_node_t *node, char *segment, size_t len, int extra_children, int extra_subs) {
+
+    /* Create node */
+    cote_sub_node_t *new_node = (cote_sub_node_t *)malloc(sizeof(cote_sub_node_t));
+    if (NULL == new_node) {
+        /* Unable to allocate memory */
+        return NULL;
+    }
+    memset(new_node, 0, sizeof(cote_sub_node_t));
+
+    /* Copy segment */
+    if (NULL != node) {
+        segment = node->segment;
+        len     = node->len;
+    }
+    if (NULL != segment) {
+        if (NULL == (new_node->segment = strndup(segment, len))) {
+            /* Unable to allocate memory */
+            cote_sub_node_release(new_node);
+            return NULL;
+        }
+        new_node->len = len;
+    }
+
+    /* Copy children and subscriptions arrays */
+    new_node->nb_children = (NULL != node) ? node->nb_children : 0;
+    new_node->nb_subs     = (NULL != node) ? node->nb_subs : 0;
+    if (0 < new_node->nb_children + extra_children) {
+        if (NULL == (new_node->children = (cote_sub_node_t **)malloc((new_node->nb_children + extra_children) * sizeof(cote_sub_node_t *)))) {
+            /* Unable to allocate memory */
+            cote_sub_node_release(new_node);
+            return NULL;
+        }
+        if (0 < new_node->nb_children) {
+            memcpy(new_node->children, node->children, new_node->nb_children * sizeof(cote_sub_node_t *));
+        }
+    }
+    if (0 < new_node->nb_subs + extra_subs) {
+        if (NULL == (new_node->subs = (cote_sub_t **)malloc((new_node->nb_subs + extra_subs) * sizeof(cote_sub_t *)))) {
+            /* Unable to allocate memory */
+            cote_sub_node_release(new_node);
+            return NULL;
+        }
+        if (0 < new_node->nb_subs) {
+            memcpy(new_node->subs, node->subs, new_node->nb_subs * sizeof(cote_sub_t *));
+        }
+    }
+
+    return new_node;
+}
+
+/**
+ * @brief Insert a subscription under a trie node, the node is copied and the original node is not modified
+ * @param node Node, NULL to create a new node
+ * @param segment Segment of the node (used only if node is NULL)
+ * @param len Length of the segment
+ * @param pos Position of the next segment in the topic of the subscription
+ * @param sub Subscription
+ * @param table Subscription table receiving the nodes and subscription replaced
+ * @return New node if the function succeeded, NULL otherwise
+ */
+static cote_sub_node_t *
+cote_sub_node_insert(cote_sub_node_t *node, char *segment, size_t len, size_t pos, cote_sub_t *sub, cote_sub_table_t *table) {
+
+    cote_sub_node_t *new_node;
+    char *           next_segment = NULL;
+    size_t           next_len     = 0;
+    bool             found        = false;
+    int              index        = 0;
+
+    /* Check if the subscription is stored on this node or on a child */
+    if (true == cote_sub_next_key(sub->topic, &pos, &next_segment, &next_len)) {
+
+        /* Copy node, all memory is allocated before modifying the trie */
+        if (NULL != node) {
+            index = cote_sub_node_search(node, next_segment, next_len, &found);
+        }
+        if (NULL == (new_node = cote_sub_node_copy(node, segment, len, (true == found) ? 0 : 1, 0))) {
+            /* Unable to allocate memory */
+            return NULL;
+        }
+
+        /* Insert subscription under the child */
+        cote_sub_node_t *child = cote_sub_node_insert((true == found) ? node->children[index] : NULL, next_segment, next_len, pos, sub, table);
+        if (NULL == child) {
+            /* Unable to allocate memory */
+            cote_sub_node_release(new_node);
+            return NULL;
+        }
+        if (false == found) {
+            memmove(&new_node->children[index + 1], &new_node->children[index], (new_node->nb_children - index) * sizeof(cote_sub_node_t *));
+            new_node->nb_children++;
+        }
+        new_node->children[index] = child;
+
+    } else {
+
+        /* Search subscription with the same topic */
+        if (NULL != node) {
+            while ((index < node->nb_subs) && (strcmp(node->subs[index]->topic, sub->topic))) {
+                index++;
+            }
+            found = (index < node->nb_subs) ? true : false;
+        }
+
+        /* Copy node */
+        if (NULL == (new_node = cote_sub_node_copy(node, segment, len, 0, (true == found) ? 0 : 1))) {
+            /* Unable to allocate memory */
+            return NULL;
+        }
+
+        /* Insert or replace subscription */
+        if (true == found) {
+            node->subs[index]->next = table->garbage.subs;
+            table->garbage.subs     = node->subs[index];
+        } else {
+            index = new_node->nb_subs;
+            new_node->nb_subs++;
+        }
+        new_node->subs[index] = sub;
+    }
+
+    /* The original node is replaced */
+    if (NULL != node) {
+        node->next           = table->garbage.nodes;
+        table->garbage.nodes = node;
+    }
+
+    return new_node;
+}
+
+/**
+ * @brief Remove a subscription under a trie node, the node is copied and the original node is not modified
+ * @param node Node
+ * @param topic Topic of the subscription
+ * @param pos Position of the next segment in the topic of the subscription
+ * @param table Subscription table receiving the nodes and subscription removed
+ * @param result New node, NULL if the new node is empty
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+static int
+cote_sub_node_remove(cote_sub_node_t *node, char *topic, size_t pos, cote_sub_table_t *table, cote_sub_node_t **result) {
+
+    cote_sub_node_t *new_node;
+    char *           next_segment = NULL;
+    size_t           next_len     = 0;
+    bool             found        = false;
+    int              index        = 0;
+
+    /* Check node */
+    if (NULL == node) {
+        /* Subscription not found */
+        return -1;
+    }
+
+    /* Check if the subscription is stored on this node or on a child */
+    if (true == cote_sub_next_key(topic, &pos, &next_segment, &next_len)) {
+
+        /* Search child */
+        index = cote_sub_node_search(node, next_segment, next_len, &found);
+        if (false == found) {
+            /* Subscription not found */
+            return -1;
+        }
+
+        /* Copy node, all memory is allocated before modifying the trie */
+        if (NULL == (new_node = cote_sub_node_copy(node, NULL, 0, 0, 0))) {
+            /* Unable to allocate memory */
+            return -1;
+        }
+
+        /* Remove subscription under the child */
+        cote_sub_node_t *child = NULL;
+        if (0 != cote_sub_node_remove(node->children[index], topic, pos, table, &child)) {
+            /* Subscription not found or unable to allocate memory */
+            cote_sub_node_release(new_node);
+            return -1;
+        }
+        if (NULL != child) {
+            new_node->children[index] = child;
+        } else {
+            new_node->nb_children--;
+            memmove(&new_node->children[index], &new_node->children[index + 1], (new_node->nb_children - index) * sizeof(cote_sub_node_t *));
+        }
+
+    } else {
+
+        /* Search subscription */
+        while ((index < node->nb_subs) && (strcmp(node->subs[index]->topic, topic))) {
+            index++;
+        }
+        if (index == node->nb_subs) {
+            /* Subscription not found */
+            return -1;
+        }
+
+        /* Copy node */
+        if (NULL == (new_node = cote_sub_node_copy(node, NULL, 0, 0, 0))) {
+            /* Unable to allocate memory */
+            return -1;
+        }
+
+        /* Remove subscription */
+        node->subs[index]->next = table->garbage.subs;
+        table->garbage.subs     = node->subs[index];
+        new_node->nb_subs--;
+        memmove(&new_node->subs[index], &new_node->subs[index + 1], (new_node->nb_subs - index) * sizeof(cote_sub_t *));
+    }
+
+    /* The original node is replaced */
+    node->next           = table->garbage.nodes;
+    table->garbage.nodes = node;
+
+    /* Empty nodes are removed from the trie */
+    if ((0 == new_node->nb_children) && (0 == new_node->nb_subs)) {
+        cote_sub_node_release(new_node);
+        new_node = NULL;
+    }
+    *result = new_node;
+
+    return 0;
+}
+
+/**
+ * @brief Release a trie node (children and subscriptions are not released)
+ * @param node Node
+ */
+static void
+cote_sub_node_release(cote_sub_node_t *node) {
+
+    /* Release node */
+    if (NULL != node) {
+        if (NULL != node->segment) {
+            free(node->segment);
+        }
+        if (NULL != node->children) {
+            free(node->children);
+        }
+        if (NULL != node->subs) {
+            free(node->subs);
+        }
+        free(node);
+    }
+}
+
+/**
+ * @brief Release a trie node, its children and its subscriptions
+ * @param node Node
+ */
+static void
+cote_sub_node_release_all(cote_sub_node_t *node) {
+
+    /* Release node */
+    if (NULL != node) {
+        for (int index = 0; index < node->nb_children; index++) {
+            cote_sub_node_release_all(node->children[index]);
+        }
+        for (int index = 0; index < node->nb_subs; index++) {
+            cote_sub_release(node->subs[index]);
+        }
+        cote_sub_node_release(node);
+    }
+}
@@ -0,0 +1,165 @@
+/**
+ * @file      cote_sub.h
+ * @brief     Cote library - Subscriptions
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021-2023 joelguittet and c-cote contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef __COTE_SUB_H__
+#define __COTE_SUB_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+
+#include <stdbool.h>
+
+#include "cote.h"
+
+/******************************************************************************/
+/* Prototypes                                                                 */
+/******************************************************************************/
+
+/**
+ * @brief Create a subscription
+ * @param topic Full topic of the subscription
+ * @param fct Callback function
+ * @param user User data
+ * @return Subscription if the function succeeded, NULL otherwise
+ */
+cote_sub_t *cote_sub_create(char *topic, void *fct, void *user);
+
+/**
+ * @brief Check if a topic match a subscription
+ * @param sub Subscription
+ * @param topic Topic
+ * @return true if the topic match the subscription, false otherwise
+ */
+bool cote_sub_match(cote_sub_t *sub, char *topic);
+
+/**
+ * @brief Release a subscription
+ * @param sub Subscription
+ */
+void cote_sub_release(cote_sub_t *sub);
+
+/**
+ * @brief Create an empty subscription table
+ * @return Subscription table if the function succeeded, NULL otherwise
+ */
+cote_sub_table_t *cote_sub_table_create(void);
+
+/**
+ * @brief Create a new subscription table with the subscription added (or replacing the subscription with the same topic)
+ * The original table is not modified and must be released with cote_sub_table_release once it is not used anymore
+ * @param table Subscription table
+ * @param sub Subscription
+ * @return New subscription table if the function succeeded, NULL otherwise
+ */
+cote_sub_table_t *cote_sub_table_add(cote_sub_table_t *table, cote_sub_t *sub);
+
+/**
+ * @brief Create a new subscription table with the subscription removed
+ * The original table is not modified and must be released with cote_sub_table_release once it is not used anymore
+ * @param table Subscription table
+ * @param topic Full topic of the subscription
+ * @return New subscription table if the function succeeded, NULL if the topic is not found or if an error occured
+ */
+cote_sub_table_t *cote_sub_table_remove(cote_sub_table_t *table, char *topic);
+
+/**
+ * @brief Check if a subscription table is empty
+ * @param table Subscription table
+ * @return true if the table contains no subscription, false otherwise
+ */
+bool cote_sub_table_is_empty(cote_sub_table_t *table);
+
+/**
+ * @brief Invoke a function for each subscription matching the topic
+ * @param table Subscription table
+ * @param topic Full topic
+ * @param fct Function invoked for each subscription matching the topic
+ * @param user User data passed to the function
+ * @return Amount of subscriptions matching the topic
+ */
+int cote_sub_table_match(cote_sub_table_t *table, char *topic, void (*fct)(cote_sub_t *, void *), void *user);
+
+/**
+ * @brief Release a subscription table which has been replaced by a newer table (content shared with the newer table is kept)
+ * @param table Subscription table
+ */
+void cote_sub_table_release(cote_sub_table_t *table);
+
+/**
+ * @brief Release the current subscription table and all its content
+ * @param table Subscription table
+ */
+void cote_sub_table_release_all(cote_sub_table_t *table);
+
+/**
+ * @brief Initialize topic subscriptions with an empty subscription table
+ * @param subs Topic subscriptions
+ * @return 0 if the function succeeded, -1 otherwise
+ */
+int cote_subs_init(cote_subs_t *subs);
+
+/**
+ * @brief Enter a read-side section and get the current subscription table
+ * The table remains valid until cote_subs_leave is called, no lock is taken
+ * @param subs Topic subscriptions
+ * @param epoch Epoch of the read-side section, to be given to cote_subs_leave
+ * @return Current subscription table
+ */
+cote_sub_table_t *cote_subs_enter(cote_subs_t *subs, unsigned int *epoch);
+
+/**
+ * @brief Leave a read-side section
+ * @param subs Topic subscriptions
+ * @param epoch Epoch of the read-side section returned by cote_subs_enter
+ */
+void cote_subs_leave(cote_subs_t *subs, unsigned int epoch);
+
+/**
+ * @brief Replace the current subscription table, the semaphore of the subscriptions must be taken by the caller
+ * The previous table is released later, once all the readers which may use it have left, the function never waits for them
+ * @param subs Topic subscriptions
+ * @param table New subscription table
+ */
+void cote_subs_replace(cote_subs_t *subs, cote_sub_table_t *table);
+
+/**
+ * @brief Release topic subscriptions, no reader must remain
+ * @param subs Topic subscriptions
+ */
+void cote_subs_release(cote_subs_t *subs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COTE_SUB_H__ */